@@ -7,6 +7,8 @@ option(FLINE_USE_RELATIVE_PATH
 
 option(FLINE_BUILD_TESTS "Set if you want to enable unit tests, unset if you don't" ON)
 
+option(FLINE_BUILD_BENCHMARKS "Set if you want to build the benchmarks. Only built when tests are enabled" OFF)
+
 option(FLINE_DO_CHECK_ASAN "Enable address sanitizer" ON)
 option(FLINE_DO_CHECK_UBSAN "Enable undefined behaviour sanitizer" ON)
 
@@ -15,6 +17,10 @@ cmake_dependent_option(FLINE_SET_COVERAGE "Enable coverage testing. Only enabled
 
 option(FLINE_NET_SUPPORT "Enable networking support" ON)
 
+option(FLINE_STRIP_DEBUG_LOG "Remove the debug log messages at compile time" OFF)
+
+option(FLINE_STRIP_PROFILER "Remove the profiler zones at compile time" OFF)
+
 set(FLINE_RENDERER "opengl" CACHE STRING "Set if you want to support the opengl renderer. 
 Since this is the only renderer, if you disable, you will not be able to render anything")
 
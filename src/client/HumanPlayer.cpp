@@ -3,12 +3,14 @@
 #include <client/input/input_service.hpp>
 #include <common/logger.hpp>
 #include <common/logic/logic_service.hpp>
+#include <common/profiler.hpp>
 
 using namespace familyline;
 using namespace familyline::graphics;
 using namespace familyline::logic;
 using namespace familyline::input;
 
+#include <chrono>
 #include <cstdio>
 
 
@@ -78,6 +80,13 @@ HumanPlayer::HumanPlayer(PlayerManager& pm, const Terrain& t, const char* name,
                 if (pressed) {
                     this->renderBBs = !this->renderBBs;
                 }
+                break;
+
+            case PlayerCommandType::DebugToggleProfiler:
+                if (pressed) {
+                    this->toggleProfiler();
+                }
+                break;
             }
             return true;
 
@@ -146,6 +155,51 @@ void HumanPlayer::setCamera(familyline::graphics::Camera* c)
 
 void HumanPlayer::SetPicker(familyline::input::InputPicker* ip) { _ip = ip; }
 
+/**
+ * Check if there is enough space to build an object of a certain type in
+ * a certain position
+ *
+ * This is checked only here, before sending the action, because the other players
+ * will create what we send.
+ */
+bool HumanPlayer::canBuildAt(const std::string& type, glm::vec2 pos) const
+{
+    auto& pm = LogicService::getPathManager();
+    auto* prototype = LogicService::getObjectFactory()->getPrototype(type);
+    if (!pm || !prototype) return true;
+
+    if (!pm->canPlace(pos, prototype->getSize())) {
+        LoggerService::getLogger()->write(
+            "human-player", LogType::Info, "cannot build {} at {:.1f}, there is something there",
+            type, pos);
+        return false;
+    }
+
+    return true;
+}
+
+void HumanPlayer::toggleProfiler()
+{
+    auto& log      = LoggerService::getLogger();
+    auto& profiler = Profiler::get();
+
+    if (!Profiler::isCapturing()) {
+        profiler.start();
+        log->write("human-player", LogType::Info, "profiler capture started");
+        return;
+    }
+
+    profiler.stop();
+
+    auto now  = std::chrono::system_clock::now().time_since_epoch();
+    auto path = fmt::format(
+        "familyline-profile-{}.json", std::chrono::duration_cast<std::chrono::seconds>(now).count());
+    if (profiler.dumpChromeTrace(path))
+        log->write("human-player", LogType::Info, "profiler capture written to {}", path);
+    else
+        log->write("human-player", LogType::Error, "could not write profiler capture to {}", path);
+}
+
 /**
  * Generate the input actions.
  *
@@ -219,14 +273,17 @@ void HumanPlayer::generateInput()
         glm::vec2 to = _ip->GetGameProjectedPosition();
         glm::vec3 p  = terr_.graphicalToGame(_ip->GetTerrainProjectedPosition());
 
-        this->pushAction(CreateEntity{nextBuild_, int(p.x), int(p.z)});
-        build_something = false;
-        mouse_click     = false;
-        if (pr_)
-            pr_->reset();
+        if (this->canBuildAt(nextBuild_, glm::vec2(int(p.x), int(p.z)))) {
+            this->pushAction(CreateEntity{nextBuild_, int(p.x), int(p.z)});
+            build_something = false;
+            if (pr_)
+                pr_->reset();
 
-        preview_building = false;        
-        nextBuild_ = "";
+            preview_building = false;        
+            nextBuild_ = "";
+        }
+
+        mouse_click = false;
     } else if (has_selection && mouse_click && _ip) {
         // Individual object selection, click-based
         // TODO: do multiple object selection, drag-based
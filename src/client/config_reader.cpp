@@ -116,6 +116,7 @@ void read_log_block_tags_section(YAML::Node& tags, ConfigData& data)
  * block_tags:
  *   - player_manager
  *   - gl_renderer
+ * binary_file: "~/.local/share/familyline/game.flog"
  *
  * ```
  *
@@ -127,6 +128,9 @@ void read_log_section(YAML::Node& fileinfo, ConfigData& data)
         YAML::Node n = fileinfo["block_tags"];
         read_log_block_tags_section(n, data);
     }
+
+    if (fileinfo["binary_file"])
+        data.log.binaryFile = expand_path(fileinfo["binary_file"].as<std::string>());
 }
 
 
@@ -150,6 +154,26 @@ void read_player_section(YAML::Node& player_info, ConfigData& data)
 
 }
 
+/**
+ * Read the telemetry section of the config file
+ *
+ * ```yaml
+ *
+ * telemetry:
+ *   file: "~/.local/share/familyline/telemetry.csv"
+ *   export_interval: 60
+ *
+ * ```
+ *
+ */
+void read_telemetry_section(YAML::Node& info, ConfigData& data)
+{
+    if (info["file"]) data.telemetry.file = expand_path(info["file"].as<std::string>());
+
+    if (info["export_interval"])
+        data.telemetry.exportInterval = info["export_interval"].as<unsigned>();
+}
+
 bool familyline::read_config_from(std::string_view path, ConfigData& data)
 {
     // create a temporary logger, just to capture those values here..
@@ -170,6 +194,11 @@ bool familyline::read_config_from(std::string_view path, ConfigData& data)
             YAML::Node n = config["player"];
             read_player_section(n, data);
         }
+
+        if (config["telemetry"]) {
+            YAML::Node n = config["telemetry"];
+            read_telemetry_section(n, data);
+        }
         
         if (config["enable_input_recording"]) {
             data.enableInputRecording = config["enable_input_recording"].as<bool>();
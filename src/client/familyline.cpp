@@ -15,6 +15,7 @@
 #include <common/logic/script_environment.hpp>
 #include <common/net/net_player_sender.hpp>
 #include <common/net/network_player.hpp>
+#include <common/profiler.hpp>
 #include <concepts>
 #include <cstdio>
 #include <cstdlib>
@@ -611,6 +612,20 @@ Game* start_game(
     Game* g   = new Game(gi);
     auto& map = g->initMap(mapfile);
 
+    if (!confdata.telemetry.file.empty()) {
+        auto& telemetry = g->getTelemetry();
+        telemetry.setInfo("version", VERSION);
+#if defined(COMMIT)
+        telemetry.setInfo("commit", COMMIT);
+#endif
+        telemetry.setInfo("map", mapfile);
+        telemetry.setExport(
+            confdata.telemetry.file, std::chrono::seconds(confdata.telemetry.exportInterval));
+        log->write(
+            "", LogType::Info, "Exporting the telemetry to {}, every {} s",
+            confdata.telemetry.file, confdata.telemetry.exportInterval);
+    }
+
     std::string player_name = confdata.player.username;
     auto pinfo              = InitPlayerInfo{player_name, uint64_t(-1)};
 
@@ -793,11 +808,22 @@ int main(int argc, char const* argv[])
 
     fmt::print("Using resolution {} x {} \n", pi.width, pi.height);
     ConfigData confdata = read_settings();
+    if (pi.telemetryFile) confdata.telemetry.file = *pi.telemetryFile;
 
     LoggerService::createLogger(pi.log_device, LogType::Debug, confdata.log.blockTags);
 
     auto& log = LoggerService::getLogger();
 
+    if (!confdata.log.binaryFile.empty()) {
+        auto binlog = std::make_unique<BinaryLogWriter>(confdata.log.binaryFile);
+        if (binlog->open())
+            log->setBinarySink(std::move(binlog));
+        else
+            log->write(
+                "", LogType::Error, "could not create the binary log file {}",
+                confdata.log.binaryFile);
+    }
+
     auto [sysname, sysversion, sysinfo] = get_system_name();
 
     log->write("", LogType::Info, "Familyline " VERSION);
@@ -818,6 +844,12 @@ int main(int argc, char const* argv[])
     log->write("", LogType::Info, "Default texture directory is " TEXTURES_DIR);
     log->write("", LogType::Info, "Default material directory is " MATERIALS_DIR);
 
+    Profiler::get().setThreadName("main");
+    if (pi.profileFile) {
+        log->write("", LogType::Info, "Capturing the profiler zones to {}", *pi.profileFile);
+        Profiler::get().start();
+    }
+
     LoopRunner lr;
 
     graphics::Window* win = nullptr;
@@ -875,6 +907,7 @@ int main(int argc, char const* argv[])
                 {"e", "DebugCreateEntity, tent"},
                 {"r", "DebugDestroyEntity"},
                 {"b", "DebugShowBoundingBox"},
+                {"p", "DebugToggleProfiler"},
             });
         }
 
@@ -1385,6 +1418,13 @@ static int show_starting_menu(
     delete ginfo.win;
     delete ginfo.f3D;
     delete ginfo.fGUI;
+
+    if (pi.profileFile) {
+        Profiler::get().stop();
+        if (!Profiler::get().dumpChromeTrace(*pi.profileFile))
+            fmt::print("could not write the profiler trace to {}\n", *pi.profileFile);
+    }
+
     fmt::print("\nExited. ({:d} frames)\n", frames);
 
     return 0;
@@ -12,6 +12,7 @@
 #include <common/logic/game_event.hpp>
 #include <common/logic/logic_service.hpp>
 #include <common/logic/pathfinder.hpp>
+#include <common/profiler.hpp>
 #include <exception>
 
 using namespace familyline;
@@ -28,6 +29,8 @@ using namespace familyline::graphics::gui;
  */
 logic::Terrain& Game::initMap(std::string_view path)
 {
+    PROFILE_ZONE("assets/map");
+
     auto& log = LoggerService::getLogger();
 
     if (!terrFile_->open(path)) {
@@ -69,6 +72,7 @@ void Game::initPlayers(
 
     cm_.swap(cm);
     pm_.swap(pm);
+    ta_ = std::make_unique<TargetAcquirer>(*cm_.get());
     pm_->render_add_callback = [&](std::shared_ptr<GameObject> o) {
         if (objrend_) objrend_->add(o);
     };
@@ -98,6 +102,8 @@ void Game::initPlayers(
  */
 void Game::initAssets()
 {
+    PROFILE_ZONE("assets");
+
     // TODO: move this outside?
     AssetFile f;
     f.loadFile("assets.yml");
@@ -138,6 +144,7 @@ void Game::initObjectManager()
 
     om_      = std::make_unique<ObjectManager>();
     olm_     = std::make_unique<ObjectLifecycleManager>(*om_.get());
+    om_->setWorkers(LogicService::getWorkerPool());
     pm_->olm = olm_.get();
 
     log->write("game", LogType::Info, "game objects configured");
@@ -197,10 +204,12 @@ void Game::initLoopData(uint64_t human_id)
     log->write("game", LogType::Info, "game class ready");
 }
 
-Game::~Game() {}
+Game::~Game() { telemetry_.exportNow(); }
 
 bool Game::runLoop()
 {
+    PROFILE_ZONE("frame");
+
     gui_->debugClear();
     gui_->debugWrite("Familyline " VERSION " commit " COMMIT
                      "\n"
@@ -211,6 +220,12 @@ bool Game::runLoop()
         "tick {}\n",
         float(1000 / pms), float(pms), logictime_.count(), inputtime_.count(), drawtime_.count(),
         pm_->tick()));
+    if (auto* frametimes = telemetry_.get("frame"); frametimes) {
+        auto& v = frametimes->values;
+        gui_->debugWrite(fmt::format(
+            "frame p50 {:.2f} ms, p99 {:.2f} ms, max {:.2f} ms, up to {} ticks/frame\n",
+            v.percentile(50) / 1000.0, v.percentile(99) / 1000.0, v.max() / 1000.0, limax));
+    }
 
     rendertime_ = std::chrono::high_resolution_clock::now();
     bool player = true;
@@ -235,14 +250,24 @@ bool Game::runLoop()
     auto logicstart = std::chrono::high_resolution_clock::now();
 
     while (logicTime >= LOGIC_DELTA) {
+        auto tickstart = std::chrono::high_resolution_clock::now();
         this->runLogic();
+        telemetry_.recordTime(
+            "tick", std::chrono::duration<double, std::milli>(
+                        std::chrono::high_resolution_clock::now() - tickstart)
+                        .count());
+
         logicTime -= LOGIC_DELTA;
         li++;
         gctx.tick++;
+        LoggerService::getLogger()->setTick(gctx.tick);
     }
     logictime_ = std::chrono::high_resolution_clock::now() - logicstart;
 
-    if (frame_ > 1) limax = std::max(li, limax);
+    if (frame_ > 1) {
+        limax = std::max(li, limax);
+        telemetry_.recordCount("logic/catch-up", li);
+    }
 
     auto drawstart = std::chrono::high_resolution_clock::now();
 
@@ -270,6 +295,7 @@ bool Game::runLoop()
 
     // Locked in ~120 fps
     if (renderdelta.count() < (1000.0 / FPS_LOCK)) {
+        PROFILE_ZONE("frame/sleep");
         auto sleepdelta = (1000.0 / FPS_LOCK) - 5;
         SDL_Delay(unsigned(sleepdelta));
     }
@@ -278,6 +304,14 @@ bool Game::runLoop()
     // because usually the first frame is when we load things, and
     // its the slowest.
 
+    if (frame_ > 2) {
+        telemetry_.recordTime("frame", delta.count());
+        telemetry_.recordTime("input", inputtime_.count());
+        telemetry_.recordTime("logic", logictime_.count());
+        telemetry_.recordTime("draw", drawtime_.count());
+    }
+    telemetry_.update();
+
     if (delta.count() > 0) {
         if (delta.count() < mindelta && frame_ > 2) mindelta = delta.count();
 
@@ -295,18 +329,32 @@ bool Game::runLoop()
 int inputruns = 0;
 bool Game::runInput()
 {
+    PROFILE_ZONE("input");
+
     /* Input processing  */
 
-    input::InputService::getInputManager()->processEvents();
+    {
+        PROFILE_ZONE("input/events");
+        input::InputService::getInputManager()->processEvents();
+    }
 
-    ip_->UpdateIntersectedObject();
-    ip_->UpdateTerrainProjectedPosition();
+    {
+        PROFILE_ZONE("input/picking");
+        ip_->UpdateIntersectedObject();
+        ip_->UpdateTerrainProjectedPosition();
+    }
 
     gctx.elapsed_seconds = INPUT_DELTA / 1000.0;
 
-    pm_->generateInput();
+    {
+        PROFILE_ZONE("input/players");
+        pm_->generateInput();
+    }
 
-    gui_->update();
+    {
+        PROFILE_ZONE("input/gui");
+        gui_->update();
+    }
 
     inputruns++;
     return !pm_->exitRequested();
@@ -314,53 +362,105 @@ bool Game::runInput()
 
 void Game::runLogic()
 {
+    PROFILE_ZONE("logic");
+
     if (irepr_) {
+        PROFILE_ZONE("logic/replay");
         irepr_->dispatchEvents((1000 / LOGIC_DELTA));
     }
 
-    pm_->run(gctx);
-    olm_->update();
+    {
+        PROFILE_ZONE("logic/players");
+        pm_->run(gctx);
+    }
+
+    {
+        PROFILE_ZONE("logic/lifecycle");
+        olm_->update();
+    }
 
     //    LogicService::getObjectListener()->updateObjects();
 
     /* Logic & graphical processing */
     // terr_rend->Update();
-    om_->update();
+    {
+        PROFILE_ZONE("logic/objects");
+        om_->update();
+    }
+
+    {
+        PROFILE_ZONE("logic/actions");
+        auto& aq = LogicService::getActionQueue();
+        telemetry_.recordCount("events", aq->pendingEvents());
+        aq->processEvents();
+    }
+
+    {
+        PROFILE_ZONE("logic/attacks");
+        LogicService::getAttackManager()->update(
+            *om_.get(), *olm_.get(), &LogicService::getPathManager()->getSpatialIndex());
+    }
 
-    LogicService::getActionQueue()->processEvents();
+    {
+        PROFILE_ZONE("logic/paths");
+        LogicService::getPathManager()->update(*om_.get());
+    }
 
-    LogicService::getAttackManager()->update(*om_.get(), *olm_.get());
-    LogicService::getPathManager()->update(*om_.get());
+    if (ta_) {
+        PROFILE_ZONE("logic/targets");
+        auto& pm = LogicService::getPathManager();
+        ta_->update(
+            *om_.get(), pm->getSpatialIndex(), *pm.get(), *LogicService::getAttackManager().get());
+    }
 
     bool objupdate = objrend_->willUpdate();
     if (objupdate) {
-        objrend_->update();
+        PROFILE_ZONE("logic/object-renderer");
+        objrend_->update(*om_.get());
         auto [w, h] = terrain_->getSize();
     }
 
     LogicService::getDebugDrawer()->update();
+
+    telemetry_.recordCount("objects", om_->size());
+    telemetry_.recordCount("paths", LogicService::getPathManager()->getPathCount());
+    telemetry_.recordCount("attacks", LogicService::getAttackManager()->attackCount());
 }
 
 ObjectManager* Game::getObjectManager() const { return om_.get(); }
 
 void Game::runGraphical(double framems)
 {
+    PROFILE_ZONE("graphics");
+
     /* Rendering */
 
     fb3D_->startDraw();
-    terr_rend_->render(*rndr_);
-
-    scenernd_->update(framems);
+    {
+        PROFILE_ZONE("graphics/terrain");
+        terr_rend_->render(*rndr_);
+    }
 
-    rndr_->render(camera_.get());
+    {
+        PROFILE_ZONE("graphics/scene");
+        scenernd_->update(framems);
+        rndr_->render(camera_.get());
+        telemetry_.recordCount("draw-calls", rndr_->getDrawCalls());
+    }
 
     fb3D_->endDraw();
 
-    fbGUI_->startDraw();
-    gui_->render();
-    fbGUI_->endDraw();
+    {
+        PROFILE_ZONE("graphics/gui");
+        fbGUI_->startDraw();
+        gui_->render();
+        fbGUI_->endDraw();
+    }
 
-    window_->update();
+    {
+        PROFILE_ZONE("graphics/present");
+        window_->update();
+    }
 }
 
 /* Show on-screen debug info
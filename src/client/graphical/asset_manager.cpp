@@ -8,6 +8,7 @@
 #include <client/graphical/meshopener/OBJOpener.hpp>
 #include <client/graphical/texture_asset.hpp>
 #include <common/logger.hpp>
+#include <common/profiler.hpp>
 #include <iterator>  // for std::back_inserter
 
 using namespace familyline;
@@ -181,6 +182,8 @@ Asset AssetManager::processAsset(AssetItem& av)
  */
 void AssetManager::loadFile(AssetFile& file)
 {
+    PROFILE_ZONE("assets/load");
+
     auto& log = LoggerService::getLogger();
 
     file.resetAsset();
@@ -37,8 +37,20 @@ void ObjectRenderer::remove(object_id_t id)
 
 #include <client/graphical/terrain_renderer.hpp>
 
-void ObjectRenderer::update()
+void ObjectRenderer::update(familyline::logic::ObjectManager& om)
 {
+    // Only move the meshes of the objects that moved since the last frame
+    auto& packed  = om.components();
+    auto& moved   = packed.moved();
+    auto& objects = packed.objects();
+    for (size_t i = 0; i < moved.size(); i++) {
+        if (!moved[i]) continue;
+
+        auto& location = objects[i]->getLocationComponent();
+        if (location && location->mesh) location->updateMesh(_terrain);
+    }
+    packed.clearMoved();
+
     std::vector<object_id_t> expired;
 
     for (auto& l : this->components) {
@@ -76,8 +88,6 @@ void ObjectRenderer::update()
             glm::vec3 halfsize = glm::vec3(comp->getSize().x / 2, 0, comp->getSize().y / 2);
             LogicService::getDebugDrawer()->drawSquare(
                 pstart - halfsize, pend + halfsize, glm::vec4(0.1, 0, 1, 1), glm::vec4(0, 0, 0, 0));
-
-            comp->getLocationComponent()->updateMesh(_terrain);
         }
     }
 
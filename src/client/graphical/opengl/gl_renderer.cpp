@@ -66,6 +66,7 @@ void GLRenderer::render(Camera* c)
     auto& log           = LoggerService::getLogger();
 
     this->runHooks(c);
+    draw_calls_ = 0;
 
     auto viewMatrix = c->GetViewMatrix();
     auto projMatrix = c->GetProjectionMatrix();
@@ -177,6 +178,7 @@ void GLRenderer::render(Camera* c)
         auto glFormat =
             vh->vinfo.renderStyle == VertexRenderStyle::Triangles ? GL_TRIANGLES : GL_LINE_STRIP;
         glDrawArrays(glFormat, 0, vh->vsize);
+        draw_calls_++;
         GLenum err = glGetError();
         if (err != GL_NO_ERROR) {
             log->write("gl-renderer", LogType::Error, "OpenGL error 0x{:x}", err);
@@ -136,52 +136,32 @@ void InputPicker::UpdateIntersectedObject()
     glm::vec3 direction = this->GetCursorWorldRay();
     glm::vec3 origin = _cam->GetPosition();
 
+    // Update our copy of the object list with what changed since the last time
     const auto& olist = familyline::logic::LogicService::getObjectListener();
-
-    std::set<object_id_t> toAdd;
-    std::set<object_id_t> toRemove;
-
-    std::map<object_id_t, bool> aliveMap;
-    auto aliveObjects = olist->getAliveObjects();
-    for (auto obj : this->poi_list) {
-        // Stored object is still alive
-        if (aliveObjects.find(obj.ID) != aliveObjects.end()) {
-            aliveMap[obj.ID] = true;
-        }
-
-        // Stored object is not alive anymore
-        if (aliveObjects.find(obj.ID) == aliveObjects.end()) {
-            aliveMap[obj.ID] = false;
-            toRemove.insert(obj.ID);
-        }
-    }
-
-    for (auto objid : aliveObjects) {
-        // We have a new stored object
-        if (aliveMap.find(objid) == aliveMap.end()) {
-            toAdd.insert(objid);
+    if (auto changes = olist->getChangesSince(poi_version_); changes) {
+        for (auto& c : *changes) {
+            if (c.alive)
+                this->AddPickerObject(c.id);
+            else
+                poi_list.erase(c.id);
         }
+    } else {
+        poi_list.clear();
+        for (auto objid : olist->getAliveObjects()) this->AddPickerObject(objid);
     }
+    poi_version_ = olist->getVersion();
 
-    for (auto objid : toRemove) {
-        poi_list.erase(std::remove_if(
-            poi_list.begin(), poi_list.end(),
-            [&](const PickerObjectInfo& poi) { return poi.ID == objid; }));
-    }
-
-    for (auto objid : toAdd) {
-        auto object = _om->get(objid).value();
-
-        if (!object->getLocationComponent()) {
-            continue;
-        }
-
-        auto mesh = object->getLocationComponent()->mesh;
-        poi_list.emplace_back(object->getPosition(), std::dynamic_pointer_cast<Mesh>(mesh), objid);
-    }
+    // Only the objects near the point where the cursor touches the terrain can be
+    // under it, so we only check those.
+    auto nearby = LogicService::getPathManager()->getSpatialIndex().queryRadius(
+        this->GetGameProjectedPosition(), PICK_RADIUS);
 
     // Check the existing objects
-    for (const PickerObjectInfo& poi : poi_list) {
+    for (auto id : nearby) {
+        auto it = poi_list.find(id);
+        if (it == poi_list.end()) continue;
+
+        const PickerObjectInfo& poi = it->second;
         auto obj = _om->get(poi.ID);
         if (!obj)
             continue;
@@ -262,6 +242,20 @@ void InputPicker::UpdateIntersectedObject()
     _locatableObject = std::weak_ptr<GameObject>();
 }
 
+/*  Add an object to the list of objects we can pick, if it has
+    something we can see */
+void InputPicker::AddPickerObject(object_id_t id)
+{
+    auto object = _om->get(id);
+    if (!object || !(*object)->getLocationComponent()) {
+        return;
+    }
+
+    auto mesh = (*object)->getLocationComponent()->mesh;
+    poi_list.insert_or_assign(
+        id, PickerObjectInfo((*object)->getPosition(), std::dynamic_pointer_cast<Mesh>(mesh), id));
+}
+
 /*  Get position where the cursor collides with the
     terrain, in render coordinates */
 glm::vec3 InputPicker::GetTerrainProjectedPosition()
@@ -132,7 +132,8 @@ std::optional<PlayerCommand> parseInputCommand(std::string command)
         {"CameraRotate", PlayerCommandType::CameraRotate},
         {"DebugCreateEntity", PlayerCommandType::DebugCreateEntity},
         {"DebugDestroyEntity", PlayerCommandType::DebugDestroyEntity},
-        {"DebugShowBoundingBox", PlayerCommandType::DebugShowBoundingBox}};
+        {"DebugShowBoundingBox", PlayerCommandType::DebugShowBoundingBox},
+        {"DebugToggleProfiler", PlayerCommandType::DebugToggleProfiler}};
 
     if (command_map.contains(strcommand))
         return std::make_optional(std::make_tuple(command_map[strcommand], strparam));
@@ -18,6 +18,12 @@ static void show_help()
     fmt::print(
         "  --log [<filename>|screen]:\n\tLogs to filename 'filename', or screen to log to screen, or\n"
         "  \twherever stderr is bound to\n\n");
+    fmt::print(
+        "  --profile <filename>:\n\tCapture the profiler zones, and write them to 'filename' at\n"
+        "  \texit, in the Chrome trace format. Press P to start and stop a capture in game\n\n");
+    fmt::print(
+        "  --telemetry <filename>:\n\tExport the frame and tick time histograms to 'filename', as\n"
+        "  \tJSON if it ends with .json, or CSV otherwise\n\n");
 }
 
 
@@ -105,6 +111,8 @@ ParamInfo parse_params(const std::vector<std::string>& params)
     bool next_is_file = false;
     bool next_is_input = false;
     bool next_is_server = false;
+    bool next_is_profile = false;
+    bool next_is_telemetry = false;
     
     for (auto& p : params) {
         ////// parse values
@@ -140,6 +148,17 @@ ParamInfo parse_params(const std::vector<std::string>& params)
             continue;
         }
 
+        if (next_is_profile) {
+            pi.profileFile = p;
+            next_is_profile = false;
+            continue;
+        }
+
+        if (next_is_telemetry) {
+            pi.telemetryFile = p;
+            next_is_telemetry = false;
+            continue;
+        }
 
         ////// parse params
 
@@ -178,6 +197,16 @@ ParamInfo parse_params(const std::vector<std::string>& params)
             continue;
         }
 
+        if (p == "--profile") {
+            next_is_profile = true;
+            continue;
+        }
+
+        if (p == "--telemetry") {
+            next_is_telemetry = true;
+            continue;
+        }
+
 
         fmt::print("\t param: {}\n", p);
     }
@@ -204,6 +233,16 @@ ParamInfo parse_params(const std::vector<std::string>& params)
         exit(1);
     }
 
+    if (next_is_profile) {
+        fmt::print("Expected a profiler trace file name\n");
+        exit(1);
+    }
+
+    if (next_is_telemetry) {
+        fmt::print("Expected a telemetry file name\n");
+        exit(1);
+    }
+
     pi.devices = get_device_list(pi.renderer);
     
     return pi;
@@ -0,0 +1,148 @@
+#include <chrono>
+#include <common/binary_log.hpp>
+
+using namespace familyline;
+using namespace std::chrono;
+
+/// Size of the buffer we keep before writing to the file
+constexpr size_t BufferSize = 64 * 1024;
+
+BinaryLogWriter::BinaryLogWriter(
+    std::filesystem::path path, size_t max_file_size, unsigned max_files)
+    : path_(path), max_file_size_(max_file_size), max_files_(std::max(max_files, 1u))
+{
+    out_.buffer().reserve(BufferSize * 2);
+}
+
+BinaryLogWriter::~BinaryLogWriter()
+{
+    this->flush();
+    if (file_) fclose(file_);
+}
+
+bool BinaryLogWriter::open()
+{
+    if (file_) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+
+    // Rotate the old files: <path>.1 becomes <path>.2, and so on. The oldest one
+    // is overwritten.
+    std::error_code ec;
+    for (auto i = max_files_ - 1; i > 0; i--) {
+        auto from = i == 1 ? path_ : this->rotatedPath(i - 1);
+        auto to   = this->rotatedPath(i);
+        if (std::filesystem::exists(from, ec)) std::filesystem::rename(from, to, ec);
+    }
+
+    file_ = fopen(path_.string().c_str(), "wb");
+    if (!file_) return false;
+
+    auto now = duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+
+    BinaryLogEncoder header;
+    header.buffer().append("FLOG");
+    header.putRaw<uint32_t>(binlog::Version);
+    header.putRaw<uint64_t>(now);
+    fwrite(header.buffer().data(), 1, header.buffer().size(), file_);
+
+    file_size_ = header.buffer().size();
+    bytes_written_ += file_size_;
+
+    // The new file does not have any of the tables
+    formats_.clear();
+    tags_.clear();
+    last_tick_ = 0;
+    last_time_ = 0;
+    return true;
+}
+
+std::filesystem::path BinaryLogWriter::rotatedPath(unsigned i) const
+{
+    return std::filesystem::path{fmt::format("{}.{}", path_.string(), i)};
+}
+
+uint32_t BinaryLogWriter::formatID(std::string_view fmt)
+{
+    if (auto it = formats_.find(fmt.data()); it != formats_.end()) return it->second;
+
+    uint32_t id          = formats_.size();
+    formats_[fmt.data()] = id;
+
+    out_.putByte(binlog::EntryFormat);
+    out_.putVarint(id);
+    out_.putString(fmt);
+    return id;
+}
+
+BinaryLogEncoder& BinaryLogWriter::beginMessage(
+    std::string_view fmt, uint32_t tag, std::string_view tagname, uint8_t level, uint64_t tick,
+    double delta)
+{
+    message_.fmt     = fmt;
+    message_.tag     = tag;
+    message_.tagname = tagname;
+    message_.level   = level;
+    message_.tick    = tick;
+    message_.time    = int64_t(delta * 1000000);
+
+    args_.buffer().clear();
+    return args_;
+}
+
+void BinaryLogWriter::endMessage(bool native)
+{
+    if (!file_) return;
+
+    // The "{}" format is registered on each file, before any other, so it is
+    // always the ID 0
+    if (formats_.empty()) this->formatID("{}");
+    auto fmtid = native ? this->formatID(message_.fmt) : binlog::PreformattedID;
+
+    if (message_.tag >= tags_.size()) tags_.resize(message_.tag + 1, false);
+    if (!tags_[message_.tag]) {
+        out_.putByte(binlog::EntryTag);
+        out_.putVarint(message_.tag);
+        out_.putString(message_.tagname);
+        tags_[message_.tag] = true;
+    }
+
+    out_.putByte(binlog::EntryMessage + message_.level);
+    out_.putVarint(fmtid);
+    out_.putVarint(message_.tag);
+    out_.putSigned(int64_t(message_.tick - last_tick_));
+    out_.putSigned(message_.time - last_time_);
+    out_.buffer().append(args_.buffer());
+
+    last_tick_ = message_.tick;
+    last_time_ = message_.time;
+
+    if (out_.buffer().size() >= BufferSize) this->flush();
+}
+
+void BinaryLogWriter::writeLost(uint64_t count)
+{
+    if (!file_) return;
+
+    out_.putByte(binlog::EntryLost);
+    out_.putVarint(count);
+}
+
+void BinaryLogWriter::flush()
+{
+    auto& buf = out_.buffer();
+    if (!file_ || buf.empty()) {
+        buf.clear();
+        return;
+    }
+
+    fwrite(buf.data(), 1, buf.size(), file_);
+    fflush(file_);
+
+    file_size_ += buf.size();
+    bytes_written_ += buf.size();
+    buf.clear();
+
+    if (file_size_ >= max_file_size_) this->open();
+}
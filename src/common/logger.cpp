@@ -1,12 +1,395 @@
 #include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <common/logger.hpp>
 #include <cstdarg>
+#include <iterator>
 
 using namespace familyline;
 using namespace std::chrono;
 
 std::unique_ptr<Logger> LoggerService::_logger;
 
+namespace familyline
+{
+/**
+ * A ring buffer of log records, written by one thread and read by the logger
+ * thread
+ *
+ * Only the writer changes the tail, and only the reader changes the head, so we
+ * do not need any lock.
+ */
+class LogRing
+{
+public:
+    explicit LogRing(size_t capacity)
+        : records_(std::make_unique<LogRecord[]>(capacity)), capacity_(capacity)
+    {
+        assert((capacity & (capacity - 1)) == 0);
+    }
+
+    /**
+     * Get the next free record, or nullptr if the ring is full
+     */
+    LogRecord* beginWrite()
+    {
+        auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= capacity_) return nullptr;
+
+        return &records_[tail & (capacity_ - 1)];
+    }
+
+    /**
+     * Count a message that did not fit in the ring
+     */
+    void drop() { dropped_.fetch_add(1, std::memory_order_relaxed); }
+
+    void endWrite()
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    size_t pending() const
+    {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * Add the records written until now to `out`, in order
+     *
+     * They stay in the ring, and the writer cannot reuse them, until we call
+     * release(). Returns how many were added.
+     */
+    size_t peek(std::vector<LogRecord*>& out)
+    {
+        auto head = head_.load(std::memory_order_relaxed);
+        auto tail = tail_.load(std::memory_order_acquire);
+
+        for (auto i = head; i != tail; i++) out.push_back(&records_[i & (capacity_ - 1)]);
+        return tail - head;
+    }
+
+    /**
+     * Free the first `count` records
+     */
+    void release(size_t count)
+    {
+        head_.store(head_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    /**
+     * Get the number of messages dropped since the last call
+     */
+    uint64_t takeDropped() { return dropped_.exchange(0, std::memory_order_relaxed); }
+
+private:
+    std::unique_ptr<LogRecord[]> records_;
+    size_t capacity_;
+
+    std::atomic<size_t> head_ = 0;
+    std::atomic<size_t> tail_ = 0;
+    std::atomic<uint64_t> dropped_ = 0;
+};
+
+}  // namespace familyline
+
+LogTagRegistry::LogTagRegistry()
+{
+    for (auto& slot : slots_) slot.store(0, std::memory_order_relaxed);
+
+    names_[OverflowTag] = "(other)";
+}
+
+LogTagRegistry& LogTagRegistry::get()
+{
+    static LogTagRegistry registry;
+    return registry;
+}
+
+/**
+ * FNV-1a hash of the tag name
+ */
+uint64_t LogTagRegistry::hash(std::string_view name)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (unsigned char c : name) {
+        hash ^= c;
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+uint32_t LogTagRegistry::intern(std::string_view name)
+{
+    auto h = hash(name);
+
+    // Find the tag, or the free slot where it would be.
+    //
+    // The name and the hash of a tag are written before its slot, so, if we see
+    // the slot, we can read them without locking.
+    auto probe = [&](size_t& i) -> std::optional<uint32_t> {
+        for (i = h & (TableSize - 1);; i = (i + 1) & (TableSize - 1)) {
+            auto slot = slots_[i].load(std::memory_order_acquire);
+            if (slot == 0) return std::nullopt;
+
+            auto id = slot - 1;
+            if (hashes_[id] == h && names_[id] == name) return std::make_optional(id);
+        }
+    };
+
+    size_t free = 0;
+    if (auto id = probe(free)) return *id;
+
+    std::lock_guard lock(mtx_);
+
+    // Someone might have registered it while we waited for the lock
+    if (auto id = probe(free)) return *id;
+
+    if (count_ >= OverflowTag) return OverflowTag;
+
+    auto id     = count_++;
+    hashes_[id] = h;
+    names_[id]  = std::string{name};
+    slots_[free].store(id + 1, std::memory_order_release);
+    return id;
+}
+
+/// The ring of the current thread, and the logger that owns it
+struct ThreadRing {
+    uint64_t logger = 0;
+    std::shared_ptr<LogRing> ring;
+};
+
+static thread_local ThreadRing current_ring;
+static std::atomic<uint64_t> next_logger_id = 1;
+
+Logger::Logger(FILE* out, LogType minlog, std::vector<std::string> blockTags, size_t ring_capacity)
+    : _out(out),
+      minlog_(minlog),
+      min_level_(minlog),
+      _start(steady_clock::now()),
+      id_(next_logger_id++),
+      ring_capacity_(ring_capacity)
+{
+    for (auto& level : tag_levels_) level.store(TagUnresolved, std::memory_order_relaxed);
+    for (auto& tag : blockTags) this->disableTag(tag);
+
+    thread_ = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger()
+{
+    {
+        std::lock_guard lock(wake_mtx_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+
+    this->drain();
+}
+
+uint8_t Logger::resolveTag(uint32_t id)
+{
+    std::lock_guard lock(tag_config_mtx_);
+
+    auto name  = LogTagRegistry::get().name(id);
+    auto it    = std::find_if(tag_config_.begin(), tag_config_.end(), [&](auto& c) {
+        return c.first == name;
+    });
+    auto level = it != tag_config_.end() ? it->second : uint8_t(minlog_);
+
+    tag_levels_[id].store(level, std::memory_order_relaxed);
+    return level;
+}
+
+void Logger::setTagConfig(std::string_view tag, uint8_t level)
+{
+    std::lock_guard lock(tag_config_mtx_);
+
+    auto it = std::find_if(
+        tag_config_.begin(), tag_config_.end(), [&](auto& c) { return c.first == tag; });
+    if (it != tag_config_.end())
+        it->second = level;
+    else
+        tag_config_.emplace_back(std::string{tag}, level);
+
+    tag_levels_[LogTag{tag}.id()].store(level, std::memory_order_relaxed);
+
+    uint8_t minlevel = minlog_;
+    for (auto& [_, l] : tag_config_) minlevel = std::min(minlevel, l);
+    min_level_.store(minlevel, std::memory_order_relaxed);
+}
+
+LogRecord* Logger::beginRecord(LogType type)
+{
+    if (current_ring.logger != id_) {
+        auto ring = std::make_shared<LogRing>(ring_capacity_);
+        {
+            std::lock_guard lock(rings_mtx_);
+            rings_.push_back(ring);
+        }
+
+        current_ring = ThreadRing{id_, ring};
+    }
+
+    auto* r = current_ring.ring->beginWrite();
+    if (!r && type != LogType::Fatal) current_ring.ring->drop();
+
+    return r;
+}
+
+void Logger::endRecord(LogType type)
+{
+    auto& ring = *current_ring.ring;
+    ring.endWrite();
+
+    if (type == LogType::Fatal) {
+        this->flush();
+        return;
+    }
+
+    // Do not wait for the next wakeup if the ring is getting full
+    if (ring.pending() > ring.capacity() / 2) wake_.notify_one();
+}
+
+void Logger::run()
+{
+    std::unique_lock lock(wake_mtx_);
+    while (!stop_) {
+        wake_.wait_for(lock, 10ms);
+
+        lock.unlock();
+        this->drain();
+        lock.lock();
+    }
+}
+
+void Logger::drain()
+{
+    std::lock_guard lock(drain_mtx_);
+
+    std::vector<std::shared_ptr<LogRing>> rings;
+    {
+        std::lock_guard rlock(rings_mtx_);
+
+        // Forget the rings of the threads that finished
+        rings_.erase(
+            std::remove_if(
+                rings_.begin(), rings_.end(),
+                [](auto& r) { return r.use_count() == 1 && r->pending() == 0; }),
+            rings_.end());
+        rings = rings_;
+    }
+
+    records_.clear();
+    text_.clear();
+
+    std::vector<size_t> counts(rings.size());
+    uint64_t dropped = 0;
+    for (size_t i = 0; i < rings.size(); i++) {
+        dropped += rings[i]->takeDropped();
+        counts[i] = rings[i]->peek(records_);
+    }
+
+    // Each ring is in order, but we need to interleave the messages of the
+    // different threads
+    std::stable_sort(records_.begin(), records_.end(), [](auto* a, auto* b) {
+        return a->delta < b->delta;
+    });
+
+    std::string data;
+    for (auto* r : records_) {
+        auto tag = LogTagRegistry::get().name(r->tag);
+
+        if (_out) {
+            r->format(*r, data);
+            this->appendLine(text_, r->delta, r->type, tag, data);
+        }
+
+        if (binary_) {
+            auto& args = binary_->beginMessage(r->fmt, r->tag, tag, r->type, r->tick, r->delta);
+            binary_->endMessage(r->encode(*r, args));
+        }
+
+        r->destroy(*r);
+    }
+
+    for (size_t i = 0; i < rings.size(); i++) rings[i]->release(counts[i]);
+
+    if (dropped > 0) {
+        dropped_ += dropped;
+
+        if (_out)
+            this->appendLine(
+                text_, this->getDelta(), LogType::Warning, "logger",
+                fmt::format("{} messages were lost, because the log was full", dropped));
+        if (binary_) binary_->writeLost(dropped);
+    }
+
+    if (_out && !text_.empty()) {
+        fwrite(text_.data(), 1, text_.size(), _out);
+        fflush(_out);
+    }
+
+    if (binary_) binary_->flush();
+}
+
+void Logger::writeNow(const LogTag& tag, LogType type, const std::string& message)
+{
+    // Write what the rings have first, so the messages stay in order
+    this->drain();
+
+    std::lock_guard lock(drain_mtx_);
+    auto delta = this->getDelta();
+    auto name  = tag.name();
+
+    if (_out) {
+        std::string line;
+        this->appendLine(line, delta, type, name, message);
+        fwrite(line.data(), 1, line.size(), _out);
+        fflush(_out);
+    }
+
+    if (binary_) {
+        auto& args = binary_->beginMessage(
+            "{}", tag.id(), name, type, tick_.load(std::memory_order_relaxed), delta);
+        binary_->endMessage(args.putArgs("{}", message));
+        binary_->flush();
+    }
+}
+
+void Logger::setBinarySink(std::unique_ptr<BinaryLogWriter> sink)
+{
+    this->drain();
+
+    std::lock_guard lock(drain_mtx_);
+    binary_ = std::move(sink);
+}
+
+void Logger::flush() { this->drain(); }
+
+uint64_t Logger::getDroppedCount()
+{
+    this->drain();
+
+    std::lock_guard lock(drain_mtx_);
+    return dropped_;
+}
+
+void Logger::appendLine(
+    std::string& out, double delta, LogType type, std::string_view tag, std::string_view data)
+{
+    auto strtype = this->getLevelText(type);
+    auto strend  = strtype.size() > 0 ? "\033[0m" : "";
+
+    fmt::format_to(std::back_inserter(out), "[{:13.4f}] {}", delta, strtype);
+    if (tag.size() > 0) fmt::format_to(std::back_inserter(out), "\033[1m{}\033[0m: ", tag);
+    fmt::format_to(std::back_inserter(out), "{}{}\n", data, strend);
+}
+
 const std::string Logger::getLevelText(const LogType type)
 {
     switch (type) {
@@ -8,10 +8,20 @@
 
 using namespace familyline::logic;
 
+static const familyline::LogTag log_tag{"action-queue"};
+
+ActionQueue::ActionQueue(size_t capacity)
+{
+    size_t size = 1;
+    while (size < capacity) size *= 2;
+
+    events.resize(size);
+}
+
 void ActionQueue::addEmitter(EventEmitter* e)
 {
     auto& log = LoggerService::getLogger();
-    log->write("action-queue", LogType::Debug, "added event emitter {}", e->getName());
+    log->write(log_tag, LogType::Debug, "added event emitter {}", e->getName());
     e->queue = this;
 }
 
@@ -21,20 +31,73 @@ void ActionQueue::addReceiver(std::string name, EventReceiver r,
     assert(r);
     auto& log = LoggerService::getLogger();
     
-    log->write("action-queue", LogType::Debug, "added event receiver {}", name);
+    log->write(log_tag, LogType::Debug, "added event receiver {}", name);
+
+    if (dispatching) {
+        pending_changes.emplace_back(ReceiverData{name, r, events});
+        return;
+    }
 
     this->receivers.emplace_back(name, r, events);
+    this->rebuildDispatch();
 }
 
 void ActionQueue::removeReceiver(std::string name)
 {
     auto& log = LoggerService::getLogger();
+    log->write(log_tag, LogType::Debug, "removed event receiver {}", name);
+
+    if (dispatching) {
+        pending_changes.emplace_back(name);
+        return;
+    }
 
-    auto newend = std::remove_if(receivers.begin(), receivers.end(), [name](ReceiverData rec) {
+    auto newend = std::remove_if(receivers.begin(), receivers.end(), [&](const ReceiverData& rec) {
         return (rec.name == name);
     });
-    log->write("action-queue", LogType::Debug, "removed event receiver {}", name);
     receivers.erase(newend, receivers.end());
+    this->rebuildDispatch();
+}
+
+/**
+ * Apply the receiver additions and removals requested while an event was
+ * being delivered, in the order they were requested
+ */
+void ActionQueue::applyPendingChanges()
+{
+    for (auto& change : pending_changes) {
+        if (auto* rec = std::get_if<ReceiverData>(&change)) {
+            receivers.push_back(std::move(*rec));
+        } else {
+            auto& name  = std::get<std::string>(change);
+            auto newend = std::remove_if(
+                receivers.begin(), receivers.end(),
+                [&](const ReceiverData& rec) { return (rec.name == name); });
+            receivers.erase(newend, receivers.end());
+        }
+    }
+
+    pending_changes.clear();
+    this->rebuildDispatch();
+}
+
+/**
+ * Rebuild the list of receivers of each event type
+ *
+ * Receivers are rarely added or removed, so we do not mind doing it from
+ * scratch.
+ */
+void ActionQueue::rebuildDispatch()
+{
+    for (auto& d : dispatch) d.clear();
+
+    for (auto& rec : receivers) {
+        for (auto type : rec.events) {
+            auto& d = dispatch[type];
+            if (std::find(d.begin(), d.end(), &rec.receiver) == d.end())
+                d.push_back(&rec.receiver);
+        }
+    }
 }
 
 void ActionQueue::removeEmitter(EventEmitter* e) { e->queue = nullptr; }
@@ -48,7 +111,7 @@ struct overload : Ts... {
 template <class... Ts>
 overload(Ts...) -> overload<Ts...>;
 
-void ActionQueue::pushEvent(const EntityEvent& ev)
+void ActionQueue::logEvent(const EntityEvent& ev)
 {
     std::string begin = fmt::format(
         "timestamp={}, source={}", ev.timestamp,
@@ -59,27 +122,27 @@ void ActionQueue::pushEvent(const EntityEvent& ev)
         overload{
             [&](const EventCreated& e) {
                 log->write(
-                    "action-queue", LogType::Info, "event added: EventCreated ({}, objectID={})",
+                    log_tag, LogType::Debug, "event added: EventCreated ({}, objectID={})",
                     begin, e.objectID);
             },
             [&](const EventBuilding& e) {
                 log->write(
-                    "action-queue", LogType::Info, "event added: EventBuilding ({}, objectID={})",
+                    log_tag, LogType::Debug, "event added: EventBuilding ({}, objectID={})",
                     begin, e.objectID);
             },
             [&](const EventBuilt& e) {
                 log->write(
-                    "action-queue", LogType::Info, "event added: EventBuilt ({}, objectID={})",
+                    log_tag, LogType::Debug, "event added: EventBuilt ({}, objectID={})",
                     begin, e.objectID);
             },
             [&](const EventReady& e) {
                 log->write(
-                    "action-queue", LogType::Info, "event added: EventReady ({}, objectID={})",
+                    log_tag, LogType::Debug, "event added: EventReady ({}, objectID={})",
                     begin, e.objectID);
             },
             [&](const EventAttackStart& e) {
                 log->write(
-                    "action-queue", LogType::Info,
+                    log_tag, LogType::Debug,
                     "event added: EventAttackStart ({}, "
                     "attacker(id={}, xpos={}, ypos={}), defender(id={}, xpos={}, ypos={}))",
                     begin, e.attackerID, e.atkXPos, e.atkYPos, e.defenderID, e.defXPos,
@@ -87,7 +150,7 @@ void ActionQueue::pushEvent(const EntityEvent& ev)
             },
             [&](const EventAttackMiss& e) {
                 log->write(
-                    "action-queue", LogType::Info,
+                    log_tag, LogType::Debug,
                     "event added: EventAttackMiss ({}, "
                     "attacker(id={}, xpos={}, ypos={}), defender(id={}, xpos={}, ypos={}))",
                     begin, e.attackerID, e.atkXPos, e.atkYPos, e.defenderID, e.defXPos,
@@ -95,7 +158,7 @@ void ActionQueue::pushEvent(const EntityEvent& ev)
             },
             [&](const EventAttackDone& e) {
                 log->write(
-                    "action-queue", LogType::Info,
+                    log_tag, LogType::Debug,
                     "event added: EventAttackDone ({}, "
                     "attacker(id={}, xpos={}, ypos={}), defender(id={}, xpos={}, ypos={}),"
                     "damageDealt={:.2f})",
@@ -104,7 +167,7 @@ void ActionQueue::pushEvent(const EntityEvent& ev)
             },
             [&](const EventAttacking& e) {
                 log->write(
-                    "action-queue", LogType::Info,
+                    log_tag, LogType::Debug,
                     "event added: EventAttacking ({}, "
                     "attacker(id={}, xpos={}, ypos={}), defender(id={}, xpos={}, ypos={}),"
                     "damageDealt={:.2f})",
@@ -113,55 +176,77 @@ void ActionQueue::pushEvent(const EntityEvent& ev)
             },
             [&](const EventWorking& e) {
                 log->write(
-                    "action-queue", LogType::Info,
+                    log_tag, LogType::Debug,
                     "event added: EventWorking ({}, objectID={},"
                     "atkXPos={}, atkYPos={}",
                     begin, e.objectID, e.atkXPos, e.atkYPos);
             },
             [&](const EventGarrisoned& e) {
                 log->write(
-                    "action-queue", LogType::Info,
+                    log_tag, LogType::Debug,
                     "event added: EventGarrisoned ({}, objectID={},"
                     "parentID={}, entering={}",
                     begin, e.objectID, e.parentID, e.entering ? "true" : "false");
             },
             [&](const EventDying& e) {
                 log->write(
-                    "action-queue", LogType::Info,
+                    log_tag, LogType::Debug,
                     "event added: EventDying ({}, objectID={},"
                     "atkXPos={}, atkYPos={}",
                     begin, e.objectID, e.atkXPos, e.atkYPos);
             },
             [&](const EventDead& e) {
                 log->write(
-                    "action-queue", LogType::Info, "event added: EventDead ({}, objectID={})",
+                    log_tag, LogType::Debug, "event added: EventDead ({}, objectID={})",
                     begin, e.objectID);
             },
             [&](const EventDestroyed& e) {
                 log->write(
-                    "action-queue", LogType::Info,
+                    log_tag, LogType::Debug,
                     "event added: EventDestroyed ({}, objectID={})", begin, e.objectID);
             }},
         ev.type);
+}
 
-    this->events.push(ev);
+/**
+ * Double the size of the ring buffer, keeping the events in order
+ */
+void ActionQueue::growEvents()
+{
+    std::vector<EntityEvent> newevents(events.size() * 2);
+    for (size_t i = 0; i < events_count; i++)
+        newevents[i] = std::move(events[(events_head + i) & (events.size() - 1)]);
+
+    events.swap(newevents);
+    events_head = 0;
 }
 
-void ActionQueue::processEvents()
+void ActionQueue::pushEvent(const EntityEvent& ev)
 {
-    while (!this->events.empty()) {
-        EntityEvent e = this->events.front();
+    // Only build the log message if someone will read it
+    if (LOGENABLED(LoggerService::getLogger(), log_tag, LogType::Debug)) this->logEvent(ev);
 
-        // printf("event %x !\n", e.type);
+    if (events_count == events.size()) this->growEvents();
 
-        for (auto& rec : this->receivers) {
-            if (std::find(rec.events.begin(), rec.events.end(), e.type.index()) !=
-                rec.events.end()) {
-                // printf("\t received by %s\n", rec.receiver->getName().c_str());
-                rec.receiver(e);
-            }
-        }
+    events[(events_head + events_count) & (events.size() - 1)] = ev;
+    events_count++;
+}
 
-        this->events.pop();
+void ActionQueue::processEvents()
+{
+    while (events_count > 0) {
+        // Take the event out before delivering it, because the receivers might
+        // push new events.
+        EntityEvent e = std::move(events[events_head]);
+        events_head   = (events_head + 1) & (events.size() - 1);
+        events_count--;
+
+        // A receiver might add or remove receivers, so the changes wait until
+        // every receiver of this event has been called.
+        dispatching = true;
+        for (auto* r : dispatch[e.type.index()]) (*r)(e);
+        dispatching = false;
+
+        if (!pending_changes.empty()) this->applyPendingChanges();
     }
 }
@@ -76,20 +76,48 @@ void AttackManager::sendAttackMissEvent(const AttackInfo& atk)
     emitter_.pushEvent(ev);
 }
 
-void AttackManager::sendDyingEvent(const AttackInfo& atk)
+void AttackManager::sendDyingEvent(entity_id_t id, glm::vec2 position)
 {
-    auto defpos = atk.defPosition;
-
     EntityEvent ev{
         0,
         EventDying{
-            .objectID = atk.defenderID,
-            .atkXPos  = (unsigned)defpos.x,
-            .atkYPos  = (unsigned)defpos.y},
+            .objectID = id, .atkXPos = (unsigned)position.x, .atkYPos = (unsigned)position.y},
         nullptr};
     emitter_.pushEvent(ev);
 }
 
+void AttackManager::sendImpactEvent(const ProjectileManager::Impact& impact, bool hit)
+{
+    auto& shot  = impact.shot;
+    auto atkpos = shot.origin;
+    auto defpos = impact.position;
+
+    EntityEvent ev{0, EventAttackMiss{}, nullptr};
+    if (hit) {
+        ev.type = EventAttackDone{
+            .attackerID   = shot.attackerID,
+            .defenderID   = shot.defenderID,
+            .attackID     = shot.attackID,
+            .atkXPos      = (unsigned)atkpos.x,
+            .atkYPos      = (unsigned)atkpos.y,
+            .defXPos      = (unsigned)defpos.x,
+            .defYPos      = (unsigned)defpos.y,
+            .atkAttribute = shot.atkAttributes,
+            .damageDealt  = shot.damage};
+    } else {
+        ev.type = EventAttackMiss{
+            .attackerID = shot.attackerID,
+            .defenderID = shot.defenderID,
+            .attackID   = shot.attackID,
+            .atkXPos    = (unsigned)atkpos.x,
+            .atkYPos    = (unsigned)atkpos.y,
+            .defXPos    = (unsigned)defpos.x,
+            .defYPos    = (unsigned)defpos.y};
+    }
+
+    emitter_.pushEvent(ev);
+}
+
 void AttackManager::updateAttackInfo(
     const GameObject& attacker, const GameObject& defender, AttackInfo& atk)
 {
@@ -136,20 +164,141 @@ void AttackManager::countUntilNextAttack(AttackInfo& atk)
     atk.ticks_until_attack += interval;
 }
 
+/**
+ * Shoot the projectiles of a ranged attack, as many as the attack speed
+ * allows in this tick
+ *
+ * The precision is decided now, but the attack is only done (or missed) when
+ * the projectile arrives.
+ */
+void AttackManager::launchProjectiles(AttackInfo& atk, const AttackTypeProjectile& projectile)
+{
+    int attacks = 0;
+
+    // Fix some precision errors that might occur.
+    atk.ticks_until_attack = 0;
+    do {
+        ProjectileManager::Shot shot{
+            .attackerID    = atk.attackerID,
+            .defenderID    = atk.defenderID,
+            .attackID      = atk.attackID,
+            .atkAttributes = atk.atkAttributes,
+            .damage        = atk.damage,
+            .origin        = atk.atkPosition,
+            .precise       = isNextAttackPrecise(atk.atkAttributes.precision),
+        };
+        projectiles_.launch(shot, atk.atkPosition, atk.defPosition, projectile.projectileSpeed);
+
+        attacks++;
+        this->countUntilNextAttack(atk);
+    } while (atk.ticks_until_attack < 1.0);
+
+    atk.total_attacks += attacks;
+}
+
+/**
+ * Damage the defender, if the projectile hit it
+ *
+ * It hits if the shot was precise, and the defender is still alive and where the
+ * projectile landed.
+ */
+void AttackManager::resolveImpact(
+    ObjectManager& om, ObjectLifecycleManager& olm, const SpatialIndex* index,
+    const ProjectileManager::Impact& impact)
+{
+    auto& shot   = impact.shot;
+    auto* defobj = om.getPointer(shot.defenderID);
+
+    bool hit = shot.precise && defobj && defobj->getHealth() > 0;
+    if (hit) {
+        if (index && index->contains(shot.defenderID)) {
+            hit = index->touches(shot.defenderID, impact.position, ProjectileManager::radius);
+        } else {
+            auto pos  = defobj->getPosition();
+            auto dist = glm::max(
+                glm::abs(impact.position - glm::vec2(pos.x, pos.z)) - defobj->getSize() / 2.0f,
+                glm::vec2(0, 0));
+            hit = glm::dot(dist, dist) <= ProjectileManager::radius * ProjectileManager::radius;
+        }
+    }
+
+    this->sendImpactEvent(impact, hit);
+    if (!hit) return;
+
+    if (auto it = attack_index_.find(shot.attackID); it != attack_index_.end())
+        attacks_[it->second].successful_attacks++;
+
+    auto remaining = this->damageObject(*defobj, shot.damage);
+    if (remaining <= 0) {
+        LoggerService::getLogger()->write(
+            "attack-manager", LogType::Info,
+            "attack {} ended because a projectile of the attacker killed the defender "
+            "(atk={}, def={})",
+            shot.attackID, shot.attackerID, shot.defenderID);
+        this->killObject(olm, shot.defenderID, impact.position);
+    }
+}
+
+/**
+ * Kill the object, and cancel all attacks it is part of
+ */
+void AttackManager::killObject(ObjectLifecycleManager& olm, entity_id_t id, glm::vec2 position)
+{
+    this->sendDyingEvent(id, position);
+
+    /// The lifecycle manager will delete the entity for us,
+    /// but we will have to sent the dying event.
+    /// TODO: change this, the lifecycle manager will listen to
+    ///       this event.
+    olm.notifyDeath(id);
+
+    /// Nobody can attack a dead entity, and it cannot attack
+    /// anybody anymore.
+    this->cancelAttacksOf(id);
+}
+
+/**
+ * Refresh the attributes and the damage of the attack, if the components
+ * of the participants changed their attributes
+ *
+ * The attributes we got from the event are the ones from when the attack started,
+ * so, the first time, we only take note of the versions.
+ */
+void AttackManager::refreshAttributes(
+    const AttackComponent& atkc, const AttackComponent& defc, AttackInfo& atk)
+{
+    if (atk.versionsKnown && atk.atkVersion == atkc.attributesVersion() &&
+        atk.defVersion == defc.attributesVersion())
+        return;
+
+    if (atk.versionsKnown) {
+        atk.atkAttributes = atkc.attributes();
+        atk.defAttributes = defc.attributes();
+        atk.damage        = AttackComponent::calculateDamage(atk.atkAttributes, atk.defAttributes);
+    }
+
+    atk.atkVersion    = atkc.attributesVersion();
+    atk.defVersion    = defc.attributesVersion();
+    atk.versionsKnown = true;
+}
+
 /**
  * Do the damage, update the projectile positions and other multiple things
  *
  * Runs once per tick
  */
-void AttackManager::update(ObjectManager& om, ObjectLifecycleManager& olm)
+void AttackManager::update(
+    ObjectManager& om, ObjectLifecycleManager& olm, const SpatialIndex* index)
 {
-    std::vector<uint64_t> attacks_to_remove;
     auto& log = LoggerService::getLogger();
 
-    //    printf("%zu attacks\n", attacks_.size());
+    for (auto& impact : projectiles_.update()) this->resolveImpact(om, olm, index, impact);
+
     for (auto& atk : attacks_) {
-        auto atkobj = om.get(atk.attackerID);
-        auto defobj = om.get(atk.defenderID);
+        if (atk.removed) continue;
+
+        auto* atkobj = om.getPointer(atk.attackerID);
+        auto* defobj = om.getPointer(atk.defenderID);
 
         if (!defobj || !atkobj) {
             log->write(
@@ -157,51 +306,52 @@ void AttackManager::update(ObjectManager& om, ObjectLifecycleManager& olm)
                 "attack {} ended because one of the participants do not exist anymore (atk={}, "
                 "def={})",
                 atk.attackID, atk.attackerID, atk.defenderID);
-            attacks_to_remove.push_back(atk.attackID);
+            this->removeAttack(atk.attackID);
             continue;
         }
 
-        if (!(*atkobj)->getAttackComponent()->isInRange(*defobj->get()->getAttackComponent())) {
+        auto& atkc = *atkobj->getAttackComponent();
+        auto& defc = *defobj->getAttackComponent();
+
+        if (!atkc.isInRange(defc)) {
             log->write(
                 "attack-manager", LogType::Info,
                 "attack {} ended because one of the participants is not in range of the other "
                 "(atk={}, def={})",
                 atk.attackID, atk.attackerID, atk.defenderID);
-            attacks_to_remove.push_back(atk.attackID);
+            this->removeAttack(atk.attackID);
             continue;
         }
-        
-        double damage = AttackComponent::calculateDamage(atk.atkAttributes, atk.defAttributes);
 
-        this->updateAttackInfo(*atkobj->get(), *defobj->get(), atk);
+        this->refreshAttributes(atkc, defc, atk);
+        this->updateAttackInfo(*atkobj, *defobj, atk);
 
         atk.ticks_until_attack--;
         if (atk.ticks_until_attack <= 0.001) {
+            if (auto* projectile = std::get_if<AttackTypeProjectile>(&atk.rule.ctype)) {
+                this->launchProjectiles(atk, *projectile);
+                continue;
+            }
+
             int attacks = 0;
             if (isNextAttackPrecise(atk.atkAttributes.precision)) {
                 // Fix some precision errors that might occur.
                 atk.ticks_until_attack = 0;
                 do {
-                    auto remaining = this->damageObject(*defobj->get(), damage);
-                    this->sendAttackDoneEvent(atk, atk.atkAttributes, damage);
+                    auto remaining = this->damageObject(*defobj, atk.damage);
+                    this->sendAttackDoneEvent(atk, atk.atkAttributes, atk.damage);
+                    attacks++;
 
                     if (remaining <= 0) {
-                        this->sendDyingEvent(atk);
                         log->write(
                             "attack-manager", LogType::Info,
                             "attack {} ended because the attacker killed the defender "
                             "(atk={}, def={})",
                             atk.attackID, atk.attackerID, atk.defenderID);
-
-                        /// The lifecycle manager will delete the entity for us,
-                        /// but we will have to sent the dying event.
-                        /// TODO: change this, the lifecycle manager will listen to
-                        ///       this event.
-                        olm.notifyDeath(atk.defenderID);
-                        attacks_to_remove.push_back(atk.attackID);
+                        this->killObject(olm, atk.defenderID, atk.defPosition);
+                        break;
                     }
 
-                    attacks++;
                     this->countUntilNextAttack(atk);
                 } while (atk.ticks_until_attack < 1.0);
 
@@ -214,11 +364,95 @@ void AttackManager::update(ObjectManager& om, ObjectLifecycleManager& olm)
         }
     }
 
-    auto itend = std::remove_if(attacks_.begin(), attacks_.end(), [&](AttackInfo& a) {
-        return std::find(attacks_to_remove.begin(), attacks_to_remove.end(), a.attackID) !=
-               attacks_to_remove.end();
-    });
-    attacks_.erase(itend, attacks_.end());
+    this->compactAttacks();
+}
+
+void AttackManager::addAttack(AttackInfo&& a)
+{
+    auto id = a.attackID;
+    if (this->hasAttack(id)) return;
+
+    by_attacker_[a.attackerID].push_back(id);
+    by_defender_[a.defenderID].push_back(id);
+
+    attack_index_[id] = attacks_.size();
+    attacks_.push_back(std::move(a));
+}
+
+/**
+ * Remove the attack ID from the list of attacks of an object
+ */
+static void removeFromIndex(
+    std::unordered_map<entity_id_t, std::vector<uint64_t>>& index, entity_id_t object,
+    uint64_t attackID)
+{
+    auto it = index.find(object);
+    if (it == index.end()) return;
+
+    auto& ids = it->second;
+    if (auto idit = std::find(ids.begin(), ids.end(), attackID); idit != ids.end()) {
+        *idit = ids.back();
+        ids.pop_back();
+    }
+
+    if (ids.empty()) index.erase(it);
+}
+
+/**
+ * Mark an attack as removed, and remove it from the indices
+ */
+void AttackManager::removeAttack(uint64_t attackID)
+{
+    auto it = attack_index_.find(attackID);
+    if (it == attack_index_.end()) return;
+
+    auto& a   = attacks_[it->second];
+    a.removed = true;
+    attack_index_.erase(it);
+
+    removeFromIndex(by_attacker_, a.attackerID, attackID);
+    removeFromIndex(by_defender_, a.defenderID, attackID);
+    has_removed_ = true;
+}
+
+/**
+ * Cancel every attack where the object is the attacker or the defender
+ */
+void AttackManager::cancelAttacksOf(entity_id_t id)
+{
+    for (auto* index : {&by_attacker_, &by_defender_}) {
+        auto it = index->find(id);
+        if (it == index->end()) continue;
+
+        auto ids = std::move(it->second);
+        index->erase(it);
+
+        for (auto attackID : ids) this->removeAttack(attackID);
+    }
+}
+
+/**
+ * Remove the attacks marked as removed from the array, keeping their order
+ *
+ * Only the attacks that moved need their index updated.
+ */
+void AttackManager::compactAttacks()
+{
+    if (!has_removed_) return;
+
+    size_t out = 0;
+    for (size_t i = 0; i < attacks_.size(); i++) {
+        if (attacks_[i].removed) continue;
+
+        if (out != i) {
+            attacks_[out]                         = std::move(attacks_[i]);
+            attack_index_[attacks_[out].attackID] = out;
+        }
+        out++;
+    }
+
+    attacks_.resize(out);
+    has_removed_ = false;
 }
 
 bool AttackManager::receiveAttackEvents(const EntityEvent& e)
@@ -229,7 +463,9 @@ bool AttackManager::receiveAttackEvents(const EntityEvent& e)
         log->write(
             "attack-manager", LogType::Info, "attack event ID {:08x} received (from={}, to={})",
             ev->attackID, ev->attackerID, ev->defenderID);
-        AttackInfo a{
+
+        auto damage = AttackComponent::calculateDamage(ev->atkAttributes, ev->defAttributes);
+        this->addAttack(AttackInfo{
             .attackerID         = ev->attackerID,
             .defenderID         = ev->defenderID,
             .attackID           = ev->attackID,
@@ -241,8 +477,12 @@ bool AttackManager::receiveAttackEvents(const EntityEvent& e)
             .successful_attacks = 0,
             .total_attacks      = 0,
             .ticks_until_attack = 0,
-        };
-        attacks_.push_back(a);
+            .damage             = damage,
+            .atkVersion         = 0,
+            .defVersion         = 0,
+            .versionsKnown      = false,
+            .removed            = false,
+        });
     }
 
     return true;
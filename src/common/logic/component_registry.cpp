@@ -0,0 +1,71 @@
+#include <common/logic/component_registry.hpp>
+#include <common/logic/game_object.hpp>
+
+using namespace familyline::logic;
+
+/**
+ * Attach an object, moving its state to the end of the arrays
+ *
+ * Returns its index
+ */
+size_t ComponentRegistry::attach(GameObject& o)
+{
+    auto index = ids_.size();
+
+    ids_.push_back(o.getID());
+    objects_.push_back(&o);
+    positions_.push_back(o._position);
+    health_.push_back(o._health);
+    moved_.push_back(1);
+
+    auto& atk = o.getAttackComponent();
+    if (!atk)
+        attack_range_.push_back(-1);
+    else
+        attack_range_.push_back(atk->rules().empty() ? 0 : atk->rules()[0].maxDistance);
+
+    o._registry       = this;
+    o._registry_index = index;
+    return index;
+}
+
+/**
+ * Detach the object at the index `i`, copying its state back to it
+ *
+ * The last object takes its place.
+ */
+void ComponentRegistry::detach(size_t i)
+{
+    auto& o           = *objects_[i];
+    o._position       = positions_[i];
+    o._health         = health_[i];
+    o._registry       = nullptr;
+    o._registry_index = 0;
+
+    auto last = ids_.size() - 1;
+    if (i != last) {
+        ids_[i]          = ids_[last];
+        objects_[i]      = objects_[last];
+        positions_[i]    = positions_[last];
+        health_[i]       = health_[last];
+        attack_range_[i] = attack_range_[last];
+        moved_[i]        = moved_[last];
+
+        objects_[i]->_registry_index = i;
+    }
+
+    ids_.pop_back();
+    objects_.pop_back();
+    positions_.pop_back();
+    health_.pop_back();
+    attack_range_.pop_back();
+    moved_.pop_back();
+}
+
+/**
+ * Detach all objects
+ */
+void ComponentRegistry::clear()
+{
+    while (!ids_.empty()) this->detach(ids_.size() - 1);
+}
@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <common/logger.hpp>
+#include <common/logic/flow_field.hpp>
+#include <functional>
+#include <queue>
+
+using namespace familyline::logic;
+
+// clang-format off
+static const std::array<glm::ivec2, 8> directions = {
+    glm::ivec2{-1, -1}, glm::ivec2{0, -1}, glm::ivec2{1, -1},
+    glm::ivec2{-1, 0},                     glm::ivec2{1, 0},
+    glm::ivec2{-1, 1},  glm::ivec2{0, 1},  glm::ivec2{1, 1}};
+// clang-format on
+
+FlowField::FlowField(
+    const Terrain& t, const std::vector<bool>& bitmap, int ratio, glm::vec2 destination,
+    glm::vec2 size, ObstacleGrid::Region bounds)
+    : ratio_(ratio), destination_(destination), size_(size)
+{
+    auto [width, height] = t.getSize();
+    grid_width_          = width / ratio;
+    grid_height_         = height / ratio;
+    assert(bitmap.size() == grid_width_ * grid_height_);
+
+    bounds_ = ObstacleGrid::Region{
+        std::max(0, bounds.x0), std::max(0, bounds.y0), std::min(int(width), bounds.x1),
+        std::min(int(height), bounds.y1)};
+    cell_x0_ = bounds_.x0 / ratio;
+    cell_y0_ = bounds_.y0 / ratio;
+    cell_x1_ = std::min(grid_width_, (bounds_.x1 + ratio - 1) / ratio);
+    cell_y1_ = std::min(grid_height_, (bounds_.y1 + ratio - 1) / ratio);
+
+    this->calculateIntegration(t, bitmap);
+    this->calculateDirections();
+}
+
+/**
+ * Check if a change in the obstacles of a region can change this field
+ */
+bool FlowField::isAffectedBy(ObstacleGrid::Region r) const
+{
+    // The cells an object checks around its position, plus the rounding of the bitmap
+    auto margin = int(std::ceil(std::max(size_.x, size_.y) / 2.0)) + ratio_;
+
+    return r.x0 < bounds_.x1 + margin && r.x1 > bounds_.x0 - margin &&
+           r.y0 < bounds_.y1 + margin && r.y1 > bounds_.y0 - margin;
+}
+
+std::optional<uint32_t> FlowField::cellFromPosition(glm::vec2 pos) const
+{
+    if (pos.x < 0 || pos.y < 0) return std::nullopt;
+
+    auto x = int(pos.x) / ratio_;
+    auto y = int(pos.y) / ratio_;
+    if (x >= grid_width_ || y >= grid_height_) return std::nullopt;
+
+    return std::make_optional(uint32_t(y * grid_width_ + x));
+}
+
+/**
+ * Check if an object of our size fits in a certain cell
+ *
+ * Uses the same rules as the pathfinder: the object position is in its center, and
+ * the cells outside of the map are ignored
+ */
+bool FlowField::fits(const std::vector<bool>& bitmap, int x, int y) const
+{
+    auto px = double(x * ratio_);
+    auto py = double(y * ratio_);
+
+    auto minx = int(std::round(px - size_.x / 2.0)) / ratio_;
+    auto maxx = int(std::round(px + size_.x / 2.0)) / ratio_;
+    auto miny = int(std::round(py - size_.y / 2.0)) / ratio_;
+    auto maxy = int(std::round(py + size_.y / 2.0)) / ratio_;
+
+    for (auto cy = std::max(0, miny); cy <= std::min(grid_height_ - 1, maxy); cy++) {
+        for (auto cx = std::max(0, minx); cx <= std::min(grid_width_ - 1, maxx); cx++) {
+            if (bitmap[cy * grid_width_ + cx]) return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Calculate the integration field
+ *
+ * This is a Dijkstra search starting from the destination, using the same costs the
+ * pathfinder uses (distance plus a little of height difference).
+ */
+void FlowField::calculateIntegration(const Terrain& t, const std::vector<bool>& bitmap)
+{
+    integration_.assign(grid_width_ * grid_height_, -1.0f);
+
+    auto dest = cellFromPosition(destination_);
+    if (!dest || !this->inBounds(*dest % grid_width_, *dest / grid_width_)) {
+        LoggerService::getLogger()->write(
+            "flow-field", LogType::Warning, "destination {:.2f} is outside of the field",
+            destination_);
+        return;
+    }
+
+    // The walkability of each cell, so we do not check the object size more than once
+    // per cell
+    std::vector<int8_t> walkable(grid_width_ * grid_height_, -1);
+    auto isWalkable = [&](int x, int y) {
+        auto& w = walkable[y * grid_width_ + x];
+        if (w < 0) w = this->fits(bitmap, x, y) ? 1 : 0;
+
+        return w == 1;
+    };
+
+    auto heightAt = [&](int x, int y) {
+        return double(t.getHeightFromCoords(glm::vec2(x * ratio_, y * ratio_)));
+    };
+
+    using QueueItem = std::pair<float, uint32_t>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+    integration_[*dest] = 0.0f;
+    queue.push(std::make_pair(0.0f, *dest));
+
+    while (!queue.empty()) {
+        auto [cost, cell] = queue.top();
+        queue.pop();
+
+        if (cost > integration_[cell]) continue;
+
+        int x       = cell % grid_width_;
+        int y       = cell / grid_width_;
+        auto height = heightAt(x, y);
+
+        for (auto& d : directions) {
+            auto nx = x + d.x;
+            auto ny = y + d.y;
+            if (!this->inBounds(nx, ny)) continue;
+
+            if (!isWalkable(nx, ny)) continue;
+
+            auto distance   = (d.x != 0 && d.y != 0) ? M_SQRT2 * ratio_ : double(ratio_);
+            auto heightcost = std::abs(heightAt(nx, ny) - height) * 0.01;
+            auto ncost      = float(cost + distance + heightcost);
+
+            auto& ic = integration_[ny * grid_width_ + nx];
+            if (ic < 0 || ncost < ic) {
+                ic = ncost;
+                queue.push(std::make_pair(ncost, uint32_t(ny * grid_width_ + nx)));
+            }
+        }
+    }
+}
+
+/**
+ * Calculate the direction field
+ *
+ * Each cell points to its neighbor with the lowest cost.
+ */
+void FlowField::calculateDirections()
+{
+    directions_.assign(grid_width_ * grid_height_, -1);
+
+    for (auto y = cell_y0_; y < cell_y1_; y++) {
+        for (auto x = cell_x0_; x < cell_x1_; x++) {
+            auto cost = integration_[y * grid_width_ + x];
+            if (cost <= 0) continue;
+
+            int8_t best   = -1;
+            auto bestcost = cost;
+            for (auto i = 0; i < int(directions.size()); i++) {
+                auto nx = x + directions[i].x;
+                auto ny = y + directions[i].y;
+                if (nx < 0 || ny < 0 || nx >= grid_width_ || ny >= grid_height_) continue;
+
+                auto ncost = integration_[ny * grid_width_ + nx];
+                if (ncost >= 0 && ncost < bestcost) {
+                    best     = i;
+                    bestcost = ncost;
+                }
+            }
+
+            directions_[y * grid_width_ + x] = best;
+        }
+    }
+}
+
+/**
+ * Check if the destination can be reached from a certain position
+ */
+bool FlowField::isReachable(glm::vec2 pos) const { return this->costAt(pos) >= 0; }
+
+/**
+ * Get the cost to go from a position to the destination, or a negative number if it
+ * cannot be reached
+ */
+double FlowField::costAt(glm::vec2 pos) const
+{
+    auto cell = cellFromPosition(pos);
+    if (!cell) return -1;
+
+    return integration_[*cell];
+}
+
+/**
+ * Get the next position an object in `pos` needs to go
+ */
+std::optional<glm::vec2> FlowField::nextPosition(
+    glm::vec2 pos, std::function<bool(glm::vec2)> isBlocked) const
+{
+    auto cell = cellFromPosition(pos);
+    if (!cell) return std::nullopt;
+
+    auto cost = integration_[*cell];
+    if (cost < 0) return std::nullopt;
+
+    if (cost == 0) {
+        if (isBlocked && isBlocked(destination_)) return std::nullopt;
+
+        return std::make_optional(destination_);
+    }
+
+    int x = *cell % grid_width_;
+    int y = *cell / grid_width_;
+
+    auto cellPosition = [&](int i) {
+        return glm::vec2((x + directions[i].x) * ratio_, (y + directions[i].y) * ratio_);
+    };
+
+    auto best = directions_[*cell];
+    if (best < 0) return std::nullopt;
+
+    if (!isBlocked || !isBlocked(cellPosition(best)))
+        return std::make_optional(cellPosition(best));
+
+    // The best cell is blocked. Try the others that still lead to the destination, from
+    // the cheapest to the most expensive.
+    std::vector<std::pair<float, int>> candidates;
+    for (auto i = 0; i < int(directions.size()); i++) {
+        auto nx = x + directions[i].x;
+        auto ny = y + directions[i].y;
+        if (i == best || nx < 0 || ny < 0 || nx >= grid_width_ || ny >= grid_height_) continue;
+
+        auto ncost = integration_[ny * grid_width_ + nx];
+        if (ncost >= 0 && ncost < cost) candidates.push_back(std::make_pair(ncost, i));
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    for (auto [ncost, i] : candidates) {
+        if (!isBlocked(cellPosition(i))) return std::make_optional(cellPosition(i));
+    }
+
+    return std::nullopt;
+}
@@ -27,7 +27,7 @@ GameObject::GameObject(
 std::shared_ptr<GameObject> GameObject::create()
 {
     auto cloned = std::make_shared<GameObject>(
-        this->_name, this->_type, this->_size, this->_health, this->_maxHealth, this->_showHealth);
+        this->_name, this->_type, this->_size, this->getHealth(), this->_maxHealth, this->_showHealth);
 
     // TODO: copy the components.
     cloned->cAttack = this->cAttack ? std::make_optional<AttackComponent>(this->cAttack.value())
@@ -49,6 +49,33 @@ std::shared_ptr<GameObject> GameObject::create()
     return cloned;
 }
 
+/**
+ * Make this object equal to a new copy of `prototype`, so it can be reused
+ * instead of creating another one
+ *
+ * We assign the components instead of recreating them, so they reuse the memory
+ * they already have.
+ */
+void GameObject::reset(const GameObject& prototype)
+{
+    _id         = -1;
+    _size       = prototype._size;
+    _health     = prototype.getHealth();
+    _maxHealth  = prototype._maxHealth;
+    _showHealth = prototype._showHealth;
+    _position   = prototype.getPosition();
+    _registry   = nullptr;
+    _commands   = nullptr;
+
+    cAttack    = prototype.cAttack;
+    cContainer = prototype.cContainer;
+    cMovement  = prototype.cMovement;
+    cColony    = prototype.cColony;
+    category   = prototype.category;
+
+    if (cAttack) cAttack->setParent(this);
+}
+
 /**
  * Get the "object checksum"
  *
@@ -89,3 +116,19 @@ object_checksum_t GameObject::getChecksum() const
  * Update internal object logic
  */
 void GameObject::update() { this->doUpdate(); }
+
+/**
+ * Run a function that changes something outside of this object
+ *
+ * While the object is being updated, the function is stored and only run
+ * after all objects were updated. Otherwise, it runs now.
+ */
+void GameObject::defer(std::function<void()> fn)
+{
+    if (!_commands) {
+        fn();
+        return;
+    }
+
+    _commands->push_back(DeferredCommand{_id, std::move(fn)});
+}
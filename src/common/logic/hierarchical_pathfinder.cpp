@@ -0,0 +1,582 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <common/logger.hpp>
+#include <common/logic/hierarchical_pathfinder.hpp>
+#include <functional>
+#include <glm/geometric.hpp>
+#include <limits>
+#include <queue>
+
+using namespace familyline::logic;
+
+static const familyline::LogTag log_tag{"hierarchical-pathfinder"};
+
+/**
+ * Update the obstacle bitmap, and the obstacle bitmap size ratio, compared to the
+ * terrain size
+ *
+ * Only the clusters that changed are recalculated. If the ratio changed, everything
+ * is recalculated.
+ */
+void HierarchicalPathfinder::update(const std::vector<bool>& bitmap, int ratio)
+{
+    if (this->resize(bitmap, ratio)) return;
+
+    std::vector<bool> dirty(clusters_.size(), false);
+    rebuilt_clusters_ = 0;
+    if (!this->diffCells(bitmap, 0, 0, grid_width_, grid_height_, dirty)) return;
+
+    this->rebuildDirty(dirty);
+}
+
+/**
+ * Update the obstacle bitmap, knowing which regions of the obstacle grid changed
+ * since the last update
+ */
+void HierarchicalPathfinder::update(
+    const std::vector<bool>& bitmap, int ratio, const std::vector<ObstacleGrid::Region>& changes)
+{
+    if (this->resize(bitmap, ratio)) return;
+
+    std::vector<bool> dirty(clusters_.size(), false);
+    bool changed = false;
+    for (auto& r : changes) {
+        if (r.empty()) continue;
+
+        changed |= this->diffCells(
+            bitmap, r.x0 / ratio, r.y0 / ratio, std::min(grid_width_, (r.x1 - 1) / ratio + 1),
+            std::min(grid_height_, (r.y1 - 1) / ratio + 1), dirty);
+    }
+
+    rebuilt_clusters_ = 0;
+    if (!changed) return;
+
+    this->rebuildDirty(dirty);
+}
+
+bool HierarchicalPathfinder::resize(const std::vector<bool>& bitmap, int ratio)
+{
+    auto [width, height] = t_.getSize();
+    assert(bitmap.size() == (width / ratio) * (height / ratio));
+
+    if (ratio == ratio_ && bitmap.size() == obstacle_bitmap_.size()) return false;
+
+    obstacle_bitmap_ = bitmap;
+    ratio_           = ratio;
+    grid_width_      = width / ratio;
+    grid_height_     = height / ratio;
+    this->rebuildAll();
+    return true;
+}
+
+bool HierarchicalPathfinder::diffCells(
+    const std::vector<bool>& bitmap, int x0, int y0, int x1, int y1, std::vector<bool>& dirty)
+{
+    bool changed = false;
+    for (auto y = y0; y < y1; y++) {
+        for (auto x = x0; x < x1; x++) {
+            auto idx = y * grid_width_ + x;
+            if (bitmap[idx] != obstacle_bitmap_[idx]) {
+                obstacle_bitmap_[idx]  = bitmap[idx];
+                dirty[clusterAt(x, y)] = true;
+                changed                = true;
+            }
+        }
+    }
+
+    return changed;
+}
+
+/**
+ * Rebuild the dirty clusters, and the borders around them
+ */
+void HierarchicalPathfinder::rebuildDirty(const std::vector<bool>& dirty)
+{
+    // The transition points of a border depend on the cells around it, so a changed cell
+    // can change the borders of the clusters around its cluster. Those borders are shared
+    // with other clusters, so they also need to be rebuilt
+    std::vector<bool> dirtyborders(borders_.size(), false);
+    for (auto c = 0; c < int(clusters_.size()); c++) {
+        if (!dirty[c]) continue;
+
+        auto cx = c % clusters_x_;
+        auto cy = c / clusters_x_;
+        for (auto ny = std::max(0, cy - 1); ny <= std::min(clusters_y_ - 1, cy + 1); ny++) {
+            for (auto nx = std::max(0, cx - 1); nx <= std::min(clusters_x_ - 1, cx + 1); nx++) {
+                auto n                              = ny * clusters_x_ + nx;
+                dirtyborders[borderIndex(n, true)]  = true;
+                dirtyborders[borderIndex(n, false)] = true;
+            }
+        }
+    }
+
+    std::vector<bool> affected(clusters_.size(), false);
+    for (auto c = 0; c < int(clusters_.size()); c++) {
+        auto cx = c % clusters_x_;
+        auto cy = c / clusters_x_;
+
+        if (dirtyborders[borderIndex(c, true)]) {
+            this->buildBorder(c, true);
+            affected[c] = true;
+            if (cx + 1 < clusters_x_) affected[c + 1] = true;
+        }
+
+        if (dirtyborders[borderIndex(c, false)]) {
+            this->buildBorder(c, false);
+            affected[c] = true;
+            if (cy + 1 < clusters_y_) affected[c + clusters_x_] = true;
+        }
+    }
+
+    for (auto c = 0; c < int(clusters_.size()); c++) {
+        if (!affected[c]) continue;
+
+        this->buildCluster(c);
+        rebuilt_clusters_++;
+    }
+
+    this->rebuildTransitionMap();
+
+    LOGDEBUG(
+        LoggerService::getLogger(), log_tag, "rebuilt {} of {} clusters", rebuilt_clusters_,
+        clusters_.size());
+}
+
+/**
+ * Rebuild everything, from scratch
+ */
+void HierarchicalPathfinder::rebuildAll()
+{
+    clusters_x_ = (grid_width_ + cluster_size_ - 1) / cluster_size_;
+    clusters_y_ = (grid_height_ + cluster_size_ - 1) / cluster_size_;
+
+    clusters_.clear();
+    clusters_.reserve(clusters_x_ * clusters_y_);
+    for (auto cy = 0; cy < clusters_y_; cy++) {
+        for (auto cx = 0; cx < clusters_x_; cx++) {
+            auto x = cx * cluster_size_;
+            auto y = cy * cluster_size_;
+
+            Cluster c;
+            c.x = x;
+            c.y = y;
+            c.w = std::min(cluster_size_, grid_width_ - x);
+            c.h = std::min(cluster_size_, grid_height_ - y);
+            clusters_.push_back(std::move(c));
+        }
+    }
+
+    borders_.clear();
+    borders_.resize(clusters_.size() * 2);
+    for (auto c = 0; c < int(clusters_.size()); c++) {
+        this->buildBorder(c, true);
+        this->buildBorder(c, false);
+    }
+
+    for (auto c = 0; c < int(clusters_.size()); c++) {
+        this->buildCluster(c);
+    }
+
+    this->rebuildTransitionMap();
+    rebuilt_clusters_ = clusters_.size();
+
+    LoggerService::getLogger()->write(
+        "hierarchical-pathfinder", LogType::Info,
+        "built {}x{} clusters of size {}, with {} transition points", clusters_x_, clusters_y_,
+        cluster_size_, this->abstractNodeCount());
+}
+
+/**
+ * Find the transition points of a border
+ *
+ * Each run of cells that are free on both sides of the border is an entrance. Short
+ * entrances get one transition point, in their middle. Long ones get two, near their
+ * ends.
+ *
+ * We prefer to put the transition points where both cells have some clearance, so
+ * objects bigger than one cell can also reach them.
+ */
+void HierarchicalPathfinder::buildBorder(int cluster, bool vertical)
+{
+    auto& border = borders_[borderIndex(cluster, vertical)];
+    border.clear();
+
+    auto& c = clusters_[cluster];
+    auto cx = cluster % clusters_x_;
+    auto cy = cluster / clusters_x_;
+
+    if (vertical && cx + 1 >= clusters_x_) return;
+    if (!vertical && cy + 1 >= clusters_y_) return;
+
+    auto length = vertical ? c.h : c.w;
+
+    // Get the pair of cells (inside, outside) of a certain offset in the border
+    auto cellsAt = [&](int i) {
+        if (vertical) {
+            auto x = c.x + c.w - 1;
+            auto y = c.y + i;
+            return std::make_pair(
+                uint32_t(y * grid_width_ + x), uint32_t(y * grid_width_ + x + 1));
+        } else {
+            auto x = c.x + i;
+            auto y = c.y + c.h - 1;
+            return std::make_pair(
+                uint32_t(y * grid_width_ + x), uint32_t((y + 1) * grid_width_ + x));
+        }
+    };
+
+    auto isClear = [&](int i) {
+        auto [inside, outside] = cellsAt(i);
+        return this->hasClearance(inside % grid_width_, inside / grid_width_) &&
+               this->hasClearance(outside % grid_width_, outside / grid_width_);
+    };
+
+    // Find the offset closest to `i`, between `start` and `end`, that has clearance.
+    // If no one has, use `i` itself
+    auto closestClear = [&](int i, int start, int end) {
+        for (auto d = 0; d <= end - start; d++) {
+            if (i - d >= start && isClear(i - d)) return i - d;
+            if (i + d <= end && isClear(i + d)) return i + d;
+        }
+
+        return i;
+    };
+
+    auto addEntrance = [&](int start, int end) {
+        auto runlength = end - start + 1;
+        if (runlength <= 6) {
+            border.push_back(cellsAt(closestClear(start + runlength / 2, start, end)));
+        } else {
+            auto first = closestClear(start + 2, start, end);
+            auto last  = closestClear(end - 2, start, end);
+            border.push_back(cellsAt(first));
+            if (last != first) border.push_back(cellsAt(last));
+        }
+    };
+
+    int runstart = -1;
+    for (auto i = 0; i < length; i++) {
+        auto [inside, outside] = cellsAt(i);
+        bool free              = !obstacle_bitmap_[inside] && !obstacle_bitmap_[outside];
+
+        if (free && runstart < 0) runstart = i;
+
+        if (!free && runstart >= 0) {
+            addEntrance(runstart, i - 1);
+            runstart = -1;
+        }
+    }
+
+    if (runstart >= 0) addEntrance(runstart, length - 1);
+}
+
+/**
+ * Check if a cell and its eight neighbors are free
+ *
+ * Cells outside of the map do not count as obstacles
+ */
+bool HierarchicalPathfinder::hasClearance(int x, int y) const
+{
+    for (auto dy = -1; dy <= 1; dy++) {
+        for (auto dx = -1; dx <= 1; dx++) {
+            auto nx = x + dx;
+            auto ny = y + dy;
+            if (nx < 0 || ny < 0 || nx >= grid_width_ || ny >= grid_height_) continue;
+
+            if (!this->isFree(nx, ny)) return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Collect the transition points of the borders of a cluster, and calculate the
+ * costs between them
+ */
+void HierarchicalPathfinder::buildCluster(int cluster)
+{
+    auto& c = clusters_[cluster];
+    auto cx = cluster % clusters_x_;
+    auto cy = cluster / clusters_x_;
+
+    // Our transition points and the ones on the other side, from the four borders.
+    std::vector<std::pair<uint32_t, uint32_t>> links;
+    for (auto& p : borders_[borderIndex(cluster, true)]) links.push_back(p);
+    for (auto& p : borders_[borderIndex(cluster, false)]) links.push_back(p);
+    if (cx > 0) {
+        for (auto& [outside, inside] : borders_[borderIndex(cluster - 1, true)])
+            links.push_back(std::make_pair(inside, outside));
+    }
+    if (cy > 0) {
+        for (auto& [outside, inside] : borders_[borderIndex(cluster - clusters_x_, false)])
+            links.push_back(std::make_pair(inside, outside));
+    }
+
+    // A cell in a corner can be a transition point for two borders.
+    c.transitions.clear();
+    for (auto& [inside, outside] : links) c.transitions.push_back(inside);
+
+    std::sort(c.transitions.begin(), c.transitions.end());
+    c.transitions.erase(
+        std::unique(c.transitions.begin(), c.transitions.end()), c.transitions.end());
+
+    auto count = c.transitions.size();
+    c.partners.assign(count, {});
+    for (auto& [inside, outside] : links) {
+        auto it = std::lower_bound(c.transitions.begin(), c.transitions.end(), inside);
+        c.partners[std::distance(c.transitions.begin(), it)].push_back(outside);
+    }
+
+    c.costs.assign(count * count, -1.0);
+    for (size_t i = 0; i < count; i++) {
+        this->searchInsideCluster(c, c.transitions[i]);
+        for (size_t j = 0; j < count; j++) {
+            c.costs[i * count + j] = this->localCost(c, c.transitions[j]);
+        }
+    }
+}
+
+/**
+ * Rebuild the map of transition points, after some clusters changed
+ */
+void HierarchicalPathfinder::rebuildTransitionMap()
+{
+    transition_map_.clear();
+    node_offsets_.resize(clusters_.size() + 1);
+
+    uint32_t offset = 0;
+    for (auto c = 0; c < int(clusters_.size()); c++) {
+        node_offsets_[c] = offset;
+
+        auto& transitions = clusters_[c].transitions;
+        for (auto i = 0; i < int(transitions.size()); i++) {
+            transition_map_[transitions[i]] = std::make_pair(uint32_t(c), uint32_t(i));
+        }
+
+        offset += transitions.size();
+    }
+
+    node_offsets_[clusters_.size()] = offset;
+}
+
+size_t HierarchicalPathfinder::abstractNodeCount() const
+{
+    return node_offsets_.empty() ? 0 : node_offsets_.back();
+}
+
+/**
+ * Run a Dijkstra search from a cell, restricted to the cluster it is in
+ *
+ * The start cell does not need to be free, because it might be the position of the
+ * object that wants to walk.
+ */
+void HierarchicalPathfinder::searchInsideCluster(const Cluster& c, uint32_t cell)
+{
+    local_cost_.assign(c.w * c.h, -1.0);
+
+    using QueueItem = std::pair<double, uint32_t>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+    auto straight = double(ratio_);
+    auto diagonal = double(ratio_) * M_SQRT2;
+
+    auto localIndex = [&](int x, int y) { return (y - c.y) * c.w + (x - c.x); };
+
+    local_cost_[localIndex(cell % grid_width_, cell / grid_width_)] = 0.0;
+    queue.push(std::make_pair(0.0, cell));
+
+    while (!queue.empty()) {
+        auto [cost, current] = queue.top();
+        queue.pop();
+
+        int x = current % grid_width_;
+        int y = current / grid_width_;
+        if (cost > local_cost_[localIndex(x, y)]) continue;
+
+        for (auto dy = -1; dy <= 1; dy++) {
+            for (auto dx = -1; dx <= 1; dx++) {
+                if (dx == 0 && dy == 0) continue;
+
+                auto nx = x + dx;
+                auto ny = y + dy;
+                if (nx < c.x || ny < c.y || nx >= c.x + c.w || ny >= c.y + c.h) continue;
+
+                if (!this->isFree(nx, ny)) continue;
+
+                auto ncost = cost + ((dx != 0 && dy != 0) ? diagonal : straight);
+                auto& lc   = local_cost_[localIndex(nx, ny)];
+                if (lc < 0 || ncost < lc) {
+                    lc = ncost;
+                    queue.push(std::make_pair(ncost, uint32_t(ny * grid_width_ + nx)));
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Get the cost of a local search to a certain cell, after calling
+ * searchInsideCluster()
+ */
+double HierarchicalPathfinder::localCost(const Cluster& c, uint32_t cell) const
+{
+    int x = cell % grid_width_;
+    int y = cell / grid_width_;
+    return local_cost_[(y - c.y) * c.w + (x - c.x)];
+}
+
+std::optional<uint32_t> HierarchicalPathfinder::cellFromPosition(glm::vec2 pos) const
+{
+    if (pos.x < 0 || pos.y < 0) return std::nullopt;
+
+    auto x = int(pos.x) / ratio_;
+    auto y = int(pos.y) / ratio_;
+    if (x >= grid_width_ || y >= grid_height_) return std::nullopt;
+
+    return std::make_optional(uint32_t(y * grid_width_ + x));
+}
+
+glm::vec2 HierarchicalPathfinder::positionFromCell(uint32_t cell) const
+{
+    return glm::vec2((cell % grid_width_) * ratio_, (cell / grid_width_) * ratio_);
+}
+
+/**
+ * Find the waypoints of a path through the terrain
+ *
+ * We temporarily add the start and the end to the abstract graph, connecting them to the
+ * transition points of their clusters, and run an A* search over it.
+ */
+std::optional<std::vector<glm::vec2>> HierarchicalPathfinder::findWaypoints(
+    glm::vec2 start, glm::vec2 end)
+{
+    expanded_nodes_ = 0;
+    if (clusters_.empty()) return std::nullopt;
+
+    auto scell = cellFromPosition(start);
+    auto ecell = cellFromPosition(end);
+    if (!scell || !ecell) return std::nullopt;
+
+    auto scluster = clusterAt(*scell % grid_width_, *scell / grid_width_);
+    auto ecluster = clusterAt(*ecell % grid_width_, *ecell / grid_width_);
+
+    // Both are in the same cluster, and we can reach one from the other without leaving
+    // it. No need to search the abstract graph
+    if (scluster == ecluster) {
+        this->searchInsideCluster(clusters_[scluster], *scell);
+        if (this->localCost(clusters_[scluster], *ecell) >= 0)
+            return std::make_optional<std::vector<glm::vec2>>({end});
+    }
+
+    auto& sc = clusters_[scluster];
+    auto& ec = clusters_[ecluster];
+
+    // Costs from the start to its cluster transition points, and from the end to its
+    // cluster transition points
+    std::vector<double> startcosts, endcosts;
+    this->searchInsideCluster(sc, *scell);
+    for (auto t : sc.transitions) startcosts.push_back(this->localCost(sc, t));
+
+    this->searchInsideCluster(ec, *ecell);
+    for (auto t : ec.transitions) endcosts.push_back(this->localCost(ec, t));
+
+    auto nodecount = uint32_t(this->abstractNodeCount());
+    auto startnode = nodecount;
+    auto endnode   = nodecount + 1;
+
+    auto infinity = std::numeric_limits<double>::infinity();
+    std::vector<double> g(nodecount + 2, infinity);
+    std::vector<uint32_t> parent(nodecount + 2, uint32_t(-1));
+    std::vector<bool> closed(nodecount + 2, false);
+
+    auto nodeCluster = [&](uint32_t node) {
+        return uint32_t(
+            std::distance(
+                node_offsets_.begin(),
+                std::upper_bound(node_offsets_.begin(), node_offsets_.end(), node)) -
+            1);
+    };
+
+    auto nodePosition = [&](uint32_t node) {
+        if (node == startnode) return start;
+        if (node == endnode) return end;
+
+        auto c = nodeCluster(node);
+        return positionFromCell(clusters_[c].transitions[node - node_offsets_[c]]);
+    };
+
+    using QueueItem = std::pair<double, uint32_t>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> open;
+
+    auto relax = [&](uint32_t from, uint32_t to, double cost) {
+        auto ng = g[from] + cost;
+        if (closed[to] || ng >= g[to]) return;
+
+        g[to]      = ng;
+        parent[to] = from;
+        open.push(std::make_pair(ng + glm::distance(nodePosition(to), end), to));
+    };
+
+    g[startnode] = 0;
+    open.push(std::make_pair(glm::distance(start, end), startnode));
+
+    while (!open.empty()) {
+        auto node = open.top().second;
+        open.pop();
+
+        if (closed[node]) continue;
+
+        closed[node] = true;
+        expanded_nodes_++;
+
+        if (node == endnode) break;
+
+        if (node == startnode) {
+            for (auto i = 0; i < int(sc.transitions.size()); i++) {
+                if (startcosts[i] >= 0) relax(node, node_offsets_[scluster] + i, startcosts[i]);
+            }
+            continue;
+        }
+
+        auto cluster = nodeCluster(node);
+        auto local   = node - node_offsets_[cluster];
+        auto& c      = clusters_[cluster];
+        auto count   = c.transitions.size();
+
+        // Transition points of the same cluster
+        for (size_t j = 0; j < count; j++) {
+            auto cost = c.costs[local * count + j];
+            if (j != local && cost >= 0) relax(node, node_offsets_[cluster] + j, cost);
+        }
+
+        // Transition points on the other side of the border
+        for (auto partner : c.partners[local]) {
+            auto [pcluster, plocal] = transition_map_.at(partner);
+            relax(node, node_offsets_[pcluster] + plocal, double(ratio_));
+        }
+
+        if (int(cluster) == ecluster && endcosts[local] >= 0) relax(node, endnode, endcosts[local]);
+    }
+
+    if (!closed[endnode]) {
+        LoggerService::getLogger()->write(
+            "hierarchical-pathfinder", LogType::Info,
+            "no abstract path between {:.2f} and {:.2f}, {} nodes expanded", start, end,
+            expanded_nodes_);
+        return std::nullopt;
+    }
+
+    // Walk the path backwards. We only want the points where the path enters a cluster, since
+    // the path between two of them is inside a single cluster.
+    std::vector<glm::vec2> waypoints = {end};
+    for (auto node = parent[endnode]; node != startnode; node = parent[node]) {
+        auto prev = parent[node];
+        if (prev == startnode || nodeCluster(prev) != nodeCluster(node))
+            waypoints.push_back(nodePosition(node));
+    }
+
+    std::reverse(waypoints.begin(), waypoints.end());
+    return std::make_optional(waypoints);
+}
@@ -0,0 +1,621 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <common/logger.hpp>
+#include <common/logic/incremental_pathfinder.hpp>
+
+using namespace familyline::logic;
+
+static const familyline::LogTag log_tag{"incremental-pathfinder"};
+
+/**
+ * Find a path through the terrain, reusing the last search if possible
+ */
+std::vector<glm::vec2> IncrementalPathfinder::findPath(
+    ObstacleView view, glm::vec2 start, glm::vec2 end, glm::vec2 size, int maxiters)
+{
+    if (!this->plan(view, start, end, size, maxiters) || !has_path_) return {};
+
+    return this->path();
+}
+
+/**
+ * Update the search, for an object that is now at `start`
+ *
+ * This is the main loop of D* Lite: move the start to where the object is, update the
+ * nodes around the cells that changed and fix the nodes that became inconsistent.
+ */
+bool IncrementalPathfinder::plan(
+    ObstacleView view, glm::vec2 start, glm::vec2 end, glm::vec2 size, int maxiters)
+{
+    auto [width, height] = t_.getSize();
+    has_max_iter_reached_ = false;
+    expanded_nodes_       = 0;
+
+    auto same_search = view_ && &view_->grid() == &view.grid() && view.ratio() == ratio_ &&
+                       size == size_ && nearestNode(end) == goal_;
+
+    view_ = view;
+    if (!same_search) {
+        ratio_       = view.ratio();
+        grid_width_  = width / ratio_;
+        grid_height_ = height / ratio_;
+        size_        = size;
+        goal_        = nearestNode(end);
+        start_       = nearestNode(start);
+        this->resetSearch();
+    }
+
+    start_pos_ = start;
+    end_pos_   = end;
+
+    // The object walked. Instead of recalculating the keys of the whole queue, we add
+    // the distance it walked to all keys we will calculate from now on
+    start_ = nearestNode(start);
+    if (start_ != last_start_) {
+        km_ += this->heuristic(last_start_, start_);
+        last_start_ = start_;
+    }
+
+    if (same_search && !this->applyChanges()) {
+        LOGDEBUG(
+            LoggerService::getLogger(), log_tag,
+            "obstacle grid changed too much, searching again from scratch");
+        this->resetSearch();
+    }
+
+    node_index_t starts[4];
+    auto count = this->startNodes(start, starts);
+    if (!this->computeShortestPath(starts, count, maxiters)) {
+        LoggerService::getLogger()->write(
+            "incremental-pathfinder", LogType::Info,
+            "tick count exceeded! Continuing on next call");
+        has_max_iter_reached_ = true;
+        return false;
+    }
+
+    // Go first to the start node that leads to the best path. Prefer the ones we can
+    // walk into
+    first_         = InvalidNode;
+    auto firstcost = Infinity;
+    auto walkable  = false;
+    for (auto i = 0; i < count; i++) {
+        auto w = this->isWalkable(starts[i]);
+        auto c = glm::distance(start, nodePosition(starts[i])) + getNode(starts[i]).g;
+        if (c == Infinity || (walkable && !w)) continue;
+
+        if (first_ == InvalidNode || (w && !walkable) || c < firstcost) {
+            first_    = starts[i];
+            firstcost = c;
+            walkable  = w;
+        }
+    }
+
+    auto had_path = has_path_;
+    has_path_     = first_ != InvalidNode;
+    if (has_path_ && !had_path) path_changed_ = true;
+
+    return true;
+}
+
+/**
+ * Get the path the last search found
+ */
+std::vector<glm::vec2> IncrementalPathfinder::path()
+{
+    assert(has_path_);
+    path_changed_ = false;
+    return this->extractPath(start_pos_, first_, end_pos_);
+}
+
+/**
+ * Start a new search, for the current end and view
+ */
+void IncrementalPathfinder::resetSearch()
+{
+    auto count = size_t(grid_width_ * grid_height_);
+    if (nodes_.size() != count) {
+        nodes_.assign(count, Node{});
+        search_gen_ = 0;
+    }
+
+    search_gen_++;
+    queue_.clear();
+    km_           = 0;
+    grid_version_ = view_->grid().version();
+    last_start_   = start_;
+    path_changed_ = true;
+
+    checked_x0_ = grid_width_;
+    checked_y0_ = grid_height_;
+    checked_x1_ = -1;
+    checked_y1_ = -1;
+
+    getNode(goal_).rhs = 0;
+    pushQueue(goal_, calculateKey(goal_));
+}
+
+/**
+ * Check the nodes that might have been affected by the cells that changed in the
+ * obstacle grid, and update the ones whose walkability changed
+ *
+ * A node is affected if the object, in that node, would cover one of the cells that
+ * changed. We only look at the nodes whose walkability we already checked: the others
+ * did not influence the search yet.
+ */
+bool IncrementalPathfinder::applyChanges()
+{
+    auto& grid   = view_->grid();
+    auto changes = grid.changesSince(grid_version_);
+    if (!changes) return false;
+
+    grid_version_ = grid.version();
+
+    auto [width, height] = t_.getSize();
+
+    // The nodes that cover a cell are at most this far from it
+    auto mx = int(std::ceil(size_.x / 2)) / ratio_ + 1;
+    auto my = int(std::ceil(size_.y / 2)) / ratio_ + 1;
+
+    for (auto& r : *changes) {
+        auto cx0 = r.x0 / ratio_, cx1 = (r.x1 - 1) / ratio_;
+        auto cy0 = r.y0 / ratio_, cy1 = (r.y1 - 1) / ratio_;
+
+        auto nx0 = std::max(checked_x0_, cx0 - mx), nx1 = std::min(checked_x1_, cx1 + mx);
+        auto ny0 = std::max(checked_y0_, cy0 - my), ny1 = std::min(checked_y1_, cy1 + my);
+        if (nx0 > nx1 || ny0 > ny1) continue;
+
+        for (auto ny = ny0; ny <= ny1; ny++) {
+            auto [ylo, yhi] = this->coveredCells(ny, size_.y, height);
+            if (yhi < cy0 || ylo > cy1) continue;
+
+            for (auto nx = nx0; nx <= nx1; nx++) {
+                auto [xlo, xhi] = this->coveredCells(nx, size_.x, width);
+                if (xhi < cx0 || xlo > cx1) continue;
+
+                auto idx = node_index_t(ny * grid_width_ + nx);
+                auto& n  = nodes_[idx];
+                if (n.gen != search_gen_ || n.walkable < 0) continue;
+
+                auto old   = n.walkable;
+                n.walkable = -1;
+                if (auto walkable = this->isWalkable(idx); walkable != bool(old))
+                    this->walkabilityChanged(idx, walkable);
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * A node became walkable, or stopped being walkable
+ *
+ * The cost of moving into it changed, so its neighbors might need a new rhs. If it
+ * became walkable, they can only get better through it. If not, only the ones whose
+ * rhs came from it need to look at all their neighbors again.
+ */
+void IncrementalPathfinder::walkabilityChanged(node_index_t idx, bool walkable)
+{
+    // We can always go to the end node
+    if (idx == goal_) return;
+
+    auto g = getNode(idx).g;
+    if (g == Infinity) return;
+
+    path_changed_ = true;
+
+    node_index_t around[8];
+    auto count = this->neighbors(idx, around);
+    for (auto i = 0; i < count; i++) {
+        if (around[i] == goal_) continue;
+
+        auto& n = getNode(around[i]);
+        auto c  = this->edgeCost(around[i], idx) + g;
+        if (walkable && c < n.rhs) {
+            n.rhs = c;
+            this->updateQueue(around[i]);
+        } else if (!walkable && c == n.rhs) {
+            this->updateNode(around[i]);
+        }
+    }
+}
+
+/**
+ * The cells of the level an object in a node covers, in one axis
+ *
+ * Uses the same rules as the normal pathfinder
+ */
+std::pair<int, int> IncrementalPathfinder::coveredCells(int node, float size, int limit) const
+{
+    auto pos = float(node * ratio_);
+    auto lo  = std::max(0, int(glm::round(pos - (size / 2.0))));
+    auto hi  = std::min(limit - 1, int(glm::round(pos + (size / 2.0))));
+    return {lo / ratio_, hi / ratio_};
+}
+
+/**
+ * Get the node nearest to a position, clamped to the grid
+ */
+IncrementalPathfinder::node_index_t IncrementalPathfinder::nearestNode(glm::vec2 pos) const
+{
+    auto nx = std::clamp(int(std::round(pos.x / ratio_)), 0, grid_width_ - 1);
+    auto ny = std::clamp(int(std::round(pos.y / ratio_)), 0, grid_height_ - 1);
+    return node_index_t(ny * grid_width_ + nx);
+}
+
+/**
+ * The nodes around the start: the ones of the cell it is in
+ */
+int IncrementalPathfinder::startNodes(glm::vec2 start, node_index_t (&out)[4]) const
+{
+    auto x0 = std::clamp(int(std::floor(start.x / ratio_)), 0, grid_width_ - 1);
+    auto y0 = std::clamp(int(std::floor(start.y / ratio_)), 0, grid_height_ - 1);
+    auto x1 = std::clamp(int(std::ceil(start.x / ratio_)), 0, grid_width_ - 1);
+    auto y1 = std::clamp(int(std::ceil(start.y / ratio_)), 0, grid_height_ - 1);
+
+    auto count = 0;
+    for (auto y = y0; y <= y1; y++) {
+        for (auto x = x0; x <= x1; x++) out[count++] = node_index_t(y * grid_width_ + x);
+    }
+
+    return count;
+}
+
+/**
+ * Get a node, resetting it if it belongs to an older search
+ */
+IncrementalPathfinder::Node& IncrementalPathfinder::getNode(node_index_t idx)
+{
+    auto& n = nodes_[idx];
+    if (n.gen != search_gen_) {
+        n        = Node{};
+        n.gen    = search_gen_;
+        n.height = t_.getHeightFromCoords(nodePosition(idx));
+    }
+
+    return n;
+}
+
+/**
+ * Check if an object can be in a node, using the same rules as the normal pathfinder
+ */
+bool IncrementalPathfinder::isWalkable(node_index_t idx)
+{
+    auto& n = getNode(idx);
+    if (n.walkable >= 0) return n.walkable;
+
+    auto [width, height] = t_.getSize();
+    auto x               = int(idx % grid_width_);
+    auto y               = int(idx / grid_width_);
+    auto [cx0, cx1]      = this->coveredCells(x, size_.x, width);
+    auto [cy0, cy1]      = this->coveredCells(y, size_.y, height);
+
+    checked_x0_ = std::min(checked_x0_, x);
+    checked_y0_ = std::min(checked_y0_, y);
+    checked_x1_ = std::max(checked_x1_, x);
+    checked_y1_ = std::max(checked_y1_, y);
+
+    auto walkable = cx0 <= cx1 && cy0 <= cy1 && view_->isFree(cx0, cy0, cx1, cy1);
+
+    n.walkable = walkable ? 1 : 0;
+    return walkable;
+}
+
+/**
+ * The cost to go from a node to its neighbor
+ *
+ * The same as the normal pathfinder: the distance, plus a small cost for the height
+ * difference
+ *
+ * We can always go to the end node. Other objects might be standing there (usually,
+ * objects going to the same place), and the normal pathfinder also goes to an end it
+ * cannot walk into, as close as it can.
+ */
+double IncrementalPathfinder::cost(node_index_t from, node_index_t to)
+{
+    if (to != goal_ && !this->isWalkable(to)) return Infinity;
+
+    return this->edgeCost(from, to);
+}
+
+/**
+ * The cost to go from a node to its neighbor, if the neighbor is walkable
+ */
+double IncrementalPathfinder::edgeCost(node_index_t from, node_index_t to)
+{
+    auto heightcost = glm::abs(getNode(to).height - getNode(from).height) * 0.01;
+    return glm::abs(glm::distance(nodePosition(from), nodePosition(to))) + heightcost;
+}
+
+/**
+ * The estimated cost between two nodes
+ */
+double IncrementalPathfinder::heuristic(node_index_t a, node_index_t b) const
+{
+    if (a == InvalidNode || b == InvalidNode) return 0;
+
+    auto delta = glm::abs(nodePosition(a) - nodePosition(b));
+    auto dmax  = std::max(delta.x, delta.y);
+    auto dmin  = std::min(delta.x, delta.y);
+
+    // A little less than sqrt(2) - 1, so float errors in the real cost do not make us
+    // overestimate it
+    return dmax + dmin * 0.4142;
+}
+
+/**
+ * Get the neighbors of a node, the ones inside of the grid
+ *
+ * The order is always the same, so the paths are deterministic
+ */
+int IncrementalPathfinder::neighbors(node_index_t idx, node_index_t (&out)[8]) const
+{
+    auto x     = int(idx % grid_width_);
+    auto y     = int(idx / grid_width_);
+    auto count = 0;
+
+    for (auto dy = -1; dy <= 1; dy++) {
+        for (auto dx = -1; dx <= 1; dx++) {
+            if (dx == 0 && dy == 0) continue;
+
+            auto nx = x + dx, ny = y + dy;
+            if (nx < 0 || ny < 0 || nx >= grid_width_ || ny >= grid_height_) continue;
+
+            out[count++] = node_index_t(ny * grid_width_ + nx);
+        }
+    }
+
+    return count;
+}
+
+IncrementalPathfinder::Key IncrementalPathfinder::calculateKey(node_index_t idx)
+{
+    auto& n = getNode(idx);
+    auto m  = std::min(n.g, n.rhs);
+    return Key{m + this->heuristic(start_, idx) + km_, m};
+}
+
+/**
+ * Recalculate the rhs of a node, and put it in the queue if it is inconsistent
+ *
+ * The rhs is the best cost we can have going through one of the neighbors
+ */
+void IncrementalPathfinder::updateNode(node_index_t idx)
+{
+    auto& n = getNode(idx);
+    if (idx != goal_) {
+        node_index_t around[8];
+        auto count = this->neighbors(idx, around);
+        auto best  = Infinity;
+        for (auto i = 0; i < count; i++) {
+            auto c = this->cost(idx, around[i]);
+            if (c < Infinity) best = std::min(best, c + getNode(around[i]).g);
+        }
+
+        n.rhs = best;
+    }
+
+    this->updateQueue(idx);
+}
+
+/**
+ * Put a node in the queue if it is inconsistent, or remove it if it is not
+ */
+void IncrementalPathfinder::updateQueue(node_index_t idx)
+{
+    auto& n = nodes_[idx];
+    if (n.g != n.rhs)
+        pushQueue(idx, calculateKey(idx));
+    else if (n.queued)
+        removeQueue(idx);
+}
+
+/**
+ * Process the inconsistent nodes, until the start nodes are consistent and no other
+ * node in the queue could change their cost
+ *
+ * The keys are calculated from the node nearest to the start, but any consistent node
+ * whose key is not more than the top of the queue has its correct cost, so we can stop
+ * when all of the start nodes are like this.
+ */
+bool IncrementalPathfinder::computeShortestPath(
+    const node_index_t* starts, int count, int maxiters)
+{
+    node_index_t around[8];
+    int itercount = 0;
+
+    auto isDone = [&](const Key& top) {
+        for (auto i = 0; i < count; i++) {
+            auto& s = getNode(starts[i]);
+            if (top < calculateKey(starts[i]) || s.rhs != s.g) return false;
+        }
+
+        return true;
+    };
+
+    while (!queue_.empty()) {
+        auto top = queue_.front();
+        if (isDone(nodes_[top].key)) break;
+
+        if (itercount == maxiters) return false;
+
+        itercount++;
+        expanded_nodes_++;
+
+        auto& u   = nodes_[top];
+        auto kold = u.key;
+        auto knew = calculateKey(top);
+        if (kold < knew) {
+            // The key was calculated before the start moved
+            pushQueue(top, knew);
+            continue;
+        }
+
+        auto ncount = this->neighbors(top, around);
+        if (u.g > u.rhs) {
+            // The node got better. Its neighbors might get better through it
+            u.g           = u.rhs;
+            path_changed_ = true;
+            removeQueue(top);
+
+            for (auto i = 0; i < ncount; i++) {
+                if (around[i] == goal_) continue;
+
+                auto c  = this->cost(around[i], top);
+                auto& n = getNode(around[i]);
+                if (c < Infinity && c + u.g < n.rhs) {
+                    n.rhs = c + u.g;
+                    this->updateQueue(around[i]);
+                }
+            }
+        } else {
+            // The node got worse. The neighbors whose rhs came from it need to look at
+            // all their neighbors again
+            auto gold     = u.g;
+            u.g           = Infinity;
+            path_changed_ = true;
+
+            for (auto i = 0; i < ncount; i++) {
+                if (around[i] == goal_) continue;
+
+                auto c = this->cost(around[i], top);
+                if (c < Infinity && c + gold == getNode(around[i]).rhs)
+                    this->updateNode(around[i]);
+            }
+
+            this->updateQueue(top);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Walk from the start to the end, through the start node and then through the
+ * neighbor with the lowest cost
+ *
+ * Each step between two nodes is split so the points are at most one unit apart,
+ * like the normal pathfinder does when the grid is downsampled.
+ */
+std::vector<glm::vec2> IncrementalPathfinder::extractPath(
+    glm::vec2 start, node_index_t first, glm::vec2 end)
+{
+    std::vector<glm::vec2> path{start};
+    auto append = [&](glm::vec2 to) {
+        auto from  = path.back();
+        auto delta = glm::abs(to - from);
+        auto steps = int(std::ceil(std::max(delta.x, delta.y)));
+        for (auto i = 1; i <= steps; i++) path.push_back(glm::mix(from, to, i / float(steps)));
+    };
+
+    auto node = first;
+    append(nodePosition(node));
+
+    node_index_t around[8];
+    for (auto remaining = nodes_.size(); node != goal_ && remaining > 0; remaining--) {
+        auto count    = this->neighbors(node, around);
+        auto best     = InvalidNode;
+        auto bestcost = Infinity;
+        for (auto i = 0; i < count; i++) {
+            auto c = this->cost(node, around[i]);
+            if (c == Infinity) continue;
+
+            auto v = c + getNode(around[i]).g;
+            if (v < bestcost) {
+                bestcost = v;
+                best     = around[i];
+            }
+        }
+
+        if (best == InvalidNode) break;
+
+        node = best;
+        append(nodePosition(node));
+    }
+
+    if (node != goal_) {
+        LoggerService::getLogger()->write(
+            "incremental-pathfinder", LogType::Warning,
+            "could not follow the search from {:.2f} to {:.2f}", start, end);
+        has_path_ = false;
+        return {};
+    }
+
+    append(end);
+    return path;
+}
+
+void IncrementalPathfinder::heapSiftUp(uint32_t pos)
+{
+    auto idx = queue_[pos];
+    while (pos > 0) {
+        auto parent = (pos - 1) / 2;
+        if (!(nodes_[idx].key < nodes_[queue_[parent]].key)) break;
+
+        queue_[pos]                     = queue_[parent];
+        nodes_[queue_[pos]].heap_index = pos;
+        pos                             = parent;
+    }
+
+    queue_[pos]            = idx;
+    nodes_[idx].heap_index = pos;
+}
+
+void IncrementalPathfinder::heapSiftDown(uint32_t pos)
+{
+    auto idx  = queue_[pos];
+    auto size = uint32_t(queue_.size());
+    while (true) {
+        auto child = pos * 2 + 1;
+        if (child >= size) break;
+
+        if (child + 1 < size && nodes_[queue_[child + 1]].key < nodes_[queue_[child]].key)
+            child++;
+
+        if (!(nodes_[queue_[child]].key < nodes_[idx].key)) break;
+
+        queue_[pos]                     = queue_[child];
+        nodes_[queue_[pos]].heap_index = pos;
+        pos                             = child;
+    }
+
+    queue_[pos]            = idx;
+    nodes_[idx].heap_index = pos;
+}
+
+/**
+ * Put a node in the queue, or update its key if it is already there
+ */
+void IncrementalPathfinder::pushQueue(node_index_t idx, Key k)
+{
+    auto& n = nodes_[idx];
+    n.key   = k;
+    if (n.queued) {
+        heapSiftUp(n.heap_index);
+        heapSiftDown(n.heap_index);
+        return;
+    }
+
+    n.queued = true;
+    queue_.push_back(idx);
+    heapSiftUp(uint32_t(queue_.size() - 1));
+}
+
+void IncrementalPathfinder::removeQueue(node_index_t idx)
+{
+    auto& n = nodes_[idx];
+    assert(n.queued);
+
+    auto pos  = n.heap_index;
+    auto last = queue_.back();
+    queue_.pop_back();
+    n.queued = false;
+
+    if (pos < queue_.size()) {
+        queue_[pos]             = last;
+        nodes_[last].heap_index = pos;
+        heapSiftUp(pos);
+        heapSiftDown(nodes_[last].heap_index);
+    }
+}
@@ -1,5 +1,6 @@
 #include <common/logger.hpp>
 #include <common/logic/lifecycle_manager.hpp>
+#include <iterator>
 
 using namespace familyline::logic;
 
@@ -21,8 +22,21 @@ object_id_t ObjectLifecycleManager::doRegister(std::weak_ptr<GameObject> o)
     lcd.event         = ActionQueueEvent::Created;
 
     assert(!o.expired());
-    auto id         = o.lock()->getID();
-    _o_creating[id] = lcd;
+    auto id = o.lock()->getID();
+
+    if (_free_records.empty()) {
+        _o_creating[id] = lcd;
+    } else {
+        auto node = std::move(_free_records.back());
+        _free_records.pop_back();
+
+        node.key()    = id;
+        node.mapped() = lcd;
+        if (auto r = _o_creating.insert(std::move(node)); !r.inserted) {
+            r.position->second = lcd;
+            _free_records.push_back(std::move(r.node));
+        }
+    }
 
     auto& log = LoggerService::getLogger();
     log->write("lifecycle-manager", LogType::Info, "object with ID {} ({}) has been registered",
@@ -46,8 +60,7 @@ void ObjectLifecycleManager::notifyCreation(object_id_t id)
 {
     auto& log = LoggerService::getLogger();
 
-    auto optr = _o_creating.find(id);
-    if (optr == _o_creating.end()) {
+    if (!this->moveRecord(_o_creating, _o_created, id, ActionQueueEvent::Created)) {
         log->write(
             "lifecycle-manager", LogType::Warning,
             "Tried to notify creation of object id {}, but it cannot be transferred to that state",
@@ -55,12 +68,6 @@ void ObjectLifecycleManager::notifyCreation(object_id_t id)
         return;
     }
 
-    LifecycleData lcd = optr->second;
-    lcd.event         = ActionQueueEvent::Created;
-
-    _o_created[id] = lcd;
-    _o_creating.erase(id);
-
     log->write("lifecycle-manager", LogType::Info, "Object with ID {} has been created", id);
 }
 
@@ -78,8 +85,7 @@ void ObjectLifecycleManager::notifyDeath(object_id_t id)
 {
     auto& log = LoggerService::getLogger();
 
-    auto optr = _o_created.find(id);
-    if (optr == _o_created.end()) {
+    if (!this->moveRecord(_o_created, _o_dying, id, ActionQueueEvent::Dying)) {
         log->write(
             "lifecycle-manager", LogType::Warning,
             "Tried to notify death of object id {}, but it cannot be transferred to that state",
@@ -87,12 +93,7 @@ void ObjectLifecycleManager::notifyDeath(object_id_t id)
         return;
     }
 
-    LifecycleData lcd = optr->second;
-    lcd.event         = ActionQueueEvent::Dying;
-    lcd.time_to_die   = 80;  // 80 ticks before removing the object
-
-    _o_dying[id] = lcd;
-    _o_created.erase(id);
+    _o_dying[id].time_to_die = 80;  // 80 ticks before removing the object
 
     log->write("lifecycle-manager", LogType::Info, "object with ID {} died", id);
 }
@@ -106,30 +107,54 @@ void ObjectLifecycleManager::update()
 {
     auto& log = LoggerService::getLogger();
 
-    // Remove the dead objects
-    for (auto [id, lcd] : _o_dead) {
+    // Remove the dead objects, and keep their records for the next ones
+    for (auto& [id, lcd] : _o_dead) {
         _om.remove(id);
     }
-    _o_dead.clear();
+
+    while (!_o_dead.empty()) {
+        auto node = _o_dead.extract(_o_dead.begin());
+        node.mapped().obj.reset();
+        _free_records.push_back(std::move(node));
+    }
 
     // Update the dying countdown
-    std::vector<object_id_t> dying_remove;
-    for (auto& [id, lcd] : _o_dying) {
+    for (auto it = _o_dying.begin(); it != _o_dying.end();) {
+        auto& [id, lcd] = *it;
         lcd.time_to_die--;
 
-        if (lcd.time_to_die <= 0) {
-            lcd.event = ActionQueueEvent::Dead;
+        if (lcd.time_to_die > 0) {
+            ++it;
+            continue;
+        }
 
-            log->write(
-                "lifecycle-manager", LogType::Info,
-                "object with ID {} is dead and will be removed", id);
+        log->write(
+            "lifecycle-manager", LogType::Info, "object with ID {} is dead and will be removed",
+            id);
 
-            _o_dead[id] = lcd;
-            dying_remove.push_back(id);
-        }
+        auto next = std::next(it);
+        this->moveRecord(_o_dying, _o_dead, id, ActionQueueEvent::Dead);
+        it = next;
     }
+}
 
-    for (auto id : dying_remove) {
-        _o_dying.erase(id);
+/**
+ * Move the record of `id` from a map to another, changing its event
+ *
+ * The record is moved as a node, so it is not reallocated. Return false if the record
+ * is not in the first map
+ */
+bool ObjectLifecycleManager::moveRecord(
+    RecordMap& from, RecordMap& to, object_id_t id, ActionQueueEvent event)
+{
+    auto node = from.extract(id);
+    if (node.empty()) return false;
+
+    node.mapped().event = event;
+    if (auto r = to.insert(std::move(node)); !r.inserted) {
+        r.position->second = r.node.mapped();
+        _free_records.push_back(std::move(r.node));
     }
+
+    return true;
 }
@@ -65,3 +65,14 @@ std::unique_ptr<ObjectPathManager>& LogicService::getPathManager()
 {
     return path_manager_;
 }
+
+std::shared_ptr<familyline::WorkerPool> LogicService::worker_pool_;
+
+std::shared_ptr<familyline::WorkerPool>& LogicService::getWorkerPool()
+{
+    if (!worker_pool_) {
+        worker_pool_ = std::make_shared<WorkerPool>(WorkerPool::defaultThreadCount());
+    }
+
+    return worker_pool_;
+}
@@ -8,8 +8,8 @@ using namespace familyline::logic;
  * i.e, doesn't exist */
 std::shared_ptr<GameObject> ObjectFactory::getObject(const char* type, float x, float y, float z)
 {
-    if (_objects.find(type) != _objects.end()) {
-        auto newo = _objects[type]->create();
+    if (auto it = _objects.find(type); it != _objects.end()) {
+        auto newo = _pool->acquire(*it->second);
         newo->setPosition(glm::vec3(x, y, z));
         return newo;
     }
@@ -17,6 +17,13 @@ std::shared_ptr<GameObject> ObjectFactory::getObject(const char* type, float x,
     return nullptr;
 }
 
+/* Gets the object the instances of 'type' are copied from */
+const GameObject* ObjectFactory::getPrototype(std::string_view type) const
+{
+    auto it = _objects.find(type);
+    return it != _objects.end() ? it->second : nullptr;
+}
+
 /* Adds an object to the factory */
 void ObjectFactory::addObject(GameObject* object) { _objects[object->getType()] = object; }
 
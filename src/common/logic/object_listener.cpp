@@ -1,9 +1,10 @@
+#include <algorithm>
 #include <common/logic/object_listener.hpp>
 #include <common/logic/logic_service.hpp>
 
 using namespace familyline::logic;
 
-ObjectListener::ObjectListener()
+ObjectListener::ObjectListener() : _changes(4096)
 {
     using namespace std::placeholders;
 
@@ -24,19 +25,103 @@ bool ObjectListener::updateObjects(const EntityEvent& e)
 {
 
     if (auto* evCreate = std::get_if<EventCreated>(&e.type); evCreate) {
-        this->_objects.insert(evCreate->objectID);
+        bool inserted;
+        if (!_free_nodes.empty()) {
+            auto node = std::move(_free_nodes.back());
+            _free_nodes.pop_back();
+            node.value() = evCreate->objectID;
+
+            auto r   = this->_objects.insert(std::move(node));
+            inserted = r.inserted;
+            if (!inserted) _free_nodes.push_back(std::move(r.node));
+        } else {
+            inserted = this->_objects.insert(evCreate->objectID).second;
+        }
+
+        if (inserted) this->pushChange(evCreate->objectID, true);
         return true;
     }
 
     if (auto* evDestroy = std::get_if<EventDestroyed>(&e.type); evDestroy) {
-        this->_objects.erase(evDestroy->objectID);
+        if (auto node = this->_objects.extract(evDestroy->objectID); node) {
+            _free_nodes.push_back(std::move(node));
+            this->pushChange(evDestroy->objectID, false);
+        }
         return true;
     }
 
     return false;
 }
 
+void ObjectListener::pushChange(object_id_t id, bool alive)
+{
+    _version++;
+    if (_changes.empty()) return;
+
+    _changes[(_changes_head + _changes_count) % _changes.size()] = ObjectChange{_version, id, alive};
+    if (_changes_count < _changes.size())
+        _changes_count++;
+    else
+        _changes_head = (_changes_head + 1) % _changes.size();
+}
+
+/**
+ * Keep the newest `v` changes we have, in a new ring buffer with `v` slots
+ */
+void ObjectListener::setMaxChanges(size_t v)
+{
+    auto keep = std::min(v, _changes_count);
+
+    std::vector<ObjectChange> changes(v);
+    for (size_t i = 0; i < keep; i++)
+        changes[i] = _changes[(_changes_head + _changes_count - keep + i) % _changes.size()];
+
+    _changes.swap(changes);
+    _changes_head  = 0;
+    _changes_count = keep;
+}
+
+/**
+ * Remove all objects
+ *
+ * We also discard the changes, and increment the version without adding a change,
+ * so the ones who ask for the changes since any older version know they need the
+ * full list
+ */
+void ObjectListener::clear()
+{
+    _objects.clear();
+    _changes_head  = 0;
+    _changes_count = 0;
+    _version++;
+}
+
 std::set<object_id_t> ObjectListener::getAliveObjects() const { return _objects; }
 
+/**
+ * Get the changes after the version `since`, the oldest first
+ *
+ * The changes have consecutive versions, so we know we have all of them if we
+ * have the one right after `since`
+ */
+std::optional<std::vector<ObjectChange>> ObjectListener::getChangesSince(uint64_t since) const
+{
+    if (since == _version) return std::make_optional<std::vector<ObjectChange>>();
+
+    // A version we never had. The listener might have been recreated
+    if (since > _version) return std::nullopt;
+
+    if (_changes_count == 0) return std::nullopt;
+
+    auto oldest = _changes[_changes_head].version;
+    if (oldest > since + 1) return std::nullopt;
+
+    std::vector<ObjectChange> ret;
+    for (auto i = size_t(since + 1 - oldest); i < _changes_count; i++)
+        ret.push_back(_changes[(_changes_head + i) % _changes.size()]);
+
+    return std::make_optional(std::move(ret));
+}
+
 
 ObjectListener::~ObjectListener() { LogicService::getActionQueue()->removeReceiver("object-listener"); }
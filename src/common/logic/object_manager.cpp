@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <cstdint>
+#include <iterator>
 #include <common/logic/logic_service.hpp>
 #include <common/logic/object_manager.hpp>
 
@@ -42,15 +44,29 @@ void ObjectEventEmitter::notifyRemoval(object_id_t id, const std::string& name)
 }
 
 
-ObjectManager::ObjectManager() { eventEmitter = new ObjectEventEmitter{}; }
+/// Number of objects each worker updates at once
+constexpr size_t update_chunk_size = 64;
+
+ObjectManager::ObjectManager() : _workers(std::make_shared<WorkerPool>(0))
+{
+    eventEmitter = new ObjectEventEmitter{};
+}
 
 ObjectManager::~ObjectManager()
 {
+    _components.clear();
     LogicService::getActionQueue()->removeEmitter(eventEmitter);
     delete eventEmitter;
 }    
 
 
+static_assert(sizeof(object_id_t) >= 8, "object IDs must hold the slot index and generation");
+
+static object_id_t makeID(uint32_t slot, uint32_t generation)
+{
+    return (object_id_t(generation) << 32) | (object_id_t(slot) + 1);
+}
+
 /**
  * Add an object to the manager.
  *
@@ -62,50 +78,146 @@ ObjectManager::~ObjectManager()
  */
 object_id_t ObjectManager::add(std::shared_ptr<GameObject>&& o)
 {
-    auto nextID = ++_lastID;
+    uint32_t slot;
+    if (_free_slots.empty()) {
+        slot = _slots.size();
+        _slots.emplace_back();
+    } else {
+        slot = _free_slots.back();
+        _free_slots.pop_back();
+    }
+
+    auto& s       = _slots[slot];
+    s.used        = true;
+    s.dense_index = _objects.size();
+
+    auto nextID = makeID(slot, s.generation);
     o->_id      = nextID;
-    _objects.push_back(o);
+    _objects.push_back(std::move(o));
+    _object_slots.push_back(slot);
+    _components.attach(*_objects.back());
 
-    eventEmitter->notifyCreationStart(o->_id, o->getName());
+    eventEmitter->notifyCreationStart(nextID, _objects.back()->getName());
 
     return nextID;
 }
 
+const ObjectManager::Slot* ObjectManager::findSlot(object_id_t id) const
+{
+    if (id == 0) return nullptr;
+
+    auto index = (id & 0xffffffff) - 1;
+    if (index >= _slots.size()) return nullptr;
+
+    auto& s = _slots[index];
+    if (!s.used || s.generation != uint32_t(id >> 32)) return nullptr;
+
+    return &s;
+}
+
 /**
  * Removes an object from the manager
+ *
+ * The last object takes the place of the removed one, so the objects stay
+ * contiguous
  */
 void ObjectManager::remove(object_id_t id)
 {
-    auto rit = std::remove_if(
-        _objects.begin(), _objects.end(),
-        [id](std::shared_ptr<GameObject>& v) { return v->getID() == id; });
+    auto* cs = this->findSlot(id);
+    if (!cs) return;
+
+    auto slot  = uint32_t((id & 0xffffffff) - 1);
+    auto index = cs->dense_index;
+
+    eventEmitter->notifyRemoval(id, _objects[index]->getName());
+    _components.detach(index);
+
+    if (index != _objects.size() - 1) {
+        _objects[index]                          = std::move(_objects.back());
+        _object_slots[index]                     = _object_slots.back();
+        _slots[_object_slots[index]].dense_index = index;
+    }
+    _objects.pop_back();
+    _object_slots.pop_back();
+
+    auto& s = _slots[slot];
+    s.used  = false;
 
-    eventEmitter->notifyRemoval(id, (*rit)->getName());
+    // A slot that used all of its generations is never used again, so its
+    // IDs are never repeated
+    if (s.generation == UINT32_MAX) return;
 
-    _objects.erase(rit);
+    s.generation++;
+    _free_slots.push_back(slot);
 }
 
 /**
  * Update every object registered into the manager
  *
- * TODO: update in a certain order?
+ * Each chunk has its own command buffer, so the workers never write to the
+ * same place. Sorting the commands by the ID of the object that created them (and
+ * keeping the order of the ones from the same object) makes the order the same one
+ * we would have with a single thread.
  */
 void ObjectManager::update()
 {
-    for (auto& o : _objects) {
-        o->update();
+    auto chunks = (_objects.size() + update_chunk_size - 1) / update_chunk_size;
+    _command_buffers.resize(chunks);
+
+    _workers->parallelFor(chunks, [&](size_t c) {
+        auto& commands = _command_buffers[c];
+        commands.clear();
+
+        auto end = std::min(_objects.size(), (c + 1) * update_chunk_size);
+        for (auto i = c * update_chunk_size; i < end; i++) {
+            auto& o     = *_objects[i];
+            o._commands = &commands;
+            o.update();
+            o._commands = nullptr;
+        }
+    });
+
+    std::vector<DeferredCommand> commands;
+    for (auto& buffer : _command_buffers) {
+        std::move(buffer.begin(), buffer.end(), std::back_inserter(commands));
+        buffer.clear();
     }
+
+    std::stable_sort(
+        commands.begin(), commands.end(),
+        [](const DeferredCommand& a, const DeferredCommand& b) { return a.source < b.source; });
+
+    for (auto& c : commands) c.run();
 }
 
-std::optional<std::shared_ptr<GameObject>> ObjectManager::get(object_id_t id) const
+/**
+ * Set the number of worker threads used to update the objects
+ */
+void ObjectManager::setWorkerCount(unsigned v)
 {
-    auto r = std::find_if(_objects.begin(), _objects.end(), [id](std::shared_ptr<GameObject> v) {
-        return v->getID() == id;
-    });
+    if (v == _workers->threadCount()) return;
 
-    if (r == _objects.end()) {
+    _workers = std::make_shared<WorkerPool>(v);
+}
+
+std::optional<std::shared_ptr<GameObject>> ObjectManager::get(object_id_t id) const
+{
+    auto* s = this->findSlot(id);
+    if (!s) {
         return std::optional<std::shared_ptr<GameObject>>();
     }
 
-    return std::make_optional(*r);
+    return std::make_optional(_objects[s->dense_index]);
+}
+
+GameObject* ObjectManager::getPointer(object_id_t id) const
+{
+    auto* s = this->findSlot(id);
+    return s ? _objects[s->dense_index].get() : nullptr;
+}
+
+std::optional<size_t> ObjectManager::indexOf(object_id_t id) const
+{
+    auto* s = this->findSlot(id);
+    return s ? std::make_optional(s->dense_index) : std::nullopt;
 }
@@ -1,9 +1,11 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cmath>
 #include <common/logger.hpp>
 #include <common/logic/logic_service.hpp>
 #include <common/logic/object_path_manager.hpp>
+#include <common/logic/path_smoother.hpp>
 #include <iterator>
 
 #include "common/logic/action_queue.hpp"
@@ -12,17 +14,23 @@
 
 using namespace familyline::logic;
 
+static const familyline::LogTag log_tag{"object-path-manager"};
+
 /*
  * TODO: maybe, instead of recalculating the path if we have multiple paths in the same map, we
  *       only recalculate if a collision would occur
  */
 
-ObjectPathManager::ObjectPathManager(Terrain& t) : t_(t)
+ObjectPathManager::ObjectPathManager(Terrain& t)
+    : t_(t),
+      workers_(LogicService::getWorkerPool()),
+      hierarchical_pf_(t),
+      obstacles_(std::get<0>(t.getSize()), std::get<1>(t.getSize())),
+      static_obstacles_(std::get<0>(t.getSize()), std::get<1>(t.getSize())),
+      spatial_index_(std::get<0>(t.getSize()), std::get<1>(t.getSize()))
 {
-    auto [w, h]      = t_.getSize();
-    obstacle_bitmap_ = std::vector<unsigned>(w * h, 0);
-    obj_events_      = [this](const EntityEvent& e) {
-        events_.push(e);
+    obj_events_ = [this](const EntityEvent& e) {
+        events_.push_back(e);
         return true;
     };
     LogicService::getActionQueue()->addReceiver(
@@ -59,22 +67,99 @@ PathHandle ObjectPathManager::startPathing(GameObject& o, glm::vec2 dest)
             "found an existing reference to '%{}' ({}) in the pathing list", o.getName().c_str(),
             o.getID());
         existingref->status = PathStatus::Repathing;
-        existingref->start  = existingref->position() ? *existingref->position()
-                                                      : glm::vec2(
-                                                           existingref->object->getPosition().x,
-                                                           existingref->object->getPosition().z);
+        existingref->start  = existingref->position();
         existingref->end    = dest;
+        existingref->replan = true;
+
+        existingref->use_flow_field = false;
+        existingref->flow_field.reset();
+        existingref->group_size = 1;
+
+        static_bitmap_valid_ = false;
         return existingref->handleval();
     } else {
         auto pathref = PathRef(o, t_, dest);
+
+        // Each object size is a size class of the clearance map. The pathfinder checks the
+        // cells under the object plus one
+        auto size = o.getSize();
+        obstacles_.addClearance(
+            pathref.ratio, int(std::ceil((std::max(size.x, size.y) + 1) / pathref.ratio)) + 1);
         l->write(
             "object-path-manager", LogType::Info,
             "adding reference to '{}' ({}) in the pathing list", o.getName().c_str(), o.getID());
+        operation_index_[o.getID()] = operations_.size();
         operations_.push_back(std::move(pathref));
+        static_bitmap_valid_ = false;
         return pathref.handleval();
     }
 }
 
+/**
+ * Start pathing a group of objects to the same destination
+ *
+ * If there is more than one object, they will share a flow field to the destination,
+ * instead of each one running its own path search.
+ */
+std::vector<PathHandle> ObjectPathManager::startGroupPathing(
+    const std::vector<GameObject*>& objects, glm::vec2 dest)
+{
+    // The flow field only needs to cover the group and the destination
+    auto bounds = ObstacleGrid::Region{int(dest.x), int(dest.y), int(dest.x) + 1, int(dest.y) + 1};
+    for (auto* o : objects) {
+        auto pos  = o->getPosition();
+        bounds.x0 = std::min(bounds.x0, int(pos.x));
+        bounds.y0 = std::min(bounds.y0, int(pos.z));
+        bounds.x1 = std::max(bounds.x1, int(pos.x) + 1);
+        bounds.y1 = std::max(bounds.y1, int(pos.z) + 1);
+    }
+
+    auto [width, height] = t_.getSize();
+    bounds               = ObstacleGrid::Region{
+        std::max(0, bounds.x0 - flow_field_margin_), std::max(0, bounds.y0 - flow_field_margin_),
+        std::min(int(width), bounds.x1 + flow_field_margin_),
+        std::min(int(height), bounds.y1 + flow_field_margin_)};
+
+    std::vector<PathHandle> handles;
+    for (auto* o : objects) {
+        handles.push_back(this->startPathing(*o, dest));
+
+        auto* ref           = findPathRefFromObject(*o);
+        ref->use_flow_field = objects.size() > 1;
+        ref->group_size     = objects.size();
+        ref->flow_bounds    = bounds;
+    }
+
+    return handles;
+}
+
+/**
+ * Set the number of worker threads used to calculate the paths
+ */
+void ObjectPathManager::setWorkerCount(unsigned v)
+{
+    if (v == workers_->threadCount()) return;
+
+    workers_ = std::make_shared<WorkerPool>(v);
+}
+
+/**
+ * Check if an object of a certain size can be placed in a certain position, without
+ * overlapping any other object or leaving the map
+ */
+bool ObjectPathManager::canPlace(glm::vec2 pos, glm::vec2 size)
+{
+    auto [width, height] = t_.getSize();
+    if (pos.x - size.x / 2 < 0 || pos.y - size.y / 2 < 0 || pos.x + size.x / 2 > width ||
+        pos.y + size.y / 2 > height)
+        return false;
+
+    obstacles_.addClearance(1, int(std::ceil(std::max(size.x, size.y))));
+
+    auto r = obstacles_.footprint(pos, size);
+    return obstacles_.isFree(1, r.x0, r.y0, r.x1 - 1, r.y1 - 1);
+}
+
 /**
  * Find an existing path reference from an object
  *
@@ -84,13 +169,29 @@ PathHandle ObjectPathManager::startPathing(GameObject& o, glm::vec2 dest)
  */
 ObjectPathManager::PathRef* ObjectPathManager::findPathRefFromObject(object_id_t oid)
 {
-    auto v = std::find_if(operations_.begin(), operations_.end(), [&](PathRef& r) {
-        return r.object->getID() == oid;
-    });
+    auto v = operation_index_.find(oid);
+    if (v == operation_index_.end()) return nullptr;
 
-    if (v == operations_.end()) return nullptr;
+    return &operations_[v->second];
+}
 
-    return &(*v);
+/**
+ * Update the operation index after we removed path references
+ *
+ * The references that remain are moved to the front of the list, so their
+ * positions change, but their objects are already in the index, and we only
+ * need to remove the objects whose references are gone.
+ */
+void ObjectPathManager::reindexOperations()
+{
+    for (auto i = 0u; i < operations_.size(); i++) operation_index_[operations_[i].oid] = i;
+
+    for (auto it = operation_index_.begin(); it != operation_index_.end();) {
+        if (it->second >= operations_.size() || operations_[it->second].oid != it->first)
+            it = operation_index_.erase(it);
+        else
+            ++it;
+    }
 }
 
 /**
@@ -117,6 +218,22 @@ PathStatus ObjectPathManager::getPathStatus(const GameObject& o)
     return v->status;
 }
 
+/**
+ * Check if an object is following a path, or waiting for one
+ *
+ * The operations that completed, stopped or could not reach the destination
+ * stay in the list for a few ticks, but the object is not moving anymore.
+ */
+bool ObjectPathManager::isMoving(object_id_t id) const
+{
+    auto v = operation_index_.find(id);
+    if (v == operation_index_.end()) return false;
+
+    auto status = operations_[v->second].status;
+    return status == PathStatus::NotStarted || status == PathStatus::InProgress ||
+           status == PathStatus::Repathing;
+}
+
 /**
  * Find the path reference from a handle
  *
@@ -141,39 +258,60 @@ void ObjectPathManager::removePathing(PathHandle h)
         std::remove_if(
             operations_.begin(), operations_.end(), [&](PathRef& r) { return r.handleval() == h; }),
         operations_.end());
+    this->reindexOperations();
 }
 
 /**
  * Update the pathing
  *
  * This means:
- *  - moving the entity to the next position in the path (the granularity is low, so
- *    do not worry).
- *      - In the future we will take into account some things like entity speed, etc.
+ *  - moving the entity along its path, as far as its speed allows in a tick
  *  - removing paths that completed
  *  - detect if a path completed calculation in its timeslot. If it did not, we reschedule
  *    it to the next frame
  *  - update the terrain bitmaps (according to each path, in the future will be according to
  *    the FoV of each unit)
+ *
+ * The path searches are not run while we walk through the paths, but collected as jobs
+ * and run together, in the worker threads, at the end of the tick. At this point, the
+ * obstacle bitmap does not change anymore.
  */
 void ObjectPathManager::update(const ObjectManager& om)
 {
     auto& log = LoggerService::getLogger();
     updateObstacleBitmap(om);
+    static_bitmap_valid_ = false;
 
     std::vector<PathHandle> toRemove;
     int movingEntities = 0;
 
-    for (auto& op : operations_) {
+    // The jobs, indexed by the position of the path reference in operations_
+    std::vector<PathJob> jobs(operations_.size());
+    for (auto i = 0u; i < operations_.size(); i++) jobs[i].ref = &operations_[i];
+
+    for (auto i = 0u; i < operations_.size(); i++) {
+        auto& op  = operations_[i];
+        auto& job = jobs[i];
+
         switch (op.status) {
             case PathStatus::NotStarted: {
-                createPath(op);
+                if (!op.use_flow_field || !this->startFlowFieldPath(op)) {
+                    this->planWaypoints(op);
+                    job.create = true;
+                }
+
                 op.status = PathStatus::InProgress;
                 break;
             }
             case PathStatus::InProgress: {
-                auto isLastPosition = op.pathElements.size() == 1;
+                if (op.flow_field) {
+                    movingEntities++;
+                    this->updateFlowFieldPath(op);
+                    break;
+                }
+
                 auto currentPos     = updatePosition(op);
+                auto isLastPosition = op.pathElements.empty();
                 movingEntities++;
 
                 LogicService::getDebugDrawer()->drawPath(
@@ -187,6 +325,10 @@ void ObjectPathManager::update(const ObjectManager& om)
                         "called it when no points are available",
                         op.handleval(), op.object->getID(), op.object->getName());
                     op.status = PathStatus::Invalid;
+                } else if (isLastPosition && op.waypoints.size() > 1) {
+                    // We finished a segment of a long path
+                    op.waypoints.pop_front();
+                    job.next_segment = true;
                 } else if (isLastPosition) {
                     // TODO: make the pathfinder alert if the path was not reached, or was reached
                     // close enough
@@ -231,10 +373,18 @@ void ObjectPathManager::update(const ObjectManager& om)
                     "Pathing of {} ({} - {}) needs to be recalculated!", op.handleval(),
                     op.object->getID(), op.object->getName());
 
-                if (!op.pathfinder->maxIterReached())
-                    op.pathfinder->update(createBitmapForObject(*op.object, op.ratio), op.ratio);
+                if (op.replan && op.use_flow_field && this->startFlowFieldPath(op)) {
+                    op.replan = false;
+                    op.status = PathStatus::InProgress;
+                    break;
+                }
+
+                if (op.replan) this->planWaypoints(op);
 
-                this->recalculatePath(op, true);
+                job.repath        = true;
+                job.repath_update = op.replan || !op.pathfinder->maxIterReached();
+
+                op.replan = false;
                 op.status = PathStatus::InProgress;
                 break;
             }
@@ -247,12 +397,16 @@ void ObjectPathManager::update(const ObjectManager& om)
         log->write(
             "object-path-manager", LogType::Info, "Recalculating path for {} entities",
             movingEntities);
-        std::for_each(operations_.begin(), operations_.end(), [this](PathRef& r) {
-            r.pathfinder->update(createBitmapForObject(*r.object, r.ratio), r.ratio);
-            this->recalculatePath(r);
-        });
+        for (auto& job : jobs) {
+            // The objects following a flow field avoid the others by themselves
+            if (job.ref->flow_field) continue;
+
+            job.recalculate = true;
+        }
     }
 
+    this->runPathJobs(jobs);
+
     if (toRemove.size() > 0) {
         log->write("object-path-manager", LogType::Info, "Removing {} pathrefs", toRemove.size());
 
@@ -264,87 +418,580 @@ void ObjectPathManager::update(const ObjectManager& om)
                            toRemove.end();
                 }),
             operations_.end());
+        this->reindexOperations();
+    }
+
+    // Remove the flow fields nobody uses anymore
+    flow_fields_.erase(
+        std::remove_if(
+            flow_fields_.begin(), flow_fields_.end(),
+            [](CachedFlowField& f) { return f.field.use_count() <= 1; }),
+        flow_fields_.end());
+}
+
+/**
+ * Run the jobs, and wait for them to finish
+ *
+ * We do not run the jobs with nothing to do, so we do not waste time waking up the
+ * workers for them
+ */
+void ObjectPathManager::runPathJobs(std::vector<PathJob>& jobs)
+{
+    jobs.erase(
+        std::remove_if(
+            jobs.begin(), jobs.end(),
+            [](PathJob& j) {
+                return !j.create && !j.next_segment && !j.repath && !j.recalculate;
+            }),
+        jobs.end());
+
+    workers_->parallelFor(jobs.size(), [&](size_t i) { this->runPathJob(jobs[i]); });
+}
+
+/**
+ * Run the calculations requested by a single job
+ *
+ * This runs in a worker thread, so it cannot change anything outside of the path
+ * reference of the job.
+ */
+void ObjectPathManager::runPathJob(PathJob& job) const
+{
+    auto& r = *job.ref;
+
+    if (job.create) this->createPath(r);
+
+    if (job.next_segment) this->startNextSegment(r);
+
+    if (job.repath) {
+        if (job.repath_update)
+            r.pathfinder->update(viewForObject(*r.object, r.ratio));
+
+        this->recalculatePath(r, true);
     }
+
+    if (job.recalculate) this->repairPath(r);
 }
 
 /**
  * Create a path for an object whose path does not exist yet
+ *
+ * The waypoints must have been planned already
  */
-void ObjectPathManager::createPath(PathRef& r)
+void ObjectPathManager::createPath(PathRef& r) const
 {
-    r.pathfinder->update(createBitmapForObject(*r.object, r.ratio), r.ratio);
-    auto elements =
-        r.pathfinder->findPath(r.start, r.end, r.object->getSize(), max_iter_paths_per_frame_);
+    r.pathfinder->update(viewForObject(*r.object, r.ratio));
+    auto elements = r.pathfinder->findPath(
+        r.start, r.target(), r.object->getSize(), max_iter_paths_per_frame_);
     assert(r.pathElements.size() == 0);
-    r.pathElements.insert(r.pathElements.begin(), elements.begin(), elements.end());
+    this->setPath(r, elements);
 }
 
 /**
  * Create a path for an object whose path already exists, essentially redoing it
  */
-void ObjectPathManager::recalculatePath(PathRef& r, bool force)
+void ObjectPathManager::recalculatePath(PathRef& r, bool force) const
 {
     auto& log = LoggerService::getLogger();
-    log->write(
-        "object-path-manager", LogType::Debug,
+    LOGDEBUG(
+        log, log_tag,
         "Recalculating path for handle {} ({}) ({} remaining points)", r.handleval(),
         r.object->getName(), r.pathElements.size());
 
-    if (r.pathElements.size() <= 2 && !force) return;
+    if (this->isNearTarget(r) && !force) return;
+
+    auto elements = r.pathfinder->findPath(
+        r.position(), r.target(), r.object->getSize(), max_iter_paths_per_frame_ / 2);
+    this->setPath(r, elements);
+}
+
+/**
+ * Repair the path of an object, because the objects around it moved
+ *
+ * The incremental pathfinder keeps its search between ticks, so, most of the time, this
+ * only checks the nodes around the cells that changed. If its search did not finish in
+ * this tick, we keep following the path we have. If it says there is no path, we let the
+ * normal pathfinder find the closest place we can go, like it always did.
+ */
+void ObjectPathManager::repairPath(PathRef& r) const
+{
+    if (!incremental_repath_) {
+        r.pathfinder->update(viewForObject(*r.object, r.ratio));
+        this->recalculatePath(r);
+        return;
+    }
+
+    if (this->isNearTarget(r)) return;
+
+    if (!r.replanner) r.replanner = std::make_unique<IncrementalPathfinder>(t_);
+
+    if (!r.replanner->plan(
+            viewForObject(*r.object, r.ratio), r.position(), r.target(),
+            r.object->getSize(), max_iter_paths_per_frame_))
+        return;
+
+    // Usually, we have no path because other objects surround us, and they will move
+    // away soon. Do not run a full search every tick because of this
+    if (!r.replanner->hasPossiblePath()) {
+        if (r.minimum_next_repath > 0) {
+            r.minimum_next_repath--;
+            return;
+        }
+
+        r.minimum_next_repath = unreachable_repath_ticks_;
+        r.pathfinder->update(viewForObject(*r.object, r.ratio));
+        this->recalculatePath(r);
+        return;
+    }
+
+    // If the normal pathfinder did not finish its search, it does not need to anymore
+    if (r.pathfinder->maxIterReached()) r.pathfinder->update(viewForObject(*r.object, r.ratio));
+
+    // Nothing that matters changed, and we are still walking on the last path we got
+    // from it, so it is still the best one
+    if (!r.replanner->pathChanged() && r.pathElements.back() == r.target()) return;
+
+    this->setPath(r, r.replanner->path());
+}
+
+/**
+ * Smooth a path found by a pathfinder, and make it the path of the object
+ *
+ * The pathfinders give us one point per step. We only need the points where the
+ * object needs to turn, so we can walk to them in a straight line.
+ */
+void ObjectPathManager::setPath(PathRef& r, const std::vector<glm::vec2>& elements) const
+{
+    auto smoother = PathSmoother(t_, viewForObject(*r.object, r.ratio));
+    auto path     = smoother.smooth(elements, r.object->getSize());
+    r.pathElements.assign(path.begin(), path.end());
+}
+
+/**
+ * Check if the object is so close to where it needs to go now that it does not need
+ * to search its path again
+ */
+bool ObjectPathManager::isNearTarget(const PathRef& r) const
+{
+    if (r.pathElements.empty()) return true;
+
+    auto delta = glm::abs(r.target() - r.position());
+    return std::max(delta.x, delta.y) <= 1;
+}
+
+/**
+ * Find the waypoints of a path, if the path is long enough to use the hierarchical
+ * pathfinder
+ *
+ * If some object already walked between the same regions, we reuse its waypoints. The
+ * normal pathfinder refines each segment between them anyway.
+ *
+ * If the hierarchical pathfinder cannot find a path, we let the normal pathfinder try
+ * to go directly to the end. At least it will walk to the closest point
+ */
+void ObjectPathManager::planWaypoints(PathRef& r)
+{
+    r.waypoints.clear();
+    if (hierarchical_min_distance_ <= 0 ||
+        glm::distance(r.start, r.end) < hierarchical_min_distance_)
+        return;
+
+    // Get the bitmap first, so the version we check in the cache is up to date
+    auto& bitmap = getStaticBitmap(r.ratio);
+    auto size    = r.object->getSize();
+    if (auto corridor = path_cache_.find(r.start, r.end, size, static_bitmap_version_)) {
+        // The last waypoint is the end of the path that created it
+        corridor->back() = r.end;
+
+        LOGDEBUG(
+            LoggerService::getLogger(), log_tag,
+            "path of handle {} has {} waypoints (from the cache)", r.handleval(),
+            corridor->size());
+        r.waypoints.assign(corridor->begin(), corridor->end());
+        return;
+    }
+
+    // Only compare the cells that changed since the last time we updated it, unless
+    // the change log does not go that far
+    if (auto changes = static_obstacles_.changesSince(hierarchical_grid_version_))
+        hierarchical_pf_.update(bitmap, r.ratio, *changes);
+    else
+        hierarchical_pf_.update(bitmap, r.ratio);
+
+    hierarchical_grid_version_ = static_obstacles_.version();
+    auto waypoints = hierarchical_pf_.findWaypoints(r.start, r.end);
+    if (!waypoints) {
+        LoggerService::getLogger()->write(
+            "object-path-manager", LogType::Info,
+            "no hierarchical path for handle {}, pathing directly", r.handleval());
+        return;
+    }
+
+    LOGDEBUG(
+        LoggerService::getLogger(), log_tag, "path of handle {} has {} waypoints", r.handleval(),
+        waypoints->size());
+    r.waypoints.assign(waypoints->begin(), waypoints->end());
+    path_cache_.add(r.start, r.end, size, static_bitmap_version_, std::move(*waypoints));
+}
 
+/**
+ * Start walking the next segment of a path split by the hierarchical pathfinder
+ *
+ * The object is at the end of the current segment, and the waypoint of the segment
+ * was already removed
+ */
+void ObjectPathManager::startNextSegment(PathRef& r) const
+{
     auto pos2d = glm::vec2(r.object->getPosition().x, r.object->getPosition().z);
-    if (r.pathElements.size() == 0) r.pathElements.push_back(pos2d);
+    r.pathfinder->update(viewForObject(*r.object, r.ratio));
+    auto elements = r.pathfinder->findPath(
+        pos2d, r.target(), r.object->getSize(), max_iter_paths_per_frame_);
+
+    // The segment might be blocked by something the hierarchical pathfinder does not
+    // know about, like the size of the object. Try to go directly to the end
+    if (!r.pathfinder->hasPossiblePath()) {
+        r.waypoints.clear();
+        r.pathfinder->update(viewForObject(*r.object, r.ratio));
+        elements = r.pathfinder->findPath(
+            pos2d, r.target(), r.object->getSize(), max_iter_paths_per_frame_);
+    }
 
-    auto posv = r.position().value_or(pos2d);
+    // The first element is where the object is now, and it was already there in this tick.
+    this->setPath(r, elements);
+    if (r.pathElements.size() > 1 && r.pathElements.front() == pos2d) r.pathElements.pop_front();
 
-    auto elements =
-        r.pathfinder->findPath(posv, r.end, r.object->getSize(), max_iter_paths_per_frame_ / 2);
-    r.pathElements.resize(elements.size());
-    std::copy(elements.begin(), elements.end(), r.pathElements.begin());
+    if (r.pathElements.empty()) r.pathElements.push_back(pos2d);
+}
+
+/**
+ * Get a flow field to some destination, for objects of some size, that covers
+ * at least the terrain cells in `bounds`
+ *
+ * If we do not have one, or the one we have is outdated, calculate it. A field is
+ * outdated only if some static obstacle changed near its bounds, so the objects
+ * that start or stop moving elsewhere do not make us calculate it again.
+ */
+std::shared_ptr<FlowField> ObjectPathManager::getFlowField(
+    glm::vec2 dest, glm::vec2 size, int ratio, ObstacleGrid::Region bounds)
+{
+    auto& bitmap = this->getStaticBitmap(ratio);
+
+    auto it = std::find_if(flow_fields_.begin(), flow_fields_.end(), [&](CachedFlowField& f) {
+        return f.field->destination() == dest && f.field->size() == size &&
+               f.field->ratio() == ratio;
+    });
+
+    if (it != flow_fields_.end()) {
+        auto fb      = it->field->bounds();
+        auto changes = static_obstacles_.changesSince(it->grid_version);
+        auto valid   = changes.has_value() && fb.x0 <= bounds.x0 && fb.y0 <= bounds.y0 &&
+                     fb.x1 >= bounds.x1 && fb.y1 >= bounds.y1;
+        if (valid) {
+            for (auto& r : *changes) {
+                if (!it->field->isAffectedBy(r)) continue;
+
+                valid = false;
+                break;
+            }
+        }
+
+        if (valid) {
+            it->grid_version = static_obstacles_.version();
+            return it->field;
+        }
+
+        // The new field needs to cover the objects of the old one, too
+        bounds = ObstacleGrid::Region{
+            std::min(fb.x0, bounds.x0), std::min(fb.y0, bounds.y0), std::max(fb.x1, bounds.x1),
+            std::max(fb.y1, bounds.y1)};
+    }
+
+    LOGDEBUG(
+        LoggerService::getLogger(), log_tag, "calculating flow field to {:.2f}, size {:.2f}",
+        dest, size);
+
+    auto field = std::make_shared<FlowField>(t_, bitmap, ratio, dest, size, bounds);
+    flow_field_builds_++;
+    if (it != flow_fields_.end()) {
+        *it = CachedFlowField{field, static_obstacles_.version()};
+    } else {
+        flow_fields_.push_back(CachedFlowField{field, static_obstacles_.version()});
+    }
+
+    return field;
+}
+
+/**
+ * Start following a flow field to the destination of the path
+ *
+ * Returns false if the destination cannot be reached with it, and so we
+ * need to use the pathfinder
+ */
+bool ObjectPathManager::startFlowFieldPath(PathRef& r)
+{
+    auto pos2d = glm::vec2(r.object->getPosition().x, r.object->getPosition().z);
+
+    r.flow_field = this->getFlowField(r.end, r.object->getSize(), r.ratio, r.flow_bounds);
+    if (!r.flow_field->isReachable(pos2d)) {
+        LoggerService::getLogger()->write(
+            "object-path-manager", LogType::Info,
+            "flow field to {:.2f} cannot reach handle {}, using the pathfinder", r.end,
+            r.handleval());
+        r.flow_field.reset();
+        r.use_flow_field = false;
+        return false;
+    }
+
+    r.pathElements.clear();
+    r.waypoints.clear();
+    r.blocked_ticks = 0;
+    return true;
+}
+
+/**
+ * Move the object to the next position of the flow field it is following
+ *
+ * We sample the field only when we reach a cell, and we only go to the next cell if it
+ * is not occupied by another object.
+ */
+void ObjectPathManager::updateFlowFieldPath(PathRef& r)
+{
+    auto& log  = LoggerService::getLogger();
+    auto pos2d = glm::vec2(r.object->getPosition().x, r.object->getPosition().z);
+
+    if (r.pathElements.empty()) {
+        if (glm::round(pos2d) == glm::round(r.end)) {
+            r.status = PathStatus::Completed;
+            return;
+        }
+
+        auto next = r.flow_field->nextPosition(pos2d, [&](glm::vec2 p) {
+            return r.blocked_ticks < max_blocked_ticks_ && this->isOccupiedByOthers(*r.object, p);
+        });
+
+        if (!next) {
+            if (!r.flow_field->isReachable(pos2d)) {
+                r.status = PathStatus::Unreachable;
+                return;
+            }
+
+            // The ones in front of us are already in the destination. Since we are
+            // moving in a group, we are close enough.
+            auto size          = r.object->getSize();
+            auto arrivalradius = std::max(size.x, size.y) * std::sqrt(double(r.group_size)) +
+                                 double(r.ratio);
+            r.blocked_ticks++;
+            if (glm::distance(pos2d, r.end) <= arrivalradius) {
+                log->write(
+                    "object-path-manager", LogType::Info,
+                    "Pathing of {} ({} - {}) completed near the destination", r.handleval(),
+                    r.object->getID(), r.object->getName());
+                r.status = PathStatus::Completed;
+            }
+            return;
+        }
+
+        r.blocked_ticks = 0;
+        r.pathElements.push_back(*next);
+    }
+
+    auto pos = this->updatePosition(r);
+    if (pos && r.pathElements.empty() && glm::round(*pos) == glm::round(r.end)) {
+        log->write(
+            "object-path-manager", LogType::Info, "Pathing of {} ({} - {}) completed!",
+            r.handleval(), r.object->getID(), r.object->getName());
+        r.status = PathStatus::Completed;
+    }
+}
+
+/**
+ * Check if an object would collide with another one if it goes to a certain position
+ *
+ * The object itself is also in the global obstacle bitmap, so we discount it
+ */
+bool ObjectPathManager::isOccupiedByOthers(const GameObject& o, glm::vec2 pos) const
+{
+    auto [width, height] = t_.getSize();
+    auto size            = o.getSize();
+
+    int ownx = o.getPosition().x;
+    int owny = o.getPosition().z;
+    auto isOwnCell = [&](int x, int y) {
+        return x >= ownx - double(size.x / 2) && x < ownx + double(size.x / 2) &&
+               y >= owny - double(size.y / 2) && y < owny + double(size.y / 2);
+    };
+
+    int posx = pos.x;
+    int posy = pos.y;
+    for (int y = posy - double(size.y / 2); y < posy + double(size.y / 2); y++) {
+        if (y < 0 || y >= height) continue;
+
+        for (int x = posx - double(size.x / 2); x < posx + double(size.x / 2); x++) {
+            if (x < 0 || x >= width) continue;
+
+            auto count = obstacles_.countAt(x, y);
+            if (isOwnCell(x, y) && count > 0) count--;
+
+            if (count > 0) return true;
+        }
+    }
+
+    return false;
 }
 
 /**
  * Update the position of an object
+ *
+ * The object walks through the segments of its path, and removes the waypoints it
+ * reaches, until it walked all it could in this tick.
+ *
+ * An object with a movement component walks its speed. The ones without it walk like
+ * they always did, one unit per tick in each axis, so they walk faster in diagonals.
  */
 std::optional<glm::vec2> ObjectPathManager::updatePosition(PathRef& r)
 {
+    if (r.pathElements.empty()) return std::nullopt;
+
+    auto& movement = r.object->getMovementComponent();
+    auto distance  = movement ? (movement->speed / 10.0) * (tick_duration_ / 1000.0) : 1.0;
+
     auto pos = r.position();
-    if (!pos) return std::nullopt;
+    while (!r.pathElements.empty() && distance > 0) {
+        auto delta  = r.pathElements.front() - pos;
+        auto length = movement ? double(glm::length(delta))
+                               : double(std::max(std::abs(delta.x), std::abs(delta.y)));
+
+        if (length > distance) {
+            pos += delta * float(distance / length);
+            break;
+        }
 
-    auto height = t_.getHeightFromCoords(*pos);
+        pos = r.pathElements.front();
+        distance -= length;
+        r.pathElements.pop_front();
+    }
 
-    setObjectOnBitmap(obstacle_bitmap_, *r.object, false);
-    setObjectOnBitmap(obstacle_bitmap_, *pos, r.object->getSize(), true);
+    auto height = t_.getHeightFromCoords(pos);
 
-    LoggerService::getLogger()->write(
-        "object-path-manager", LogType::Debug,
+    LOGDEBUG(
+        LoggerService::getLogger(), log_tag,
         "position of object id {:016x} ({}) is now ({:.2f}, {}, {:.2f})", r.object->getID(),
-        r.object->getName().c_str(), pos->x, height, pos->y);
-
-    assert(fabs(pos->x - r.object->getPosition().x) <= 1.5);
-    assert(fabs(pos->y - r.object->getPosition().z) <= 1.5);
+        r.object->getName().c_str(), pos.x, height, pos.y);
 
-    r.object->setPosition(glm::vec3(pos->x, height, pos->y));
-    mapped_objects_[r.object->getID()] = std::make_tuple<>(*pos, r.object->getSize());
-    r.pathElements.pop_front();
+    r.object->setPosition(glm::vec3(pos.x, height, pos.y));
+    this->mapObject(r.object->getID(), pos, r.object->getSize());
 
     return pos;
 }
 
 /**
  * Update the global obstacle bitmap with the data from our event receiver
+ *
+ * We do not rebuild it, the events only add and remove the objects they refer to.
+ */
+void ObjectPathManager::updateObstacleBitmap(const ObjectManager& om) { pollEntities(om); }
+
+/**
+ * Add an object to the obstacle grids and the spatial index, or update it if it is
+ * already there
+ *
+ * If the object is already there, only the cells it left and entered change
  */
-void ObjectPathManager::updateObstacleBitmap(const ObjectManager& om)
+void ObjectPathManager::mapObject(object_id_t id, glm::vec2 pos, glm::vec2 size)
 {
-    pollEntities(om);
-    std::fill(obstacle_bitmap_.begin(), obstacle_bitmap_.end(), false);
+    spatial_index_.update(id, pos, size);
+
+    auto isStatic = moving_objects_.find(id) == moving_objects_.end();
+
+    auto it = mapped_objects_.find(id);
+    if (it == mapped_objects_.end()) {
+        obstacles_.add(pos, size);
+        if (isStatic) static_obstacles_.add(pos, size);
+
+        if (!free_mapped_objects_.empty()) {
+            auto node = std::move(free_mapped_objects_.back());
+            free_mapped_objects_.pop_back();
+            node.key()    = id;
+            node.mapped() = std::make_tuple<>(pos, size);
+            mapped_objects_.insert(std::move(node));
+        } else {
+            mapped_objects_[id] = std::make_tuple<>(pos, size);
+        }
+        return;
+    }
 
-    for (auto [id, data] : mapped_objects_) {
-        auto pos  = std::get<0>(data);
-        auto size = std::get<1>(data);
+    auto [oldpos, oldsize] = it->second;
+    if (oldpos == pos && oldsize == size) return;
 
-        setObjectOnBitmap(obstacle_bitmap_, pos, size, true);
+    if (oldsize == size) {
+        obstacles_.move(oldpos, pos, size);
+        if (isStatic) static_obstacles_.move(oldpos, pos, size);
+    } else {
+        obstacles_.remove(oldpos, oldsize);
+        obstacles_.add(pos, size);
+        if (isStatic) {
+            static_obstacles_.remove(oldpos, oldsize);
+            static_obstacles_.add(pos, size);
+        }
     }
+
+    it->second = std::make_tuple<>(pos, size);
+}
+
+/**
+ * Remove an object from the obstacle grids and the spatial index
+ */
+void ObjectPathManager::unmapObject(object_id_t id)
+{
+    spatial_index_.remove(id);
+
+    auto it = mapped_objects_.find(id);
+    if (it == mapped_objects_.end()) return;
+
+    auto [pos, size] = it->second;
+    obstacles_.remove(pos, size);
+    if (moving_objects_.find(id) == moving_objects_.end()) static_obstacles_.remove(pos, size);
+
+    free_mapped_objects_.push_back(mapped_objects_.extract(it));
+}
+
+/**
+ * Move the objects that started or stopped moving out of, or into, the static
+ * obstacle grid
+ *
+ * The objects that are moving are the ones with a pathing operation that did not end
+ * yet.
+ */
+void ObjectPathManager::updateMovingObjects()
+{
+    std::unordered_set<object_id_t> moving;
+    for (auto& op : operations_) {
+        switch (op.status) {
+            case PathStatus::NotStarted:
+            case PathStatus::InProgress:
+            case PathStatus::Repathing: moving.insert(op.oid); break;
+            default: break;
+        }
+    }
+
+    for (auto id : moving_objects_) {
+        if (moving.find(id) != moving.end()) continue;
+
+        if (auto it = mapped_objects_.find(id); it != mapped_objects_.end()) {
+            auto [pos, size] = it->second;
+            static_obstacles_.add(pos, size);
+        }
+    }
+
+    for (auto id : moving) {
+        if (moving_objects_.find(id) != moving_objects_.end()) continue;
+
+        if (auto it = mapped_objects_.find(id); it != mapped_objects_.end()) {
+            auto [pos, size] = it->second;
+            static_obstacles_.remove(pos, size);
+        }
+    }
+
+    moving_objects_ = std::move(moving);
 }
 
 
@@ -356,20 +1003,20 @@ void ObjectPathManager::parseEntityEvent(const ObjectManager& om, const EntityEv
             auto pos  = (*obj)->getPosition();
             auto size = (*obj)->getSize();
 
-            log->write(
-                "object-path-manager", LogType::Debug,
+            LOGDEBUG(
+                log, log_tag,
                 "adding '{}' ({}) (pos {:.1f}) to the list of mapped objects (as an "
                 "obstacle)",
                 (*obj)->getName(), ec->objectID, (*obj)->getPosition());
 
-            mapped_objects_[ec->objectID] = std::make_tuple<>(glm::vec2(pos.x, pos.z), size);
+            this->mapObject(ec->objectID, glm::vec2(pos.x, pos.z), size);
         }
     }
 
     // We have this one only to set the pathref status, so it does not go away
     // immediately.
     if (auto* ec = std::get_if<EventDead>(&e.type); ec) {
-        mapped_objects_.erase(ec->objectID);
+        this->unmapObject(ec->objectID);
 
         // if we have a reference to any removed object, destroy it!
         auto* ref = findPathRefFromObject(ec->objectID);
@@ -381,24 +1028,23 @@ void ObjectPathManager::parseEntityEvent(const ObjectManager& om, const EntityEv
 
             ref->status = PathStatus::Stopped;
         }
+    }
 
-        if (auto* ec = std::get_if<EventDestroyed>(&e.type); ec) {
-            mapped_objects_.erase(ec->objectID);
+    if (auto* ec = std::get_if<EventDestroyed>(&e.type); ec) {
+        this->unmapObject(ec->objectID);
 
-            log->write(
-                "object-path-manager", LogType::Debug,
-                "removing pathing handle of destroyed entity {}", ec->objectID);
-
-            // if we have a reference to any removed object, destroy it!
-            auto* ref = findPathRefFromObject(ec->objectID);
-            if (ref) {
-                operations_.erase(
-                    std::remove_if(
-                        operations_.begin(), operations_.end(),
-                        [&](PathRef& r) { return r.oid == ec->objectID; }),
-                    operations_.end());
-            }
-        }
+        LOGDEBUG(
+            log, log_tag,
+            "removing pathing handle of destroyed entity {}", ec->objectID);
+
+        // if we have a reference to any removed object, destroy it! The object
+        // itself might have been freed already, so we only look at the IDs
+        operations_.erase(
+            std::remove_if(
+                operations_.begin(), operations_.end(),
+                [&](PathRef& r) { return r.oid == ec->objectID; }),
+            operations_.end());
+        this->reindexOperations();
     }
 }
 
@@ -409,107 +1055,64 @@ void ObjectPathManager::parseEntityEvent(const ObjectManager& om, const EntityEv
 void ObjectPathManager::pollEntities(const ObjectManager& om)
 {
 
-    while (!events_.empty()) {
-        EntityEvent e = events_.front();        
-        parseEntityEvent(om, e);
-        events_.pop();
-    }
+    for (auto& e : events_) parseEntityEvent(om, e);
+    events_.clear();
 }
 
 /**
- * Resize a object bitmap according to a certain ratio
- */
-
-/**
- * Creates an obstacle bitmap for the current game object
+ * Creates an obstacle bitmap view for the current game object
  *
  * Currently, it only removes the actual object from the bitmap, but, in the future,
  * it will also consider the terrain type (e.g, insert water for units that only walk
  * on land)
  */
-std::vector<bool> ObjectPathManager::createBitmapForObject(const GameObject& o, int ratio)
+ObstacleView ObjectPathManager::viewForObject(const GameObject& o, int ratio) const
 {
     /// TODO: if two objects are too close to each other, one might not be seen on the other's
     /// obstacle bitmap
-    std::vector<unsigned> v{obstacle_bitmap_};
-    setObjectOnBitmap(v, o, false, 1);
-
-    std::vector<bool> nv(v.size() / (ratio * ratio), false);
-
-    auto [w, h] = t_.getSize();
-    for (auto y = 0; y < h; y++) {
-        for (auto x = 0; x < w; x++) {
-            nv[(y / ratio) * (w / ratio) + (x / ratio)] = v[y * w + x] > 0;
-        }
-    }
-
-    return nv;
+    return ObstacleView(obstacles_, ratio, &o);
 }
 
 /**
- * Set the object data in the obstacle bitmap to a certain state
- */
-void ObjectPathManager::setObjectOnBitmap(
-    std::vector<bool>& bitmap, const GameObject& o, bool value, float ratio)
-{
-    auto pos2d = glm::vec2(o.getPosition().x, o.getPosition().z);
-    setObjectOnBitmap(bitmap, pos2d, o.getSize(), value, ratio);
-}
-/**
- * Set the object data in the obstacle bitmap to a certain state
+ * Get the obstacle bitmap with only the objects that are not moving
+ *
+ * We only calculate it once per tick, or when the pathing operations change, and
+ * only recalculate the cells in the regions of the static grid that changed.
  */
-void ObjectPathManager::setObjectOnBitmap(
-    std::vector<bool>& bitmap, glm::vec2 pos, glm::vec2 size, bool value, float ratio)
+const std::vector<bool>& ObjectPathManager::getStaticBitmap(int ratio)
 {
-    int posx = pos.x;
-    int posy = pos.y;
+    if (static_bitmap_valid_ && static_bitmap_ratio_ == ratio) return static_bitmap_;
 
-    auto [width, height] = t_.getSize();
+    this->updateMovingObjects();
+    static_obstacles_.addLevel(ratio);
 
-    for (int y = posy - double(size.y / 2); y < posy + double(size.y / 2); y++) {
-        if (y < 0 || y >= height) continue;
-
-        for (int x = posx - double(size.x / 2); x < posx + double(size.x / 2); x++) {
-            if (x < 0 || x >= width) continue;
-
-            bitmap[int(ceil(y / ratio)) * int(width / ratio) + int(ceil(x / ratio))] = value;
+    auto changed = false;
+    auto changes = static_obstacles_.changesSince(static_grid_version_);
+    if (static_bitmap_.empty() || ratio != static_bitmap_ratio_ || !changes) {
+        static_bitmap_ = static_obstacles_.toBitmap(ratio);
+        changed        = true;
+    } else {
+        auto width  = static_obstacles_.width() / ratio;
+        auto height = static_obstacles_.height() / ratio;
+
+        for (auto& r : *changes) {
+            for (auto cy = r.y0 / ratio; cy <= std::min(height - 1, (r.y1 - 1) / ratio); cy++) {
+                for (auto cx = r.x0 / ratio; cx <= std::min(width - 1, (r.x1 - 1) / ratio);
+                     cx++) {
+                    auto blocked = static_obstacles_.isBlocked(cx, cy, ratio);
+                    if (static_bitmap_[cy * width + cx] != blocked) {
+                        static_bitmap_[cy * width + cx] = blocked;
+                        changed                         = true;
+                    }
+                }
+            }
         }
     }
-}
-
-/**
- * Set the object data in the global obstacle bitmap to a certain state
- */
-void ObjectPathManager::setObjectOnBitmap(
-    std::vector<unsigned>& bitmap, const GameObject& o, bool value, float ratio)
-{
-    auto pos2d = glm::vec2(o.getPosition().x, o.getPosition().z);
-    setObjectOnBitmap(bitmap, pos2d, o.getSize(), value, ratio);
-}
-/**
- * Set the object data in the global obstacle bitmap to a certain state
- */
-void ObjectPathManager::setObjectOnBitmap(
-    std::vector<unsigned>& bitmap, glm::vec2 pos, glm::vec2 size, bool value, float ratio)
-{
-    int posx = pos.x;
-    int posy = pos.y;
 
-    auto [width, height] = t_.getSize();
+    static_grid_version_ = static_obstacles_.version();
+    if (changed) static_bitmap_version_++;
 
-    for (int y = posy - double(size.y / 2); y < posy + double(size.y / 2); y++) {
-        if (y < 0 || y >= height) continue;
-
-        for (int x = posx - double(size.x / 2); x < posx + double(size.x / 2); x++) {
-            if (x < 0 || x >= width) continue;
-
-            auto& val = bitmap[int(ceil(y / ratio)) * int(width / ratio) + int(ceil(x / ratio))];
-
-            if (value) {
-                val++;
-            } else {
-                if (val > 0) val--;
-            }
-        }
-    }
+    static_bitmap_ratio_ = ratio;
+    static_bitmap_valid_ = true;
+    return static_bitmap_;
 }
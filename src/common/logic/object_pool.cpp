@@ -0,0 +1,135 @@
+#include <common/logic/object_pool.hpp>
+
+using namespace familyline::logic;
+
+/**
+ * Free lists of memory blocks, by block size
+ *
+ * It is shared by all allocators that come from the same pool, and lives while
+ * any of them (and so any control block) lives.
+ */
+struct ObjectPool::BlockPool {
+    std::unordered_map<size_t, std::vector<void*>> free;
+
+    size_t allocated = 0;
+    size_t reused    = 0;
+
+    void* get(size_t bytes)
+    {
+        auto& list = free[bytes];
+        if (list.empty()) {
+            allocated++;
+            return ::operator new(bytes);
+        }
+
+        reused++;
+        auto* p = list.back();
+        list.pop_back();
+        return p;
+    }
+
+    void put(void* p, size_t bytes) { free[bytes].push_back(p); }
+
+    ~BlockPool()
+    {
+        for (auto& [bytes, list] : free) {
+            for (auto* p : list) ::operator delete(p);
+        }
+    }
+};
+
+/**
+ * An allocator that takes its blocks from a BlockPool
+ *
+ * shared_ptr uses it to allocate its control block
+ */
+template <typename T>
+struct ObjectPool::BlockAllocator {
+    using value_type = T;
+
+    std::shared_ptr<BlockPool> pool;
+
+    explicit BlockAllocator(std::shared_ptr<BlockPool> p) : pool(std::move(p)) {}
+
+    template <typename U>
+    BlockAllocator(const BlockAllocator<U>& o) : pool(o.pool)
+    {
+    }
+
+    T* allocate(size_t n) { return static_cast<T*>(pool->get(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) { pool->put(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const BlockAllocator<U>& o) const
+    {
+        return pool == o.pool;
+    }
+
+    template <typename U>
+    bool operator!=(const BlockAllocator<U>& o) const
+    {
+        return pool != o.pool;
+    }
+};
+
+/**
+ * The deleter of the shared_ptrs we give
+ *
+ * It has the real owner of the object, and gives it back to the pool. If the pool
+ * does not exist anymore, the object is destroyed.
+ */
+struct ObjectPool::Release {
+    std::shared_ptr<GameObject> owner;
+    std::weak_ptr<ObjectPool> pool;
+
+    void operator()(GameObject*)
+    {
+        if (auto p = pool.lock()) p->release(std::move(owner));
+
+        owner.reset();
+    }
+};
+
+ObjectPool::ObjectPool() : blocks_(std::make_shared<BlockPool>()) {}
+
+/**
+ * Get an object of the same type of `prototype`, reusing one if we can
+ */
+std::shared_ptr<GameObject> ObjectPool::acquire(GameObject& prototype)
+{
+    std::shared_ptr<GameObject> owner;
+
+    auto it = free_objects_.find(prototype.getType());
+    if (it != free_objects_.end() && !it->second.empty()) {
+        owner = std::move(it->second.back());
+        it->second.pop_back();
+        owner->reset(prototype);
+        objects_reused_++;
+    } else {
+        owner = prototype.create();
+        objects_created_++;
+    }
+
+    auto* raw = owner.get();
+    return std::shared_ptr<GameObject>(
+        raw, Release{std::move(owner), weak_from_this()}, BlockAllocator<GameObject>(blocks_));
+}
+
+void ObjectPool::release(std::shared_ptr<GameObject> o)
+{
+    free_objects_[o->getType()].push_back(std::move(o));
+}
+
+/**
+ * Destroy the objects that are waiting to be reused
+ */
+void ObjectPool::clear() { free_objects_.clear(); }
+
+ObjectPool::Stats ObjectPool::stats() const
+{
+    size_t free_objects = 0;
+    for (auto& [type, list] : free_objects_) free_objects += list.size();
+
+    return Stats{
+        objects_created_, objects_reused_, blocks_->allocated, blocks_->reused, free_objects};
+}
@@ -0,0 +1,370 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <common/logic/game_object.hpp>
+#include <common/logic/obstacle_grid.hpp>
+
+using namespace familyline::logic;
+
+/// Number of changes we keep in the log
+constexpr size_t MaxLoggedChanges = 4096;
+
+/// The maximum clearance we can store
+constexpr int MaxClearance = 255;
+
+ObstacleGrid::ObstacleGrid(int width, int height)
+    : width_(width), height_(height), counts_(width * height, 0)
+{
+    changes_.reserve(MaxLoggedChanges);
+}
+
+/**
+ * Get the cells covered by an object in a certain position, with a certain size
+ *
+ * Uses the same rules the path manager always used to mark objects in its bitmap
+ */
+ObstacleGrid::Region ObstacleGrid::footprint(glm::vec2 pos, glm::vec2 size) const
+{
+    int posx = pos.x;
+    int posy = pos.y;
+    auto hx  = double(size.x / 2);
+    auto hy  = double(size.y / 2);
+
+    return Region{
+        std::max(0, int(posx - hx)), std::max(0, int(posy - hy)),
+        std::min(width_, int(std::ceil(posx + hx))), std::min(height_, int(std::ceil(posy + hy)))};
+}
+
+void ObstacleGrid::add(glm::vec2 pos, glm::vec2 size)
+{
+    auto r = this->footprint(pos, size);
+    this->stamp(r, 1);
+    this->regionChanged(r);
+}
+
+void ObstacleGrid::remove(glm::vec2 pos, glm::vec2 size)
+{
+    auto r = this->footprint(pos, size);
+    this->stamp(r, -1);
+    this->regionChanged(r);
+}
+
+/**
+ * Move an object from a position to another
+ *
+ * The objects move at most one cell per tick, so both footprints are almost the same
+ * region. We handle both as a single changed region
+ */
+void ObstacleGrid::move(glm::vec2 from, glm::vec2 to, glm::vec2 size)
+{
+    auto rfrom = this->footprint(from, size);
+    auto rto   = this->footprint(to, size);
+    this->stamp(rfrom, -1);
+    this->stamp(rto, 1);
+
+    if (rfrom.empty() || rto.empty()) {
+        this->regionChanged(rfrom);
+        this->regionChanged(rto);
+        return;
+    }
+
+    this->regionChanged(Region{
+        std::min(rfrom.x0, rto.x0), std::min(rfrom.y0, rto.y0), std::max(rfrom.x1, rto.x1),
+        std::max(rfrom.y1, rto.y1)});
+}
+
+/**
+ * Add (delta = 1) or remove (delta = -1) an object from all cells of a region
+ */
+void ObstacleGrid::stamp(Region r, int delta)
+{
+    for (auto y = r.y0; y < r.y1; y++) {
+        for (auto x = r.x0; x < r.x1; x++) {
+            auto& c = counts_[y * width_ + x];
+            if (delta > 0) {
+                if (c++ == 0) this->updateLevels(x, y, 1);
+            } else if (c > 0) {
+                if (--c == 0) this->updateLevels(x, y, -1);
+            }
+        }
+    }
+}
+
+/**
+ * Update everything that depends on the cells of a region, after they changed
+ */
+void ObstacleGrid::regionChanged(Region r)
+{
+    for (auto& l : levels_) this->updateClearance(l, r);
+
+    this->logChange(r);
+}
+
+/**
+ * Remove every object
+ */
+void ObstacleGrid::clear()
+{
+    std::fill(counts_.begin(), counts_.end(), 0);
+    for (auto& l : levels_) std::fill(l.occupied.begin(), l.occupied.end(), 0);
+
+    this->regionChanged(Region{0, 0, width_, height_});
+}
+
+/**
+ * Start maintaining a downsampled level with a certain ratio
+ *
+ * The level is built from the current grid. After this, it is only updated
+ * incrementally
+ */
+void ObstacleGrid::addLevel(int ratio)
+{
+    assert(ratio > 0);
+    if (this->hasLevel(ratio)) return;
+
+    Level l{
+        .ratio         = ratio,
+        .width         = width_ / ratio,
+        .height        = height_ / ratio,
+        .occupied      = {},
+        .clearance     = {},
+        .max_clearance = 0};
+    l.occupied.assign(l.width * l.height, 0);
+
+    for (auto y = 0; y < l.height * ratio; y++) {
+        for (auto x = 0; x < l.width * ratio; x++) {
+            if (counts_[y * width_ + x] > 0) l.occupied[(y / ratio) * l.width + (x / ratio)]++;
+        }
+    }
+
+    levels_.push_back(std::move(l));
+}
+
+const ObstacleGrid::Level* ObstacleGrid::findLevel(int ratio) const
+{
+    auto it = std::find_if(
+        levels_.begin(), levels_.end(), [ratio](const Level& l) { return l.ratio == ratio; });
+    return it == levels_.end() ? nullptr : &(*it);
+}
+
+ObstacleGrid::Level* ObstacleGrid::findLevel(int ratio)
+{
+    auto it = std::find_if(
+        levels_.begin(), levels_.end(), [ratio](const Level& l) { return l.ratio == ratio; });
+    return it == levels_.end() ? nullptr : &(*it);
+}
+
+/**
+ * Maintain a clearance map for a level, so we can check objects of up to `size` cells
+ * with a single lookup
+ *
+ * If the size is bigger than the one we maintain now, we calculate the whole map again
+ */
+void ObstacleGrid::addClearance(int ratio, int size)
+{
+    this->addLevel(ratio);
+    auto* l = this->findLevel(ratio);
+
+    size = std::clamp(size, 1, MaxClearance);
+    if (size <= l->max_clearance) return;
+
+    l->max_clearance = size;
+    l->clearance.assign(l->width * l->height, 0);
+    this->updateClearance(*l, Region{0, 0, width_, height_});
+}
+
+/**
+ * Recalculate the clearance of the cells whose square might reach a region of
+ * the full resolution grid
+ *
+ * The clearance of a cell depends on the cells at its right and below it, so we
+ * calculate from the bottom right to the top left. The cells after the region already
+ * have the right values, and, since the clearance has a maximum, only the cells up to
+ * that distance before the region can change.
+ */
+void ObstacleGrid::updateClearance(Level& l, Region r)
+{
+    if (l.max_clearance == 0 || r.empty()) return;
+
+    auto x0 = std::max(0, r.x0 / l.ratio - l.max_clearance + 1);
+    auto y0 = std::max(0, r.y0 / l.ratio - l.max_clearance + 1);
+    auto x1 = std::min(l.width - 1, (r.x1 - 1) / l.ratio);
+    auto y1 = std::min(l.height - 1, (r.y1 - 1) / l.ratio);
+
+    // The cells outside of the level do not limit the clearance, like the pathfinder, that
+    // ignores the parts of an object that are outside of the map
+    auto clearanceAt = [&](int x, int y) {
+        if (x >= l.width || y >= l.height) return l.max_clearance;
+
+        return int(l.clearance[y * l.width + x]);
+    };
+
+    for (auto y = y1; y >= y0; y--) {
+        for (auto x = x1; x >= x0; x--) {
+            auto idx = y * l.width + x;
+            if (l.occupied[idx] > 0) {
+                l.clearance[idx] = 0;
+                continue;
+            }
+
+            auto c = 1 + std::min(
+                             {clearanceAt(x + 1, y), clearanceAt(x, y + 1),
+                              clearanceAt(x + 1, y + 1)});
+            l.clearance[idx] = uint8_t(std::min(c, l.max_clearance));
+        }
+    }
+}
+
+/**
+ * A cell of the full resolution grid became free (delta = -1) or occupied (delta = 1)
+ */
+void ObstacleGrid::updateLevels(int x, int y, int delta)
+{
+    for (auto& l : levels_) {
+        auto cx = x / l.ratio;
+        auto cy = y / l.ratio;
+        if (cx >= l.width || cy >= l.height) continue;
+
+        l.occupied[cy * l.width + cx] += delta;
+    }
+}
+
+void ObstacleGrid::logChange(Region r)
+{
+    if (r.empty()) return;
+
+    version_++;
+    if (changes_.size() < MaxLoggedChanges) {
+        changes_.push_back(r);
+        return;
+    }
+
+    // The log is full: the new change takes the place of the oldest one
+    changes_[changes_head_] = r;
+    changes_head_           = (changes_head_ + 1) % changes_.size();
+    first_change_++;
+}
+
+/**
+ * The regions that changed after a certain version, oldest first
+ */
+std::optional<std::vector<ObstacleGrid::Region>> ObstacleGrid::changesSince(
+    uint64_t version) const
+{
+    if (version >= version_) return std::make_optional<std::vector<Region>>();
+
+    if (version + 1 < first_change_) return std::nullopt;
+
+    std::vector<Region> ret;
+    for (auto i = size_t(version + 1 - first_change_); i < changes_.size(); i++)
+        ret.push_back(changes_[(changes_head_ + i) % changes_.size()]);
+
+    return std::make_optional(std::move(ret));
+}
+
+/**
+ * Check if a cell of a downsampled level is an obstacle
+ *
+ * If the cell does not intersect the excluded region, the level already has the
+ * answer. If it does, we only need to look at the cells of the intersection: the ones
+ * with only one object will be free.
+ */
+bool ObstacleGrid::isBlocked(int cx, int cy, int ratio, Region exclude) const
+{
+    auto* l = this->findLevel(ratio);
+    assert(l);
+
+    if (cx < 0 || cy < 0 || cx >= l->width || cy >= l->height) return true;
+
+    auto occupied = l->occupied[cy * l->width + cx];
+    if (occupied == 0) return false;
+
+    auto x0 = std::max(cx * ratio, exclude.x0);
+    auto x1 = std::min((cx + 1) * ratio, exclude.x1);
+    auto y0 = std::max(cy * ratio, exclude.y0);
+    auto y1 = std::min((cy + 1) * ratio, exclude.y1);
+
+    for (auto y = y0; y < y1; y++) {
+        for (auto x = x0; x < x1; x++) {
+            if (counts_[y * width_ + x] == 1) occupied--;
+        }
+    }
+
+    return occupied > 0;
+}
+
+/**
+ * Check if all the cells of a region of a downsampled level are free
+ *
+ * We split the region in squares as big as possible (so a square region is a single
+ * square), and check the clearance of each one. The cells near the excluded region are
+ * checked one by one, since the clearance map does not know about the exclusion.
+ */
+bool ObstacleGrid::isFree(int ratio, int cx0, int cy0, int cx1, int cy1, Region exclude) const
+{
+    auto* l = this->findLevel(ratio);
+    assert(l);
+
+    if (cx0 > cx1 || cy0 > cy1) return true;
+
+    if (cx0 < 0 || cy0 < 0 || cx1 >= l->width || cy1 >= l->height) return false;
+
+    auto excluded = !exclude.empty() && cx0 * ratio < exclude.x1 &&
+                    (cx1 + 1) * ratio > exclude.x0 && cy0 * ratio < exclude.y1 &&
+                    (cy1 + 1) * ratio > exclude.y0;
+
+    if (l->max_clearance == 0 || excluded) {
+        for (auto y = cy0; y <= cy1; y++) {
+            for (auto x = cx0; x <= cx1; x++) {
+                if (this->isBlocked(x, y, ratio, exclude)) return false;
+            }
+        }
+
+        return true;
+    }
+
+    auto side = std::min({cx1 - cx0 + 1, cy1 - cy0 + 1, l->max_clearance});
+    for (auto y = cy0; y <= cy1; y += side) {
+        auto sy = std::min(y, cy1 - side + 1);
+        for (auto x = cx0; x <= cx1; x += side) {
+            auto sx = std::min(x, cx1 - side + 1);
+            if (l->clearance[sy * l->width + sx] < side) return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Create a bitmap of a downsampled level, one element per cell
+ */
+std::vector<bool> ObstacleGrid::toBitmap(int ratio) const
+{
+    auto* l = this->findLevel(ratio);
+    assert(l);
+
+    std::vector<bool> bitmap(l->occupied.size());
+    std::transform(l->occupied.begin(), l->occupied.end(), bitmap.begin(), [](unsigned v) {
+        return v > 0;
+    });
+
+    return bitmap;
+}
+
+ObstacleView::ObstacleView(const ObstacleGrid& grid, int ratio, const GameObject* self)
+    : grid_(&grid), ratio_(ratio), self_(self)
+{
+    assert(grid.hasLevel(ratio));
+    this->refresh();
+}
+
+/**
+ * Read the position of the object again
+ */
+void ObstacleView::refresh()
+{
+    if (!self_) return;
+
+    auto pos = self_->getPosition();
+    exclude_ = grid_->footprint(glm::vec2(pos.x, pos.z), self_->getSize());
+}
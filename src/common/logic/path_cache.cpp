@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <cmath>
+#include <common/logic/path_cache.hpp>
+
+using namespace familyline::logic;
+
+/**
+ * Find a path in the cache
+ *
+ * If we find it, it becomes the most recently used one
+ */
+std::optional<std::vector<glm::vec2>> PathCache::find(
+    glm::vec2 start, glm::vec2 end, glm::vec2 size, unsigned version)
+{
+    this->checkVersion(version);
+
+    auto it = index_.find(this->makeKey(start, end, size));
+    if (it == index_.end()) {
+        misses_++;
+        return std::nullopt;
+    }
+
+    hits_++;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return std::make_optional(it->second->corridor);
+}
+
+/**
+ * Add a path to the cache
+ */
+void PathCache::add(
+    glm::vec2 start, glm::vec2 end, glm::vec2 size, unsigned version,
+    std::vector<glm::vec2> corridor)
+{
+    if (capacity_ == 0) return;
+
+    this->checkVersion(version);
+
+    auto key = this->makeKey(start, end, size);
+    if (auto it = index_.find(key); it != index_.end()) {
+        it->second->corridor = std::move(corridor);
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+
+    if (entries_.size() >= capacity_) {
+        index_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+
+    entries_.push_front(Entry{key, std::move(corridor)});
+    index_[key] = entries_.begin();
+}
+
+void PathCache::clear()
+{
+    entries_.clear();
+    index_.clear();
+}
+
+/**
+ * Set the size of the regions
+ *
+ * The keys we have are for the old regions, so we discard everything
+ */
+void PathCache::setRegionSize(int v)
+{
+    if (v == region_size_) return;
+
+    region_size_ = std::max(1, v);
+    this->clear();
+}
+
+PathCache::Stats PathCache::stats() const
+{
+    // Each entry is in the list and in the index, and each of them allocates a node
+    size_t memory = entries_.size() * (sizeof(Entry) + 2 * sizeof(void*) + sizeof(Key) +
+                                       sizeof(std::list<Entry>::iterator) + 2 * sizeof(void*));
+    for (auto& e : entries_) memory += e.corridor.capacity() * sizeof(glm::vec2);
+
+    return Stats{hits_, misses_, entries_.size(), memory};
+}
+
+PathCache::Key PathCache::makeKey(glm::vec2 start, glm::vec2 end, glm::vec2 size) const
+{
+    return Key{
+        int(start.x) / region_size_, int(start.y) / region_size_, int(end.x) / region_size_,
+        int(end.y) / region_size_, int(std::ceil(std::max(size.x, size.y)))};
+}
+
+void PathCache::checkVersion(unsigned version)
+{
+    if (version == version_) return;
+
+    this->clear();
+    version_ = version;
+}
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cmath>
+#include <common/logic/path_smoother.hpp>
+
+using namespace familyline::logic;
+
+/**
+ * Check if an object can walk in a straight line from a point to another
+ *
+ * We walk through the line in steps of at most one unit in each axis. The cells the
+ * object covers only grow in the direction it walks, so every cell it covers between
+ * two steps is inside of the rectangle around what it covers in both of them. We check
+ * that rectangle. It might be a little more than what the object really covers, but
+ * never less.
+ *
+ * The cells covered in each position are the same ones the pathfinder checks (see
+ * Pathfinder::isWalkable())
+ */
+bool PathSmoother::canWalkStraight(glm::vec2 from, glm::vec2 to, glm::vec2 size) const
+{
+    auto [width, height] = t_.getSize();
+    auto ratio           = view_.ratio();
+
+    auto delta = to - from;
+    auto steps = std::max(1, int(std::ceil(std::max(std::abs(delta.x), std::abs(delta.y)))));
+
+    auto prev = from;
+    for (auto i = 1; i <= steps; i++) {
+        auto next = glm::mix(from, to, float(i) / float(steps));
+
+        auto minx = std::max(0, int(glm::round(std::min(prev.x, next.x) - (size.x / 2.0))));
+        auto maxx =
+            std::min(int(width) - 1, int(glm::round(std::max(prev.x, next.x) + (size.x / 2.0))));
+        auto miny = std::max(0, int(glm::round(std::min(prev.y, next.y) - (size.y / 2.0))));
+        auto maxy =
+            std::min(int(height) - 1, int(glm::round(std::max(prev.y, next.y) + (size.y / 2.0))));
+
+        if (minx > maxx || miny > maxy) return false;
+        if (!view_.isFree(minx / ratio, miny / ratio, maxx / ratio, maxy / ratio)) return false;
+
+        prev = next;
+    }
+
+    return true;
+}
+
+/**
+ * Smooth a path
+ *
+ * We only try to skip to the corners of the compressed path. The points in the middle
+ * of the lines would rarely let us go further, and checking each one of them would be
+ * a lot more expensive.
+ */
+std::vector<glm::vec2> PathSmoother::smooth(
+    const std::vector<glm::vec2>& path, glm::vec2 size) const
+{
+    auto corners = this->compress(path);
+    if (corners.size() <= 2) return corners;
+
+    std::vector<glm::vec2> result = {corners.front()};
+    auto anchor                   = corners.front();
+    for (auto i = 1u; i < corners.size() - 1; i++) {
+        if (this->canWalkStraight(anchor, corners[i + 1], size)) continue;
+
+        result.push_back(corners[i]);
+        anchor = corners[i];
+    }
+
+    result.push_back(corners.back());
+    return result;
+}
+
+/**
+ * Remove the points that are in the middle of a straight line
+ *
+ * A point is in the middle of a line if the direction we walk to reach it is the same
+ * one we walk to leave it
+ */
+std::vector<glm::vec2> PathSmoother::compress(const std::vector<glm::vec2>& path) const
+{
+    std::vector<glm::vec2> result;
+    for (auto& p : path) {
+        if (!result.empty() && result.back() == p) continue;
+
+        if (result.size() >= 2) {
+            auto in  = result.back() - result[result.size() - 2];
+            auto out = p - result.back();
+
+            auto cross = in.x * out.y - in.y * out.x;
+            if (std::abs(cross) < 1e-4 * glm::length(in) * glm::length(out) &&
+                glm::dot(in, out) > 0) {
+                result.back() = p;
+                continue;
+            }
+        }
+
+        result.push_back(p);
+    }
+
+    return result;
+}
@@ -6,6 +6,8 @@
 
 using namespace familyline::logic;
 
+static const familyline::LogTag log_tag{"pathfinder"};
+
 #include <algorithm>
 #include <iterator>
 
@@ -18,69 +20,141 @@ const Pathfinder::TerrainTile Pathfinder::getTileAtPosition(glm::vec2 p)
 }
 
 /**
- * Sort the list so that the best tiles stay in the top
+ * Get the node index of a certain position in the grid, or InvalidNode if the
+ * position is out of the grid
  */
-Pathfinder::PathNode* sortBestTile(std::list<std::unique_ptr<Pathfinder::PathNode>>& open_list)
+Pathfinder::node_index_t Pathfinder::nodeIndex(glm::vec2 pos) const
 {
-    open_list.sort([](const std::unique_ptr<Pathfinder::PathNode>& a,
-                      const std::unique_ptr<Pathfinder::PathNode>& b) { return a->f() < b->f(); });
-    return open_list.front().get();
+    if (pos.x < 0 || pos.y < 0) return InvalidNode;
+
+    auto x = int(pos.x) / ratio_;
+    auto y = int(pos.y) / ratio_;
+    if (x >= grid_width_ || y >= grid_height_) return InvalidNode;
+
+    return node_index_t(y * grid_width_ + x);
 }
 
 /**
- * Generate a list of neighbors for a given node
- *
- * We generate exactly 8 neigbors, in all directions, like this:
- *
- *   N | N | N     (X is the given node, all others are the neighbors)
- *  ---+---+---
- *   N | X | N
- *  ---+---+---
- *   N | N | N
- *
- *  We might generate less neighbors if, for example, you are in the border of
- *  the map, and the neighbor would be out of the map (less than 0, or more than
- *  the width/height)
+ * Get the node at a certain index, resetting it if it belongs to an older search
+ */
+Pathfinder::PathNode& Pathfinder::getNode(node_index_t idx, glm::vec2 pos)
+{
+    auto& n = nodes_[idx];
+    if (n.gen != search_gen_) {
+        n          = PathNode{};
+        n.gen      = search_gen_;
+        n.position = pos;
+    }
+
+    return n;
+}
+
+/**
+ * Compare two nodes in the open heap
  *
+ * The node with the lowest f() is the best. If both are equal, the oldest one
+ * is the best
  */
-std::vector<std::unique_ptr<Pathfinder::PathNode>> Pathfinder::generateNeighbors(const PathNode& n)
+bool Pathfinder::heapLess(node_index_t a, node_index_t b) const
 {
-    auto [width, height] = t_.getSize();
+    auto& na = nodes_[a];
+    auto& nb = nodes_[b];
+    auto fa  = na.f();
+    auto fb  = nb.f();
+
+    if (fa != fb) return fa < fb;
+
+    return na.order < nb.order;
+}
+
+void Pathfinder::heapSiftUp(uint32_t pos)
+{
+    auto idx = open_heap_[pos];
+    while (pos > 0) {
+        auto parent = (pos - 1) / 2;
+        if (!heapLess(idx, open_heap_[parent])) break;
+
+        open_heap_[pos]                      = open_heap_[parent];
+        nodes_[open_heap_[pos]].heap_index = pos;
+        pos                                  = parent;
+    }
+
+    open_heap_[pos]        = idx;
+    nodes_[idx].heap_index = pos;
+}
 
-    std::vector<glm::vec2> directions = {{-ratio_, -ratio_}, {0, -ratio_},    {ratio_, -ratio_},
-                                         {-ratio_, 0},       {ratio_, 0},     {-ratio_, ratio_},
-                                         {0, ratio_},        {ratio_, ratio_}};
+void Pathfinder::heapSiftDown(uint32_t pos)
+{
+    auto idx  = open_heap_[pos];
+    auto size = uint32_t(open_heap_.size());
+    while (true) {
+        auto child = pos * 2 + 1;
+        if (child >= size) break;
+
+        if (child + 1 < size && heapLess(open_heap_[child + 1], open_heap_[child])) child++;
 
-    std::vector<std::unique_ptr<Pathfinder::PathNode>> ret;
-    for (auto& d : directions) {
-        auto newpos = d + n.position;
-        assert(int(newpos.x) % ratio_ == 0);
-        assert(int(newpos.y) % ratio_ == 0);
+        if (!heapLess(open_heap_[child], idx)) break;
 
-        if (newpos.x < 0 || newpos.y < 0) continue;
+        open_heap_[pos]                      = open_heap_[child];
+        nodes_[open_heap_[pos]].heap_index = pos;
+        pos                                  = child;
+    }
 
-        if (newpos.x >= width || newpos.y >= height) continue;
+    open_heap_[pos]        = idx;
+    nodes_[idx].heap_index = pos;
+}
 
-        ret.push_back(std::make_unique<PathNode>(newpos));
+/**
+ * Put a node in the open list, or update its position if it is already there
+ */
+void Pathfinder::pushOpen(node_index_t idx)
+{
+    auto& n = nodes_[idx];
+    if (n.state == NodeState::Open) {
+        heapSiftUp(n.heap_index);
+        heapSiftDown(n.heap_index);
+        return;
     }
-    return ret;
+
+    if (n.state == NodeState::Closed) closed_count_--;
+
+    n.state = NodeState::Open;
+    n.order = next_order_++;
+    open_heap_.push_back(idx);
+    heapSiftUp(uint32_t(open_heap_.size() - 1));
 }
 
 /**
- * Check if the node is in the open list
- *
- * If yes, return a pointer to it
- * If not, return nullptr
+ * Remove the best node from the open list
  */
-Pathfinder::PathNode* Pathfinder::findInOpenList(const PathNode& n)
+Pathfinder::node_index_t Pathfinder::popOpen()
 {
-    auto it = std::find_if(
-        open_list_.begin(), open_list_.end(),
-        [&](const std::unique_ptr<Pathfinder::PathNode>& v) { return v->position == n.position; });
+    auto best = open_heap_.front();
+    auto last = open_heap_.back();
+    open_heap_.pop_back();
+
+    if (!open_heap_.empty()) {
+        open_heap_[0]           = last;
+        nodes_[last].heap_index = 0;
+        heapSiftDown(0);
+    }
 
-    if (it == open_list_.end()) return nullptr;
+    return best;
+}
 
-    return it->get();
+/**
+ * Move a node to the closed state
+ *
+ * The node must not be in the open heap anymore.
+ */
+void Pathfinder::closeNode(node_index_t idx)
+{
+    auto& n = nodes_[idx];
+    if (n.state != NodeState::Closed) closed_count_++;
+
+    n.state = NodeState::Closed;
+    last_closed_ = idx;
+    expanded_nodes_++;
 }
 
 /**
@@ -125,235 +199,284 @@ std::vector<glm::vec2> Pathfinder::getCoordsInsideObject(glm::vec2 pos, glm::vec
  *   ooooo |
  *         -
  */
-bool Pathfinder::isWalkable(const PathNode& n, glm::vec2 size) const
+bool Pathfinder::isWalkable(glm::vec2 pos, glm::vec2 size) const
 {
-    auto width  = std::get<0>(t_.getSize());
-    auto coords = getCoordsInsideObject(n.position, size);
-    std::vector<unsigned int> indices;
-    auto ratio = ratio_;
-    std::transform(
-        coords.begin(), coords.end(), std::back_inserter(indices),
-        [width, ratio](auto& v) { return int(v.y / ratio) * (width / ratio) + int(v.x / ratio); });
-
-    if (indices.size() == 0) return false;
-
-    return std::all_of(indices.begin(), indices.end(), [&](auto index) {
-        return (index >= obstacle_bitmap_.size()) ? false : !obstacle_bitmap_[index];
-    });
-}
+    assert(size.x > 0);
+    assert(size.y > 0);
+    auto [width, height] = t_.getSize();
 
-/**
- * Check if node is in the closed list
- */
-bool Pathfinder::isInClosedList(const PathNode& n) const
-{
-    auto it = std::find_if(
-        closed_list_.rbegin(), closed_list_.rend(),
-        [&](const std::unique_ptr<Pathfinder::PathNode>& v) { return v->position == n.position; });
-    return (it != closed_list_.rend());
-}
+    // The same coordinates getCoordsInsideObject() would return, but we check each cell of
+    // the bitmap only once, and do not allocate anything.
+    auto minx = std::max(0, int(glm::round(pos.x - (size.x / 2.0))));
+    auto maxx = std::min(int(width) - 1, int(glm::round(pos.x + (size.x / 2.0))));
+    auto miny = std::max(0, int(glm::round(pos.y - (size.y / 2.0))));
+    auto maxy = std::min(int(height) - 1, int(glm::round(pos.y + (size.y / 2.0))));
 
-void Pathfinder::moveToClosedList(Pathfinder::PathNode* n)
-{
-    auto ptr = std::find_if(
-        open_list_.begin(), open_list_.end(),
-        [&](std::unique_ptr<PathNode>& node) { return node.get() == n; });
-    assert(ptr != open_list_.end());
+    if (minx > maxx || miny > maxy) return false;
 
-    auto distance = std::distance(open_list_.begin(), ptr);
-    std::unique_ptr<PathNode> nnode;
-    nnode = std::move(*ptr);
+    // The obstacle grid has a clearance map, so it can answer this with a single lookup
+    // for most objects
+    if (view_) return view_->isFree(minx / ratio_, miny / ratio_, maxx / ratio_, maxy / ratio_);
 
-    open_list_.erase(std::next(open_list_.begin(), distance));
+    for (auto y = miny / ratio_; y <= maxy / ratio_; y++) {
+        for (auto x = minx / ratio_; x <= maxx / ratio_; x++) {
+            if (this->isCellBlocked(x, y)) return false;
+        }
+    }
 
-    closed_list_.push_back(std::move(nnode));
+    return true;
 }
 
-/// Purge the list of non-existing pointers or pointers that point to nothing
-void purgeList(std::list<std::unique_ptr<Pathfinder::PathNode>>& list)
+/**
+ * Check if a cell of the obstacle bitmap is blocked
+ *
+ * The cells outside of the bitmap are always blocked
+ */
+bool Pathfinder::isCellBlocked(int x, int y) const
 {
-    list.erase(
-        std::remove_if(
-            list.begin(), list.end(),
-            [](std::unique_ptr<Pathfinder::PathNode>& v) { return v ? false : true; }),
-        list.end());
+    auto index = unsigned(y * grid_width_ + x);
+    return (index >= obstacle_bitmap_.size()) ? true : obstacle_bitmap_[index];
 }
 
-Pathfinder::PathNode* Pathfinder::traversePath(
+Pathfinder::node_index_t Pathfinder::traversePath(
     glm::vec2 start, glm::vec2 end, glm::vec2 size, int maxiters)
 {
-    auto nstart = std::make_unique<PathNode>(start);
-    nstart->calculateValues(start, end, getTileAtPosition(nstart->position));
-    open_list_.push_back(std::move(nstart));
+    // If the last search stopped because it reached the iteration limit, and the obstacle
+    // bitmap did not change, we continue it from where it stopped. The path will still
+    // begin where that search began.
+    //
+    // Any other search starts from scratch
+    bool resuming         = has_max_iter_reached_ && !open_heap_.empty();
     has_max_iter_reached_ = false;
-
-    /// If the start does not align to the "grid", we make it align
-    if (int(start.x) % ratio_ != 0 || int(start.y) % ratio_ != 0) {
-        auto direction = end - start;
-        auto vec       = glm::vec2(
-            direction.x > 0 ? 1 / float(ratio_) : (direction.x < 0 ? -1 / float(ratio_) : 0),
-            direction.y > 0 ? 1 / float(ratio_) : (direction.y < 0 ? -1 / float(ratio_) : 0));
-
-        if (int(start.x) % ratio_ == 0) vec.x = 0;
-        if (int(start.y) % ratio_ == 0) vec.y = 0;
-
-        bool walkable                 = false;
-        int idx                       = 0;
-        std::array<glm::vec2, 8> vals = {glm::vec2(0, 0),  glm::vec2(0, 1),  glm::vec2(0, -1),
-                                         glm::vec2(1, 0),  glm::vec2(-1, 0), glm::vec2(1, 1),
-                                         glm::vec2(-1, -1)};
-
-        moveToClosedList(open_list_.back().get());
-        
-        do {
-            auto pos = (start / float(ratio_) + (vec + vals[idx])) * float(ratio_);
-
-            auto alignstart = std::make_unique<PathNode>(pos);
-            walkable        = isWalkable(*alignstart.get(), size);
-
-            alignstart->calculateValues(start, end, getTileAtPosition(alignstart->position));
-            alignstart->parent = closed_list_.back().get();
-
-            if (walkable) {
-                open_list_.push_back(std::move(alignstart));
-            } else {
-                idx++;
-                if (idx > vals.size()) {
-                    LoggerService::getLogger()->write(
-                        "pathfinder", LogType::Warning,
-                        "Fractional path is completely blocked! Cannot pass through! Returning the "
-                        "best value");
-                    return closed_list_.back().get();
+    expanded_nodes_       = 0;
+
+    if (!resuming) {
+        this->resetSearch();
+
+        /// If the start does not align to the "grid", it will not have a place there.
+        /// Use the extra start node.
+        bool aligned = (int(start.x) % ratio_ == 0 && int(start.y) % ratio_ == 0);
+        auto nstart  = aligned ? nodeIndex(start) : InvalidNode;
+        if (nstart == InvalidNode) nstart = startNode();
+
+        calculateValues(getNode(nstart, start), end);
+        pushOpen(nstart);
+
+        /// If the start does not align to the "grid", we make it align
+        if (!aligned) {
+            auto direction = end - start;
+            auto vec       = glm::vec2(
+                direction.x > 0 ? 1 / float(ratio_) : (direction.x < 0 ? -1 / float(ratio_) : 0),
+                direction.y > 0 ? 1 / float(ratio_) : (direction.y < 0 ? -1 / float(ratio_) : 0));
+
+            if (int(start.x) % ratio_ == 0) vec.x = 0;
+            if (int(start.y) % ratio_ == 0) vec.y = 0;
+
+            bool walkable                 = false;
+            int idx                       = 0;
+            std::array<glm::vec2, 7> vals = {glm::vec2(0, 0),  glm::vec2(0, 1),  glm::vec2(0, -1),
+                                             glm::vec2(1, 0),  glm::vec2(-1, 0), glm::vec2(1, 1),
+                                             glm::vec2(-1, -1)};
+
+            popOpen();
+            closeNode(nstart);
+
+            do {
+                auto pos = (start / float(ratio_) + (vec + vals[idx])) * float(ratio_);
+
+                auto alignidx = nodeIndex(pos);
+                walkable      = alignidx != InvalidNode && isWalkable(pos, size);
+
+                if (walkable) {
+                    auto& n  = getNode(alignidx, pos);
+                    n.parent = nstart;
+                    calculateValues(n, end);
+                    pushOpen(alignidx);
+                } else {
+                    idx++;
+                    if (idx >= vals.size()) {
+                        LoggerService::getLogger()->write(
+                            log_tag, LogType::Warning,
+                            "Fractional path is completely blocked! Cannot pass through! "
+                            "Returning the best value");
+                        return nstart;
+                    }
                 }
-            }
-        } while (!walkable);
+            } while (!walkable);
+        }
     }
 
     int itercount = 0;
     auto endtiles = getCoordsInsideObject(end, size);
     if (endtiles.size() == 0) {
         LoggerService::getLogger()->write(
-            "pathfinder", LogType::Warning,
+            log_tag, LogType::Warning,
             "cannot go there {:.2f}! the pathfinder will try to go to the nearest place",
             end);
     }
 
-    while (!open_list_.empty()) {
-        PathNode* best = sortBestTile(open_list_);
-        moveToClosedList(best);
+    bool end_walkable = isWalkable(end, size);
+    node_index_t last = last_closed_;
+
+    // clang-format off
+    const std::array<glm::vec2, 8> directions = {
+        glm::vec2{-ratio_, -ratio_}, glm::vec2{0, -ratio_}, glm::vec2{ratio_, -ratio_},
+        glm::vec2{-ratio_, 0},                              glm::vec2{ratio_, 0},
+        glm::vec2{-ratio_, ratio_},  glm::vec2{0, ratio_},  glm::vec2{ratio_, ratio_}};
+    // clang-format on
+
+    auto [width, height] = t_.getSize();
+
+    while (!open_heap_.empty()) {
+        auto bestidx = popOpen();
+        closeNode(bestidx);
+        last = bestidx;
+
+        auto bestpos = nodes_[bestidx].position;
 
         // we are in the final position
-        if (glm::round(best->position) == glm::round(end)) {
+        if (glm::round(bestpos) == glm::round(end)) {
             break;
         }
 
         // we are not in the final position, but sufficiently close to
-        if (auto delta = glm::abs(end - best->position);
+        if (auto delta = glm::abs(end - bestpos);
             delta.x < double(ratio_) && delta.y < double(ratio_)) {
-            auto nend    = std::make_unique<PathNode>(end);
-            nend->parent = closed_list_.back().get();
-            closed_list_.push_back(std::move(nend));
+            auto nend = endNode();
+            auto& n   = getNode(nend, end);
+            n.parent = bestidx;
+            n.state  = NodeState::Closed;
+            closed_count_++;
+            last = last_closed_ = nend;
             break;
         }
 
         // we cannot go to the final position, but we are sufficiently close
-        if (PathNode tend{end}; !isWalkable(tend, size) &&
-                                std::any_of(endtiles.begin(), endtiles.end(), [&](auto& endpos) {
-                                    return endpos == best->position;
-                                })) {
+        if (!end_walkable && std::any_of(endtiles.begin(), endtiles.end(), [&](auto& endpos) {
+                return endpos == bestpos;
+            })) {
             LoggerService::getLogger()->write(
-                "pathfinder", LogType::Warning,
+                log_tag, LogType::Warning,
                 "requested end point {:.2f} not equal to found end point {:.2f}, but "
                 "close enough",
-                end.x, best->position);
+                end.x, bestpos);
             break;
         }
 
         // we exceeded the iteration count, maybe retry again next tick
         if (itercount == maxiters) {
             LoggerService::getLogger()->write(
-                "pathfinder", LogType::Info, "tick count exceeded! Repathing on next call");
+                log_tag, LogType::Info, "tick count exceeded! Repathing on next call");
             has_max_iter_reached_ = true;
             break;
         }
 
         // we are not in the final position nor exceeding iter count
-        auto neighbors = generateNeighbors(*best);
-        for (auto& n : neighbors) {
-            n->parent = best;
-            n->calculateValues(start, end, getTileAtPosition(n->position));
-            if (!isWalkable(*n.get(), size) || isInClosedList(*n.get())) continue;
-
-            auto existing = findInOpenList(*n.get());
-            if (existing) {
-                if (existing->g < n->g) {
-                    existing->parent = best;
-                    existing->calculateG(start, end, getTileAtPosition(existing->position));
+        //
+        // Check all the 8 neighbors of the node, in all directions, like this:
+        //
+        //   N | N | N     (X is the given node, all others are the neighbors)
+        //  ---+---+---
+        //   N | X | N
+        //  ---+---+---
+        //   N | N | N
+        //
+        // We skip the ones outside of the map.
+        for (auto& d : directions) {
+            auto newpos = d + bestpos;
+            assert(int(newpos.x) % ratio_ == 0);
+            assert(int(newpos.y) % ratio_ == 0);
+
+            if (newpos.x < 0 || newpos.y < 0) continue;
+
+            if (newpos.x >= width || newpos.y >= height) continue;
+
+            auto nidx = nodeIndex(newpos);
+            if (nidx == InvalidNode) continue;
+
+            auto& n = getNode(nidx, newpos);
+            if (n.state == NodeState::Closed) continue;
+
+            auto tile = getTileAtPosition(newpos);
+            auto g    = calculateG(n, bestidx, tile.height);
+
+            if (n.state == NodeState::Open) {
+                if (g < n.g) {
+                    n.parent = bestidx;
+                    n.g      = g;
+                    heapSiftUp(n.heap_index);
                 }
 
                 continue;
             }
 
-            std::unique_ptr<PathNode> npointer;
-            npointer.swap(n);
-            open_list_.push_back(std::move(npointer));
-        }
+            if (!isWalkable(newpos, size)) continue;
 
-        purgeList(open_list_);
-        purgeList(closed_list_);
+            n.parent = bestidx;
+            n.g      = g;
+            n.h      = glm::abs(glm::distance(newpos, end));
+            n.height = tile.height;
+            pushOpen(nidx);
+        }
 
-        LoggerService::getLogger()->write(
-            "pathfinder", LogType::Debug,
+        LOGDEBUG(
+            LoggerService::getLogger(), log_tag,
             "({:03d}) open list has {}, closed list has {}, best: {:.2f}", itercount,
-            open_list_.size(), closed_list_.size(), best->position);
+            open_heap_.size(), closed_count_, bestpos);
 
         itercount++;
     }
 
-    if (open_list_.empty()) {
+    if (open_heap_.empty()) {
         LoggerService::getLogger()->write(
-            "pathfinder", LogType::Warning,
+            log_tag, LogType::Warning,
             "Path is completely blocked! Cannot pass through! Returning the best value");
     }
 
-    return closed_list_.back().get();
+    return last;
 }
 
-void Pathfinder::PathNode::calculateG(glm::vec2 start, glm::vec2 end, const TerrainTile& current)
+/**
+ * Calculate the g value of a node, considering the parent it has
+ */
+double Pathfinder::calculateG(const PathNode& n, node_index_t parent, double height) const
 {
-    if (parent) {
-        auto heightcost = glm::abs(glm::distance(double(current.height), parent->height)) * 0.01;
-        g = parent->g + glm::abs(glm::distance(position, parent->position)) + heightcost;
-    } else {
-        g = 0;
-    }
+    if (parent == InvalidNode) return 0;
+
+    auto& p         = nodes_[parent];
+    auto heightcost = glm::abs(glm::distance(height, p.height)) * 0.01;
+    return p.g + glm::abs(glm::distance(n.position, p.position)) + heightcost;
 }
 
-void Pathfinder::PathNode::calculateValues(
-    glm::vec2 start, glm::vec2 end, const TerrainTile& current)
+/**
+ * Calculate the g, h and height values of a node, considering the parent it has
+ */
+void Pathfinder::calculateValues(PathNode& n, glm::vec2 end)
 {
-    this->calculateG(start, end, current);
-    h      = glm::abs(glm::distance(position, end));
-    height = current.height;
+    auto tile = getTileAtPosition(n.position);
+    n.g       = calculateG(n, n.parent, tile.height);
+    n.h       = glm::abs(glm::distance(n.position, end));
+    n.height  = tile.height;
 }
 
 std::vector<glm::vec2> Pathfinder::calculatePath(
     glm::vec2 start, glm::vec2 end, glm::vec2 size, int maxiters)
 {
-    PathNode* node = traversePath(start, end, size, maxiters);
-    assert(node);
+    auto node = traversePath(start, end, size, maxiters);
+    assert(node != InvalidNode);
 
     std::vector<glm::vec2> positions;
     positions.reserve(int(glm::abs(glm::distance(start, end))));
-    for (PathNode* current = node; current != nullptr; current = current->parent) {
+    for (auto current = node; current != InvalidNode; current = nodes_[current].parent) {
+        auto position = nodes_[current].position;
         if (positions.size() > 0 &&
-            glm::abs(glm::distance(current->position, positions.back())) >= ratio_) {
+            glm::abs(glm::distance(position, positions.back())) >= ratio_) {
             auto begin = positions.back();
             for (auto i = 1; i <= ratio_; i++) {
-                positions.push_back(glm::mix(begin, current->position, i / double(ratio_)));
+                positions.push_back(glm::mix(begin, position, i / double(ratio_)));
             }
         } else {
-            positions.push_back(current->position);
+            positions.push_back(position);
         }
     }
 
@@ -363,12 +486,14 @@ std::vector<glm::vec2> Pathfinder::calculatePath(
 std::vector<glm::vec2> Pathfinder::findPath(
     glm::vec2 start, glm::vec2 end, glm::vec2 size, int maxiters)
 {
-    LoggerService::getLogger()->write(
-        "pathfinder", LogType::Debug,
-        "trying to find a path between {:.2f} and {:.2f}, with size {:.2f}",
-        start, end, size);
+    LOGDEBUG(
+        LoggerService::getLogger(), log_tag,
+        "trying to find a path between {:.2f} and {:.2f}, with size {:.2f}", start, end, size);
 
-    assert(obstacle_bitmap_.size() > 1);
+    assert(view_ || obstacle_bitmap_.size() > 1);
+
+    // The object might have moved since the last update
+    if (view_) view_->refresh();
 
     auto positions = this->calculatePath(start, end, size, maxiters);
     std::vector<glm::vec2> ret;
@@ -384,11 +509,49 @@ void Pathfinder::update(std::vector<bool> bitmap, int ratio)
 
     assert(bitmap.size() == (width / ratio) * (height / ratio));
     obstacle_bitmap_ = bitmap;
+    view_.reset();
+
+    ratio_       = ratio;
+    grid_width_  = width / ratio;
+    grid_height_ = height / ratio;
 
-    // Invalidate both, because they are simply not valid now.
+    // Invalidate all nodes, because they are simply not valid now.
     //
     // We will need to calculate the whole path
-    open_list_.clear();
-    closed_list_.clear();
-    ratio_ = ratio;
+    nodes_.resize(grid_width_ * grid_height_ + 2);
+    this->resetSearch();
+}
+
+void Pathfinder::update(ObstacleView view)
+{
+    auto [width, height] = t_.getSize();
+    assert(view.width() == int(width / view.ratio()));
+    assert(view.height() == int(height / view.ratio()));
+
+    obstacle_bitmap_.clear();
+    view_.emplace(view);
+
+    ratio_       = view.ratio();
+    grid_width_  = view.width();
+    grid_height_ = view.height();
+
+    nodes_.resize(grid_width_ * grid_height_ + 2);
+    this->resetSearch();
+}
+
+/**
+ * Invalidate the current search
+ *
+ * We do not clean the node storage, only bump the search generation, so
+ * the nodes from the older searches are considered unvisited. There is nothing to
+ * continue anymore, so the iteration limit is not reached either.
+ */
+void Pathfinder::resetSearch()
+{
+    has_max_iter_reached_ = false;
+    open_heap_.clear();
+    closed_count_ = 0;
+    next_order_   = 0;
+    last_closed_  = InvalidNode;
+    search_gen_++;
 }
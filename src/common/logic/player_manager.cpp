@@ -329,18 +329,25 @@ void PlayerManager::processAction(const PlayerInputAction& pia, ObjectManager& o
                 auto selections       = (*player)->getSelections();
                 auto valid_selections = getValidSelections(selections);
 
+                // Only move components that are of the player.
+                std::vector<GameObject*> movable;
                 for (auto& s : valid_selections) {
-                    // Only move components that are of the player.
                     if (s->getColonyComponent().has_value() &&
                         s->getColonyComponent()->owner.has_value() &&
                         s->getColonyComponent()->owner->get().isOfPlayer(*(*player))) {
-                        auto& pm = LogicService::getPathManager();
-                        pm->startPathing(*s.get(), glm::vec2(a.xPos, a.yPos));
-
-                        log->write(
-                            "human-player", LogType::Debug, "moved to {}, {}", a.xPos, a.yPos);
+                        movable.push_back(s.get());
                     }
                 }
+
+                // Move them as a group, so they can share the path calculation
+                if (!movable.empty()) {
+                    auto& pm = LogicService::getPathManager();
+                    pm->startGroupPathing(movable, glm::vec2(a.xPos, a.yPos));
+
+                    log->write(
+                        "human-player", LogType::Debug, "moved {} objects to {}, {}",
+                        movable.size(), a.xPos, a.yPos);
+                }
             },
             [&](const CameraMove& a) {
                 log->write(
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cmath>
+#include <common/logic/projectile_manager.hpp>
+
+using namespace familyline::logic;
+
+/**
+ * Shoot a projectile from `from` to `to`, with a speed of `speed` units per tick
+ *
+ * We round the flight time up to a whole number of ticks, and adjust the velocity,
+ * so the projectile arrives exactly at `to`.
+ */
+void ProjectileManager::launch(const Shot& shot, glm::vec2 from, glm::vec2 to, double speed)
+{
+    auto distance = glm::length(to - from);
+    auto ticks    = speed > 0 ? std::max(1, int(std::ceil(distance / speed))) : 1;
+    auto velocity = (to - from) / float(ticks);
+
+    xs_.push_back(from.x);
+    ys_.push_back(from.y);
+    vxs_.push_back(velocity.x);
+    vys_.push_back(velocity.y);
+    ticks_left_.push_back(ticks);
+    shots_.push_back(shot);
+}
+
+/**
+ * Move every projectile by one tick
+ */
+const std::vector<ProjectileManager::Impact>& ProjectileManager::update()
+{
+    impacts_.clear();
+
+    auto count       = xs_.size();
+    float* xs        = xs_.data();
+    float* ys        = ys_.data();
+    const float* vxs = vxs_.data();
+    const float* vys = vys_.data();
+    int* ticks_left  = ticks_left_.data();
+
+    bool arrived = false;
+    for (size_t i = 0; i < count; i++) {
+        xs[i] += vxs[i];
+        ys[i] += vys[i];
+        ticks_left[i]--;
+        arrived |= ticks_left[i] <= 0;
+    }
+
+    if (!arrived) return impacts_;
+
+    // Remove the projectiles that arrived, keeping the order of the others
+    size_t out = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (ticks_left[i] <= 0) {
+            impacts_.push_back(Impact{shots_[i], glm::vec2(xs[i], ys[i])});
+            continue;
+        }
+
+        if (out != i) {
+            xs[out]         = xs[i];
+            ys[out]         = ys[i];
+            vxs_[out]       = vxs[i];
+            vys_[out]       = vys[i];
+            ticks_left[out] = ticks_left[i];
+            shots_[out]     = shots_[i];
+        }
+        out++;
+    }
+
+    xs_.resize(out);
+    ys_.resize(out);
+    vxs_.resize(out);
+    vys_.resize(out);
+    ticks_left_.resize(out);
+    shots_.resize(out);
+
+    return impacts_;
+}
+
+/**
+ * Reserve space for `count` projectiles, so that shooting them does not
+ * allocate anything
+ */
+void ProjectileManager::reserve(size_t count)
+{
+    xs_.reserve(count);
+    ys_.reserve(count);
+    vxs_.reserve(count);
+    vys_.reserve(count);
+    ticks_left_.reserve(count);
+    shots_.reserve(count);
+    impacts_.reserve(count);
+}
+
+void ProjectileManager::clear()
+{
+    xs_.clear();
+    ys_.clear();
+    vxs_.clear();
+    vys_.clear();
+    ticks_left_.clear();
+    shots_.clear();
+    impacts_.clear();
+}
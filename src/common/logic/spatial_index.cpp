@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <cmath>
+#include <common/logic/spatial_index.hpp>
+
+using namespace familyline::logic;
+
+SpatialIndex::SpatialIndex(int width, int height, int cell_size)
+    : cell_size_(std::max(1, cell_size)),
+      cols_(std::max(1, (width + cell_size_ - 1) / cell_size_)),
+      rows_(std::max(1, (height + cell_size_ - 1) / cell_size_)),
+      cells_(cols_ * rows_)
+{
+}
+
+int SpatialIndex::cellOf(glm::vec2 pos) const
+{
+    auto cx = std::clamp(int(std::floor(pos.x / cell_size_)), 0, cols_ - 1);
+    auto cy = std::clamp(int(std::floor(pos.y / cell_size_)), 0, rows_ - 1);
+    return cy * cols_ + cx;
+}
+
+/**
+ * Add an object, or update it if it is already there
+ *
+ * Most updates are from objects that moved a little, and stayed in the same
+ * cell, so we only change the item there
+ */
+void SpatialIndex::update(object_id_t id, glm::vec2 pos, glm::vec2 size)
+{
+    auto half_size = size / 2.0f;
+    max_half_size_ = glm::max(max_half_size_, half_size);
+
+    auto cell = this->cellOf(pos);
+    if (auto it = locations_.find(id); it != locations_.end()) {
+        auto& items = cells_[it->second];
+        auto item   = std::find_if(
+            items.begin(), items.end(), [id](const Item& i) { return i.id == id; });
+
+        if (it->second == cell) {
+            item->pos       = pos;
+            item->half_size = half_size;
+            return;
+        }
+
+        *item = items.back();
+        items.pop_back();
+        it->second = cell;
+    } else if (!free_locations_.empty()) {
+        auto node = std::move(free_locations_.back());
+        free_locations_.pop_back();
+        node.key()    = id;
+        node.mapped() = cell;
+        locations_.insert(std::move(node));
+    } else {
+        locations_[id] = cell;
+    }
+
+    cells_[cell].push_back(Item{id, pos, half_size});
+}
+
+void SpatialIndex::remove(object_id_t id)
+{
+    auto it = locations_.find(id);
+    if (it == locations_.end()) return;
+
+    auto& items = cells_[it->second];
+    auto item =
+        std::find_if(items.begin(), items.end(), [id](const Item& i) { return i.id == id; });
+    *item = items.back();
+    items.pop_back();
+
+    free_locations_.push_back(locations_.extract(it));
+}
+
+/**
+ * Call `fn` for each object in the cells that might touch the rectangle
+ * between `min` and `max`
+ */
+template <typename F>
+void SpatialIndex::forEachCandidate(glm::vec2 min, glm::vec2 max, F&& fn) const
+{
+    min -= max_half_size_;
+    max += max_half_size_;
+
+    auto cx0 = std::clamp(int(std::floor(min.x / cell_size_)), 0, cols_ - 1);
+    auto cy0 = std::clamp(int(std::floor(min.y / cell_size_)), 0, rows_ - 1);
+    auto cx1 = std::clamp(int(std::floor(max.x / cell_size_)), 0, cols_ - 1);
+    auto cy1 = std::clamp(int(std::floor(max.y / cell_size_)), 0, rows_ - 1);
+
+    for (auto cy = cy0; cy <= cy1; cy++) {
+        for (auto cx = cx0; cx <= cx1; cx++) {
+            for (auto& item : cells_[cy * cols_ + cx]) fn(item);
+        }
+    }
+}
+
+/**
+ * Squared distance between a point and the hitbox of an object
+ *
+ * It is zero if the point is inside of it
+ */
+double SpatialIndex::distanceSquared(const Item& item, glm::vec2 p)
+{
+    auto d = glm::max(glm::abs(p - item.pos) - item.half_size, glm::vec2(0, 0));
+    return double(d.x) * d.x + double(d.y) * d.y;
+}
+
+/**
+ * Get the objects whose hitbox touches the circle with center `center` and
+ * radius `radius`
+ */
+std::vector<object_id_t> SpatialIndex::queryRadius(glm::vec2 center, double radius) const
+{
+    std::vector<object_id_t> result;
+    auto r  = float(radius);
+    auto r2 = radius * radius;
+
+    this->forEachCandidate(center - r, center + r, [&](const Item& item) {
+        if (distanceSquared(item, center) <= r2) result.push_back(item.id);
+    });
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/**
+ * Check if the hitbox of the object `id` touches the circle with center
+ * `center` and radius `radius`
+ */
+bool SpatialIndex::touches(object_id_t id, glm::vec2 center, double radius) const
+{
+    auto it = locations_.find(id);
+    if (it == locations_.end()) return false;
+
+    auto& items = cells_[it->second];
+    auto item =
+        std::find_if(items.begin(), items.end(), [id](const Item& i) { return i.id == id; });
+    return distanceSquared(*item, center) <= radius * radius;
+}
+
+/**
+ * Get the objects whose hitbox touches the rectangle between `min` and `max`
+ */
+std::vector<object_id_t> SpatialIndex::queryRect(glm::vec2 min, glm::vec2 max) const
+{
+    std::vector<object_id_t> result;
+    auto rmin = glm::min(min, max);
+    auto rmax = glm::max(min, max);
+
+    this->forEachCandidate(rmin, rmax, [&](const Item& item) {
+        auto imin = item.pos - item.half_size;
+        auto imax = item.pos + item.half_size;
+        if (imin.x <= rmax.x && imax.x >= rmin.x && imin.y <= rmax.y && imax.y >= rmin.y)
+            result.push_back(item.id);
+    });
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/**
+ * Get the `k` objects nearest to `center`, the nearest first
+ *
+ * We search in a square that doubles its size each time. After searching one with
+ * half side `r`, we know every object that is at most `r` units away, so we can stop
+ * as soon as we have `k` of them.
+ */
+std::vector<object_id_t> SpatialIndex::queryNearest(
+    glm::vec2 center, size_t k, double max_radius) const
+{
+    std::vector<std::pair<double, object_id_t>> found;
+    if (k == 0) return {};
+
+    auto r = std::min(double(cell_size_), max_radius);
+    while (true) {
+        found.clear();
+
+        auto fr = float(r);
+        auto r2 = r * r;
+        this->forEachCandidate(center - fr, center + fr, [&](const Item& item) {
+            auto d = distanceSquared(item, center);
+            if (d <= r2) found.emplace_back(d, item.id);
+        });
+
+        if (found.size() >= k || r >= max_radius) break;
+
+        r = std::min(r * 2, max_radius);
+    }
+
+    std::sort(found.begin(), found.end());
+    if (found.size() > k) found.resize(k);
+
+    std::vector<object_id_t> result;
+    result.reserve(found.size());
+    for (auto& [d, id] : found) result.push_back(id);
+
+    return result;
+}
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <common/logger.hpp>
+#include <common/logic/target_acquirer.hpp>
+
+using namespace familyline::logic;
+
+static const familyline::LogTag log_tag{"target-acquirer"};
+
+TargetAcquirer::TargetAcquirer(const ColonyManager& cm, size_t units_per_tick)
+    : cm_(cm), units_per_tick_(units_per_tick)
+{
+}
+
+/**
+ * Check the next units, and make the idle ones attack the nearest enemy in
+ * their range
+ */
+void TargetAcquirer::update(
+    ObjectManager& om, const SpatialIndex& index, const ObjectPathManager& pm,
+    const AttackManager& am)
+{
+    auto& components = om.components();
+    auto& ids        = components.ids();
+    auto& health     = components.health();
+    auto& range      = components.attackRange();
+    auto count       = std::min(units_per_tick_, ids.size());
+
+    for (size_t i = 0; i < count; i++) {
+        if (next_ >= ids.size()) next_ = 0;
+
+        auto u = next_++;
+
+        // Most objects cannot attack, or are busy, and we know it without
+        // touching them
+        if (range[u] <= 0 || health[u] <= 0) continue;
+        if (am.isAttacking(ids[u]) || pm.isMoving(ids[u])) continue;
+
+        auto* unit   = components.objects()[u];
+        auto& colony = unit->getColonyComponent();
+        if (!colony || !colony->owner) continue;
+
+        this->acquire(om, index, *unit, components.positions()[u], range[u]);
+    }
+}
+
+/**
+ * Make the unit attack the nearest enemy in its range, if there is one
+ *
+ * The attack component still checks the range and the angle of the attack, so,
+ * if it refuses to attack the nearest enemy, we try the next one.
+ */
+bool TargetAcquirer::acquire(
+    ObjectManager& om, const SpatialIndex& index, GameObject& unit, glm::vec3 pos, double range)
+{
+    auto& components = om.components();
+    auto& atk        = *unit.getAttackComponent();
+
+    auto nearest = index.queryNearest(glm::vec2(pos.x, pos.z), candidate_count_, range);
+
+    for (auto id : nearest) {
+        if (id == unit.getID()) continue;
+
+        // Dead objects, and the ones that cannot be attacked, are skipped by
+        // their packed state, too
+        auto oi = om.indexOf(id);
+        if (!oi || components.health()[*oi] <= 0 || components.attackRange()[*oi] < 0) continue;
+
+        auto* other = components.objects()[*oi];
+        if (!this->isEnemy(unit, *other)) continue;
+
+        if (atk.attack(*other->getAttackComponent())) {
+            LOGDEBUG(
+                LoggerService::getLogger(), log_tag, "object {} ({}) acquired target {} ({})",
+                unit.getID(), unit.getName(), other->getID(), other->getName());
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TargetAcquirer::isEnemy(GameObject& unit, GameObject& other) const
+{
+    auto& mine   = unit.getColonyComponent();
+    auto& theirs = other.getColonyComponent();
+    if (!theirs || !theirs->owner) return false;
+
+    return cm_.getDiplomacy(mine->owner->get(), theirs->owner->get()) == DiplomacyStatus::Enemy;
+}
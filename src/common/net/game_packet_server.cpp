@@ -16,6 +16,7 @@
 #include <common/logic/input_reproducer.hpp>
 #include <common/net/game_packet_server.hpp>
 #include <common/net/server.hpp>
+#include <common/profiler.hpp>
 #include <iterator>
 #include <mutex>
 #include <optional>
@@ -258,6 +259,8 @@ void GamePacketServer::update()
 #ifdef FLINE_NET_SUPPORT
     if (!connected_) return;
 
+    PROFILE_ZONE("net/server");
+
     auto& log = LoggerService::getLogger();
     std::array<uint8_t, 1024*16> data;
     
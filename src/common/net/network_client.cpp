@@ -1,6 +1,7 @@
 #include <common/logger.hpp>
 #include <common/net/game_packet_server.hpp>
 #include <common/net/network_client.hpp>
+#include <common/profiler.hpp>
 
 using namespace familyline::net;
 
@@ -90,6 +91,8 @@ std::future<tl::expected<bool, NetResult>> NetworkClient::waitReadyToStart()
  */
 void NetworkClient::update()
 {
+    PROFILE_ZONE("net/client");
+
     send_queue_mtx_.lock();
     while (!send_queue_.empty()) {
         auto timestamp = duration_cast<std::chrono::seconds>(
@@ -1,6 +1,7 @@
 #include <common/logger.hpp>
 #include <common/net/net_common.hpp>
 #include <common/net/network_player.hpp>
+#include <common/profiler.hpp>
 #include <variant>
 
 using namespace familyline::net;
@@ -8,6 +9,8 @@ using namespace familyline::logic;
 
 void NetworkPlayer::generateInput()
 {
+    PROFILE_ZONE("net/player-input");
+
     auto& log = LoggerService::getLogger();
 
     for (net::Packet packet; client_.peek(packet);) {
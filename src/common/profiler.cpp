@@ -0,0 +1,156 @@
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <common/profiler.hpp>
+#include <cstdio>
+#include <nlohmann/json.hpp>
+
+using namespace familyline;
+using json = nlohmann::ordered_json;
+
+thread_local std::shared_ptr<Profiler::ThreadBuffer> Profiler::current_;
+
+Profiler::Profiler() : epoch_(std::chrono::steady_clock::now()) {}
+
+Profiler& Profiler::get()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::ThreadBuffer::resize(size_t capacity)
+{
+    events.assign(capacity, ProfileEvent{});
+    next  = 0;
+    count = 0;
+}
+
+Profiler::ThreadBuffer& Profiler::threadBuffer()
+{
+    if (!current_) {
+        auto buf = std::make_shared<ThreadBuffer>();
+
+        std::lock_guard lock(threads_mtx_);
+        buf->id   = threads_.size() + 1;
+        buf->name = fmt::format("thread {}", buf->id);
+        buf->resize(capacity_);
+        threads_.push_back(buf);
+
+        current_ = buf;
+    }
+
+    return *current_;
+}
+
+void Profiler::start(size_t events_per_thread)
+{
+    {
+        std::lock_guard lock(threads_mtx_);
+        capacity_ = std::max(events_per_thread, size_t(1));
+
+        for (auto& t : threads_) {
+            std::lock_guard tlock(t->mtx);
+            t->resize(capacity_);
+        }
+    }
+
+    capturing_.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::record(const char* name, int64_t start, int64_t end, uint32_t depth)
+{
+    auto& buf = this->threadBuffer();
+
+    std::lock_guard lock(buf.mtx);
+    if (buf.events.empty()) return;
+
+    buf.events[buf.next] = ProfileEvent{name, start, end - start, depth};
+    buf.next             = (buf.next + 1) % buf.events.size();
+    buf.count            = std::min(buf.count + 1, buf.events.size());
+}
+
+void Profiler::setThreadName(std::string_view name)
+{
+    auto& buf = this->threadBuffer();
+
+    std::lock_guard lock(buf.mtx);
+    buf.name = std::string{name};
+}
+
+std::vector<std::pair<uint32_t, ProfileEvent>> Profiler::getEvents()
+{
+    std::vector<std::pair<uint32_t, ProfileEvent>> ret;
+
+    std::lock_guard lock(threads_mtx_);
+    for (auto& t : threads_) {
+        std::lock_guard tlock(t->mtx);
+
+        // The oldest zone is the one we would overwrite next
+        auto size  = t->events.size();
+        auto first = (t->next + size - t->count) % std::max(size, size_t(1));
+        auto begin = ret.size();
+        for (size_t i = 0; i < t->count; i++)
+            ret.emplace_back(t->id, t->events[(first + i) % size]);
+
+        // The zones are recorded when they end, so the outer ones come after the
+        // inner ones
+        std::stable_sort(ret.begin() + begin, ret.end(), [](auto& a, auto& b) {
+            return a.second.start < b.second.start;
+        });
+    }
+
+    return ret;
+}
+
+/**
+ * Write the zones as complete events ("ph": "X"), and one metadata event per
+ * thread, with its name
+ *
+ * See the "Trace Event Format" document, from the Chromium project
+ */
+bool Profiler::dumpChromeTrace(const std::filesystem::path& path)
+{
+    auto events = this->getEvents();
+
+    std::vector<std::pair<uint32_t, std::string>> names;
+    {
+        std::lock_guard lock(threads_mtx_);
+        for (auto& t : threads_) {
+            std::lock_guard tlock(t->mtx);
+            names.emplace_back(t->id, t->name);
+        }
+    }
+
+    json trace;
+    trace["displayTimeUnit"] = "ms";
+
+    auto& out = trace["traceEvents"] = json::array();
+    for (auto& [id, name] : names) {
+        out.push_back(
+            {{"name", "thread_name"},
+             {"ph", "M"},
+             {"pid", 1},
+             {"tid", id},
+             {"args", {{"name", name}}}});
+    }
+
+    for (auto& [id, e] : events) {
+        out.push_back(
+            {{"name", e.name},
+             {"ph", "X"},
+             {"pid", 1},
+             {"tid", id},
+             {"ts", e.start / 1000.0},
+             {"dur", e.duration / 1000.0},
+             {"args", {{"depth", e.depth}}}});
+    }
+
+    auto data = trace.dump() + "\n";
+
+    FILE* f = fopen(path.string().c_str(), "w");
+    if (!f) return false;
+
+    auto written = fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+    return written == data.size();
+}
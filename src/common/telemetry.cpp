@@ -0,0 +1,233 @@
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <common/telemetry.hpp>
+#include <cstdio>
+#include <iterator>
+#include <nlohmann/json.hpp>
+#include <system_error>
+
+using namespace familyline;
+
+// Keep the keys in the order we add them, so the metrics stay in the order
+// they were first recorded
+using json = nlohmann::ordered_json;
+
+size_t Histogram::bucketOf(uint64_t value)
+{
+    if (value < 2 * SubBucketCount) return value;
+
+    // Keep the highest SubBucketBits + 1 bits of the value. The highest one is
+    // always set, so the others select the bucket inside this power of two
+    unsigned shift = std::bit_width(value) - 1 - SubBucketBits;
+    return (shift + 1) * SubBucketCount + ((value >> shift) - SubBucketCount);
+}
+
+uint64_t Histogram::bucketHighest(size_t bucket)
+{
+    if (bucket < 2 * SubBucketCount) return bucket;
+
+    unsigned shift = bucket / SubBucketCount - 1;
+    uint64_t top   = bucket % SubBucketCount + SubBucketCount;
+    return ((top + 1) << shift) - 1;
+}
+
+void Histogram::record(uint64_t value)
+{
+    buckets_[bucketOf(value)]++;
+    count_++;
+    sum_ += value;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+}
+
+void Histogram::merge(const Histogram& other)
+{
+    for (size_t i = 0; i < BucketCount; i++) buckets_[i] += other.buckets_[i];
+
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+void Histogram::reset() { *this = Histogram{}; }
+
+uint64_t Histogram::percentile(double p) const
+{
+    if (count_ == 0) return 0;
+
+    auto target = uint64_t(std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * count_));
+    target      = std::max(target, uint64_t(1));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BucketCount; i++) {
+        seen += buckets_[i];
+        if (seen >= target) return std::clamp(bucketHighest(i), this->min(), max_);
+    }
+
+    return max_;
+}
+
+/////////////////////////////////
+
+Histogram& Telemetry::metric(std::string_view name, Unit unit)
+{
+    auto it = std::find_if(
+        metrics_.begin(), metrics_.end(), [&](const Metric& m) { return m.name == name; });
+    if (it != metrics_.end()) return it->values;
+
+    metrics_.push_back(Metric{std::string{name}, unit, Histogram{}});
+    return metrics_.back().values;
+}
+
+void Telemetry::recordTime(std::string_view name, double ms)
+{
+    this->metric(name, Unit::Milliseconds).record(uint64_t(std::max(ms, 0.0) * 1000.0));
+}
+
+void Telemetry::recordCount(std::string_view name, uint64_t value)
+{
+    this->metric(name, Unit::Count).record(value);
+}
+
+void Telemetry::setInfo(std::string_view key, std::string_view value)
+{
+    auto it = std::find_if(info_.begin(), info_.end(), [&](auto& i) { return i.first == key; });
+    if (it != info_.end())
+        it->second = std::string{value};
+    else
+        info_.emplace_back(std::string{key}, std::string{value});
+}
+
+const Telemetry::Metric* Telemetry::get(std::string_view name) const
+{
+    auto it = std::find_if(
+        metrics_.begin(), metrics_.end(), [&](const Metric& m) { return m.name == name; });
+    return it != metrics_.end() ? &*it : nullptr;
+}
+
+void Telemetry::reset()
+{
+    metrics_.clear();
+    started_ = std::chrono::steady_clock::now();
+}
+
+void Telemetry::setExport(std::filesystem::path path, std::chrono::seconds interval)
+{
+    export_path_     = std::move(path);
+    export_interval_ = interval;
+    last_export_     = std::chrono::steady_clock::now();
+}
+
+void Telemetry::update()
+{
+    if (export_path_.empty() || export_interval_.count() <= 0) return;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_export_ < export_interval_) return;
+
+    last_export_ = now;
+    this->exportNow();
+}
+
+/**
+ * Write to a temporary file, and rename it over the export file, so whoever is
+ * reading the file never sees it half written
+ */
+bool Telemetry::exportNow()
+{
+    if (export_path_.empty()) return false;
+
+    auto data = export_path_.extension() == ".json" ? this->toJSON() : this->toCSV();
+
+    auto tmppath = export_path_;
+    tmppath += ".tmp";
+
+    FILE* f = fopen(tmppath.string().c_str(), "w");
+    if (!f) return false;
+
+    auto written = fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+
+    std::error_code ec;
+    if (written == data.size()) std::filesystem::rename(tmppath, export_path_, ec);
+
+    if (written != data.size() || ec) {
+        std::filesystem::remove(tmppath, ec);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * The values we export for each metric, already converted to the unit of
+ * the metric
+ */
+struct MetricSummary {
+    double min, mean, p50, p90, p99, max;
+};
+
+static MetricSummary summarize(const Telemetry::Metric& m)
+{
+    double div = m.unit == Telemetry::Unit::Milliseconds ? 1000.0 : 1.0;
+    auto& v    = m.values;
+
+    return MetricSummary{
+        v.min() / div,
+        v.mean() / div,
+        v.percentile(50) / div,
+        v.percentile(90) / div,
+        v.percentile(99) / div,
+        v.max() / div};
+}
+
+static const char* unitName(Telemetry::Unit u)
+{
+    return u == Telemetry::Unit::Milliseconds ? "ms" : "count";
+}
+
+std::string Telemetry::toCSV() const
+{
+    std::string out = "metric,unit,count,min,mean,p50,p90,p99,max\n";
+    auto it         = std::back_inserter(out);
+
+    for (auto& m : metrics_) {
+        auto s = summarize(m);
+        fmt::format_to(
+            it, "{},{},{},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f}\n", m.name, unitName(m.unit),
+            m.values.count(), s.min, s.mean, s.p50, s.p90, s.p99, s.max);
+    }
+
+    return out;
+}
+
+std::string Telemetry::toJSON() const
+{
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_);
+
+    json out;
+    out["info"] = json::object();
+    for (auto& [key, value] : info_) out["info"][key] = value;
+
+    out["elapsed"] = elapsed.count();
+
+    out["metrics"] = json::object();
+    for (auto& m : metrics_) {
+        auto s                 = summarize(m);
+        out["metrics"][m.name] = {
+            {"unit", unitName(m.unit)},
+            {"count", m.values.count()},
+            {"min", s.min},
+            {"mean", s.mean},
+            {"p50", s.p50},
+            {"p90", s.p90},
+            {"p99", s.p99},
+            {"max", s.max}};
+    }
+
+    return out.dump(2) + "\n";
+}
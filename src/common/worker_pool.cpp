@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <common/worker_pool.hpp>
+
+using namespace familyline;
+
+WorkerPool::WorkerPool(unsigned threads)
+{
+    for (auto i = 0u; i < threads; i++) {
+        threads_.emplace_back([this]() { this->workerLoop(); });
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lg(mtx_);
+        quitting_ = true;
+    }
+    start_cv_.notify_all();
+
+    for (auto& t : threads_) t.join();
+}
+
+/**
+ * A sensible default for the number of worker threads: one for each core, minus the
+ * one that is calling us.
+ */
+unsigned WorkerPool::defaultThreadCount()
+{
+    auto cores = std::thread::hardware_concurrency();
+    return cores > 1 ? std::min(cores - 1, 7u) : 0;
+}
+
+/**
+ * Run items of the current batch until there is no more of them
+ */
+void WorkerPool::runItems()
+{
+    for (auto i = next_.fetch_add(1); i < count_; i = next_.fetch_add(1)) {
+        (*fn_)(i);
+    }
+}
+
+void WorkerPool::workerLoop()
+{
+    uint64_t lastbatch = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lk(mtx_);
+            start_cv_.wait(lk, [&]() { return quitting_ || batch_ != lastbatch; });
+
+            if (quitting_) return;
+
+            lastbatch = batch_;
+        }
+
+        this->runItems();
+
+        {
+            std::lock_guard<std::mutex> lg(mtx_);
+            running_--;
+        }
+        done_cv_.notify_one();
+    }
+}
+
+/**
+ * Run `fn(i)` for every i in [0, count), and wait until all of them end
+ */
+void WorkerPool::parallelFor(size_t count, const std::function<void(size_t)>& fn)
+{
+    // Not worth waking up the workers
+    if (threads_.empty() || count <= 1) {
+        for (size_t i = 0; i < count; i++) fn(i);
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lg(mtx_);
+        fn_      = &fn;
+        count_   = count;
+        next_    = 0;
+        running_ = threads_.size();
+        batch_++;
+    }
+    start_cv_.notify_all();
+
+    this->runItems();
+
+    std::unique_lock<std::mutex> lk(mtx_);
+    done_cv_.wait(lk, [&]() { return running_ == 0; });
+    fn_ = nullptr;
+}
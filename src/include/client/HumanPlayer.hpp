@@ -68,6 +68,18 @@ private:
 
     const familyline::input::CommandTable& ctable_;
 
+    /**
+     * Check if there is enough space to build an object of a certain type in
+     * a certain position
+     */
+    bool canBuildAt(const std::string& type, glm::vec2 pos) const;
+
+    /**
+     * Start capturing the profiler zones, or, if we are capturing, stop and
+     * dump them to a trace file
+     */
+    void toggleProfiler();
+
 public:
     bool renderBBs = false;
 
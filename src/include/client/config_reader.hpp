@@ -30,6 +30,15 @@ struct ConfigData {
          * see
          */
         std::vector<std::string> blockTags;
+
+        /**
+         * Also write the log to this file, in the binary log format
+         *
+         * The binary log is smaller and faster to write than the text one, so it
+         * is useful to keep the log of long games. Use tools/dump_log.py to read
+         * it. If empty, we do not write a binary log.
+         */
+        std::string binaryFile;
     } log;
 
     /**
@@ -48,6 +57,23 @@ struct ConfigData {
     struct {
         std::string username = "DefaultUser";
     } player;
+
+    struct {
+        /**
+         * Export the frame and tick time histograms, and the counters of the
+         * subsystems, to this file, when the game ends
+         *
+         * Files ending in .json are written as JSON, the other ones as CSV. If
+         * empty, we do not export anything.
+         */
+        std::string file;
+
+        /**
+         * Also export them every this many seconds, so long runs that do not end
+         * cleanly still leave their data. 0 exports only at the end.
+         */
+        unsigned exportInterval = 60;
+    } telemetry;
 };
 
     std::vector<std::string> get_config_valid_paths();
@@ -37,7 +37,9 @@
 #include <common/logic/object_path_manager.hpp>
 #include <common/logic/pathfinder.hpp>
 #include <common/logic/player_manager.hpp>
+#include <common/logic/target_acquirer.hpp>
 #include <common/logic/terrain_file.hpp>
+#include <common/telemetry.hpp>
 //#include "graphical/gui/ImageControl.hpp"
 
 //#include <client/input/InputPicker.hpp>
@@ -133,6 +135,13 @@ public:
     /// Return maximum, minimum and average fps
     std::tuple<double, double, double> getStatisticInfo();
 
+    /**
+     * Get the frame and tick times, and the counters of the subsystems
+     *
+     * They are exported when the game ends, if an export file was set
+     */
+    Telemetry& getTelemetry() { return telemetry_; }
+
     logic::ObjectManager* getObjectManager() const;
 
     logic::PlayerManager* getPlayerManager() { return pm_.get(); }
@@ -159,6 +168,9 @@ private:
     std::unique_ptr<logic::ObjectLifecycleManager> olm_;
     std::unique_ptr<logic::ColonyManager> cm_;
 
+    /// Makes the idle units attack the enemies near them
+    std::unique_ptr<logic::TargetAcquirer> ta_;
+
     // might not be used at all, but it needs to have the same lifetime
     // as the game, so inputs can be captured.
     std::unique_ptr<logic::InputRecorder> ir_;
@@ -226,6 +238,8 @@ private:
         int i = 0;
     } widgets;
 
+    Telemetry telemetry_;
+
     int frame_ = 0;
 
     bool runInput();
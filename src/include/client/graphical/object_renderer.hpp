@@ -9,6 +9,7 @@
 #include <common/logic/terrain.hpp>
 #include <common/logic/game_object.hpp>
 #include <common/logic/object_components.hpp>
+#include <common/logic/object_manager.hpp>
 #include <map>
 #include <memory>
 #include <vector>
@@ -52,6 +53,12 @@ public:
      */
     bool willUpdate() { return true; }
 
-    void update();
+    /**
+     * Update the meshes of the objects that moved, and draw the debug boxes
+     *
+     * The moved objects are found by the `moved` flags of the packed state of
+     * the object manager, so the objects that stood still are not touched.
+     */
+    void update(familyline::logic::ObjectManager& om);
 };
 }  // namespace familyline::graphics
@@ -50,6 +50,9 @@ private:
     std::unordered_map<long long int, render_hook_t> hooks_;
 
 protected:
+    /// Draw calls made in the last call to render()
+    size_t draw_calls_ = 0;
+
     void runHooks(Camera* c)
     {
         std::for_each(hooks_.begin(), hooks_.end(), [&](auto& hookd) { hookd.second(c); });
@@ -68,6 +71,9 @@ public:
     virtual VertexHandle* createVertex(VertexData& vd, VertexInfo& vi) = 0;
     virtual void removeVertex(VertexHandle* vh)                        = 0;
     virtual void render(Camera* c)                                     = 0;
+
+    /// Number of draw calls made in the last call to render()
+    size_t getDrawCalls() const { return draw_calls_; }
     // virtual LightHandle createLight(LightData& ld) = 0;
 
     virtual LightHandle* createLight(Light& light) = 0;
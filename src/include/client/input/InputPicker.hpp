@@ -17,6 +17,7 @@
 #include <common/logic/object_components.hpp>
 #include <common/logic/object_manager.hpp>
 #include <glm/glm.hpp>
+#include <unordered_map>
 
 #include "Cursor.hpp"
 
@@ -24,6 +25,11 @@ namespace familyline::input
 {
 #define MAX_PICK_ITERATIONS 16
 
+/// Maximum distance, in game units, between an object and the point where the cursor
+/// touches the terrain, for the object to be picked. The cursor ray passes over the
+/// objects before reaching the terrain, so this needs to account for their height.
+#define PICK_RADIUS 32.0
+
 /**
  * \brief Object information needed by the picker
  *
@@ -68,7 +74,12 @@ private:
 
     bool CheckIfTerrainIntersect(glm::vec3 ray, float start, float end);
 
-    std::vector<PickerObjectInfo> poi_list;
+    /// The objects we can pick, and the version of the object listener
+    /// they are from
+    std::unordered_map<familyline::logic::object_id_t, PickerObjectInfo> poi_list;
+    uint64_t poi_version_ = 0;
+
+    void AddPickerObject(familyline::logic::object_id_t id);
 
 public:
     InputPicker(
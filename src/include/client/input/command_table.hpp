@@ -21,7 +21,8 @@ namespace familyline::input
     enum class PlayerCommandType { CameraMove, CameraRotate, CameraZoom,
         DebugCreateEntity,
         DebugDestroyEntity,
-        DebugShowBoundingBox};
+        DebugShowBoundingBox,
+        DebugToggleProfiler};
 
 /**
  * The player command itself
@@ -28,6 +28,12 @@ struct ParamInfo {
     std::optional<std::string> inputFile;
 
     std::optional<std::string> serverAddress;
+
+    /// Capture the profiler zones during the whole game, and dump them to this file at exit
+    std::optional<std::string> profileFile;
+
+    /// Export the frame and tick time histograms to this file (overrides the settings file)
+    std::optional<std::string> telemetryFile;
 };
 
 /**
@@ -0,0 +1,281 @@
+/**
+ * Binary log format
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <fmt/format.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <glm/glm.hpp>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace familyline
+{
+/**
+ * The binary log file
+ *
+ * The file starts with a header:
+ *
+ *     "FLOG" | version (u32) | start time, in microseconds since the epoch (u64)
+ *
+ * followed by a sequence of entries. Each entry starts with a byte that tells its
+ * kind. Integers are LEB128 varints, and signed ones are zigzag encoded first.
+ *
+ *  - Format string: 0x01 | format ID | length | string
+ *  - Tag name:      0x02 | tag ID | length | string
+ *  - Lost messages: 0x03 | count
+ *  - Message:       0x10 + level | format ID | tag ID | tick delta (signed) |
+ *                   timestamp delta, in microseconds (signed) | argument count |
+ *                   arguments
+ *
+ * The format strings and tag names are written once per file, before the first
+ * message that uses them, so each file can be decoded by itself. The ticks and
+ * timestamps are relative to the previous message.
+ *
+ * Each argument is a type byte (one of binlog::ArgType), followed by its value.
+ * Floating point numbers are written as they are in memory, little endian.
+ *
+ * Format ID 0 is always "{}". Messages with arguments that we cannot write are
+ * formatted by the logger, and written as a single string with that format.
+ *
+ * tools/dump_log.py decodes this format.
+ */
+namespace binlog
+{
+constexpr uint32_t Version = 1;
+
+enum EntryKind : uint8_t {
+    EntryFormat  = 0x01,
+    EntryTag     = 0x02,
+    EntryLost    = 0x03,
+    EntryMessage = 0x10,
+};
+
+enum ArgType : uint8_t {
+    ArgInt    = 1,
+    ArgUint   = 2,
+    ArgDouble = 3,
+    ArgBool   = 4,
+    ArgChar   = 5,
+    ArgString = 6,
+    ArgVec2   = 7,
+    ArgVec3   = 8,
+    ArgFloat  = 9,
+};
+
+/// The ID of the "{}" format
+constexpr uint32_t PreformattedID = 0;
+
+}  // namespace binlog
+
+/**
+ * Encodes log messages into the binary log format
+ *
+ * Only appends to a memory buffer, so it is cheap to call.
+ */
+class BinaryLogEncoder
+{
+public:
+    void putByte(uint8_t v) { buf_.push_back(char(v)); }
+
+    void putVarint(uint64_t v)
+    {
+        while (v >= 0x80) {
+            buf_.push_back(char((v & 0x7f) | 0x80));
+            v >>= 7;
+        }
+        buf_.push_back(char(v));
+    }
+
+    void putSigned(int64_t v) { this->putVarint((uint64_t(v) << 1) ^ uint64_t(v >> 63)); }
+
+    void putString(std::string_view s)
+    {
+        this->putVarint(s.size());
+        buf_.append(s.data(), s.size());
+    }
+
+    template <typename T>
+    void putRaw(T v)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        char b[sizeof(T)];
+        std::memcpy(b, &v, sizeof(T));
+        buf_.append(b, sizeof(T));
+    }
+
+    /**
+     * If we can write this type as a binary argument
+     *
+     * The other types are formatted to text, with the rest of the message
+     */
+    template <typename T>
+    static constexpr bool isNative =
+        std::is_arithmetic_v<T> || std::is_same_v<T, std::string> ||
+        std::is_same_v<T, glm::vec2> || std::is_same_v<T, glm::vec3>;
+
+    template <typename T>
+    void putArg(const T& v)
+    {
+        if constexpr (std::is_same_v<T, bool>) {
+            this->putByte(binlog::ArgBool);
+            this->putByte(v ? 1 : 0);
+        } else if constexpr (std::is_same_v<T, char>) {
+            this->putByte(binlog::ArgChar);
+            this->putByte(uint8_t(v));
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            this->putByte(binlog::ArgInt);
+            this->putSigned(v);
+        } else if constexpr (std::is_integral_v<T>) {
+            this->putByte(binlog::ArgUint);
+            this->putVarint(v);
+        } else if constexpr (std::is_same_v<T, float>) {
+            this->putByte(binlog::ArgFloat);
+            this->putRaw(v);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            this->putByte(binlog::ArgDouble);
+            this->putRaw(double(v));
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            this->putByte(binlog::ArgString);
+            this->putString(v);
+        } else if constexpr (std::is_same_v<T, glm::vec2>) {
+            this->putByte(binlog::ArgVec2);
+            this->putRaw(v.x);
+            this->putRaw(v.y);
+        } else {
+            static_assert(std::is_same_v<T, glm::vec3>, "this argument type is not native");
+            this->putByte(binlog::ArgVec3);
+            this->putRaw(v.x);
+            this->putRaw(v.y);
+            this->putRaw(v.z);
+        }
+    }
+
+    /**
+     * Write the arguments of a message
+     *
+     * If one of them is not native, we format the message, and write it as one
+     * string. Returns false in this case.
+     */
+    template <typename... Args>
+    bool putArgs(std::string_view fmt, const Args&... args)
+    {
+        if constexpr ((isNative<Args> && ...)) {
+            this->putByte(uint8_t(sizeof...(Args)));
+            (this->putArg(args), ...);
+            return true;
+        } else {
+            auto text = fmt::vformat(fmt, fmt::make_format_args(args...));
+            this->putByte(1);
+            this->putArg(text);
+            return false;
+        }
+    }
+
+    std::string& buffer() { return buf_; }
+
+private:
+    std::string buf_;
+};
+
+/**
+ * Writes log messages to binary log files
+ *
+ * When a file gets bigger than `max_file_size`, it is renamed to `<path>.1`, the
+ * older ones are renamed to `<path>.2`, `<path>.3` and so on, and we start a new
+ * one. We keep at most `max_files` files.
+ */
+class BinaryLogWriter
+{
+public:
+    BinaryLogWriter(
+        std::filesystem::path path, size_t max_file_size = 64 * 1024 * 1024,
+        unsigned max_files = 4);
+    ~BinaryLogWriter();
+
+    BinaryLogWriter(const BinaryLogWriter&)            = delete;
+    BinaryLogWriter& operator=(const BinaryLogWriter&) = delete;
+
+    /**
+     * Create the log file, rotating the old ones
+     *
+     * Returns false if we could not create it
+     */
+    bool open();
+
+    /**
+     * Start a message
+     *
+     * The format string is identified by its address, so it must be a literal.
+     * After this call, write the arguments to the encoder, and call endMessage().
+     */
+    BinaryLogEncoder& beginMessage(
+        std::string_view fmt, uint32_t tag, std::string_view tagname, uint8_t level,
+        uint64_t tick, double delta);
+
+    /**
+     * Finish the message
+     *
+     * `native` is what BinaryLogEncoder::putArgs() returned. If false, the message
+     * is written with the "{}" format.
+     */
+    void endMessage(bool native);
+
+    void writeLost(uint64_t count);
+
+    /**
+     * Write the buffered messages to the file
+     */
+    void flush();
+
+    /// Number of bytes written, since the writer was created
+    uint64_t bytesWritten() const { return bytes_written_; }
+
+private:
+    std::filesystem::path path_;
+    size_t max_file_size_;
+    unsigned max_files_;
+
+    FILE* file_             = nullptr;
+    size_t file_size_       = 0;
+    uint64_t bytes_written_ = 0;
+
+    /// The message we are encoding, and its arguments
+    struct {
+        std::string_view fmt;
+        uint32_t tag;
+        std::string_view tagname;
+        uint8_t level;
+        uint64_t tick;
+        int64_t time;
+    } message_;
+    BinaryLogEncoder args_;
+
+    /// The messages ready to be written
+    BinaryLogEncoder out_;
+
+    /// Format strings and tags already written to the current file
+    std::unordered_map<const char*, uint32_t> formats_;
+    std::vector<bool> tags_;
+
+    uint64_t last_tick_ = 0;
+    int64_t last_time_  = 0;
+
+    /**
+     * Get the ID of a format string, writing it if it is not in the file yet
+     */
+    uint32_t formatID(std::string_view fmt);
+
+    std::filesystem::path rotatedPath(unsigned i) const;
+};
+
+}  // namespace familyline
@@ -11,12 +11,21 @@
 #include <fmt/format.h>
 #include <fmt/ranges.h>  // so you can directly print ranges to the log
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <common/binary_log.hpp>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdio>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <optional>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <type_traits>
 #include <vector>
 
@@ -90,32 +99,371 @@ struct fmt::formatter<std::optional<T>> : formatter<T> {
 
 namespace familyline
 {
-#define LOGDEBUG(log, tag, format, ...) log->write(tag, LogType::Debug, format, __VA_ARGS__)
+/**
+ * The lowest level of the messages compiled into the game
+ *
+ * If FLINE_STRIP_DEBUG_LOG is defined, the debug messages written with the macros
+ * below are removed at compile time, together with their arguments.
+ * Logger::write also drops them, but their arguments are still evaluated.
+ */
+#ifdef FLINE_STRIP_DEBUG_LOG
+#define FLINE_LOG_MIN_TYPE familyline::LogType::Info
+#else
+#define FLINE_LOG_MIN_TYPE familyline::LogType::Debug
+#endif
+
+/**
+ * Check if a message would be written
+ *
+ * Always false for messages removed at compile time
+ */
+#define LOGENABLED(log, tag, type) ((type) >= FLINE_LOG_MIN_TYPE && (log)->isEnabled(tag, type))
+
+/**
+ * Write a message, evaluating the arguments only if it will be written
+ */
+#define LOGWRITE(log, tag, type, ...)                                            \
+    do {                                                                         \
+        if constexpr ((type) >= FLINE_LOG_MIN_TYPE) {                            \
+            if ((log)->isEnabled(tag, type)) (log)->write(tag, type, __VA_ARGS__); \
+        }                                                                        \
+    } while (0)
+
+#define LOGDEBUG(log, tag, ...) LOGWRITE(log, tag, familyline::LogType::Debug, __VA_ARGS__)
 
 enum LogType { Debug, Info, Warning, Error, Fatal };
 
+/**
+ * The names of the log tags
+ *
+ * Each tag name gets an integer ID the first time it is used, so the loggers can
+ * keep the level of each tag in an array, and the log messages only need to store
+ * the ID.
+ *
+ * Looking up an existing tag does not lock anything, so it can be done in any
+ * thread, at any time.
+ */
+class LogTagRegistry
+{
+public:
+    static constexpr size_t MaxTags = 256;
+
+    /// The ID given to the tags after we registered MaxTags of them
+    static constexpr uint32_t OverflowTag = MaxTags - 1;
+
+    static LogTagRegistry& get();
+
+    /**
+     * Get the ID of a tag, registering it if needed
+     */
+    uint32_t intern(std::string_view name);
+
+    std::string_view name(uint32_t id) const { return names_[id]; }
+
+private:
+    LogTagRegistry();
+
+    static uint64_t hash(std::string_view name);
+
+    static constexpr size_t TableSize = MaxTags * 2;
+
+    /// Open addressing hash table of the tags. Each slot has the tag ID plus one,
+    /// or zero if it is empty
+    std::array<std::atomic<uint32_t>, TableSize> slots_;
+
+    std::array<uint64_t, MaxTags> hashes_;
+    std::array<std::string, MaxTags> names_;
+    uint32_t count_ = 0;
+
+    std::mutex mtx_;
+};
+
+/**
+ * A log tag, interned
+ *
+ * Create them once, as a static constant, and log with them, so you do not pay the
+ * lookup of the tag name on every message:
+ *
+ *     static const LogTag tag{"pathfinder"};
+ *     LOGDEBUG(LoggerService::getLogger(), tag, "open list has {}", open.size());
+ */
+class LogTag
+{
+public:
+    explicit LogTag(std::string_view name) : id_(LogTagRegistry::get().intern(name)) {}
+
+    uint32_t id() const { return id_; }
+    std::string_view name() const { return LogTagRegistry::get().name(id_); }
+
+private:
+    uint32_t id_;
+};
+
+/**
+ * A log message waiting to be written
+ *
+ * The arguments of the message are copied into `args`, so the caller does not need
+ * to keep them alive. The logger thread formats them (or encodes them, for the
+ * binary log) later, with the functions below, that know their types.
+ */
+struct LogRecord {
+    /// Maximum size of the arguments of a message.
+    /// Messages with bigger arguments are formatted by the caller
+    static constexpr size_t ArgsSize = 192;
+
+    double delta;
+    uint64_t tick;
+    LogType type;
+    uint32_t tag;
+
+    /// The format string. It is always a string literal, so it lives forever
+    std::string_view fmt;
+
+    /// Format the message into `out`
+    void (*format)(const LogRecord& r, std::string& out);
+
+    /// Write the arguments to a binary log. Returns false if they had to be
+    /// formatted to text
+    bool (*encode)(const LogRecord& r, BinaryLogEncoder& out);
+
+    /// Destroy the arguments
+    void (*destroy)(LogRecord& r);
+
+    alignas(std::max_align_t) unsigned char args[ArgsSize];
+};
+
+class LogRing;
+
+/**
+ * The game logger
+ *
+ * Writing to the log does not format anything in the thread that writes: the
+ * message is copied to a ring buffer owned by that thread, and a background thread
+ * formats and writes the messages of every ring.
+ *
+ * If a thread writes faster than the background thread can consume, its ring fills
+ * up, and the new messages are dropped. The background thread reports how many
+ * messages were lost, so the memory used by the logger is always bounded.
+ */
 class Logger
 {
 private:
     FILE* _out = nullptr;
     LogType minlog_;
-    std::vector<std::string> blockTags_;
+
+    /// Level of a tag we did not look at yet
+    static constexpr uint8_t TagUnresolved = 0xff;
+
+    /// Level of a tag whose messages are never written
+    static constexpr uint8_t TagDisabled = LogType::Fatal + 1;
+
+    /// The minimum level of each tag, indexed by the tag ID
+    std::array<std::atomic<uint8_t>, LogTagRegistry::MaxTags> tag_levels_;
+
+    /// The lowest level of any tag, so we can discard most messages before
+    /// looking at their tag
+    std::atomic<uint8_t> min_level_;
+
+    /// The tags whose level is not `minlog_`
+    std::mutex tag_config_mtx_;
+    std::vector<std::pair<std::string, uint8_t>> tag_config_;
+
+    /**
+     * Find the level of a tag, from the tag configuration
+     */
+    uint8_t resolveTag(uint32_t id);
+    void setTagConfig(std::string_view tag, uint8_t level);
+
     std::chrono::steady_clock::time_point _start;
     double getDelta();
 
-    std::mutex mtx;
     const std::string getLevelText(const LogType type);
 
+    /// Unique ID of this logger, so that the rings of a thread are not reused by
+    /// another logger
+    uint64_t id_;
+    size_t ring_capacity_;
+
+    std::mutex rings_mtx_;
+    std::vector<std::shared_ptr<LogRing>> rings_;
+
+    /// Only one thread can consume the rings at a time
+    std::mutex drain_mtx_;
+    std::vector<LogRecord*> records_;
+    std::string text_;
+
+    /// The binary log, if we have one. Only used while holding drain_mtx_
+    std::unique_ptr<BinaryLogWriter> binary_;
+
+    std::atomic<uint64_t> tick_ = 0;
+
+    std::mutex wake_mtx_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+    std::thread thread_;
+
+    uint64_t dropped_ = 0;
+
+    /**
+     * Get a free record in the ring of the current thread, or nullptr if it is full
+     *
+     * If it is full, the message is counted as lost, unless it is a fatal one.
+     */
+    LogRecord* beginRecord(LogType type);
+
+    /**
+     * Publish the record returned by beginRecord()
+     */
+    void endRecord(LogType type);
+
+    /**
+     * Consume the messages of every ring, and write them to the log file
+     */
+    void drain();
+
+    /**
+     * Write an already formatted message, without going through the rings
+     *
+     * Used for the fatal messages that do not fit in the ring of their thread,
+     * because they cannot be lost.
+     */
+    void writeNow(const LogTag& tag, LogType type, const std::string& message);
+
+    void run();
+
+    /**
+     * Format a line of the text log, and append it to `out`
+     */
+    void appendLine(
+        std::string& out, double delta, LogType type, std::string_view tag, std::string_view data);
+
+    /**
+     * The type we store for each argument
+     *
+     * Strings not owned by the argument are copied, because they might not be
+     * alive when the message is formatted
+     */
+    template <typename T>
+    struct StoredArg {
+        using type = T;
+    };
+
+    template <typename T>
+    using Stored = typename StoredArg<std::decay_t<T>>::type;
+
+    /**
+     * If an argument can be formatted in the logger thread
+     *
+     * Some arguments can only be formatted in the thread that created them
+     * (like scheme objects, because the interpreter is not thread-safe)
+     */
+    template <typename T>
+    static constexpr bool formatsAsync = !std::is_same_v<std::decay_t<T>, s7_print_pair>;
+
+    template <typename... Args>
+    void enqueue(const LogTag& tag, const LogType type, std::string_view fmt, const Args&... args)
+    {
+        using Tuple = std::tuple<Stored<Args>...>;
+
+        if constexpr (
+            sizeof(Tuple) > LogRecord::ArgsSize || alignof(Tuple) > alignof(std::max_align_t) ||
+            !(formatsAsync<Args> && ...)) {
+            this->enqueue(tag, type, "{}", fmt::format(fmt, args...));
+        } else {
+            auto* r = this->beginRecord(type);
+            if (!r) {
+                if (type == LogType::Fatal)
+                    this->writeNow(tag, type, fmt::format(fmt, args...));
+                return;
+            }
+
+            r->delta = this->getDelta();
+            r->tick  = tick_.load(std::memory_order_relaxed);
+            r->type  = type;
+            r->tag   = tag.id();
+            r->fmt   = fmt;
+
+            new (r->args) Tuple(args...);
+            r->format = [](const LogRecord& r, std::string& out) {
+                auto& stored = *std::launder(reinterpret_cast<const Tuple*>(r.args));
+                try {
+                    out = std::apply(
+                        [&](const auto&... a) {
+                            return fmt::vformat(r.fmt, fmt::make_format_args(a...));
+                        },
+                        stored);
+                } catch (const fmt::format_error& e) {
+                    out = fmt::format("invalid log message '{}' ({})", r.fmt, e.what());
+                }
+            };
+            r->encode = [](const LogRecord& r, BinaryLogEncoder& out) {
+                auto& stored = *std::launder(reinterpret_cast<const Tuple*>(r.args));
+                try {
+                    return std::apply(
+                        [&](const auto&... a) { return out.putArgs(r.fmt, a...); }, stored);
+                } catch (const fmt::format_error& e) {
+                    out.putArgs("{}", fmt::format("invalid log message '{}' ({})", r.fmt, e.what()));
+                    return false;
+                }
+            };
+            r->destroy = [](LogRecord& r) {
+                std::launder(reinterpret_cast<Tuple*>(r.args))->~Tuple();
+            };
+
+            this->endRecord(type);
+        }
+    }
+
 public:
+    /**
+     * Create a logger
+     *
+     * `ring_capacity` is the number of messages each thread can have waiting to be
+     * written. It must be a power of two.
+     */
     Logger(
-        FILE* out = stderr, LogType minlog = LogType::Info, std::vector<std::string> blockTags = {})
-        : _out(out),
-          minlog_(minlog),
-          _start(std::chrono::steady_clock::now()),
-          blockTags_(blockTags)
+        FILE* out = stderr, LogType minlog = LogType::Info, std::vector<std::string> blockTags = {},
+        size_t ring_capacity = 1024);
+
+    /**
+     * Write the remaining messages, and stop the logger thread
+     */
+    ~Logger();
+
+    Logger(const Logger&)            = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    /**
+     * Check if a message with this tag and type would be written
+     *
+     * Use it to avoid building expensive log messages that nobody will see
+     */
+    bool isEnabled(const LogTag& tag, const LogType type)
     {
+        auto level = tag_levels_[tag.id()].load(std::memory_order_relaxed);
+        if (level == TagUnresolved) [[unlikely]]
+            level = this->resolveTag(tag.id());
+
+        return type >= level;
+    }
+
+    bool isEnabled(std::string_view tag, const LogType type)
+    {
+        if (type < min_level_.load(std::memory_order_relaxed)) return false;
+
+        return this->isEnabled(LogTag{tag}, type);
     }
 
+    /**
+     * Set the minimum level of the messages of a tag
+     */
+    void setTagLevel(std::string_view tag, LogType level) { this->setTagConfig(tag, level); }
+
+    /**
+     * Do not write any message of a tag
+     */
+    void disableTag(std::string_view tag) { this->setTagConfig(tag, TagDisabled); }
+
     /**
      * Well..., write a message to a logfile.
      * The logfile can be a file, or stderr
@@ -127,27 +475,88 @@ public:
      * We have 5 levels of logging: Debug, Info, Warning, Error and Fatal.
      * The logging levels are autodescriptive
      *
+     * The message is written later, by the logger thread, except for the fatal
+     * ones, which are written before this function returns.
      */
-    template <typename... Args>
-    void write(std::string_view tag, const LogType type, const std::string fmt, Args... args)
+    template <size_t N, typename... Args>
+    void write(const LogTag& tag, const LogType type, const char (&fmt)[N], const Args&... args)
     {
-        if (type < minlog_) return;
+        if (type < FLINE_LOG_MIN_TYPE) return;
+        if (!this->isEnabled(tag, type)) return;
 
-        if (std::find(blockTags_.begin(), blockTags_.end(), tag) != blockTags_.end()) return;
+        this->enqueue(tag, type, std::string_view(fmt, N - 1), args...);
+    }
 
-        auto strtype = this->getLevelText(type);
-        auto delta   = this->getDelta();
-        auto strend  = strtype.size() > 0 ? "\033[0m" : "";
+    template <size_t N, typename... Args>
+    void write(std::string_view tag, const LogType type, const char (&fmt)[N], const Args&... args)
+    {
+        if (type < FLINE_LOG_MIN_TYPE) return;
+        if (type < min_level_.load(std::memory_order_relaxed)) return;
 
-        auto data = fmt::format(fmt, args...);
-        auto stag = tag.size() > 0 ? fmt::format("\033[1m{}\033[0m: ", tag) : "";
+        this->write(LogTag{tag}, type, fmt, args...);
+    }
 
-        auto msg = fmt::format("[{:13.4f}] {}{}{}{}\n", delta, strtype, stag, data, strend);
+    /**
+     * Write a message whose format string is not a literal
+     *
+     * The format string might not be alive when the logger thread formats the
+     * message, so we format it here.
+     */
+    template <typename... Args>
+    void write(const LogTag& tag, const LogType type, const std::string& fmt, const Args&... args)
+    {
+        if (type < FLINE_LOG_MIN_TYPE) return;
+        if (!this->isEnabled(tag, type)) return;
+
+        this->enqueue(tag, type, "{}", fmt::format(fmt, args...));
+    }
 
-        mtx.lock();
-        fputs(msg.c_str(), _out);
-        mtx.unlock();
+    template <typename... Args>
+    void write(std::string_view tag, const LogType type, const std::string& fmt, const Args&... args)
+    {
+        if (type < FLINE_LOG_MIN_TYPE) return;
+        if (type < min_level_.load(std::memory_order_relaxed)) return;
+
+        this->write(LogTag{tag}, type, fmt, args...);
     }
+
+    /**
+     * Write every message written until now
+     */
+    void flush();
+
+    /**
+     * Also write the messages to a binary log
+     *
+     * Pass nullptr to stop writing to it. If you only want the binary log, create
+     * the logger with a null output file.
+     */
+    void setBinarySink(std::unique_ptr<BinaryLogWriter> sink);
+
+    /**
+     * Set the game tick, stored with every message in the binary log
+     */
+    void setTick(uint64_t tick) { tick_.store(tick, std::memory_order_relaxed); }
+
+    /**
+     * Number of messages lost because their ring was full
+     */
+    uint64_t getDroppedCount();
+};
+
+template <>
+struct Logger::StoredArg<const char*> {
+    using type = std::string;
+};
+
+template <>
+struct Logger::StoredArg<char*> {
+    using type = std::string;
+};
+
+template <>
+struct Logger::StoredArg<std::string_view> {
+    using type = std::string;
 };
 
 class LoggerService
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <array>
 #include <common/logic/game_event.hpp>
 #include <functional>
-#include <queue>
+#include <string>
+#include <variant>
 #include <vector>
 
 namespace familyline::logic
@@ -14,8 +16,7 @@ namespace familyline::logic
  * EntityEventType variant in the game_event.hpp header, because I use this
  * value as sort of a numeric value
  *
- * TODO: actually enforce this, like this:
- * https://en.cppreference.com/w/cpp/utility/variant/variant_alternative
+ * We check, at least, that both have the same number of elements.
  */
 enum ActionQueueEvent {
     Created = 0,
@@ -33,6 +34,11 @@ enum ActionQueueEvent {
     Destroyed
 };
 
+constexpr size_t ActionQueueEventCount = std::variant_size_v<EntityEventType>;
+static_assert(
+    ActionQueueEvent::Destroyed + 1 == ActionQueueEventCount,
+    "ActionQueueEvent and EntityEventType must have the same number of elements");
+
 /**
  * The event receiving callback.
  *
@@ -62,14 +68,45 @@ struct ReceiverData {
  * Acts like a central hub for events that happen in the game.
  * Receiving events here is good if you want to know when a certain entity was
  * created, or died, or has been attacked.
+ *
+ * The events wait in a ring buffer, that only grows if it gets full, so pushing
+ * an event does not allocate anything. For each event type, we keep the list of
+ * receivers that listen to it, so delivering an event does not look at the
+ * receivers that do not want it.
  */
 class ActionQueue
 {
 private:
-    std::queue<EntityEvent> events;
+    /// The pending events. Its size is always a power of two.
+    std::vector<EntityEvent> events;
+    size_t events_head  = 0;
+    size_t events_count = 0;
+
     std::vector<ReceiverData> receivers;
 
+    /// The receivers of each event type, in the order they were added
+    std::array<std::vector<EventReceiver*>, ActionQueueEventCount> dispatch;
+
+    /// True while we call the receivers of an event.
+    ///
+    /// Receivers added (a ReceiverData) or removed (a name) meanwhile wait in
+    /// `pending_changes`, because changing `receivers` would move or destroy
+    /// the receiver we are calling. They are applied after the event has been
+    /// delivered, so they see the next events.
+    bool dispatching = false;
+    std::vector<std::variant<ReceiverData, std::string>> pending_changes;
+
+    void applyPendingChanges();
+
+    void rebuildDispatch();
+
+    void growEvents();
+
+    void logEvent(const EntityEvent& e);
+
 public:
+    explicit ActionQueue(size_t capacity = 4096);
+
     void addEmitter(EventEmitter* e);
     void addReceiver(std::string name, EventReceiver r, std::initializer_list<ActionQueueEvent> events);
 
@@ -81,10 +118,12 @@ public:
 
     void clearEvents()
     {
-        while (!events.empty()) {
-            events.pop();
-        }
+        events_head  = 0;
+        events_count = 0;
     }
+
+    /// Number of events waiting to be processed
+    size_t pendingEvents() const { return events_count; }
 };
 
 }  // namespace familyline::logic
@@ -3,7 +3,10 @@
 #include <common/logic/game_event.hpp>
 #include <common/logic/lifecycle_manager.hpp>
 #include <common/logic/object_components.hpp>
+#include <common/logic/projectile_manager.hpp>
+#include <common/logic/spatial_index.hpp>
 #include <unordered_map>
+#include <vector>
 
 namespace familyline::logic
 {
@@ -11,6 +14,10 @@ namespace familyline::logic
  * The attack manager
  *
  * Causes the real damage, calculate  the damage of the projectiles, etc.
+ *
+ * The attacks are kept in a dense array, indexed by their ID, and by the IDs of
+ * their attacker and of their defender, so finding or removing an attack, or all
+ * attacks of an object, does not need to look at every attack.
  */
 class AttackManager
 {
@@ -22,8 +29,33 @@ public:
      * Do the damage, update the projectile positions and other multiple things
      *
      * Runs once per tick
+     *
+     * If `index` is not null, we use it to check if the projectiles hit their
+     * targets.
+     */
+    void update(
+        ObjectManager& om, ObjectLifecycleManager& olm, const SpatialIndex* index = nullptr);
+
+    /**
+     * Cancel every attack where the object is the attacker or the defender
+     *
+     * Called when it dies, or when the player orders it elsewhere.
+     */
+    void cancelAttacksOf(entity_id_t id);
+
+    bool hasAttack(uint64_t attackID) const
+    {
+        return attack_index_.find(attackID) != attack_index_.end();
+    }
+
+    /**
+     * Check if the object is attacking something
      */
-    void update(ObjectManager& om, ObjectLifecycleManager& olm);
+    bool isAttacking(entity_id_t id) const { return by_attacker_.find(id) != by_attacker_.end(); }
+
+    size_t attackCount() const { return attack_index_.size(); }
+
+    const ProjectileManager& getProjectiles() const { return projectiles_; }
 
 private:
     /**
@@ -56,6 +88,18 @@ private:
         /// increments between 0 and 1, and so we have two attacks in the same
         /// tick.
         double ticks_until_attack;
+
+        /// The damage of each attack, calculated from the attributes above.
+        double damage;
+
+        /// The attribute versions of the attacker and defender components when
+        /// we last read them. We only recalculate the damage when they change.
+        unsigned atkVersion;
+        unsigned defVersion;
+        bool versionsKnown;
+
+        /// The attack was cancelled, and will be removed at the end of the update
+        bool removed;
     };
 
     /**
@@ -76,7 +120,8 @@ private:
     void sendAttackDoneEvent(
         const AttackInfo& atk, AttackAttributes atkAttribute, double damageDealt);
     void sendAttackMissEvent(const AttackInfo& atk);
-    void sendDyingEvent(const AttackInfo& atk);
+    void sendDyingEvent(entity_id_t id, glm::vec2 position);
+    void sendImpactEvent(const ProjectileManager::Impact& impact, bool hit);
 
     void updateAttackInfo(const GameObject& attacker, const GameObject& defender, AttackInfo& atk);
 
@@ -88,7 +133,58 @@ private:
      */
     void countUntilNextAttack(AttackInfo& atk);
 
+    /**
+     * Shoot the projectiles of a ranged attack, as many as the attack speed
+     * allows in this tick
+     */
+    void launchProjectiles(AttackInfo& atk, const AttackTypeProjectile& projectile);
+
+    /**
+     * Damage the defender, if the projectile hit it
+     */
+    void resolveImpact(
+        ObjectManager& om, ObjectLifecycleManager& olm, const SpatialIndex* index,
+        const ProjectileManager::Impact& impact);
+
+    /**
+     * Kill the object, and cancel all attacks it is part of
+     */
+    void killObject(ObjectLifecycleManager& olm, entity_id_t id, glm::vec2 position);
+
+    void addAttack(AttackInfo&& a);
+
+    /**
+     * Mark an attack as removed, and remove it from the indices
+     *
+     * It stays in `attacks_` until the end of the update, so the update loop
+     * can keep going through the array.
+     */
+    void removeAttack(uint64_t attackID);
+
+    /**
+     * Remove the attacks marked as removed from the array, keeping their order
+     */
+    void compactAttacks();
+
+    /**
+     * Refresh the attributes and the damage of the attack, if the components
+     * of the participants changed their attributes
+     */
+    void refreshAttributes(
+        const AttackComponent& atkc, const AttackComponent& defc, AttackInfo& atk);
+
     std::vector<AttackInfo> attacks_;
+
+    /// Index in `attacks_` of each attack ID
+    std::unordered_map<uint64_t, size_t> attack_index_;
+
+    /// The attack IDs of each attacker and of each defender
+    std::unordered_map<entity_id_t, std::vector<uint64_t>> by_attacker_;
+    std::unordered_map<entity_id_t, std::vector<uint64_t>> by_defender_;
+
+    bool has_removed_ = false;
+
+    ProjectileManager projectiles_;
     EventEmitter emitter_ = EventEmitter("attack-manager-emitter");
     bool receiveAttackEvents(const EntityEvent& e);
 };
@@ -0,0 +1,119 @@
+/**
+ * Packed storage for the hot state of the game objects
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <algorithm>
+#include <common/logic/types.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace familyline::logic
+{
+class GameObject;
+
+/**
+ * Stores the state every system reads, every tick, for every object, in packed
+ * arrays, one for each kind of value (a structure of arrays)
+ *
+ * The game objects are allocated one by one, in the heap, so walking through them
+ * means jumping through memory. Here, the positions of all objects are together,
+ * and so are their health points. A system that only needs the positions reads only
+ * the positions.
+ *
+ * The objects are attached to the registry when they are added to the object manager,
+ * and the registry becomes the owner of their state. The accessors of the GameObject
+ * read and write here. When they are detached, the state is copied back to the
+ * object, so objects outside of a manager (or that outlived it) still work.
+ *
+ * The index of an object here is the same index it has in the object manager list,
+ * and removing an object moves the last one to its place.
+ *
+ * The systems that run over all objects walk these arrays, and only touch the
+ * objects that pass their checks: the target acquirer skips the units that cannot
+ * attack, or are dead, by their attack range and health, and the renderer only
+ * moves the meshes of the objects whose `moved` flag is set.
+ */
+class ComponentRegistry
+{
+public:
+    ComponentRegistry() = default;
+
+    ComponentRegistry(const ComponentRegistry&)            = delete;
+    ComponentRegistry& operator=(const ComponentRegistry&) = delete;
+
+    /**
+     * Attach an object, moving its state to the end of the arrays
+     *
+     * Returns its index
+     */
+    size_t attach(GameObject& o);
+
+    /**
+     * Detach the object at the index `i`, copying its state back to it
+     *
+     * The last object takes its place.
+     */
+    void detach(size_t i);
+
+    /**
+     * Detach all objects
+     */
+    void clear();
+
+    size_t size() const { return ids_.size(); }
+
+    const std::vector<object_id_t>& ids() const { return ids_; }
+    const std::vector<GameObject*>& objects() const { return objects_; }
+
+    const std::vector<glm::vec3>& positions() const { return positions_; }
+    std::vector<glm::vec3>& positions() { return positions_; }
+
+    const std::vector<double>& health() const { return health_; }
+    std::vector<double>& health() { return health_; }
+
+    /**
+     * The maximum distance of the first attack rule of each object
+     *
+     * It is 0 if the object has an attack component without rules, and
+     * negative if it does not have one. It is read when the object is attached.
+     */
+    const std::vector<double>& attackRange() const { return attack_range_; }
+
+    /**
+     * Set the position of the object at the index `i`, and mark it as moved
+     */
+    void setPosition(size_t i, glm::vec3 v)
+    {
+        positions_[i] = v;
+        moved_[i]     = 1;
+    }
+
+    /**
+     * Objects whose position changed since the last clearMoved()
+     *
+     * New objects start marked.
+     */
+    const std::vector<uint8_t>& moved() const { return moved_; }
+    void clearMoved() { std::fill(moved_.begin(), moved_.end(), 0); }
+
+    ~ComponentRegistry() { this->clear(); }
+
+private:
+    std::vector<object_id_t> ids_;
+    std::vector<GameObject*> objects_;
+
+    std::vector<glm::vec3> positions_;
+    std::vector<double> health_;
+    std::vector<double> attack_range_;
+
+    /// Not a vector<bool>, so objects updated in different threads do not share
+    /// a byte
+    std::vector<uint8_t> moved_;
+};
+
+}  // namespace familyline::logic
@@ -0,0 +1,133 @@
+/**
+ * Flow field implementation
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <common/logic/obstacle_grid.hpp>
+#include <common/logic/terrain.hpp>
+#include <cstdint>
+#include <limits>
+#include <functional>
+#include <glm/glm.hpp>
+#include <optional>
+#include <vector>
+
+namespace familyline::logic
+{
+/**
+ * A flow field to a certain destination
+ *
+ * When a lot of objects go to the same place, it is cheaper to calculate, once, the
+ * cost from every cell of the map to the destination (the integration field), and the
+ * direction each cell needs to go to reach it (the direction field), than to run one
+ * search for each object.
+ *
+ * Every object ordered to that place just samples the field in its own position to
+ * know where to go next.
+ *
+ * The field is calculated for a certain object size, over an obstacle bitmap with only
+ * the static obstacles. Avoiding the moving ones is a job for whoever samples it.
+ *
+ * It can be limited to a rectangle of the terrain, so it does not need to cover the
+ * whole map, and only changes to the obstacles inside it make it outdated. The cells
+ * outside of it cannot reach the destination.
+ */
+class FlowField
+{
+public:
+    /**
+     * Calculate the flow field to `destination`, for objects of size `size`, inside
+     * the terrain cells of `bounds`
+     */
+    FlowField(
+        const Terrain& t, const std::vector<bool>& bitmap, int ratio, glm::vec2 destination,
+        glm::vec2 size,
+        ObstacleGrid::Region bounds = ObstacleGrid::Region{
+            0, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max()});
+
+    FlowField(const FlowField&) = delete;
+    FlowField& operator=(const FlowField&) = delete;
+
+    glm::vec2 destination() const { return destination_; }
+    glm::vec2 size() const { return size_; }
+    int ratio() const { return ratio_; }
+
+    /// The terrain cells the field covers, clipped to the map
+    ObstacleGrid::Region bounds() const { return bounds_; }
+
+    /**
+     * Check if a change in the obstacles of a region can change this field
+     *
+     * The objects that follow the field look at the cells around them, so the
+     * changes a little outside of the bounds count too.
+     */
+    bool isAffectedBy(ObstacleGrid::Region r) const;
+
+    /**
+     * Check if the destination can be reached from a certain position
+     */
+    bool isReachable(glm::vec2 pos) const;
+
+    /**
+     * Get the cost to go from a position to the destination, or a negative number if it
+     * cannot be reached
+     */
+    double costAt(glm::vec2 pos) const;
+
+    /**
+     * Get the next position an object in `pos` needs to go
+     *
+     * This is the position of the next cell in the field, or the destination itself if we
+     * are in its cell.
+     *
+     * `isBlocked` tells if a position is temporarily blocked (for example, by another
+     * object). If the best cell is blocked, we try the other ones that still lead us
+     * closer to the destination.
+     *
+     * Returns nullopt if we cannot move, either because the destination is unreachable
+     * or because everything is blocked
+     */
+    std::optional<glm::vec2> nextPosition(
+        glm::vec2 pos, std::function<bool(glm::vec2)> isBlocked = nullptr) const;
+
+private:
+    int ratio_;
+    glm::vec2 destination_;
+    glm::vec2 size_;
+
+    /// Width and height of the obstacle bitmap
+    int grid_width_;
+    int grid_height_;
+
+    ObstacleGrid::Region bounds_;
+
+    /// The bounds, in cells of the obstacle bitmap
+    int cell_x0_, cell_y0_, cell_x1_, cell_y1_;
+
+    /// The integration field: cost of each cell to the destination. Negative if the
+    /// destination cannot be reached from it
+    std::vector<float> integration_;
+
+    /// The direction field: for each cell, the index of the neighbor direction to follow,
+    /// or -1 if there is none (we are in the destination, or it cannot be reached)
+    std::vector<int8_t> directions_;
+
+    std::optional<uint32_t> cellFromPosition(glm::vec2 pos) const;
+
+    bool inBounds(int x, int y) const
+    {
+        return x >= cell_x0_ && y >= cell_y0_ && x < cell_x1_ && y < cell_y1_;
+    }
+
+    /**
+     * Check if an object of our size fits in a certain cell
+     */
+    bool fits(const std::vector<bool>& bitmap, int x, int y) const;
+
+    void calculateIntegration(const Terrain& t, const std::vector<bool>& bitmap);
+    void calculateDirections();
+};
+
+}  // namespace familyline::logic
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <array>
+#include <functional>
+#include <common/logic/component_registry.hpp>
 #include <common/logic/object_components.hpp>
 #include <common/logic/types.hpp>
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace familyline::logic
 {
@@ -24,12 +27,24 @@ enum class ObjectCategory { CommonUnit, Building, ResourceDepot, SiegeUnit, Nava
 
 typedef std::array<uint8_t, 256> object_checksum_t;
 
+/**
+ * A change that an object wants to do outside of itself while it is being updated
+ *
+ * The objects might be updated in parallel, so the changes are deferred and run after
+ * all of them were updated, in the order of the ID of the object that created them.
+ */
+struct DeferredCommand {
+    object_id_t source;
+    std::function<void()> run;
+};
+
 /**
  * Our beloved base game object
  */
 class GameObject
 {
     friend class ObjectManager;
+    friend class ComponentRegistry;
 
 private:
 protected:
@@ -66,6 +81,18 @@ protected:
      */
     glm::vec3 _position;
 
+    /**
+     * The registry that has our position and health, while we are in an
+     * object manager
+     *
+     * If it is null, they are in the fields above.
+     */
+    ComponentRegistry* _registry = nullptr;
+    size_t _registry_index       = 0;
+
+    /// Where we store the deferred commands, while we are being updated
+    std::vector<DeferredCommand>* _commands = nullptr;
+
 protected:
     std::optional<LocationComponent> cLocation;
     std::optional<AttackComponent> cAttack;
@@ -85,7 +112,10 @@ public:
     const std::string& getType() const { return _type; }
     const std::string& getName() const { return _name; }
 
-    double getHealth() const { return _health; }
+    double getHealth() const
+    {
+        return _registry ? _registry->health()[_registry_index] : _health;
+    }
     int getMaxHealth() const { return _maxHealth; }
     bool isShowingHealth() const { return _showHealth; }
 
@@ -103,17 +133,25 @@ public:
 
     double addHealth(double v)
     {
-        _health += v;
-        return _health;
+        auto& health = _registry ? _registry->health()[_registry_index] : _health;
+        health += v;
+        return health;
     }
 
     glm::vec2 getSize() const { return _size; }
 
-    glm::vec3 getPosition() const { return _position; }
+    glm::vec3 getPosition() const
+    {
+        return _registry ? _registry->positions()[_registry_index] : _position;
+    }
     glm::vec3 setPosition(glm::vec3 v)
     {
-        _position = v;
-        return _position;
+        if (_registry)
+            _registry->setPosition(_registry_index, v);
+        else
+            _position = v;
+
+        return v;
     }
 
     GameObject(
@@ -129,11 +167,32 @@ public:
      */
     virtual std::shared_ptr<GameObject> create();
 
+    /**
+     * Make this object equal to a new copy of `prototype`, so it can be reused
+     * instead of creating another one
+     *
+     * The location component is kept, because its mesh is ours. Objects with more
+     * state than the base class should reset it too.
+     */
+    virtual void reset(const GameObject& prototype);
+
     /**
      * Update internal object logic
+     *
+     * The object manager might update many objects at the same time, so the
+     * update can only change the object itself. Changes to other objects, or
+     * anything shared (like sending events), need to go through defer().
      */
     void update();
 
+    /**
+     * Run a function that changes something outside of this object
+     *
+     * While the object is being updated, the function is stored and only run
+     * after all objects were updated. Otherwise, it runs now.
+     */
+    void defer(std::function<void()> fn);
+
     std::optional<LocationComponent>& getLocationComponent() { return cLocation; }
     std::optional<AttackComponent>& getAttackComponent() { return cAttack; }
     std::optional<ContainerComponent>& getContainerComponent() { return cContainer; }
@@ -0,0 +1,239 @@
+/**
+ * Hierarchical pathfinder implementation
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <common/logic/obstacle_grid.hpp>
+#include <common/logic/terrain.hpp>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace familyline::logic
+{
+/**
+ * Hierarchical A* (HPA*) pathfinder
+ *
+ * The normal pathfinder expands a number of nodes proportional to the area between the
+ * start and the end, so long paths are expensive.
+ *
+ * Here, we split the obstacle bitmap in square clusters. In the border between two
+ * clusters, every run of free cells (free on both sides of the border) is an entrance,
+ * and each entrance has one or two transition points.
+ *
+ * Inside each cluster, we precompute the cost to go from one transition point to the
+ * others. Those points and their costs form an abstract graph, much smaller than
+ * the grid, and we search a path in this graph instead.
+ *
+ * The result is a list of waypoints, one for each cluster the path enters. The caller
+ * only needs to refine (i.e, find a real path with the normal pathfinder) the segment
+ * between its current position and the next waypoint, and that is limited by the
+ * size of the clusters, not by the size of the map.
+ *
+ * When the obstacle bitmap changes, only the clusters that had cells changed (and their
+ * neighbors, because the entrances are shared between them) are recalculated.
+ *
+ * This is only used for the static obstacles, and for objects of size 1. The normal
+ * pathfinder still deals with the moving objects and the object size when it refines
+ * the path.
+ */
+class HierarchicalPathfinder
+{
+public:
+    HierarchicalPathfinder(const Terrain& t, int cluster_size = 16)
+        : t_(t), cluster_size_(cluster_size)
+    {
+    }
+
+    /**
+     * Update the obstacle bitmap, and the obstacle bitmap size ratio, compared to the
+     * terrain size
+     *
+     * Only the clusters that changed are recalculated. If the ratio changed, everything
+     * is recalculated.
+     */
+    void update(const std::vector<bool>& bitmap, int ratio = 1);
+
+    /**
+     * Update the obstacle bitmap, knowing which regions of the obstacle grid changed
+     * since the last update
+     *
+     * Only the cells inside those regions are compared, instead of the whole bitmap.
+     * The regions are in the full resolution grid, like the ones returned by
+     * ObstacleGrid::changesSince().
+     */
+    void update(
+        const std::vector<bool>& bitmap, int ratio,
+        const std::vector<ObstacleGrid::Region>& changes);
+
+    /**
+     * Find the waypoints of a path through the terrain
+     *
+     * Returns a list of X+Z positions, ordered from start to end. The last one is always
+     * the end, and the others are the points where the path enters a new cluster.
+     *
+     * Return nullopt if no path could be found.
+     */
+    std::optional<std::vector<glm::vec2>> findWaypoints(glm::vec2 start, glm::vec2 end);
+
+    /// Number of clusters recalculated in the last call to update()
+    size_t rebuiltClusters() const { return rebuilt_clusters_; }
+
+    /// Number of abstract nodes (transition points) in the graph
+    size_t abstractNodeCount() const;
+
+    /// Number of abstract nodes expanded in the last call to findWaypoints()
+    size_t expandedNodes() const { return expanded_nodes_; }
+
+    int clusterSize() const { return cluster_size_; }
+
+private:
+    const Terrain& t_;
+    std::vector<bool> obstacle_bitmap_;
+
+    int cluster_size_;
+    int ratio_ = 0;
+
+    /// Width and height of the obstacle bitmap
+    int grid_width_  = 0;
+    int grid_height_ = 0;
+
+    /// Number of clusters in each axis
+    int clusters_x_ = 0;
+    int clusters_y_ = 0;
+
+    size_t rebuilt_clusters_ = 0;
+    size_t expanded_nodes_   = 0;
+
+    struct Cluster {
+        /// Position and size of the cluster, in bitmap cells
+        int x, y, w, h;
+
+        /// Cell index of each transition point inside this cluster
+        std::vector<uint32_t> transitions;
+
+        /// Cost between every pair of transition points, as a
+        /// transitions.size() x transitions.size() matrix.
+        /// Negative if there is no path between them inside the cluster.
+        std::vector<double> costs;
+
+        /// For each transition point, the cells of the transition points on the other
+        /// side of the border
+        std::vector<std::vector<uint32_t>> partners;
+    };
+
+    std::vector<Cluster> clusters_;
+
+    /**
+     * The transition points of each border
+     *
+     * Each point is a pair of cells, one on each side of the border.
+     * Index it with borderIndex()
+     */
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> borders_;
+
+    /**
+     * A map of the cell index of each transition point to its cluster and index inside the
+     * cluster transition list
+     */
+    std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> transition_map_;
+
+    /// Index of the first abstract node of each cluster. The last element is the
+    /// total number of abstract nodes
+    std::vector<uint32_t> node_offsets_;
+
+    /// Scratch space for the local searches, to not allocate it every time
+    std::vector<double> local_cost_;
+
+    int clusterAt(int x, int y) const
+    {
+        return (y / cluster_size_) * clusters_x_ + (x / cluster_size_);
+    }
+
+    bool isFree(int x, int y) const { return !obstacle_bitmap_[y * grid_width_ + x]; }
+
+    /**
+     * Check if a cell and its eight neighbors are free
+     */
+    bool hasClearance(int x, int y) const;
+
+    /**
+     * Get the index of the border of a cluster.
+     * `vertical` is the border on the right, if false, it is the border on the bottom
+     */
+    size_t borderIndex(int cluster, bool vertical) const
+    {
+        return cluster * 2 + (vertical ? 1 : 0);
+    }
+
+    /**
+     * Start again from scratch if the size of the bitmap changed
+     *
+     * Return true if we did
+     */
+    bool resize(const std::vector<bool>& bitmap, int ratio);
+
+    /**
+     * Copy the cells of a rectangle of the bitmap that changed, and mark their
+     * clusters as dirty
+     *
+     * The minimum coordinates are inclusive, the maximum ones are exclusive.
+     * Return true if some cell changed
+     */
+    bool diffCells(
+        const std::vector<bool>& bitmap, int x0, int y0, int x1, int y1,
+        std::vector<bool>& dirty);
+
+    /**
+     * Rebuild the dirty clusters, and the borders around them
+     */
+    void rebuildDirty(const std::vector<bool>& dirty);
+
+    /**
+     * Rebuild everything, from scratch
+     */
+    void rebuildAll();
+
+    /**
+     * Find the transition points of a border
+     */
+    void buildBorder(int cluster, bool vertical);
+
+    /**
+     * Collect the transition points of the borders of a cluster, and calculate the
+     * costs between them
+     */
+    void buildCluster(int cluster);
+
+    /**
+     * Rebuild the map of transition points, after some clusters changed
+     */
+    void rebuildTransitionMap();
+
+    /**
+     * Run a Dijkstra search from a cell, restricted to the cluster it is in
+     *
+     * Fill `local_cost_` with the cost from that cell to every cell in the cluster, or
+     * a negative value if it cannot be reached.
+     */
+    void searchInsideCluster(const Cluster& c, uint32_t cell);
+
+    /**
+     * Get the cost of a local search to a certain cell, after calling
+     * searchInsideCluster()
+     */
+    double localCost(const Cluster& c, uint32_t cell) const;
+
+    /**
+     * Convert a position in the terrain to a cell index, and a cell index to
+     * a position in the terrain
+     */
+    std::optional<uint32_t> cellFromPosition(glm::vec2 pos) const;
+    glm::vec2 positionFromCell(uint32_t cell) const;
+};
+
+}  // namespace familyline::logic
@@ -0,0 +1,286 @@
+/**
+ * Incremental pathfinder, to repair paths when the obstacles move
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <common/logic/obstacle_grid.hpp>
+#include <common/logic/terrain.hpp>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace familyline::logic
+{
+/**
+ * An incremental pathfinder, based on D* Lite
+ *
+ * The normal pathfinder searches the whole path again every time it is called. When
+ * lots of objects move together, each one recalculating its path every tick, this is
+ * expensive, and almost always unnecessary: only a small part of the map changed since
+ * the last search, and, most of the time, that part is nowhere near the path.
+ *
+ * This pathfinder searches backwards, from the end to the start, and keeps its search
+ * between calls. Each node has two values:
+ *   - g: the cost from the node to the end, as we calculated it
+ *   - rhs: the cost from the node to the end, as it would be if we used the current g
+ *     of its neighbors
+ *
+ * A node where both are equal is consistent. The ones that are not are in a priority
+ * queue. When a cell of the obstacle grid changes, only the nodes around it have their
+ * rhs recalculated, and the search only needs to fix the nodes that became inconsistent
+ * and are relevant for the path. When the start moves (because the object walked), we do
+ * not start again: the keys of the queue are corrected by an offset (km).
+ *
+ * The nodes are the same as in the normal pathfinder (one for each cell of a downsampled
+ * obstacle grid), and so are the costs, so the paths are similar.
+ *
+ * (Check "D* Lite", by Sven Koenig and Maxim Likhachev, if you want the details)
+ */
+class IncrementalPathfinder
+{
+public:
+    IncrementalPathfinder(const Terrain& t) : t_(t) {}
+
+    /**
+     * Find a path through the terrain, reusing the last search if possible
+     *
+     * If the end, the size or the obstacle grid are different from the ones of the
+     * last call, we start the search from scratch. If not, we only repair it for the
+     * cells that changed in the grid.
+     *
+     * Return a vector of X+Z positions, from start to end, at most one unit apart. If
+     * the search did not finish, or there is no path, return an empty vector (check
+     * maxIterReached() and hasPossiblePath())
+     */
+    std::vector<glm::vec2> findPath(
+        ObstacleView view, glm::vec2 start, glm::vec2 end, glm::vec2 size, int maxiters = 200);
+
+    /**
+     * Update the search, like findPath(), but do not build the path
+     *
+     * Return true if the search finished. If it did, and there is a path, get it with
+     * path()
+     */
+    bool plan(
+        ObstacleView view, glm::vec2 start, glm::vec2 end, glm::vec2 size, int maxiters = 200);
+
+    /**
+     * Get the path found by the last call to plan(), from its start to its end
+     */
+    std::vector<glm::vec2> path();
+
+    /**
+     * Did the search change since the last call to path()?
+     *
+     * If it did not, the last path is still the best one, and an object that is walking
+     * on it can keep walking.
+     */
+    bool pathChanged() const { return path_changed_; }
+
+    /**
+     * The last call stopped because it reached the iteration limit. The next one will
+     * continue from where it stopped
+     */
+    bool maxIterReached() const { return has_max_iter_reached_; }
+
+    /**
+     * Is there a path from the start to the end?
+     *
+     * Only meaningful if the search finished
+     */
+    bool hasPossiblePath() const { return has_path_; }
+
+    /**
+     * Number of nodes we expanded in the last call to findPath()
+     *
+     * Useful for benchmarking
+     */
+    size_t expandedNodes() const { return expanded_nodes_; }
+
+private:
+    using node_index_t                        = uint32_t;
+    static constexpr node_index_t InvalidNode = node_index_t(-1);
+    static constexpr double Infinity          = std::numeric_limits<double>::infinity();
+
+    struct Key {
+        double k1, k2;
+
+        bool operator<(const Key& o) const { return k1 < o.k1 || (k1 == o.k1 && k2 < o.k2); }
+    };
+
+    /**
+     * A node of the search
+     *
+     * Like in the normal pathfinder, the nodes are reused: every node whose `gen` is not
+     * the current one is reset when we first touch it.
+     */
+    struct Node {
+        double g   = Infinity;
+        double rhs = Infinity;
+
+        /// The key it has in the queue, if it is there
+        Key key = {0, 0};
+
+        double height = 0;
+
+        uint32_t heap_index = 0;
+        uint32_t gen        = 0;
+
+        /// If the node is walkable: -1 if we did not check yet, 0 if not, 1 if it is
+        int8_t walkable = -1;
+        bool queued     = false;
+    };
+
+    const Terrain& t_;
+    std::optional<ObstacleView> view_;
+
+    std::vector<Node> nodes_;
+    std::vector<node_index_t> queue_;
+
+    uint32_t search_gen_ = 0;
+
+    int ratio_       = 1;
+    int grid_width_  = 0;
+    int grid_height_ = 0;
+
+    /// What we are searching for
+    glm::vec2 size_ = glm::vec2(0, 0);
+    node_index_t goal_       = InvalidNode;
+    node_index_t start_      = InvalidNode;
+    node_index_t last_start_ = InvalidNode;
+
+    /// Where the object is, where it wants to go, and the node it should go first
+    glm::vec2 start_pos_ = glm::vec2(0, 0);
+    glm::vec2 end_pos_   = glm::vec2(0, 0);
+    node_index_t first_  = InvalidNode;
+
+    /// The key modifier, the sum of the distances the start moved
+    double km_ = 0;
+
+    /// The version of the obstacle grid we last saw
+    uint64_t grid_version_ = 0;
+
+    /// The area (in nodes) with the nodes whose walkability we checked. Changes
+    /// outside of it cannot affect the search
+    int checked_x0_ = 0, checked_y0_ = 0;
+    int checked_x1_ = -1, checked_y1_ = -1;
+
+    bool has_max_iter_reached_ = false;
+    bool has_path_             = false;
+    bool path_changed_         = true;
+    size_t expanded_nodes_     = 0;
+
+    /**
+     * Start a new search, for the current end and view
+     */
+    void resetSearch();
+
+    /**
+     * Check the nodes that might have been affected by the cells that changed in the
+     * obstacle grid, and update the ones whose walkability changed
+     *
+     * Return false if the grid changed too much, and we need to start again
+     */
+    bool applyChanges();
+
+    /**
+     * A node became walkable, or stopped being walkable. Update its neighbors
+     */
+    void walkabilityChanged(node_index_t idx, bool walkable);
+
+    /**
+     * The cells of the level an object in a node covers, in one axis
+     *
+     * `limit` is the size of the terrain in that axis
+     */
+    std::pair<int, int> coveredCells(int node, float size, int limit) const;
+
+    /**
+     * Get the node nearest to a position, clamped to the grid
+     */
+    node_index_t nearestNode(glm::vec2 pos) const;
+
+    /**
+     * The nodes around the start: the ones of the cell it is in (only one if it is
+     * aligned to the grid)
+     *
+     * We might go to any of them first, so all of them need to be consistent at the
+     * end of the search. Return how many there are
+     */
+    int startNodes(glm::vec2 start, node_index_t (&out)[4]) const;
+
+    glm::vec2 nodePosition(node_index_t idx) const
+    {
+        return glm::vec2((idx % grid_width_) * ratio_, (idx / grid_width_) * ratio_);
+    }
+
+    /**
+     * Get a node, resetting it if it belongs to an older search
+     */
+    Node& getNode(node_index_t idx);
+
+    bool isWalkable(node_index_t idx);
+
+    /**
+     * The cost to go from a node to its neighbor. Infinite if the neighbor is not
+     * walkable
+     */
+    double cost(node_index_t from, node_index_t to);
+
+    /**
+     * The cost to go from a node to its neighbor, if the neighbor is walkable
+     */
+    double edgeCost(node_index_t from, node_index_t to);
+
+    /**
+     * The estimated cost between two nodes
+     *
+     * It is the octile distance: never more than the real cost, and it respects the
+     * triangle inequality, as D* Lite needs.
+     */
+    double heuristic(node_index_t a, node_index_t b) const;
+
+    /**
+     * Get the neighbors of a node, the ones inside of the grid. Return how many there are
+     */
+    int neighbors(node_index_t idx, node_index_t (&out)[8]) const;
+
+    Key calculateKey(node_index_t idx);
+
+    /**
+     * Recalculate the rhs of a node, and put it in the queue if it is inconsistent
+     */
+    void updateNode(node_index_t idx);
+
+    /**
+     * Put a node in the queue if it is inconsistent, or remove it if it is not
+     */
+    void updateQueue(node_index_t idx);
+
+    /**
+     * Process the inconsistent nodes, until the start nodes are consistent and no other
+     * node in the queue could change their cost
+     *
+     * Return false if we stopped because of the iteration limit
+     */
+    bool computeShortestPath(const node_index_t* starts, int count, int maxiters);
+
+    /**
+     * Walk from the start to the end, through the start node and then through the
+     * neighbor with the lowest cost
+     */
+    std::vector<glm::vec2> extractPath(glm::vec2 start, node_index_t first, glm::vec2 end);
+
+    /// Queue operations
+    void heapSiftUp(uint32_t pos);
+    void heapSiftDown(uint32_t pos);
+    void pushQueue(node_index_t idx, Key k);
+    void removeQueue(node_index_t idx);
+};
+
+}  // namespace familyline::logic
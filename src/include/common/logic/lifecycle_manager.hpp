@@ -9,6 +9,7 @@
 #include <common/logic/game_event.hpp>
 #include <common/logic/object_manager.hpp>
 #include <unordered_map>
+#include <vector>
 
 namespace familyline::logic
 {
@@ -36,10 +37,28 @@ class ObjectLifecycleManager
 private:
     ObjectManager &_om;
 
-    std::unordered_map<object_id_t, LifecycleData> _o_creating;
-    std::unordered_map<object_id_t, LifecycleData> _o_created;
-    std::unordered_map<object_id_t, LifecycleData> _o_dying;
-    std::unordered_map<object_id_t, LifecycleData> _o_dead;
+    using RecordMap = std::unordered_map<object_id_t, LifecycleData>;
+
+    RecordMap _o_creating;
+    RecordMap _o_created;
+    RecordMap _o_dying;
+    RecordMap _o_dead;
+
+    /**
+     * Records of removed objects, to be reused
+     *
+     * The records move between the maps above as nodes, without being
+     * reallocated, and the nodes of the removed objects come here, so
+     * registering a new object does not allocate a new one.
+     */
+    std::vector<RecordMap::node_type> _free_records;
+
+    /**
+     * Move the record of `id` from a map to another, changing its event
+     *
+     * Return false if the record is not in the first map
+     */
+    bool moveRecord(RecordMap& from, RecordMap& to, object_id_t id, ActionQueueEvent event);
 
 public:
     ObjectLifecycleManager(ObjectManager &om) : _om(om) {}
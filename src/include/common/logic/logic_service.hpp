@@ -11,6 +11,7 @@
 #include <common/logic/terrain.hpp>
 
 #include <common/logic/object_path_manager.hpp>
+#include <common/worker_pool.hpp>
 
 /**
  * Logic service class
@@ -28,6 +29,8 @@ private:
 
     static std::unique_ptr<ObjectPathManager> path_manager_;
 
+    static std::shared_ptr<WorkerPool> worker_pool_;
+
     
 public:
     static std::unique_ptr<ActionQueue>& getActionQueue();
@@ -41,6 +44,15 @@ public:
 
     static void initPathManager(Terrain& t);
     static std::unique_ptr<ObjectPathManager>& getPathManager();
+
+    /**
+     * The worker threads shared by the logic systems
+     *
+     * It has one thread for each core, minus the logic thread. The systems that
+     * use it run one after the other in the logic thread, so they share it instead
+     * of each one having its own threads, and fighting for the cores.
+     */
+    static std::shared_ptr<WorkerPool>& getWorkerPool();
 };
 
 }  // namespace familyline::logic
@@ -125,7 +125,23 @@ public:
     tl::expected<AttackData, AttackError> attack(const AttackComponent& other);
 
     const AttackAttributes& attributes() const { return this->attributes_; }
-    
+
+    /**
+     * Change the attributes, for example, because of an upgrade
+     *
+     * This increments the attribute version, so the ones that cached something
+     * calculated from them know they need to recalculate
+     */
+    void setAttributes(const AttackAttributes& attributes)
+    {
+        attributes_ = attributes;
+        attributes_version_++;
+    }
+
+    unsigned attributesVersion() const { return attributes_version_; }
+
+    const std::vector<AttackRule>& rules() const { return this->rules_; }
+
     /**
      * Calculates the base damage that would be inflicted if the attack was done
      * right now, but using only the component attributes.
@@ -186,6 +202,7 @@ private:
         const AttackAttributes& atkAttributes, const AttackAttributes& defAttributes);
 
     AttackAttributes attributes_;
+    unsigned attributes_version_ = 0;
     std::vector<AttackRule> rules_;
 };
 
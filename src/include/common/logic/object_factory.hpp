@@ -5,9 +5,12 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <string>
+#include <string_view>
 
 #include "game_object.hpp"
+#include "object_pool.hpp"
 
 namespace familyline::logic
 {
@@ -19,11 +22,15 @@ namespace familyline::logic
  * shared libraries (.dll, .so), we need to load them without knowing
  * its class, so the code that use it might use an object without
  * really knowing who it is, only its base class.
+ *
+ * The objects come from a pool, so the objects that died are reused
+ * for the new ones of the same type.
  */
 class ObjectFactory
 {
 private:
-    std::map<std::string /*type*/, GameObject*> _objects;
+    std::map<std::string /*type*/, GameObject*, std::less<>> _objects;
+    std::shared_ptr<ObjectPool> _pool = std::make_shared<ObjectPool>();
 
 public:
     /**
@@ -33,6 +40,15 @@ public:
      */
     std::shared_ptr<GameObject> getObject(const char* type, float x, float y, float z);
 
+    /**
+     * Gets the object the instances of type 'type' are copied from, or
+     * nullptr if it does not exist
+     *
+     * Use it to read the properties of a type (like its size) without
+     * creating an object
+     */
+    const GameObject* getPrototype(std::string_view type) const;
+
     /**
      * Adds an object to the factory
      */
@@ -43,7 +59,16 @@ public:
      */
     std::map<std::string, object_checksum_t> getObjectChecksums() const;
 
-    void clear() { _objects.clear(); }
+    void clear()
+    {
+        _objects.clear();
+        _pool->clear();
+    }
+
+    /**
+     * Get the statistics of the object pool
+     */
+    ObjectPool::Stats getPoolStats() const { return _pool->stats(); }
 
 };
 
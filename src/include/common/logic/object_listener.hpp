@@ -13,14 +13,30 @@
 
 /// TODO: refactor EventReceiver to be a callback instead of a full class with inheritance, etc.
 
-#include <set>
+#include <cstdint>
 #include <functional>
+#include <optional>
+#include <set>
+#include <vector>
 
 #include <common/logic/game_event.hpp>
 #include <common/logic/game_object.hpp>
 
 namespace familyline::logic
 {
+/**
+ * A change in the set of alive objects
+ */
+struct ObjectChange {
+    /// The version of the listener after this change
+    uint64_t version;
+
+    object_id_t id;
+
+    /// True if the object was created, false if it was destroyed
+    bool alive;
+};
+
 class ObjectListener
 {
 private:
@@ -31,18 +47,62 @@ private:
     /// duplicates
     std::set<object_id_t> _objects;
 
+    /// Nodes of destroyed objects, reused for the next ones, so a new object
+    /// does not allocate
+    std::vector<std::set<object_id_t>::node_type> _free_nodes;
+
+    /// The last changes, in a ring buffer with one slot for each change we keep.
+    /// The oldest one is at `_changes_head`
+    std::vector<ObjectChange> _changes;
+    size_t _changes_head  = 0;
+    size_t _changes_count = 0;
+
+    /// The version of the last change
+    uint64_t _version = 0;
+
     /**
      * Update the object statuses according to the events
      */
     bool updateObjects(const EntityEvent& e);
 
+    void pushChange(object_id_t id, bool alive);
+
 public:
     ObjectListener();
 
-    void clear() { _objects.clear(); }
-    
+    /**
+     * Remove all objects
+     *
+     * Whoever mirrors the objects will need to get all of them again
+     */
+    void clear();
+
     std::set<object_id_t> getAliveObjects() const;
 
+    /**
+     * Get the version of the last change
+     *
+     * Each object created or destroyed increments it
+     */
+    uint64_t getVersion() const { return _version; }
+
+    /**
+     * Get the changes after the version `since`, the oldest first
+     *
+     * If we do not have all of them anymore (you took too long to ask, or the
+     * listener was cleared), return an empty optional. In that case, get the
+     * full object list with getAliveObjects().
+     *
+     * With this, whoever keeps a copy of the object list only needs to do
+     * work for what changed since the last time it asked.
+     */
+    std::optional<std::vector<ObjectChange>> getChangesSince(uint64_t since) const;
+
+    /**
+     * Set the number of changes we keep, before discarding the oldest ones
+     */
+    void setMaxChanges(size_t v);
+
     ~ObjectListener();
 };
 }  // namespace familyline::logic
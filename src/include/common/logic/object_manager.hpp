@@ -1,11 +1,14 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <vector>
 
 #include <common/logic/action_queue.hpp>
+#include <common/logic/component_registry.hpp>
 #include <common/logic/game_object.hpp>
+#include <common/worker_pool.hpp>
 
 /// TODO: add event creation on object add/delete
 
@@ -37,13 +40,61 @@ public:
     void notifyRemoval(object_id_t id, const std::string& name);
 };
 
+/**
+ * Stores the game objects, and gives them their IDs
+ *
+ * The objects are stored in a slot map. The ID of an object has the index of its
+ * slot in the lower 32 bits, plus one, so that no object has the ID 0, and the
+ * generation of the slot in the upper 32 bits.
+ *
+ * When an object is removed, the generation of its slot increases, so the old ID
+ * will not find the next object that uses the same slot. This lets us find an object
+ * in constant time, and still know when an ID refers to an object that does not
+ * exist anymore.
+ *
+ * The objects themselves are kept in a dense vector, so updating them is only a walk
+ * through it. Their position and health are kept in a component registry, in the
+ * same order.
+ */
 class ObjectManager
 {
 private:
+    struct Slot {
+        /// Index of the object in the _objects vector, if the slot is used
+        size_t dense_index;
+
+        uint32_t generation = 0;
+        bool used           = false;
+    };
+
+    /// The objects, without holes between them
     std::vector<std::shared_ptr<GameObject>> _objects;
-    int _lastID                      = 0;
+
+    /// The slot of each object in _objects, in the same order
+    std::vector<uint32_t> _object_slots;
+
+    std::vector<Slot> _slots;
+
+    /// Slots that are not used by any object, and can be reused
+    std::vector<uint32_t> _free_slots;
+
+    /// The packed state of the objects, in the same order of _objects
+    ///
+    /// It needs to be destroyed before the objects, so it can give them their state back
+    ComponentRegistry _components;
+
+    std::shared_ptr<WorkerPool> _workers;
+
+    /// The deferred commands of each chunk of objects, in the last update
+    std::vector<std::vector<DeferredCommand>> _command_buffers;
+
     ObjectEventEmitter* eventEmitter = nullptr;
-    
+
+    /**
+     * Get the slot of an ID, or nullptr if the ID is not from a live object
+     */
+    const Slot* findSlot(object_id_t id) const;
+
 public:
     ObjectManager();
 
@@ -66,10 +117,34 @@ public:
     /**
      * Update every object registered into the manager
      *
-     * TODO: update in a certain order?
+     * The objects are split in chunks, and the chunks are updated in parallel. The
+     * changes the objects defer are run after that, in the order of their IDs, so the
+     * result is the same as updating them one by one, in that order, regardless of
+     * the number of workers.
+     *
+     * Objects cannot be added or removed while they are updating, except by
+     * deferred commands.
      */
     void update();
 
+    /**
+     * Set the number of worker threads used to update the objects
+     *
+     * Set it to 0 to update them all in the game thread, the default.
+     * The manager gets its own threads; to use the ones of another system,
+     * call setWorkers().
+     */
+    void setWorkerCount(unsigned v);
+    unsigned getWorkerCount() const { return _workers->threadCount(); }
+
+    /**
+     * Use an existing pool of worker threads to update the objects
+     *
+     * Useful to share the pool of LogicService with the other systems, since
+     * they do not run at the same time.
+     */
+    void setWorkers(std::shared_ptr<WorkerPool> w) { _workers = std::move(w); }
+
     /**
      * Gets an object from its ID
      *
@@ -78,6 +153,33 @@ public:
      */
     std::optional<std::shared_ptr<GameObject>> get(object_id_t id) const;
 
+    /**
+     * Gets an object from its ID, without sharing its ownership
+     *
+     * Returns nullptr if not found. Use it in hot loops that only need the object
+     * for a moment; the pointer is valid while the object is in the manager.
+     */
+    GameObject* getPointer(object_id_t id) const;
+
+    /**
+     * Get the number of objects in the manager
+     */
+    size_t size() const { return _objects.size(); }
+
+    /**
+     * Get the packed state of the objects
+     *
+     * The indices are valid until the next object is added or removed
+     */
+    const ComponentRegistry& components() const { return _components; }
+    ComponentRegistry& components() { return _components; }
+
+    /**
+     * Get the index of an object in the packed state, or an empty optional if
+     * the ID is not from a live object
+     */
+    std::optional<size_t> indexOf(object_id_t id) const;
+
     ~ObjectManager();
 
 };
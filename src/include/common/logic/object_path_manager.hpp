@@ -7,13 +7,23 @@
 #pragma once
 
 #include <common/logic/game_event.hpp>
+#include <common/logic/flow_field.hpp>
 #include <common/logic/game_object.hpp>
+#include <common/logic/hierarchical_pathfinder.hpp>
+#include <common/logic/incremental_pathfinder.hpp>
+#include <common/logic/obstacle_grid.hpp>
+#include <common/logic/path_cache.hpp>
 #include <common/logic/pathfinder.hpp>
+#include <common/logic/spatial_index.hpp>
 #include <common/logic/terrain.hpp>
 #include <common/logic/types.hpp>
+#include <common/worker_pool.hpp>
 #include <deque>
 #include <glm/fwd.hpp>
+#include <memory>
 #include <optional>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "common/logic/object_manager.hpp"
@@ -65,6 +75,10 @@ public:
     struct PathRef {
         std::unique_ptr<Pathfinder> pathfinder;
 
+        /// The pathfinder that repairs the path when the other objects move. Created
+        /// the first time we need it
+        std::unique_ptr<IncrementalPathfinder> replanner;
+
         /// A pointer to a game object
         /// Apparently, we cannot use a reference here, because moving a reference deletes the move
         /// constructor
@@ -80,9 +94,34 @@ public:
         /// Current terrain ratio
         int ratio = 2;        
         
-        /// A path element deque (because pure queues does not allow copy to it)
-        /// The front element is always where the object is.
+        /// The waypoints of the path (a deque, because pure queues does not allow copy
+        /// to it). The object walks in a straight line to the front one, and the last
+        /// one is the end of the path, or of the segment.
         std::deque<glm::vec2> pathElements;
+
+        /// Waypoints found by the hierarchical pathfinder, for long paths.
+        /// The front element is the end of the segment we are walking now, the last
+        /// one is the end. Empty if the path is not split in segments.
+        std::deque<glm::vec2> waypoints;
+
+        /// This object was ordered to move together with others, to the same place, so it
+        /// will follow a flow field instead of running its own search
+        bool use_flow_field = false;
+
+        /// The flow field we are following, or nullptr if we are not following one
+        std::shared_ptr<FlowField> flow_field;
+
+        /// The terrain cells the flow field of the group needs to cover
+        ObstacleGrid::Region flow_bounds = {0, 0, 0, 0};
+
+        /// Number of objects that were ordered to move together with this one
+        int group_size = 1;
+
+        /// Number of ticks we could not move because our next position was blocked
+        int blocked_ticks = 0;
+
+        /// The destination was changed by the user, so we need to plan the path again
+        bool replan = false;
        
         /// The pathing calculation is completed. We now just follow the path
         bool calculationCompleted = false;
@@ -115,23 +154,26 @@ public:
         PathRef(PathRef&& other) = default;
         PathRef& operator=(PathRef&& other) = default;
 
-        std::optional<glm::vec2> position() const
+        /// Where the object is now
+        glm::vec2 position() const
         {
-            if (pathElements.empty()) return std::nullopt;
-
-            return std::make_optional<>(pathElements.front());
+            return glm::vec2(object->getPosition().x, object->getPosition().z);
         }
 
         PathHandle handleval() const { return (PathHandle)(oid * 2); }
+
+        /**
+         * Where the pathfinder needs to go now: the next waypoint, or the end, if
+         * we have no waypoints
+         */
+        glm::vec2 target() const { return waypoints.empty() ? end : waypoints.front(); }
     };
 
     /**
      * Update the pathing
      *
      * This means:
-     *  - moving the entity to the next position in the path (the granularity is low, so
-     *    do not worry).
-     *      - In the future we will take into account some things like entity speed, etc.
+     *  - moving the entity along its path, as far as its speed allows in a tick
      *  - removing paths that completed
      *  - detect if a path completed calculation in its timeslot. If it did not, we reschedule
      *    it to the next frame
@@ -150,6 +192,17 @@ public:
      */
     PathHandle startPathing(GameObject& o, glm::vec2 dest);
 
+    /**
+     * Start pathing a group of objects to the same destination
+     *
+     * If there is more than one object, they will share a flow field to the destination,
+     * instead of each one running its own path search.
+     *
+     * Returns a path handle for each object, in the same order
+     */
+    std::vector<PathHandle> startGroupPathing(
+        const std::vector<GameObject*>& objects, glm::vec2 dest);
+
     /**
      * Get the status of a pathing operation
      */
@@ -161,6 +214,11 @@ public:
      */
     PathStatus getPathStatus(const GameObject& o);
 
+    /**
+     * Check if an object is following a path, or waiting for one
+     */
+    bool isMoving(object_id_t id) const;
+
     /**
      * Remove the pathing operation
      *
@@ -171,34 +229,238 @@ public:
     void setItersPerFrame(int v) { max_iter_paths_per_frame_ = v; }
     int getItersPerFrame() const { return max_iter_paths_per_frame_; }
 
+    /**
+     * Set the minimum distance between the start and the end of a path for it to be
+     * planned by the hierarchical pathfinder, and split in segments
+     *
+     * Set it to 0 to disable the hierarchical pathfinder
+     */
+    void setHierarchicalDistance(double v) { hierarchical_min_distance_ = v; }
+    double getHierarchicalDistance() const { return hierarchical_min_distance_; }
+
+    /**
+     * Check if an object of a certain size can be placed in a certain position, without
+     * overlapping any other object or leaving the map
+     *
+     * Useful to know if we can build something somewhere
+     */
+    bool canPlace(glm::vec2 pos, glm::vec2 size);
+
+    /// Number of flow fields we have cached
+    size_t getFlowFieldCount() const { return flow_fields_.size(); }
+
+    /// Number of flow fields we calculated, since the path manager was created
+    size_t getFlowFieldBuildCount() const { return flow_field_builds_; }
+
+    /// Number of pathing operations in progress
+    size_t getPathCount() const { return operations_.size(); }
+
+    /// Statistics of the cache of hierarchical paths
+    PathCache::Stats getPathCacheStats() const { return path_cache_.stats(); }
+
+    /**
+     * Get the spatial index of the objects
+     *
+     * It is updated as the objects are created, move and die, like the obstacle grid
+     */
+    const SpatialIndex& getSpatialIndex() const { return spatial_index_; }
+
+    /**
+     * Set the number of worker threads used to calculate the paths
+     *
+     * Set it to 0 to calculate them all in the game thread. The result is the same
+     * regardless of the number of workers.
+     *
+     * By default, we use the worker pool of LogicService. Setting the count gives
+     * the path manager its own threads.
+     */
+    void setWorkerCount(unsigned v);
+    unsigned getWorkerCount() const { return workers_->threadCount(); }
+
+    /**
+     * Use an existing pool of worker threads to calculate the paths
+     */
+    void setWorkers(std::shared_ptr<WorkerPool> w) { workers_ = std::move(w); }
+
+    /**
+     * Set if the paths are repaired incrementally when other objects move, instead of
+     * being searched again from scratch
+     */
+    void setIncrementalRepath(bool v) { incremental_repath_ = v; }
+    bool getIncrementalRepath() const { return incremental_repath_; }
+
+    /**
+     * Set the duration of a tick, in milliseconds
+     *
+     * Objects with a movement component use it to know how much they walk in a tick
+     */
+    void setTickDuration(double v) { tick_duration_ = v; }
+    double getTickDuration() const { return tick_duration_; }
+
     ~ObjectPathManager();
     
 private:
     Terrain& t_;
     EventReceiver obj_events_;
-    std::queue<EntityEvent> events_;
+
+    /// The events received since the last update. We keep its memory between
+    /// updates, so receiving an event does not allocate
+    std::vector<EntityEvent> events_;
     
     void parseEntityEvent(const ObjectManager& om, const EntityEvent& e);
     
     int max_iter_paths_per_frame_ = 200;
 
+    /**
+     * The path calculations requested for a path reference in the current tick
+     *
+     * They are collected while we walk through the references, and run later, in
+     * parallel, after everything that changes the obstacle bitmap was done.
+     * The flags run in the order they are declared.
+     */
+    struct PathJob {
+        PathRef* ref;
+
+        /// Create the path (see createPath())
+        bool create = false;
+
+        /// Calculate the path of the next segment (see startNextSegment())
+        bool next_segment = false;
+
+        /// Update the pathfinder bitmap, then recalculate the path, even if it is short
+        /// (the Repathing status)
+        bool repath        = false;
+        bool repath_update = false;
+
+        /// Repair the path, because other objects are moving (see repairPath())
+        bool recalculate = false;
+    };
+
+    /**
+     * The workers that run the path jobs
+     *
+     * Each job only touches its own path reference, and only reads the obstacle bitmap,
+     * that does not change while they run. This way, the result does not depend on the
+     * order the jobs finish.
+     */
+    std::shared_ptr<WorkerPool> workers_;
+
+    /**
+     * Run the jobs, and wait for them to finish
+     */
+    void runPathJobs(std::vector<PathJob>& jobs);
+
+    /**
+     * Run the calculations requested by a single job
+     */
+    void runPathJob(PathJob& job) const;
+
+    /**
+     * The hierarchical pathfinder, shared by all paths.
+     *
+     * It only knows about the objects that are not moving, the ones that are moving are
+     * avoided by the pathfinder of each path.
+     */
+    HierarchicalPathfinder hierarchical_pf_;
+
+    /// Version of the static obstacle grid when we last updated the hierarchical
+    /// pathfinder
+    uint64_t hierarchical_grid_version_ = 0;
+
+    /// The waypoints the hierarchical pathfinder found recently. The regions are as big
+    /// as its clusters, with the default ratio
+    PathCache path_cache_{256, 32};
+
+    double hierarchical_min_distance_ = 64.0;
+
+    bool incremental_repath_ = true;
+
+    /// Number of ticks we wait before searching again with the normal pathfinder, when
+    /// the incremental one says there is no path
+    int unreachable_repath_ticks_ = 10;
+
+    /// The same as the logic tick of the game
+    double tick_duration_ = 16.0;
+
+    struct CachedFlowField {
+        std::shared_ptr<FlowField> field;
+
+        /// Version of the static obstacle grid when we last checked that the field
+        /// is still valid
+        uint64_t grid_version;
+    };
+
+    /**
+     * The flow fields being used by the objects moving in groups
+     *
+     * They are kept while someone uses them, and no static obstacle changes inside
+     * their bounds
+     */
+    std::vector<CachedFlowField> flow_fields_;
+
+    /// How far, in terrain cells, the flow field of a group goes beyond the group
+    /// and its destination, so it can walk around the obstacles between them
+    int flow_field_margin_ = 32;
+
+    size_t flow_field_builds_ = 0;
+
+    /// Number of ticks a moving object in a group waits for another one that is blocking
+    /// its way, until it goes through it.
+    int max_blocked_ticks_ = 20;
+
+    /**
+     * The obstacle bitmap with only the objects that are not moving, and its ratio
+     *
+     * It is updated at most once per tick, and only in the regions of the static obstacle
+     * grid that changed. Its version is incremented every time it changes
+     */
+    std::vector<bool> static_bitmap_;
+    int static_bitmap_ratio_        = 0;
+    bool static_bitmap_valid_       = false;
+    unsigned static_bitmap_version_ = 0;
+
+    /// Version of the static obstacle grid when we last updated the bitmap
+    uint64_t static_grid_version_ = 0;
+
     /**
      * A map of object IDs and their respective positions and sizes, to mask them into the
      * obstacle bitmap
      *
      * TODO: add an event to the action queue for position changed?
      */
-    std::unordered_map<object_id_t, std::tuple<glm::vec2 /* pos */, glm::vec2 /* size */>>
-        mapped_objects_;
+    using MappedObjectMap =
+        std::unordered_map<object_id_t, std::tuple<glm::vec2 /* pos */, glm::vec2 /* size */>>;
+    MappedObjectMap mapped_objects_;
+
+    /// Nodes of unmapped objects, reused for the next ones
+    std::vector<MappedObjectMap::node_type> free_mapped_objects_;
 
     /**
-     * Each element for this global obstacle 'bitmap' is a value telling how many entities
-     * would be there.
+     * The objects that were moving the last time we looked at the path references
+     *
+     * They are not in the static obstacle grid
+     */
+    std::unordered_set<object_id_t> moving_objects_;
+
+    /**
+     * The global obstacle grid. Each cell tells how many entities are there.
      *
      * Useful for correctly hiding the obstacle bitmap in certain situations where two meshes would
      * be over each other
+     *
+     * It is updated as the objects are created, move and die, never rebuilt.
+     */
+    ObstacleGrid obstacles_;
+
+    /**
+     * The obstacle grid with only the objects that are not moving
      */
-    std::vector<unsigned> obstacle_bitmap_;
+    ObstacleGrid static_obstacles_;
+
+    /**
+     * Index of the objects by their position, to find the ones near some place
+     */
+    SpatialIndex spatial_index_;
 
     /**
      * Find an existing path reference from an object
@@ -220,6 +482,19 @@ private:
 
     std::vector<ObjectPathManager::PathRef> operations_;
 
+    /**
+     * The position of the path reference of each object in `operations_`
+     *
+     * Lets us find the path of an object without scanning all of them; the
+     * target acquirer asks it for every unit it checks.
+     */
+    std::unordered_map<object_id_t, size_t> operation_index_;
+
+    /**
+     * Update the operation index after we removed path references
+     */
+    void reindexOperations();
+
     /**
      * Find the path reference from a handle
      *
@@ -231,12 +506,70 @@ private:
     /**
      * Create a path for an object whose path does not exist yet
      */
-    void createPath(PathRef& r);
+    void createPath(PathRef& r) const;
 
     /**
      * Create a path for an object whose path already exists, essentially redoing it
      */
-    void recalculatePath(PathRef& r, bool force = false);
+    void recalculatePath(PathRef& r, bool force = false) const;
+
+    /**
+     * Repair the path of an object, because the objects around it moved
+     *
+     * Uses the incremental pathfinder of the path, if enabled, so only the part of the
+     * search affected by what moved is calculated again.
+     */
+    void repairPath(PathRef& r) const;
+
+    /**
+     * Smooth a path found by a pathfinder, and make it the path of the object
+     */
+    void setPath(PathRef& r, const std::vector<glm::vec2>& elements) const;
+
+    /**
+     * Check if the object is at most one step from where it needs to go now
+     */
+    bool isNearTarget(const PathRef& r) const;
+
+    /**
+     * Find the waypoints of a path, if the path is long enough to use the hierarchical
+     * pathfinder
+     */
+    void planWaypoints(PathRef& r);
+
+    /**
+     * Start walking the next segment of a path split by the hierarchical pathfinder
+     *
+     * The waypoint of the segment we finished must have been removed already
+     */
+    void startNextSegment(PathRef& r) const;
+
+    /**
+     * Get a flow field to some destination, for objects of some size, that covers
+     * at least the terrain cells in `bounds`
+     *
+     * If we do not have one, or the one we have is outdated, calculate it
+     */
+    std::shared_ptr<FlowField> getFlowField(
+        glm::vec2 dest, glm::vec2 size, int ratio, ObstacleGrid::Region bounds);
+
+    /**
+     * Start following a flow field to the destination of the path
+     *
+     * Returns false if the destination cannot be reached with it, and so we
+     * need to use the pathfinder
+     */
+    bool startFlowFieldPath(PathRef& r);
+
+    /**
+     * Move the object to the next position of the flow field it is following
+     */
+    void updateFlowFieldPath(PathRef& r);
+
+    /**
+     * Check if an object would collide with another one if it goes to a certain position
+     */
+    bool isOccupiedByOthers(const GameObject& o, glm::vec2 pos) const;
 
     /**
      * Update the position of an object
@@ -258,33 +591,35 @@ private:
     void updateObstacleBitmap(const ObjectManager& om);
 
     /**
-     * Creates an obstacle bitmap for the current game object
-     *
-     * Currently, it only removes the actual object from the bitmap, but, in the future,
-     * it will also consider the terrain type (e.g, insert water for units that only walk
-     * on land)
+     * Add an object to the obstacle grids and the spatial index, or update it if it
+     * is already there
      */
-    std::vector<bool> createBitmapForObject(const GameObject& o, int ratio=1);
+    void mapObject(object_id_t id, glm::vec2 pos, glm::vec2 size);
 
     /**
-     * Set the object data in the obstacle bitmap to a certain state
+     * Remove an object from the obstacle grids and the spatial index
      */
-    void setObjectOnBitmap(std::vector<bool>& bitmap, const GameObject& o, bool value, float ratio=1.0);
+    void unmapObject(object_id_t id);
 
     /**
-     * Set the object data in the obstacle bitmap to a certain state
+     * Move the objects that started or stopped moving out of, or into, the static
+     * obstacle grid
      */
-    void setObjectOnBitmap(std::vector<bool>& bitmap, glm::vec2 pos, glm::vec2 size, bool value, float ratio=1.0);
-    
+    void updateMovingObjects();
+
     /**
-     * Set the object data in the global obstacle bitmap to a certain state
+     * Creates an obstacle bitmap view for the current game object
+     *
+     * Currently, it only removes the actual object from the bitmap, but, in the future,
+     * it will also consider the terrain type (e.g, insert water for units that only walk
+     * on land)
      */
-    void setObjectOnBitmap(std::vector<unsigned>& bitmap, const GameObject& o, bool value, float ratio=1.0);
+    ObstacleView viewForObject(const GameObject& o, int ratio = 1) const;
 
     /**
-     * Set the object data in the global obstacle bitmap to a certain state
+     * Get the obstacle bitmap with only the objects that are not moving
      */
-    void setObjectOnBitmap(std::vector<unsigned>& bitmap, glm::vec2 pos, glm::vec2 size, bool value, float ratio=1.0);
+    const std::vector<bool>& getStaticBitmap(int ratio = 1);
 };
 
 }  // namespace familyline::logic
@@ -0,0 +1,86 @@
+/**
+ * Pool of reusable game objects
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <common/logic/game_object.hpp>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace familyline::logic
+{
+/**
+ * Keeps the objects that died, so new objects of the same type can reuse them
+ *
+ * In a long game, units are created and killed all the time. Each new object would
+ * allocate the object itself, its components and the control block of its
+ * shared_ptr, and each death would free all of them.
+ *
+ * Here, an object is returned to the pool when nobody holds a shared_ptr to it
+ * anymore (that is, after it is removed from the object manager and from everything
+ * else). The next object of the same type reuses it, after resetting it to the
+ * state of the prototype. The control blocks of the shared_ptrs come from a free
+ * list too, so, once the pool has enough objects, creating one does not touch the
+ * heap.
+ *
+ * The weak_ptrs to an object still expire when it goes back to the pool, and the
+ * object gets a new ID when it is added to the object manager again, so nobody can
+ * tell it is not a new object.
+ */
+class ObjectPool : public std::enable_shared_from_this<ObjectPool>
+{
+public:
+    struct Stats {
+        /// Objects created from the prototype, and objects reused from the pool
+        size_t objects_created;
+        size_t objects_reused;
+
+        /// Control blocks allocated from the heap, and reused from the free list
+        size_t blocks_allocated;
+        size_t blocks_reused;
+
+        /// Objects waiting to be reused
+        size_t free_objects;
+    };
+
+    ObjectPool();
+    ObjectPool(const ObjectPool&)            = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    /**
+     * Get an object of the same type of `prototype`, reusing one if we can
+     *
+     * The pool needs to be owned by a shared_ptr.
+     */
+    std::shared_ptr<GameObject> acquire(GameObject& prototype);
+
+    /**
+     * Destroy the objects that are waiting to be reused
+     */
+    void clear();
+
+    Stats stats() const;
+
+private:
+    struct BlockPool;
+    struct Release;
+
+    template <typename T>
+    struct BlockAllocator;
+
+    /// The free objects, by type
+    std::unordered_map<std::string, std::vector<std::shared_ptr<GameObject>>> free_objects_;
+
+    std::shared_ptr<BlockPool> blocks_;
+
+    size_t objects_created_ = 0;
+    size_t objects_reused_  = 0;
+
+    void release(std::shared_ptr<GameObject> o);
+};
+
+}  // namespace familyline::logic
@@ -0,0 +1,245 @@
+/**
+ * Incremental obstacle occupancy grid
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <optional>
+#include <vector>
+
+namespace familyline::logic
+{
+class GameObject;
+
+/**
+ * The occupancy grid of the obstacles of a map
+ *
+ * Each cell has the number of objects over it. The grid is not rebuilt every tick:
+ * adding, removing or moving an object only touches the cells of its footprint, so the
+ * cost of keeping it updated depends on how much moved, not on the size of the map.
+ *
+ * The grid also keeps some downsampled levels (one for each ratio the pathfinders use)
+ * up to date. A cell of a level is an obstacle if any of the cells it covers is.
+ *
+ * It also keeps a log of the regions that changed, numbered by a version that grows on
+ * each change, so whoever derives data from the grid can remember the version it saw
+ * and update only what changed after it.
+ *
+ * A level can also have a clearance map: for each cell, the side of the largest free
+ * square that starts on it (the cell is its top left corner). With it, checking if an
+ * object fits somewhere is one lookup, instead of one for each cell under it.
+ */
+class ObstacleGrid
+{
+public:
+    /**
+     * A rectangle of cells, in the full resolution grid.
+     * The minimum coordinates are inclusive, the maximum ones are exclusive
+     */
+    struct Region {
+        int x0, y0, x1, y1;
+
+        bool empty() const { return x0 >= x1 || y0 >= y1; }
+    };
+
+    ObstacleGrid(int width, int height);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    /**
+     * Get the cells covered by an object in a certain position, with a certain size
+     *
+     * The object position is in its center. The region is clipped to the grid
+     */
+    Region footprint(glm::vec2 pos, glm::vec2 size) const;
+
+    /**
+     * Add an object to the grid
+     */
+    void add(glm::vec2 pos, glm::vec2 size);
+
+    /**
+     * Remove an object from the grid
+     */
+    void remove(glm::vec2 pos, glm::vec2 size);
+
+    /**
+     * Move an object from a position to another
+     */
+    void move(glm::vec2 from, glm::vec2 to, glm::vec2 size);
+
+    /**
+     * Remove every object
+     */
+    void clear();
+
+    /**
+     * Number of objects over a cell of the full resolution grid
+     */
+    unsigned countAt(int x, int y) const { return counts_[y * width_ + x]; }
+
+    /**
+     * Start maintaining a downsampled level with a certain ratio
+     *
+     * Do nothing if we already have it
+     */
+    void addLevel(int ratio);
+
+    bool hasLevel(int ratio) const { return this->findLevel(ratio) != nullptr; }
+
+    /**
+     * Maintain a clearance map for a level, so we can check objects of up to `size` cells
+     * with a single lookup
+     *
+     * Each call adds a size class. The clearance is maintained up to the largest one, so
+     * the cost of updating it grows with it. Bigger objects still work, but need more
+     * than one lookup.
+     */
+    void addClearance(int ratio, int size);
+
+    /**
+     * Check if all the cells of a region of a downsampled level are free
+     *
+     * The minimum and maximum coordinates are both inclusive, in cells of the level.
+     * The cells covered by `exclude` (in the full resolution grid) have one object less.
+     */
+    bool isFree(
+        int ratio, int cx0, int cy0, int cx1, int cy1, Region exclude = Region{0, 0, 0, 0}) const;
+
+    /**
+     * Check if a cell of a downsampled level is an obstacle
+     *
+     * The cells covered by `exclude` have one object less. This is how an object does not
+     * see itself as an obstacle.
+     */
+    bool isBlocked(int cx, int cy, int ratio, Region exclude = Region{0, 0, 0, 0}) const;
+
+    /**
+     * Create a bitmap of a downsampled level, one element per cell
+     */
+    std::vector<bool> toBitmap(int ratio) const;
+
+    /**
+     * The current version of the grid. It increases each time a region changes
+     */
+    uint64_t version() const { return version_; }
+
+    /**
+     * The regions that changed after a certain version, oldest first
+     *
+     * They might overlap. We only keep the most recent changes, so, if the version is
+     * too old, return an empty optional: the caller needs to read everything again.
+     */
+    std::optional<std::vector<Region>> changesSince(uint64_t version) const;
+
+private:
+    int width_;
+    int height_;
+
+    /// Number of objects over each cell
+    std::vector<unsigned> counts_;
+
+    struct Level {
+        int ratio;
+        int width;
+        int height;
+
+        /// Number of cells with at least one object, for each cell of the level
+        std::vector<unsigned> occupied;
+
+        /// The clearance map, and the maximum value it stores. Empty if the level does
+        /// not have one
+        std::vector<uint8_t> clearance;
+        int max_clearance = 0;
+    };
+
+    std::vector<Level> levels_;
+
+    /// The change log, in a ring buffer that is allocated once. The element at
+    /// `changes_head_` is the change that made the grid reach the version
+    /// `first_change_`
+    std::vector<Region> changes_;
+    size_t changes_head_   = 0;
+    uint64_t first_change_ = 1;
+    uint64_t version_      = 0;
+
+    const Level* findLevel(int ratio) const;
+    Level* findLevel(int ratio);
+
+    /**
+     * Recalculate the clearance of the cells whose square might reach a region of
+     * the full resolution grid
+     */
+    void updateClearance(Level& l, Region r);
+
+    void logChange(Region r);
+
+    /**
+     * Add (delta = 1) or remove (delta = -1) an object from all cells of a region
+     */
+    void stamp(Region r, int delta);
+
+    /**
+     * Update everything that depends on the cells of a region, after they changed
+     */
+    void regionChanged(Region r);
+
+    /**
+     * A cell of the full resolution grid became free (delta = -1) or occupied (delta = 1)
+     */
+    void updateLevels(int x, int y, int delta);
+};
+
+/**
+ * A view of a downsampled level of the obstacle grid, as seen by a certain object
+ *
+ * It does not copy the grid, so it must not outlive it. The object does not see itself
+ * as an obstacle.
+ */
+class ObstacleView
+{
+public:
+    ObstacleView(const ObstacleGrid& grid, int ratio, const GameObject* self = nullptr);
+
+    int ratio() const { return ratio_; }
+    int width() const { return grid_->width() / ratio_; }
+    int height() const { return grid_->height() / ratio_; }
+
+    /**
+     * Read the position of the object again
+     *
+     * The view might be kept while the object moves, so call this before using it
+     */
+    void refresh();
+
+    const ObstacleGrid& grid() const { return *grid_; }
+
+    /**
+     * The footprint of the object, in cells of the full resolution grid
+     */
+    ObstacleGrid::Region excluded() const { return exclude_; }
+
+    bool isBlocked(int cx, int cy) const { return grid_->isBlocked(cx, cy, ratio_, exclude_); }
+
+    /**
+     * Check if all cells between (cx0, cy0) and (cx1, cy1), inclusive, are free
+     */
+    bool isFree(int cx0, int cy0, int cx1, int cy1) const
+    {
+        return grid_->isFree(ratio_, cx0, cy0, cx1, cy1, exclude_);
+    }
+
+private:
+    const ObstacleGrid* grid_;
+    int ratio_;
+    const GameObject* self_;
+
+    /// The footprint of the object, as we read it in the last refresh
+    ObstacleGrid::Region exclude_ = {0, 0, 0, 0};
+};
+
+}  // namespace familyline::logic
@@ -0,0 +1,136 @@
+/**
+ * A cache of the paths between two regions of the map
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace familyline::logic
+{
+/**
+ * A least recently used cache of paths, keyed by the regions of their start and end
+ *
+ * Objects of the same player usually walk between the same few places, like from the
+ * town centre to a resource site. Each one of them would search the same path again.
+ *
+ * The map is divided in square regions. Paths that start in the same region and end in
+ * the same region, for objects of the same size class, share an entry. What we store is
+ * a corridor: a list of waypoints, coarse enough to be valid from anywhere in the start
+ * region. Whoever uses it refines each segment with a normal, local search.
+ *
+ * The corridors are only valid for the obstacles they were searched with, so each
+ * entry has the version of the obstacle bitmap it used. When the version changes, all
+ * entries are discarded.
+ */
+class PathCache
+{
+public:
+    struct Stats {
+        size_t hits;
+        size_t misses;
+
+        /// Number of paths stored
+        size_t entries;
+
+        /// An estimate of the memory used by the entries, in bytes
+        size_t memory;
+
+        double hitRate() const { return hits + misses == 0 ? 0 : double(hits) / (hits + misses); }
+    };
+
+    /**
+     * Create a cache that stores at most `capacity` paths, with regions of
+     * `region_size` units
+     */
+    PathCache(size_t capacity = 256, int region_size = 32)
+        : capacity_(capacity), region_size_(region_size)
+    {
+    }
+
+    /**
+     * Find a path from `start` to `end`, for an object of size `size`, searched with
+     * version `version` of the obstacle bitmap
+     */
+    std::optional<std::vector<glm::vec2>> find(
+        glm::vec2 start, glm::vec2 end, glm::vec2 size, unsigned version);
+
+    /**
+     * Add a path, replacing the one we had for the same regions, if any
+     *
+     * If the cache is full, the least recently used path is removed.
+     */
+    void add(
+        glm::vec2 start, glm::vec2 end, glm::vec2 size, unsigned version,
+        std::vector<glm::vec2> corridor);
+
+    /**
+     * Remove all paths
+     */
+    void clear();
+
+    void setRegionSize(int v);
+    int getRegionSize() const { return region_size_; }
+
+    Stats stats() const;
+
+private:
+    struct Key {
+        int start_x, start_y;
+        int end_x, end_y;
+        int size_class;
+
+        bool operator==(const Key& o) const
+        {
+            return start_x == o.start_x && start_y == o.start_y && end_x == o.end_x &&
+                   end_y == o.end_y && size_class == o.size_class;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& k) const
+        {
+            uint64_t h = 14695981039346656037ull;
+            for (auto v : {k.start_x, k.start_y, k.end_x, k.end_y, k.size_class}) {
+                h ^= uint64_t(uint32_t(v));
+                h *= 1099511628211ull;
+            }
+
+            return size_t(h);
+        }
+    };
+
+    struct Entry {
+        Key key;
+        std::vector<glm::vec2> corridor;
+    };
+
+    size_t capacity_;
+    int region_size_;
+
+    /// The version of the obstacle bitmap of all entries
+    unsigned version_ = 0;
+
+    /// The entries, the most recently used first
+    std::list<Entry> entries_;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+
+    size_t hits_   = 0;
+    size_t misses_ = 0;
+
+    Key makeKey(glm::vec2 start, glm::vec2 end, glm::vec2 size) const;
+
+    /**
+     * Discard everything if the version of the obstacle bitmap changed
+     */
+    void checkVersion(unsigned version);
+};
+
+}  // namespace familyline::logic
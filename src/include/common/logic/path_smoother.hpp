@@ -0,0 +1,58 @@
+/**
+ * Path post-processing, to turn paths into a few waypoints
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <common/logic/obstacle_grid.hpp>
+#include <common/logic/terrain.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace familyline::logic
+{
+/**
+ * Smooths the paths the pathfinders create
+ *
+ * The pathfinders return one point for each step of the path, and they can only walk
+ * in eight directions. This turns them into a few waypoints, in two passes:
+ *
+ *  - compression: the points in the middle of a straight line are removed, because
+ *    the line alone says the same thing.
+ *  - string pulling: from each waypoint, we skip all the following ones we can reach
+ *    by walking in a straight line, like pulling a string tied to the start and the
+ *    end of the path. The path gets shorter and stops zig-zagging.
+ *
+ * A straight line is only used if all cells the object would cover while walking on it
+ * are free, in the same obstacle view the pathfinder used, so the smoothed path is as
+ * safe as the original one.
+ */
+class PathSmoother
+{
+public:
+    PathSmoother(const Terrain& t, ObstacleView view) : t_(t), view_(view) {}
+
+    /**
+     * Check if an object of size `size` can walk in a straight line from `from` to `to`
+     */
+    bool canWalkStraight(glm::vec2 from, glm::vec2 to, glm::vec2 size) const;
+
+    /**
+     * Smooth a path of an object of size `size`
+     *
+     * The first and the last points are always kept.
+     */
+    std::vector<glm::vec2> smooth(const std::vector<glm::vec2>& path, glm::vec2 size) const;
+
+private:
+    const Terrain& t_;
+    ObstacleView view_;
+
+    /**
+     * Remove the points that are in the middle of a straight line
+     */
+    std::vector<glm::vec2> compress(const std::vector<glm::vec2>& path) const;
+};
+
+}  // namespace familyline::logic
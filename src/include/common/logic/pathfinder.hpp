@@ -5,10 +5,12 @@
  */
 #pragma once
 
+#include <common/logic/obstacle_grid.hpp>
 #include <common/logic/terrain.hpp>
 #include <glm/glm.hpp>
-#include <list>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <vector>
 
 namespace familyline::logic
@@ -42,6 +44,11 @@ namespace familyline::logic
  *    (Check https://medium.com/@nicholas.w.swift/easy-a-star-pathfinding-7e6689c7f7b2 if my
  *     explanation is too hard)
  *
+ *   The open list is a binary heap, indexed by the node, so we can find the best node and
+ * update an existing one without searching the whole list. The nodes themselves live in a flat
+ * array with one node per cell of the obstacle bitmap, so checking if a node is open or closed
+ * is a simple lookup. This array is reused between searches.
+ *
  *
  *   Here, we also limit the number of iterations for each pathing operation, to not calculate a
  * huge path once per frame. Do not worry, if you do not reach the destination, the point will
@@ -58,27 +65,19 @@ public:
      */
     void update(std::vector<bool>, int ratio = 1);
 
+    /**
+     * Update the obstacle bitmap to a view of an obstacle grid
+     *
+     * We do not copy the grid, we read it directly. This means the grid cannot change
+     * while we search.
+     */
+    void update(ObstacleView view);
+
     struct TerrainTile {
         unsigned int height;
         TerrainType& type;
     };
 
-    struct PathNode {
-        glm::vec2 position;
-        double height;
-
-        double g;
-        double h;
-        PathNode* parent = nullptr;
-
-        double f() const { return g + h; }
-
-        void calculateG(glm::vec2 start, glm::vec2 end, const TerrainTile& current);
-        void calculateValues(glm::vec2 start, glm::vec2 end, const TerrainTile& current);
-
-        PathNode(glm::vec2 pos) : position(pos), height(0.0), g(0.0), h(0.0) {}
-    };
-
     /**
      * Find a path through the terrain
      *
@@ -90,18 +89,90 @@ public:
     bool maxIterReached() const { return has_max_iter_reached_; }
 
     bool hasPossiblePath() const {
-        if (open_list_.size() == 0)
-            return closed_list_.size() == 0;
+        if (open_heap_.size() == 0)
+            return closed_count_ == 0;
 
         return true;
     }
 
+    /**
+     * Number of nodes we moved to the closed list in the last call to findPath()
+     *
+     * Useful for benchmarking
+     */
+    size_t expandedNodes() const { return expanded_nodes_; }
+
 private:
+    using node_index_t = uint32_t;
+    static constexpr node_index_t InvalidNode = node_index_t(-1);
+
+    enum class NodeState : uint8_t { Unvisited, Open, Closed };
+
+    /**
+     * A node of the search
+     *
+     * We have one node for each cell of the obstacle bitmap, plus two extra ones, for the
+     * start (if it is not aligned to the bitmap grid) and the end (because the end might
+     * also not be aligned).
+     *
+     * The nodes are reused between searches: instead of cleaning all of them, we bump
+     * `search_gen_`, and every node whose `gen` is different from it is considered
+     * unvisited.
+     */
+    struct PathNode {
+        glm::vec2 position;
+        double height = 0.0;
+
+        double g = 0.0;
+        double h = 0.0;
+
+        node_index_t parent = InvalidNode;
+
+        /// Position of this node inside the open heap, if it is open
+        uint32_t heap_index = 0;
+
+        /// Insertion order in the open list. Used to break ties between nodes with
+        /// the same f(), so that the older one wins, like the old list-based
+        /// implementation
+        uint32_t order = 0;
+
+        uint32_t gen = 0;
+        NodeState state = NodeState::Unvisited;
+
+        double f() const { return g + h; }
+    };
+
     const Terrain& t_;
     std::vector<bool> obstacle_bitmap_;
 
-    std::list<std::unique_ptr<PathNode>> open_list_;
-    std::list<std::unique_ptr<PathNode>> closed_list_;
+    /// The obstacle grid view, if we use one instead of our own bitmap
+    std::optional<ObstacleView> view_;
+
+    /**
+     * Check if a cell of our own obstacle bitmap is blocked
+     */
+    bool isCellBlocked(int x, int y) const;
+
+    /**
+     * The node storage
+     *
+     * Its size is the size of the obstacle bitmap plus the two extra nodes
+     */
+    std::vector<PathNode> nodes_;
+
+    /**
+     * The open list, as a binary min-heap of node indices, ordered by f() and
+     * insertion order
+     */
+    std::vector<node_index_t> open_heap_;
+    size_t closed_count_ = 0;
+
+    /// The last node we moved to the closed state
+    node_index_t last_closed_ = InvalidNode;
+
+    uint32_t search_gen_ = 1;
+    uint32_t next_order_ = 0;
+    size_t expanded_nodes_ = 0;
 
     /**
      * Ratio of the obstacle bitmap
@@ -111,20 +182,40 @@ private:
      * height
      */
     int ratio_ = 1;
-    
+
+    /// Width and height of the obstacle bitmap
+    int grid_width_ = 1;
+    int grid_height_ = 1;
+
     bool has_max_iter_reached_ = false;
 
+    node_index_t startNode() const { return node_index_t(grid_width_ * grid_height_); }
+    node_index_t endNode() const { return startNode() + 1; }
+
     /**
-     * Traverse the path, from begin to end, putting the possible nodes in the open_list and the
-     * closed nodes in the closed list
-     *
-     * Returns the node of the end path, or nullptr if no path is possible
-     * (TODO: fix that, make it always return a path!)
+     * Get the node index of a certain position in the grid, or InvalidNode if the
+     * position is out of the grid
+     */
+    node_index_t nodeIndex(glm::vec2 pos) const;
+
+    /**
+     * Get the node at a certain index, resetting it if it belongs to an older search
+     */
+    PathNode& getNode(node_index_t idx, glm::vec2 pos);
+
+    /**
+     * Invalidate the current search, so the next one starts from scratch
+     */
+    void resetSearch();
+
+    /**
+     * Traverse the path, from begin to end, putting the possible nodes in the open heap and the
+     * closed nodes in the closed state
      *
-     * Please do not clean the closed_list_ before using the PathNode* we return, or you will
-     * crash the program.
+     * Returns the index of the end node. If no path is possible, returns the closest node we
+     * could find.
      */
-    PathNode* traversePath(glm::vec2 start, glm::vec2 end, glm::vec2 size, int maxiters);
+    node_index_t traversePath(glm::vec2 start, glm::vec2 end, glm::vec2 size, int maxiters);
 
     /**
      * Calculate the path positions
@@ -140,46 +231,31 @@ private:
     const TerrainTile getTileAtPosition(glm::vec2);
 
     /**
-     * Move a node from the open to the closed list
-     *
-     * Obviously we remove it from the open list
+     * Calculate the g, h and height values of a node, considering the parent it has
      */
-    void moveToClosedList(PathNode* n);
+    void calculateValues(PathNode& n, glm::vec2 end);
 
     /**
-     * Check if node is not in an obstacle
+     * Calculate the g value of a node, considering the parent it has
      */
-    bool isWalkable(const PathNode& n, glm::vec2 size) const;
+    double calculateG(const PathNode& n, node_index_t parent, double height) const;
 
-    /**
-     * Check if node is in the closed list
-     */
-    bool isInClosedList(const PathNode& n) const;
+    /// Open heap operations
+    bool heapLess(node_index_t a, node_index_t b) const;
+    void heapSiftUp(uint32_t pos);
+    void heapSiftDown(uint32_t pos);
+    void pushOpen(node_index_t idx);
+    node_index_t popOpen();
 
     /**
-     * Check if the node is in the open list
-     *
-     * If yes, return a pointer to it
-     * If not, return nullptr
+     * Move a node to the closed state
      */
-    PathNode* findInOpenList(const PathNode& n);
+    void closeNode(node_index_t idx);
 
     /**
-     * Generate a list of neighbors for a given node
-     *
-     * We generate exactly 8 neigbors, in all directions, like this:
-     *
-     *   N | N | N     (X is the given node, all others are the neighbors)
-     *  ---+---+---
-     *   N | X | N
-     *  ---+---+---
-     *   N | N | N
-     *
-     *  We might generate less neighbors if, for example, you are in the border of
-     *  the map.
-     *
+     * Check if node is not in an obstacle
      */
-    std::vector<std::unique_ptr<Pathfinder::PathNode>> generateNeighbors(const PathNode& n);
+    bool isWalkable(glm::vec2 pos, glm::vec2 size) const;
 
     std::vector<glm::vec2> getCoordsInsideObject(glm::vec2 pos, glm::vec2 size) const;
 };
@@ -0,0 +1,101 @@
+/**
+ * Simulation of the projectiles in flight
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <common/logic/game_event.hpp>
+#include <common/logic/object_components.hpp>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace familyline::logic
+{
+/**
+ * Stores and moves the projectiles that were shot, and tells when each one
+ * arrives at its destination
+ *
+ * The projectiles are stored as a structure of arrays: the data we use every tick
+ * (the position, velocity and remaining flight time) are in their own arrays, so
+ * moving all of them is a simple loop the compiler can vectorize. The data we only
+ * need at the impact is in another array.
+ *
+ * A projectile flies in a straight line to the point where the defender was when
+ * it was shot, and arrives there after a whole number of ticks, so the impact
+ * happens in the same tick on every client. The arrays keep their memory when
+ * projectiles are removed, so, after the first volleys, shooting does not
+ * allocate anything.
+ */
+class ProjectileManager
+{
+public:
+    /**
+     * Information about a shot, that we need when it hits (or misses)
+     */
+    struct Shot {
+        entity_id_t attackerID;
+        entity_id_t defenderID;
+        uint64_t attackID;
+
+        AttackAttributes atkAttributes;
+        double damage;
+
+        /// Where the attacker was when it shot
+        glm::vec2 origin;
+
+        /// If false, the projectile will miss, wherever the defender is
+        bool precise;
+    };
+
+    /**
+     * A projectile that arrived at its destination
+     */
+    struct Impact {
+        Shot shot;
+        glm::vec2 position;
+    };
+
+    /// Radius of a projectile, used to check if it hit something
+    static constexpr double radius = 0.5;
+
+    /**
+     * Shoot a projectile from `from` to `to`, with a speed of `speed` units per tick
+     */
+    void launch(const Shot& shot, glm::vec2 from, glm::vec2 to, double speed);
+
+    /**
+     * Move every projectile by one tick
+     *
+     * Returns the projectiles that arrived in this tick, in the order they were
+     * shot. The list is valid until the next call.
+     */
+    const std::vector<Impact>& update();
+
+    /**
+     * Reserve space for `count` projectiles, so that shooting them does not
+     * allocate anything
+     */
+    void reserve(size_t count);
+
+    void clear();
+
+    size_t size() const { return shots_.size(); }
+    size_t capacity() const { return shots_.capacity(); }
+
+    glm::vec2 getPosition(size_t i) const { return glm::vec2(xs_[i], ys_[i]); }
+    const Shot& getShot(size_t i) const { return shots_[i]; }
+
+private:
+    /// Positions, velocities and remaining flight ticks
+    std::vector<float> xs_, ys_;
+    std::vector<float> vxs_, vys_;
+    std::vector<int> ticks_left_;
+
+    std::vector<Shot> shots_;
+
+    std::vector<Impact> impacts_;
+};
+
+}  // namespace familyline::logic
@@ -0,0 +1,123 @@
+/**
+ * Uniform grid index of the objects of a map
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <common/logic/types.hpp>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace familyline::logic
+{
+/**
+ * A spatial index of the objects, so we can find the ones near some place without
+ * checking all of them
+ *
+ * The map is divided in square cells. Each object is stored in the cell of its center.
+ * A query only looks at the cells that might have an object that matches it, so its
+ * cost depends on how many objects are near the queried place, not on how many
+ * objects exist.
+ *
+ * Objects can be bigger than a cell, so the queries are expanded by half of the
+ * size of the biggest object we ever had.
+ *
+ * The results of every query are sorted by object ID, or by distance and then by
+ * ID, so they are the same on every client.
+ */
+class SpatialIndex
+{
+public:
+    /**
+     * Create an index for a map with `width` and `height` units, with cells of
+     * `cell_size` units
+     */
+    SpatialIndex(int width, int height, int cell_size = 16);
+
+    /**
+     * Add an object, or update it if it is already there
+     *
+     * The position is the center of the object
+     */
+    void update(object_id_t id, glm::vec2 pos, glm::vec2 size);
+
+    void remove(object_id_t id);
+
+    bool contains(object_id_t id) const { return locations_.find(id) != locations_.end(); }
+    size_t size() const { return locations_.size(); }
+
+    /**
+     * Get the objects whose hitbox touches the circle with center `center` and
+     * radius `radius`
+     */
+    std::vector<object_id_t> queryRadius(glm::vec2 center, double radius) const;
+
+    /**
+     * Get the objects whose hitbox touches the rectangle between `min` and `max`
+     */
+    std::vector<object_id_t> queryRect(glm::vec2 min, glm::vec2 max) const;
+
+    /**
+     * Get the `k` objects nearest to `center`, the nearest first
+     *
+     * The distance is measured up to the hitbox of the object. Objects farther than
+     * `max_radius` are not considered.
+     */
+    std::vector<object_id_t> queryNearest(glm::vec2 center, size_t k, double max_radius) const;
+
+    /**
+     * Check if the hitbox of the object `id` touches the circle with center
+     * `center` and radius `radius`
+     *
+     * It only looks at that object, so it does not allocate anything. Returns
+     * false if the object is not in the index.
+     */
+    bool touches(object_id_t id, glm::vec2 center, double radius) const;
+
+    int cellSize() const { return cell_size_; }
+
+private:
+    struct Item {
+        object_id_t id;
+        glm::vec2 pos;
+        glm::vec2 half_size;
+    };
+
+    int cell_size_;
+
+    /// Number of cells in each axis
+    int cols_, rows_;
+
+    std::vector<std::vector<Item>> cells_;
+
+    using LocationMap = std::unordered_map<object_id_t, int>;
+
+    /// The cell of each object
+    LocationMap locations_;
+
+    /// Nodes of removed objects, reused for the next ones, so adding an object
+    /// does not allocate
+    std::vector<LocationMap::node_type> free_locations_;
+
+    /// The biggest half size we ever had. We never shrink it.
+    glm::vec2 max_half_size_ = glm::vec2(0, 0);
+
+    int cellOf(glm::vec2 pos) const;
+
+    /**
+     * Call `fn` for each object in the cells that might touch the rectangle
+     * between `min` and `max`
+     */
+    template <typename F>
+    void forEachCandidate(glm::vec2 min, glm::vec2 max, F&& fn) const;
+
+    /**
+     * Squared distance between a point and the hitbox of an object
+     */
+    static double distanceSquared(const Item& item, glm::vec2 p);
+};
+
+}  // namespace familyline::logic
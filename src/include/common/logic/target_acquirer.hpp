@@ -0,0 +1,87 @@
+/**
+ * Automatic target acquisition for idle units
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <common/logic/attack_manager.hpp>
+#include <common/logic/colony_manager.hpp>
+#include <common/logic/object_manager.hpp>
+#include <common/logic/object_path_manager.hpp>
+#include <common/logic/spatial_index.hpp>
+#include <cstddef>
+
+namespace familyline::logic
+{
+/**
+ * Makes idle units that can attack start attacking the enemies that come
+ * into their range
+ *
+ * Checking every unit against every other one, every tick, would be too slow
+ * for big armies, so, on each tick, we only check a fixed number of units,
+ * continuing from where we stopped in the last tick. Each check is a query to
+ * the spatial index for the nearest objects in the range of the unit, so the
+ * cost of a tick does not depend on the size of the armies, only on how many
+ * units we check.
+ *
+ * The units are checked in the order of the packed state of the object manager,
+ * and the ones that cannot attack, or are dead, are skipped by their packed
+ * attack range and health, without touching the object.
+ *
+ * A unit is idle if it is alive, it is not attacking anything, and it is not
+ * moving, so units walking under a move order are not pulled off their path.
+ * The attacks are started the same way the attack command starts them, by
+ * sending an attack event to the attack manager.
+ */
+class TargetAcquirer
+{
+public:
+    /**
+     * Create a target acquirer that checks `units_per_tick` units per tick
+     */
+    TargetAcquirer(const ColonyManager& cm, size_t units_per_tick = 32);
+
+    /**
+     * Check the next units, and make the idle ones attack the nearest enemy in
+     * their range
+     *
+     * Runs once per tick
+     */
+    void update(
+        ObjectManager& om, const SpatialIndex& index, const ObjectPathManager& pm,
+        const AttackManager& am);
+
+    void setUnitsPerTick(size_t v) { units_per_tick_ = v; }
+    size_t getUnitsPerTick() const { return units_per_tick_; }
+
+    /**
+     * Number of objects we look at, for each unit, before giving up
+     *
+     * The nearest ones might be allies, so we look at more than one.
+     */
+    void setCandidateCount(size_t v) { candidate_count_ = v; }
+
+private:
+    const ColonyManager& cm_;
+
+    size_t units_per_tick_;
+    size_t candidate_count_ = 8;
+
+    /// The index, in the component registry of the object manager, of the
+    /// next unit we will check
+    size_t next_ = 0;
+
+    /**
+     * Make the unit attack the nearest enemy in its range, if there is one
+     *
+     * Return true if it started an attack
+     */
+    bool acquire(
+        ObjectManager& om, const SpatialIndex& index, GameObject& unit, glm::vec3 pos,
+        double range);
+
+    bool isEnemy(GameObject& unit, GameObject& other) const;
+};
+
+}  // namespace familyline::logic
@@ -0,0 +1,188 @@
+/**
+ * Frame profiler
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace familyline
+{
+/**
+ * A zone that was measured
+ */
+struct ProfileEvent {
+    /// The zone name. Always a string literal
+    const char* name;
+
+    /// Start and duration, in nanoseconds since the profiler was created
+    int64_t start;
+    int64_t duration;
+
+    /// How many zones were open in this thread when this one started
+    uint32_t depth;
+};
+
+/**
+ * Measures how long some parts of the game take
+ *
+ * The parts are zones, marked with the PROFILE_ZONE macro: the zone starts
+ * where the macro is, and ends at the end of the scope. Zones can be nested.
+ *
+ * The profiler only records something while it is capturing. Each thread keeps
+ * its last zones in a ring buffer, so we can capture during the whole game and
+ * still only keep the last few seconds. When you want to see them, dump them in
+ * the Chrome trace format, and open the file in chrome://tracing or in Perfetto.
+ *
+ * When the game is built with FLINE_STRIP_PROFILER, the zones are removed at
+ * compile time.
+ */
+class Profiler
+{
+public:
+    static Profiler& get();
+
+    /**
+     * Start capturing, keeping the last `events_per_thread` zones of each thread
+     *
+     * The zones captured before are discarded.
+     */
+    void start(size_t events_per_thread = 65536);
+
+    void stop() { capturing_.store(false, std::memory_order_relaxed); }
+
+    static bool isCapturing() { return capturing_.load(std::memory_order_relaxed); }
+
+    /**
+     * Record a zone of the current thread
+     */
+    void record(const char* name, int64_t start, int64_t end, uint32_t depth);
+
+    /**
+     * Name the current thread, in the dumped traces
+     */
+    void setThreadName(std::string_view name);
+
+    /**
+     * Get the zones captured in every thread, ordered by thread, then by start
+     * time
+     */
+    std::vector<std::pair<uint32_t, ProfileEvent>> getEvents();
+
+    /**
+     * Write the captured zones to a file, in the Chrome trace format
+     *
+     * Returns false if we could not create the file
+     */
+    bool dumpChromeTrace(const std::filesystem::path& path);
+
+    /**
+     * Nanoseconds since the profiler was created
+     */
+    int64_t now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - epoch_)
+            .count();
+    }
+
+private:
+    Profiler();
+
+    /**
+     * The zones of a thread
+     *
+     * Only its thread writes to it, but we lock it anyway, so we can read it
+     * while the thread runs. Nobody else holds the lock for long, so it is
+     * almost always free.
+     */
+    struct ThreadBuffer {
+        std::mutex mtx;
+        uint32_t id;
+        std::string name;
+
+        std::vector<ProfileEvent> events;
+        size_t next  = 0;
+        size_t count = 0;
+
+        void resize(size_t capacity);
+    };
+
+    /// The buffer of the current thread
+    static thread_local std::shared_ptr<ThreadBuffer> current_;
+
+    ThreadBuffer& threadBuffer();
+
+    static inline std::atomic<bool> capturing_ = false;
+
+    std::chrono::steady_clock::time_point epoch_;
+
+    std::mutex threads_mtx_;
+    std::vector<std::shared_ptr<ThreadBuffer>> threads_;
+    size_t capacity_ = 65536;
+};
+
+/**
+ * A zone, measured from its creation until its destruction
+ *
+ * Use it through the PROFILE_ZONE macro
+ */
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name)
+    {
+        if (!Profiler::isCapturing()) return;
+
+        name_  = name;
+        depth_ = depth++;
+        start_ = Profiler::get().now();
+    }
+
+    ~ProfileZone()
+    {
+        if (!name_) return;
+
+        auto& p = Profiler::get();
+        depth--;
+        p.record(name_, start_, p.now(), depth_);
+    }
+
+    ProfileZone(const ProfileZone&)            = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name_ = nullptr;
+    int64_t start_;
+    uint32_t depth_;
+
+    /// Number of zones open in the current thread
+    static inline thread_local uint32_t depth = 0;
+};
+
+}  // namespace familyline
+
+#define FLINE_PROFILE_CONCAT_(a, b) a##b
+#define FLINE_PROFILE_CONCAT(a, b) FLINE_PROFILE_CONCAT_(a, b)
+
+/**
+ * Measure the time from here until the end of the scope
+ *
+ * The name must be a string literal.
+ */
+#ifdef FLINE_STRIP_PROFILER
+#define PROFILE_ZONE(name)
+#else
+#define PROFILE_ZONE(name) \
+    familyline::ProfileZone FLINE_PROFILE_CONCAT(profile_zone_, __LINE__) { name }
+#endif
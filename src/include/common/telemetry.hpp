@@ -0,0 +1,168 @@
+/**
+ * Frame and tick telemetry
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace familyline
+{
+/**
+ * A histogram of integer values, with a bounded relative error
+ *
+ * Like the HDR histograms: values below 64 have their own bucket, and each
+ * power of two above that is split into 32 buckets, so the error of a
+ * percentile is at most 1/32 (~3%) of its value, while the whole histogram is a
+ * fixed array of counters. Recording a value is a few arithmetic operations, so
+ * we can record every frame and every tick.
+ *
+ * The minimum, the maximum and the mean are exact.
+ */
+class Histogram
+{
+public:
+    static constexpr unsigned SubBucketBits  = 5;
+    static constexpr uint64_t SubBucketCount = uint64_t(1) << SubBucketBits;
+    static constexpr size_t BucketCount      = (64 - SubBucketBits + 1) * SubBucketCount;
+
+    void record(uint64_t value);
+
+    /**
+     * Add the values of another histogram to this one
+     */
+    void merge(const Histogram& other);
+
+    void reset();
+
+    uint64_t count() const { return count_; }
+    uint64_t min() const { return count_ ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ ? double(sum_) / count_ : 0.0; }
+
+    /**
+     * Get the value below which `p` percent of the values are
+     *
+     * Returns the highest value of the bucket, so it never underestimates the
+     * percentile, and never goes past the maximum.
+     */
+    uint64_t percentile(double p) const;
+
+    /// The bucket of a value, and the highest value of a bucket
+    static size_t bucketOf(uint64_t value);
+    static uint64_t bucketHighest(size_t bucket);
+
+private:
+    std::array<uint64_t, BucketCount> buckets_ = {};
+
+    uint64_t count_ = 0;
+    uint64_t sum_   = 0;
+    uint64_t min_   = UINT64_MAX;
+    uint64_t max_   = 0;
+};
+
+/**
+ * Collects the frame and tick times, and the counters of the subsystems, of a
+ * game session
+ *
+ * Each metric is a histogram. Durations are recorded in microseconds, and
+ * exported in milliseconds; counters (number of objects, of draw calls...) are
+ * exported as they are. The metrics are kept in the order they were first
+ * recorded, so the exported files of two builds can be compared line by line.
+ *
+ * The metrics can be exported to a CSV or JSON file at the end of the session,
+ * and periodically, so a soak run that gets killed still leaves its data. Each
+ * export writes the whole session so far.
+ *
+ * This class is not thread safe: record everything from the game thread.
+ */
+class Telemetry
+{
+public:
+    enum class Unit { Milliseconds, Count };
+
+    struct Metric {
+        std::string name;
+        Unit unit;
+        Histogram values;
+    };
+
+    /**
+     * Record a duration, in milliseconds
+     */
+    void recordTime(std::string_view name, double ms);
+
+    /**
+     * Record a sample of a counter
+     */
+    void recordCount(std::string_view name, uint64_t value);
+
+    /**
+     * Add some information about the session (version, map...) to the JSON export
+     */
+    void setInfo(std::string_view key, std::string_view value);
+
+    /**
+     * Get a metric, or nullptr if it was never recorded
+     */
+    const Metric* get(std::string_view name) const;
+
+    const std::vector<Metric>& metrics() const { return metrics_; }
+
+    void reset();
+
+    /**
+     * Export to this file every `interval`, when update() is called
+     *
+     * Files ending in .json are written as JSON, the other ones as CSV.
+     */
+    void setExport(std::filesystem::path path, std::chrono::seconds interval);
+
+    /**
+     * Export the metrics, if the export interval has passed
+     *
+     * Call it once per frame
+     */
+    void update();
+
+    /**
+     * Export the metrics to the export file, now
+     *
+     * Returns false if there is no export file, or we could not write it
+     */
+    bool exportNow();
+
+    /**
+     * Write the metrics, one per line, with the columns
+     * `metric,unit,count,min,mean,p50,p90,p99,max`
+     */
+    std::string toCSV() const;
+
+    /**
+     * Write the metrics as a JSON object, with the session information in
+     * "info", and the metrics in "metrics", keyed by name
+     */
+    std::string toJSON() const;
+
+private:
+    std::vector<Metric> metrics_;
+    std::vector<std::pair<std::string, std::string>> info_;
+
+    std::chrono::steady_clock::time_point started_ = std::chrono::steady_clock::now();
+
+    std::filesystem::path export_path_;
+    std::chrono::seconds export_interval_{0};
+    std::chrono::steady_clock::time_point last_export_;
+
+    Histogram& metric(std::string_view name, Unit unit);
+};
+
+}  // namespace familyline
@@ -0,0 +1,89 @@
+/**
+ * A simple pool of worker threads
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace familyline
+{
+/**
+ * A pool of worker threads, for splitting independent work over the processor cores
+ *
+ * The only operation is parallelFor(), that runs a function for each index of a range, and
+ * only returns when all of them finished.
+ *
+ * The pool does not guarantee any order of execution, so, to keep the game deterministic,
+ * the function must only write to data that belongs to its own index, and read the shared
+ * data only if nobody is writing to it. Anything that depends on order must be done by
+ * the caller, after parallelFor() returns.
+ */
+class WorkerPool
+{
+public:
+    /**
+     * Create a pool with `threads` worker threads
+     *
+     * The thread that calls parallelFor() also works, so a pool with zero threads is valid,
+     * and runs everything in the calling thread.
+     */
+    explicit WorkerPool(unsigned threads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * Run `fn(i)` for every i in [0, count), and wait until all of them end
+     *
+     * Do not call this from inside `fn`.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    unsigned threadCount() const { return threads_.size(); }
+
+    /**
+     * A sensible default for the number of worker threads: one for each core, minus the
+     * one that is calling us.
+     */
+    static unsigned defaultThreadCount();
+
+private:
+    std::vector<std::thread> threads_;
+
+    std::mutex mtx_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+
+    /// The function of the current batch, and its item count
+    const std::function<void(size_t)>* fn_ = nullptr;
+    size_t count_                          = 0;
+
+    /// The next item index to be run
+    std::atomic<size_t> next_ = 0;
+
+    /// Number of workers still running the current batch
+    unsigned running_ = 0;
+
+    /// Incremented on each batch, so the workers know they have a new one
+    uint64_t batch_ = 0;
+
+    bool quitting_ = false;
+
+    void workerLoop();
+
+    /**
+     * Run items of the current batch until there is no more of them
+     */
+    void runItems();
+};
+
+}  // namespace familyline
@@ -0,0 +1,156 @@
+/**
+ * Battle benchmark
+ *
+ * Puts two armies face to face, makes every unit attack the one in front of it,
+ * and prints how much time the attack manager took per tick. The units have
+ * different health, so they die during the whole battle, and their attacks are
+ * cancelled while the others keep going.
+ *
+ * It is run twice: once with melee units, and once with archers, so we also
+ * measure the projectiles in flight.
+ *
+ * Usage: familyline-bench-attack [unit count] [tick count]
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cmath>
+#include <common/logger.hpp>
+#include <common/logic/attack_manager.hpp>
+#include <common/logic/lifecycle_manager.hpp>
+#include <common/logic/logic_service.hpp>
+#include <common/logic/object_manager.hpp>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace familyline::logic;
+
+/**
+ * A unit that can attack anything around it
+ *
+ * Archers shoot projectiles, the others attack in melee
+ */
+class BenchUnit : public GameObject
+{
+public:
+    BenchUnit(int health, bool archer)
+        : GameObject("bench-unit", "Unit", glm::vec2(2, 2), health, health)
+    {
+        auto rule = archer ? AttackRule{
+                                 .minDistance = 0.5,
+                                 .maxDistance = 20,
+                                 .ctype       = AttackTypeProjectile{.projectileSpeed = 2}}
+                           : AttackRule{
+                                 .minDistance = 0.5,
+                                 .maxDistance = 5,
+                                 .ctype       = AttackTypeMelee{}};
+
+        this->cAttack = std::make_optional<AttackComponent>(
+            AttackAttributes{
+                .attackPoints  = 1.5,
+                .defensePoints = 0.5,
+                .attackSpeed   = archer ? 512.0 : 2048.0,
+                .precision     = 90,
+                .maxAngle      = 2 * M_PI},
+            std::vector<AttackRule>{rule});
+        this->cAttack->setParent(this);
+    }
+};
+
+struct BattleResult {
+    double total_ms;
+    double worst_tick_ms;
+    size_t max_attacks;
+    size_t max_projectiles;
+    size_t remaining_units;
+};
+
+static BattleResult runBattle(int unitcount, int ticks, bool archers)
+{
+    LogicService::getActionQueue()->clearEvents();
+
+    ObjectManager om;
+    ObjectLifecycleManager olm{om};
+    AttackManager am;
+
+    // Two armies, in lines of 50 units, three units apart from each other. The
+    // archers stay farther from the enemy.
+    std::mt19937 rng{1234};
+    std::uniform_int_distribution<int> hdist(5, 200);
+
+    std::vector<object_id_t> armyA, armyB;
+    auto pairs = unitcount / 2;
+    for (auto i = 0; i < pairs; i++) {
+        auto row = i % 50;
+        auto col = i / 50;
+
+        for (auto* army : {&armyA, &armyB}) {
+            auto x = 10 + col * 30 + (army == &armyA ? 0 : archers ? 12 : 3);
+            auto o = std::make_shared<BenchUnit>(hdist(rng), archers);
+            o->setPosition(glm::vec3(x, 1, 10 + row * 3));
+
+            auto id = om.add(std::move(o));
+            olm.doRegister(om.get(id).value());
+            olm.notifyCreation(id);
+            army->push_back(id);
+        }
+    }
+    olm.update();
+
+    for (auto i = 0; i < pairs; i++) {
+        auto a = om.getPointer(armyA[i]);
+        auto b = om.getPointer(armyB[i]);
+        a->getAttackComponent()->attack(*b->getAttackComponent());
+        b->getAttackComponent()->attack(*a->getAttackComponent());
+    }
+
+    BattleResult res{0, 0, 0, 0, 0};
+    for (auto tick = 0; tick < ticks; tick++) {
+        LogicService::getActionQueue()->processEvents();
+        res.max_attacks = std::max(res.max_attacks, am.attackCount());
+
+        auto begin = std::chrono::steady_clock::now();
+        am.update(om, olm);
+        auto end = std::chrono::steady_clock::now();
+
+        res.max_projectiles = std::max(res.max_projectiles, am.getProjectiles().size());
+        olm.update();
+
+        auto ms = std::chrono::duration<double, std::milli>(end - begin).count();
+        res.total_ms += ms;
+        res.worst_tick_ms = std::max(res.worst_tick_ms, ms);
+    }
+
+    res.remaining_units = om.size();
+    return res;
+}
+
+int main(int argc, char const* argv[])
+{
+    int unitcount = 1000;
+    int ticks     = 300;
+
+    if (argc > 1) unitcount = atoi(argv[1]);
+    if (argc > 2) ticks = atoi(argv[2]);
+
+    familyline::LoggerService::createLogger(stderr, familyline::LogType::Fatal);
+
+    fmt::print("units: {}, ticks: {}, budget: 16 ms/tick\n", unitcount, ticks);
+
+    auto melee = runBattle(unitcount, ticks, false);
+    fmt::print(
+        "melee:   {:.3f} ms/tick (worst {:.3f} ms), {} attacks at most, {} units left\n",
+        melee.total_ms / ticks, melee.worst_tick_ms, melee.max_attacks, melee.remaining_units);
+
+    auto ranged = runBattle(unitcount, ticks, true);
+    fmt::print(
+        "archers: {:.3f} ms/tick (worst {:.3f} ms), {} attacks and {} projectiles at most, {} "
+        "units left\n",
+        ranged.total_ms / ticks, ranged.worst_tick_ms, ranged.max_attacks,
+        ranged.max_projectiles, ranged.remaining_units);
+    return 0;
+}
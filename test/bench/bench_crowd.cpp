@@ -0,0 +1,134 @@
+/**
+ * Crowd pathing benchmark
+ *
+ * Moves two groups of objects through each other, on a map with some buildings, and
+ * prints how much time the path manager took per tick. This is the case where every
+ * moving object repairs its path every tick, so it is run twice: once searching each
+ * path again from scratch, and once repairing them incrementally.
+ *
+ * Usage: familyline-bench-crowd [object count] [tick count]
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <common/logger.hpp>
+#include <common/logic/logic_service.hpp>
+#include <common/logic/object_manager.hpp>
+#include <common/logic/object_path_manager.hpp>
+#include <common/logic/terrain.hpp>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace familyline::logic;
+
+struct CrowdResult {
+    double total_ms;
+    double worst_tick_ms;
+    int completed;
+};
+
+static CrowdResult runCrowd(Terrain& t, int objcount, int ticks, bool incremental)
+{
+    auto [width, height] = t.getSize();
+
+    LogicService::getActionQueue()->clearEvents();
+    LogicService::initPathManager(t);
+
+    auto& pm = LogicService::getPathManager();
+    pm->setIncrementalRepath(incremental);
+    pm->setWorkerCount(0);
+
+    ObjectManager om;
+
+    // Some buildings, always in the same places
+    std::mt19937 rng{1234};
+    std::uniform_int_distribution<int> xdist(width / 4, width * 3 / 4);
+    std::uniform_int_distribution<int> ydist(0, height - 1);
+    for (auto i = 0; i < 40; i++) {
+        auto building = std::make_shared<GameObject>(
+            "bench-building", "Building", glm::vec2(6, 6), 1000, 1000);
+        building->setPosition(glm::vec3(xdist(rng), 1, ydist(rng)));
+        om.add(std::move(building));
+    }
+
+    // Two groups, one in each side of the map, each one going to the other side
+    std::vector<std::shared_ptr<GameObject>> objects;
+    std::vector<glm::vec2> destinations;
+    auto rows = std::max(1, objcount / 4);
+    for (auto i = 0; i < objcount; i++) {
+        auto left = i % 2 == 0;
+        auto row  = (i / 2) % rows;
+        auto col  = (i / 2) / rows;
+
+        auto x = left ? 8 + col * 6 : int(width) - 8 - col * 6;
+        auto y = int(height) / 2 - rows * 3 + row * 6;
+
+        auto o =
+            std::make_shared<GameObject>("bench-unit", "Unit", glm::vec2(2, 2), 100, 100);
+        o->setPosition(glm::vec3(x, 1, y));
+        auto id = om.add(std::move(o));
+
+        objects.push_back(om.get(id).value());
+        destinations.push_back(glm::vec2(int(width) - x, y));
+    }
+
+    LogicService::getActionQueue()->processEvents();
+    for (auto i = 0u; i < objects.size(); i++) pm->startPathing(*objects[i], destinations[i]);
+
+    CrowdResult res{0, 0, 0};
+    for (auto tick = 0; tick < ticks; tick++) {
+        LogicService::getActionQueue()->processEvents();
+
+        auto begin = std::chrono::steady_clock::now();
+        pm->update(om);
+        auto end = std::chrono::steady_clock::now();
+
+        auto ms = std::chrono::duration<double, std::milli>(end - begin).count();
+        res.total_ms += ms;
+        res.worst_tick_ms = std::max(res.worst_tick_ms, ms);
+    }
+
+    for (auto& o : objects) {
+        if (pm->getPathStatus(*o) == PathStatus::Completed) res.completed++;
+    }
+
+    return res;
+}
+
+int main(int argc, char const* argv[])
+{
+    int objcount = 64;
+    int ticks    = 300;
+
+    if (argc > 1) objcount = atoi(argv[1]);
+    if (argc > 2) ticks = atoi(argv[2]);
+
+    familyline::LoggerService::createLogger(stderr, familyline::LogType::Fatal);
+
+    TerrainFile tf{256, 256};
+    Terrain t{tf};
+    LogicService::initDebugDrawer(new DummyDebugDrawer{t});
+
+    fmt::print("objects: {}, ticks: {}, map: 256x256\n", objcount, ticks);
+
+    auto full = runCrowd(t, objcount, ticks, false);
+    fmt::print(
+        "full search: {:.3f} ms/tick (worst {:.3f} ms), {} completed\n", full.total_ms / ticks,
+        full.worst_tick_ms, full.completed);
+
+    auto incr = runCrowd(t, objcount, ticks, true);
+    fmt::print(
+        "incremental: {:.3f} ms/tick (worst {:.3f} ms), {} completed\n", incr.total_ms / ticks,
+        incr.worst_tick_ms, incr.completed);
+
+    fmt::print("speedup: {:.2f}x\n", full.total_ms / incr.total_ms);
+
+    // The path manager and the debug drawer know the terrain, so they cannot outlive it
+    LogicService::getPathManager().reset();
+    LogicService::initDebugDrawer(nullptr);
+    return 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * Action queue benchmark
+ *
+ * Pushes a lot of events per tick to the action queue, from a few emitters, and
+ * delivers them to receivers that listen to a few event types each, like the
+ * attack manager, the lifecycle manager and the object listener do. Prints how
+ * much time pushing and delivering them took per tick.
+ *
+ * Usage: familyline-bench-events [events per tick] [tick count]
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <common/logger.hpp>
+#include <common/logic/action_queue.hpp>
+#include <cstdlib>
+#include <vector>
+
+using namespace familyline::logic;
+
+int main(int argc, char const* argv[])
+{
+    int eventcount = 10000;
+    int ticks      = 300;
+
+    if (argc > 1) eventcount = atoi(argv[1]);
+    if (argc > 2) ticks = atoi(argv[2]);
+
+    // Like in a normal game, the action queue messages are not shown
+    familyline::LoggerService::createLogger(stderr, familyline::LogType::Warning);
+
+    ActionQueue aq;
+    EventEmitter attacks("bench-attacks");
+    EventEmitter lifecycle("bench-lifecycle");
+    aq.addEmitter(&attacks);
+    aq.addEmitter(&lifecycle);
+
+    size_t received = 0;
+    auto count      = [&](const EntityEvent&) {
+        received++;
+        return true;
+    };
+
+    aq.addReceiver("bench-attack-manager", count, {ActionQueueEvent::AttackStart});
+    aq.addReceiver(
+        "bench-lifecycle-manager", count,
+        {ActionQueueEvent::Created, ActionQueueEvent::Dying, ActionQueueEvent::Dead});
+    aq.addReceiver(
+        "bench-object-listener", count,
+        {ActionQueueEvent::Created, ActionQueueEvent::Dead, ActionQueueEvent::Destroyed});
+    aq.addReceiver(
+        "bench-renderer", count, {ActionQueueEvent::AttackDone, ActionQueueEvent::AttackMiss});
+    aq.addReceiver("bench-unused", count, {ActionQueueEvent::Garrisoned});
+
+    fmt::print("events per tick: {}, ticks: {}\n", eventcount, ticks);
+
+    double push_ms = 0, process_ms = 0;
+    for (auto tick = 0; tick < ticks; tick++) {
+        auto begin = std::chrono::steady_clock::now();
+        for (auto i = 0; i < eventcount; i++) {
+            entity_id_t id = i;
+            EntityEvent e{0, EventCreated{.objectID = id}, nullptr};
+            switch (i % 4) {
+                case 0:
+                    e.type = EventAttackDone{.attackerID = id, .defenderID = id + 1};
+                    break;
+                case 1:
+                    e.type = EventAttackMiss{.attackerID = id, .defenderID = id + 1};
+                    break;
+                case 2:
+                    e.type = EventAttackStart{.attackerID = id, .defenderID = id + 1};
+                    break;
+            }
+
+            (i % 4 == 3 ? lifecycle : attacks).pushEvent(e);
+        }
+        auto middle = std::chrono::steady_clock::now();
+
+        aq.processEvents();
+        auto end = std::chrono::steady_clock::now();
+
+        push_ms += std::chrono::duration<double, std::milli>(middle - begin).count();
+        process_ms += std::chrono::duration<double, std::milli>(end - middle).count();
+    }
+
+    fmt::print(
+        "push: {:.3f} ms/tick, process: {:.3f} ms/tick, {} events received\n", push_ms / ticks,
+        process_ms / ticks, received);
+    return 0;
+}
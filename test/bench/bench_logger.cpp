@@ -0,0 +1,145 @@
+/**
+ * Logger benchmark
+ *
+ * Writes a lot of messages from a few threads, like the pathfinder workers do
+ * when the debug log is enabled, and prints how much time each write took in the
+ * thread that wrote it. The messages are written to /dev/null, so we measure
+ * the logger, not the terminal.
+ *
+ * The blocked messages are written twice: once with the tag name, and once with
+ * an interned tag.
+ *
+ * Then, it compares the text and the binary logs: it writes the same messages to
+ * each one, and prints how much time the logger thread spent writing them, and how
+ * many bytes it wrote.
+ *
+ * Usage: familyline-bench-logger [messages per thread] [thread count]
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <common/logger.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <glm/glm.hpp>
+#include <thread>
+#include <vector>
+
+using namespace familyline;
+
+struct SinkResult {
+    double ns_per_message;
+    uintmax_t bytes;
+};
+
+/**
+ * Write `msgcount` messages to a logger that writes to a text file, or to a binary
+ * file, and measure only the time spent consuming them
+ */
+static SinkResult runSink(int msgcount, bool binary)
+{
+    auto path = std::filesystem::temp_directory_path() /
+                (binary ? "familyline-bench.flog" : "familyline-bench.log");
+
+    FILE* text = binary ? nullptr : fopen(path.string().c_str(), "w");
+    double ns  = 0;
+    {
+        Logger log{text, LogType::Debug, {}, 1024};
+        if (binary) {
+            auto writer = std::make_unique<BinaryLogWriter>(path, 1024 * 1024 * 1024);
+            writer->open();
+            log.setBinarySink(std::move(writer));
+        }
+
+        static const LogTag tag{"pathfinder"};
+        for (auto i = 0; i < msgcount; i += 256) {
+            for (auto j = i; j < i + 256; j++) {
+                log.setTick(j / 100);
+                log.write(
+                    tag, LogType::Debug,
+                    "({:03d}) open list has {}, closed list has {}, best: {:.2f}", j % 1000,
+                    size_t(j % 37), size_t(j % 91), glm::vec2(j % 512, j % 256));
+            }
+
+            auto begin = std::chrono::steady_clock::now();
+            log.flush();
+            auto end = std::chrono::steady_clock::now();
+            ns += std::chrono::duration<double, std::nano>(end - begin).count();
+        }
+    }
+
+    if (text) fclose(text);
+
+    auto bytes = std::filesystem::file_size(path);
+    std::filesystem::remove(path);
+    return SinkResult{ns / msgcount, bytes};
+}
+
+int main(int argc, char const* argv[])
+{
+    int msgcount    = 200000;
+    int threadcount = 4;
+
+    if (argc > 1) msgcount = atoi(argv[1]);
+    if (argc > 2) threadcount = atoi(argv[2]);
+
+    FILE* devnull = fopen("/dev/null", "w");
+    LoggerService::createLogger(devnull, LogType::Info, {"blocked"});
+    auto& log = LoggerService::getLogger();
+
+    fmt::print("messages: {}, threads: {}\n", msgcount, threadcount);
+
+    auto run = [&](const char* name, auto&& fn) {
+        std::vector<std::thread> threads;
+        std::vector<double> times(threadcount);
+
+        for (auto t = 0; t < threadcount; t++) {
+            threads.emplace_back([&, t]() {
+                auto begin = std::chrono::steady_clock::now();
+                for (auto i = 0; i < msgcount; i++) fn(i);
+                auto end = std::chrono::steady_clock::now();
+                times[t] = std::chrono::duration<double, std::nano>(end - begin).count();
+            });
+        }
+
+        for (auto& t : threads) t.join();
+        log->flush();
+
+        double total = 0;
+        for (auto v : times) total += v;
+        fmt::print("{:10} {:8.1f} ns/message\n", name, total / (double(msgcount) * threadcount));
+    };
+
+    run("filtered:", [&](int i) {
+        log->write("pathfinder", LogType::Debug, "iteration {} at {}", i, glm::vec2(i, i));
+    });
+    run("blocked:", [&](int i) {
+        log->write("blocked", LogType::Info, "iteration {} at {}", i, glm::vec2(i, i));
+    });
+    static const LogTag blocked{"blocked"};
+    run("interned:", [&](int i) {
+        LOGWRITE(log, blocked, LogType::Info, "iteration {} at {}", i, glm::vec2(i, i));
+    });
+    run("written:", [&](int i) {
+        log->write("pathfinder", LogType::Info, "iteration {} at {}", i, glm::vec2(i, i));
+    });
+
+    fmt::print("{} messages lost\n", log->getDroppedCount());
+
+    auto text   = runSink(msgcount, false);
+    auto binary = runSink(msgcount, true);
+    fmt::print(
+        "text log:   {:8.1f} ns/message, {:10} bytes ({:.1f} bytes/message)\n",
+        text.ns_per_message, text.bytes, double(text.bytes) / msgcount);
+    fmt::print(
+        "binary log: {:8.1f} ns/message, {:10} bytes ({:.1f} bytes/message)\n",
+        binary.ns_per_message, binary.bytes, double(binary.bytes) / msgcount);
+
+    log.reset();
+    fclose(devnull);
+    return 0;
+}
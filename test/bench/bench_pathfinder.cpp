@@ -0,0 +1,123 @@
+/**
+ * Pathfinder benchmark
+ *
+ * Runs a fixed set of path queries on the bundled test terrain, with some
+ * randomly placed (but deterministic) obstacles, and prints how much time
+ * they took.
+ *
+ * Usage: familyline-bench-pathfinder [terrain file] [query count]
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <common/logger.hpp>
+#include <common/logic/pathfinder.hpp>
+#include <common/logic/terrain.hpp>
+#include <common/logic/terrain_file.hpp>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace familyline::logic;
+
+/**
+ * Create an obstacle bitmap with some rectangular obstacles, like buildings
+ *
+ * The seed is fixed, so every run uses the same map
+ */
+static std::vector<bool> createObstacleBitmap(int width, int height, std::mt19937& rng)
+{
+    std::vector<bool> bitmap(width * height, false);
+
+    std::uniform_int_distribution<int> xdist(0, width - 1);
+    std::uniform_int_distribution<int> ydist(0, height - 1);
+    std::uniform_int_distribution<int> sizedist(2, 10);
+
+    int obstacles = (width * height) / 256;
+    for (int i = 0; i < obstacles; i++) {
+        int ox = xdist(rng), oy = ydist(rng);
+        int ow = sizedist(rng), oh = sizedist(rng);
+
+        for (int y = oy; y < std::min(oy + oh, height); y++) {
+            for (int x = ox; x < std::min(ox + ow, width); x++) {
+                bitmap[y * width + x] = true;
+            }
+        }
+    }
+
+    return bitmap;
+}
+
+struct PathQuery {
+    glm::vec2 start;
+    glm::vec2 end;
+};
+
+int main(int argc, char const* argv[])
+{
+    std::string mapfile = TESTS_DIR "/terrain_test.flte";
+    int querycount      = 200;
+
+    if (argc > 1) mapfile = argv[1];
+    if (argc > 2) querycount = atoi(argv[2]);
+
+    familyline::LoggerService::createLogger(stderr, familyline::LogType::Fatal);
+
+    TerrainFile tf;
+    if (!tf.open(mapfile)) {
+        fmt::print(stderr, "could not open terrain file {}\n", mapfile);
+        return 1;
+    }
+
+    Terrain t{tf};
+    auto [width, height] = t.getSize();
+
+    std::mt19937 rng{1234};
+    auto bitmap = createObstacleBitmap(width, height, rng);
+
+    std::uniform_int_distribution<int> xdist(0, width - 1);
+    std::uniform_int_distribution<int> ydist(0, height - 1);
+
+    auto randomFreePoint = [&]() {
+        while (true) {
+            int x = xdist(rng), y = ydist(rng);
+            if (!bitmap[y * width + x]) return glm::vec2(x, y);
+        }
+    };
+
+    std::vector<PathQuery> queries;
+    for (int i = 0; i < querycount; i++) {
+        queries.push_back(PathQuery{randomFreePoint(), randomFreePoint()});
+    }
+
+    Pathfinder pf{t};
+    pf.update(bitmap);
+
+    size_t total_points = 0;
+    size_t incomplete   = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (auto& q : queries) {
+        auto path = pf.findPath(q.start, q.end, glm::vec2(1, 1), 2000);
+        total_points += path.size();
+        if (pf.maxIterReached()) incomplete++;
+
+        // Every query is a new one, so do not continue the previous search
+        pf.update(bitmap);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+
+    fmt::print("map: {} ({}x{})\n", mapfile, width, height);
+    fmt::print("queries: {}, incomplete: {}, total path points: {}\n", querycount, incomplete,
+               total_points);
+    fmt::print("total: {:.3f} ms, per query: {:.3f} ms\n", elapsed / 1000.0,
+               elapsed / 1000.0 / querycount);
+
+    return 0;
+}
@@ -0,0 +1,542 @@
+/**
+ * Pathfinding benchmark suite
+ *
+ * Builds some synthetic maps in memory (an open field, a maze and a map
+ * with chokepoints) and, for each one, measures:
+ *
+ *  - single: long path queries, with the normal (A*) and the hierarchical
+ *    pathfinders, one at a time
+ *  - group: a big group of objects moving together to the other side of
+ *    the map, through the path manager
+ *  - sustained: lots of objects walking to random places, getting a new
+ *    destination when they arrive, so we can see the cost of a tick of the
+ *    path manager over a long time
+ *
+ * For each one, we print the latency percentiles, the number of nodes the
+ * pathfinder expanded (when we can know it) and the number of memory
+ * allocations. Use --json to print the results as JSON, so you can compare
+ * runs with a script.
+ *
+ * Usage: familyline-bench-pathing [--json] [--quick] [--workers N] [filter]
+ *
+ * `filter` only runs the benchmarks whose name contains it, like "maze" or
+ * "sustained"
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <common/logger.hpp>
+#include <common/logic/hierarchical_pathfinder.hpp>
+#include <common/logic/logic_service.hpp>
+#include <common/logic/object_manager.hpp>
+#include <common/logic/object_path_manager.hpp>
+#include <common/logic/pathfinder.hpp>
+#include <common/logic/terrain.hpp>
+#include <common/logic/terrain_file.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_utils.hpp"
+
+using namespace familyline::logic;
+
+/**
+ * A rectangular obstacle, like a wall or a building
+ *
+ * (x, y) is its top-left corner
+ */
+struct Wall {
+    int x, y, w, h;
+};
+
+/**
+ * A synthetic map: the terrain and the obstacles over it
+ */
+struct BenchMap {
+    std::string name;
+    int width, height;
+    std::vector<uint16_t> heights;
+    std::vector<Wall> walls;
+
+    std::vector<bool> toBitmap() const
+    {
+        std::vector<bool> bitmap(width * height, false);
+        for (auto& w : walls) {
+            for (auto y = std::max(0, w.y); y < std::min(height, w.y + w.h); y++)
+                for (auto x = std::max(0, w.x); x < std::min(width, w.x + w.w); x++)
+                    bitmap[y * width + x] = true;
+        }
+
+        return bitmap;
+    }
+};
+
+/**
+ * A flat map with some gentle hills, and nothing in the way
+ */
+static BenchMap createOpenField(int size)
+{
+    BenchMap m{"open", size, size, std::vector<uint16_t>(size * size), {}};
+    for (auto y = 0; y < size; y++) {
+        for (auto x = 0; x < size; x++) {
+            m.heights[y * size + x] =
+                uint16_t(32 + 16 * std::sin(x / 24.0) + 16 * std::cos(y / 32.0));
+        }
+    }
+
+    return m;
+}
+
+/**
+ * A maze, with corridors `cell` units wide
+ *
+ * Created with a randomized depth-first search, with a fixed seed, so there is
+ * exactly one way between two places, and it is usually a long one
+ */
+static BenchMap createMaze(int size, int cell)
+{
+    BenchMap m{"maze", size, size, std::vector<uint16_t>(size * size, 0), {}};
+
+    auto cells = size / cell;
+    std::vector<bool> visited(cells * cells, false);
+
+    // The walls between the cells. right[i] is the wall at the right of cell i,
+    // and down[i] is the one below it
+    std::vector<bool> right(cells * cells, true), down(cells * cells, true);
+
+    std::mt19937 rng{1234};
+    std::vector<int> stack{0};
+    visited[0] = true;
+    while (!stack.empty()) {
+        auto c = stack.back();
+        auto cx = c % cells, cy = c / cells;
+
+        int next[4], count = 0;
+        if (cx > 0 && !visited[c - 1]) next[count++] = c - 1;
+        if (cx < cells - 1 && !visited[c + 1]) next[count++] = c + 1;
+        if (cy > 0 && !visited[c - cells]) next[count++] = c - cells;
+        if (cy < cells - 1 && !visited[c + cells]) next[count++] = c + cells;
+
+        if (count == 0) {
+            stack.pop_back();
+            continue;
+        }
+
+        auto n = next[std::uniform_int_distribution<int>(0, count - 1)(rng)];
+        if (n == c + 1) right[c] = false;
+        if (n == c - 1) right[n] = false;
+        if (n == c + cells) down[c] = false;
+        if (n == c - cells) down[n] = false;
+
+        visited[n] = true;
+        stack.push_back(n);
+    }
+
+    for (auto cy = 0; cy < cells; cy++) {
+        for (auto cx = 0; cx < cells; cx++) {
+            auto c = cy * cells + cx;
+            if (right[c] && cx < cells - 1)
+                m.walls.push_back(Wall{(cx + 1) * cell - 1, cy * cell - 1, 2, cell + 2});
+            if (down[c] && cy < cells - 1)
+                m.walls.push_back(Wall{cx * cell - 1, (cy + 1) * cell - 1, cell + 2, 2});
+        }
+    }
+
+    return m;
+}
+
+/**
+ * Some walls across the map, each one with a few small openings
+ *
+ * Everything that goes from one side to the other needs to pass through
+ * them, like a crowd going through the gates of a city
+ */
+static BenchMap createChokepoints(int size)
+{
+    BenchMap m{"chokepoints", size, size, std::vector<uint16_t>(size * size, 0), {}};
+
+    std::mt19937 rng{4321};
+    auto walls = 5;
+    auto gap   = 6;
+    for (auto i = 1; i <= walls; i++) {
+        auto x = i * size / (walls + 1);
+
+        std::vector<int> gaps;
+        std::uniform_int_distribution<int> gapdist(gap, size - 2 * gap);
+        for (auto g = 0; g < 2; g++) gaps.push_back(gapdist(rng));
+        std::sort(gaps.begin(), gaps.end());
+
+        auto y = 0;
+        for (auto g : gaps) {
+            if (g > y) m.walls.push_back(Wall{x, y, 4, g - y});
+            y = std::max(y, g + gap);
+        }
+        m.walls.push_back(Wall{x, y, 4, size - y});
+    }
+
+    return m;
+}
+
+/**
+ * The results of a benchmark
+ */
+struct BenchResult {
+    std::string name;
+    std::string unit;
+
+    /// The duration of each sample (a query, or a tick), in milliseconds
+    std::vector<double> samples;
+
+    /// The number of nodes expanded by the pathfinder, if we know it
+    std::optional<size_t> expanded_nodes;
+
+    size_t allocations = 0;
+
+    /// Something specific of each benchmark, like the number of paths that
+    /// completed
+    std::string extra_name;
+    size_t extra = 0;
+
+    double percentile(double p) const
+    {
+        if (samples.empty()) return 0;
+
+        auto sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+
+        auto rank = size_t(std::ceil(p / 100.0 * sorted.size()));
+        return sorted[std::clamp(rank, size_t(1), sorted.size()) - 1];
+    }
+
+    double total() const
+    {
+        double t = 0;
+        for (auto s : samples) t += s;
+
+        return t;
+    }
+};
+
+struct BenchOptions {
+    bool quick       = false;
+    int workers      = -1;
+    std::string filter;
+};
+
+/**
+ * Find a free point near a position, searching in squares around it
+ */
+static glm::vec2 freePointNear(const BenchMap& m, const std::vector<bool>& bitmap, int x, int y)
+{
+    for (auto radius = 0; radius < m.width; radius++) {
+        for (auto dy = -radius; dy <= radius; dy++) {
+            for (auto dx = -radius; dx <= radius; dx++) {
+                auto px = x + dx, py = y + dy;
+                if (px < 2 || py < 2 || px >= m.width - 2 || py >= m.height - 2) continue;
+
+                // Our objects are 2x2, so check all cells they would be in
+                if (!bitmap[py * m.width + px] && !bitmap[(py - 1) * m.width + px] &&
+                    !bitmap[py * m.width + px - 1] && !bitmap[(py - 1) * m.width + px - 1])
+                    return glm::vec2(px, py);
+            }
+        }
+    }
+
+    return glm::vec2(x, y);
+}
+
+/**
+ * Long path queries, from one side of the map to the other
+ */
+static std::vector<BenchResult> benchSingle(
+    const BenchMap& m, Terrain& t, const BenchOptions& opt)
+{
+    auto bitmap     = m.toBitmap();
+    auto querycount = opt.quick ? 5 : 30;
+
+    std::mt19937 rng{1234};
+    std::uniform_int_distribution<int> edge(0, m.width / 8);
+    std::vector<std::pair<glm::vec2, glm::vec2>> queries;
+    for (auto i = 0; i < querycount; i++) {
+        auto flip  = i % 2 == 0;
+        auto start = freePointNear(m, bitmap, edge(rng), flip ? edge(rng) : m.height - edge(rng));
+        auto end   = freePointNear(
+            m, bitmap, m.width - edge(rng), flip ? m.height - edge(rng) : edge(rng));
+        queries.push_back({start, end});
+    }
+
+    BenchResult astar{m.name + "/single/astar", "query"};
+    astar.expanded_nodes = 0;
+    astar.extra_name     = "complete";
+
+    Pathfinder pf{t};
+    for (auto& [start, end] : queries) {
+        // Every query is a new one, so do not continue the previous search
+        pf.update(bitmap);
+
+        auto allocs = getAllocationCount();
+        auto begin  = std::chrono::steady_clock::now();
+        auto path   = pf.findPath(start, end, glm::vec2(1, 1), m.width * m.height);
+        auto finish = std::chrono::steady_clock::now();
+
+        astar.allocations += getAllocationCount() - allocs;
+        astar.samples.push_back(
+            std::chrono::duration<double, std::milli>(finish - begin).count());
+        *astar.expanded_nodes += pf.expandedNodes();
+        if (!pf.maxIterReached() && pf.hasPossiblePath()) astar.extra++;
+    }
+
+    BenchResult hpa{m.name + "/single/hierarchical", "query"};
+    hpa.expanded_nodes = 0;
+    hpa.extra_name     = "complete";
+
+    HierarchicalPathfinder hpf{t};
+    hpf.update(bitmap);
+    for (auto& [start, end] : queries) {
+        auto allocs    = getAllocationCount();
+        auto begin     = std::chrono::steady_clock::now();
+        auto waypoints = hpf.findWaypoints(start, end);
+        auto finish    = std::chrono::steady_clock::now();
+
+        hpa.allocations += getAllocationCount() - allocs;
+        hpa.samples.push_back(std::chrono::duration<double, std::milli>(finish - begin).count());
+        *hpa.expanded_nodes += hpf.expandedNodes();
+        if (waypoints) hpa.extra++;
+    }
+
+    return {astar, hpa};
+}
+
+/**
+ * Everything the path manager benchmarks need
+ *
+ * The walls of the map become static objects, like buildings
+ */
+struct PathingWorld {
+    ObjectManager om;
+    std::vector<std::shared_ptr<GameObject>> units;
+
+    PathingWorld(const BenchMap& m, Terrain& t, const BenchOptions& opt)
+    {
+        LogicService::getActionQueue()->clearEvents();
+        LogicService::initPathManager(t);
+
+        auto& pm = LogicService::getPathManager();
+        if (opt.workers >= 0) pm->setWorkerCount(unsigned(opt.workers));
+
+        for (auto& w : m.walls) {
+            auto o = std::make_shared<GameObject>(
+                "bench-wall", "Wall", glm::vec2(w.w, w.h), 1000, 1000);
+            o->setPosition(glm::vec3(w.x + w.w / 2.0, 1, w.y + w.h / 2.0));
+            om.add(std::move(o));
+        }
+    }
+
+    GameObject& addUnit(glm::vec2 pos)
+    {
+        auto o = std::make_shared<GameObject>("bench-unit", "Unit", glm::vec2(2, 2), 100, 100);
+        o->setPosition(glm::vec3(pos.x, 1, pos.y));
+        auto id = om.add(std::move(o));
+
+        units.push_back(om.get(id).value());
+        return *units.back();
+    }
+
+    /**
+     * Run a tick, and return how long the path manager took, in milliseconds
+     */
+    double tick(BenchResult& r)
+    {
+        LogicService::getActionQueue()->processEvents();
+
+        auto& pm    = LogicService::getPathManager();
+        auto allocs = getAllocationCount();
+        auto begin  = std::chrono::steady_clock::now();
+        pm->update(om);
+        auto finish = std::chrono::steady_clock::now();
+
+        r.allocations += getAllocationCount() - allocs;
+        return std::chrono::duration<double, std::milli>(finish - begin).count();
+    }
+};
+
+/**
+ * A big group, at the left of the map, going to the right side of it
+ */
+static BenchResult benchGroup(const BenchMap& m, Terrain& t, const BenchOptions& opt)
+{
+    auto unitcount = opt.quick ? 100 : 500;
+    auto ticks     = opt.quick ? 100 : 600;
+    auto bitmap    = m.toBitmap();
+
+    BenchResult r{m.name + "/group", "tick"};
+    r.extra_name = "completed";
+
+    PathingWorld w{m, t, opt};
+
+    auto columns = int(std::ceil(std::sqrt(unitcount)));
+    for (auto i = 0; i < unitcount; i++) {
+        auto x = 4 + (i % columns) * 3;
+        auto y = m.height / 2 - columns * 3 / 2 + (i / columns) * 3;
+        w.addUnit(freePointNear(m, bitmap, x, y));
+    }
+
+    LogicService::getActionQueue()->processEvents();
+
+    std::vector<GameObject*> group;
+    for (auto& u : w.units) group.push_back(u.get());
+
+    // The first sample is the order itself, the others are the ticks
+    auto& pm    = LogicService::getPathManager();
+    auto dest   = freePointNear(m, bitmap, m.width - 16, m.height / 2);
+    auto allocs = getAllocationCount();
+    auto begin  = std::chrono::steady_clock::now();
+    pm->startGroupPathing(group, dest);
+    auto finish = std::chrono::steady_clock::now();
+
+    r.allocations += getAllocationCount() - allocs;
+    r.samples.push_back(std::chrono::duration<double, std::milli>(finish - begin).count());
+
+    for (auto tick = 0; tick < ticks; tick++) r.samples.push_back(w.tick(r));
+
+    for (auto& u : w.units) {
+        if (pm->getPathStatus(*u) == PathStatus::Completed) r.extra++;
+    }
+
+    return r;
+}
+
+/**
+ * Lots of objects walking to random places, forever
+ */
+static BenchResult benchSustained(const BenchMap& m, Terrain& t, const BenchOptions& opt)
+{
+    auto unitcount = opt.quick ? 50 : 200;
+    auto ticks     = opt.quick ? 100 : 500;
+    auto bitmap    = m.toBitmap();
+
+    BenchResult r{m.name + "/sustained", "tick"};
+    r.extra_name = "arrivals";
+
+    PathingWorld w{m, t, opt};
+
+    std::mt19937 rng{5678};
+    std::uniform_int_distribution<int> xdist(8, m.width - 8), ydist(8, m.height - 8);
+    auto randomPoint = [&]() { return freePointNear(m, bitmap, xdist(rng), ydist(rng)); };
+
+    for (auto i = 0; i < unitcount; i++) w.addUnit(randomPoint());
+
+    LogicService::getActionQueue()->processEvents();
+
+    auto& pm = LogicService::getPathManager();
+    for (auto& u : w.units) pm->startPathing(*u, randomPoint());
+
+    for (auto tick = 0; tick < ticks; tick++) {
+        r.samples.push_back(w.tick(r));
+
+        for (auto& u : w.units) {
+            auto status = pm->getPathStatus(*u);
+            if (status == PathStatus::Completed || status == PathStatus::Unreachable) {
+                if (status == PathStatus::Completed) r.extra++;
+                pm->startPathing(*u, randomPoint());
+            }
+        }
+    }
+
+    return r;
+}
+
+static void printText(const std::vector<BenchResult>& results)
+{
+    fmt::print(
+        "{:<32} {:>7} {:>10} {:>10} {:>10} {:>10} {:>12} {:>10}  {}\n", "benchmark", "samples",
+        "p50 (ms)", "p99 (ms)", "max (ms)", "total (ms)", "expanded", "allocs", "extra");
+
+    for (auto& r : results) {
+        fmt::print(
+            "{:<32} {:>7} {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f} {:>12} {:>10}  {}: {}\n",
+            r.name, r.samples.size(), r.percentile(50), r.percentile(99), r.percentile(100),
+            r.total(), r.expanded_nodes ? std::to_string(*r.expanded_nodes) : "-",
+            r.allocations, r.extra_name, r.extra);
+    }
+}
+
+static void printJSON(const std::vector<BenchResult>& results)
+{
+    fmt::print("[\n");
+    for (auto i = 0u; i < results.size(); i++) {
+        auto& r = results[i];
+        fmt::print(
+            "  {{\"name\": \"{}\", \"unit\": \"{}\", \"samples\": {}, \"p50_ms\": {:.6f}, "
+            "\"p99_ms\": {:.6f}, \"max_ms\": {:.6f}, \"total_ms\": {:.6f}, "
+            "\"expanded_nodes\": {}, \"allocations\": {}, \"{}\": {}}}{}\n",
+            r.name, r.unit, r.samples.size(), r.percentile(50), r.percentile(99),
+            r.percentile(100), r.total(),
+            r.expanded_nodes ? std::to_string(*r.expanded_nodes) : "null", r.allocations,
+            r.extra_name, r.extra, i + 1 < results.size() ? "," : "");
+    }
+    fmt::print("]\n");
+}
+
+int main(int argc, char const* argv[])
+{
+    BenchOptions opt;
+    auto json = false;
+
+    for (auto i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--json"))
+            json = true;
+        else if (!strcmp(argv[i], "--quick"))
+            opt.quick = true;
+        else if (!strcmp(argv[i], "--workers") && i + 1 < argc)
+            opt.workers = atoi(argv[++i]);
+        else
+            opt.filter = argv[i];
+    }
+
+    familyline::LoggerService::createLogger(stderr, familyline::LogType::Fatal);
+
+    auto size = opt.quick ? 128 : 512;
+    std::vector<BenchMap> maps = {
+        createOpenField(size), createMaze(size, 16), createChokepoints(size)};
+
+    auto wanted = [&](const std::string& name) {
+        return opt.filter.empty() || name.find(opt.filter) != std::string::npos;
+    };
+
+    std::vector<BenchResult> results;
+    for (auto& m : maps) {
+        TerrainFile tf{size_t(m.width), size_t(m.height), m.heights};
+        Terrain t{tf};
+        LogicService::initDebugDrawer(new DummyDebugDrawer{t});
+
+        if (wanted(m.name + "/single")) {
+            for (auto& r : benchSingle(m, t, opt)) results.push_back(r);
+        }
+
+        if (wanted(m.name + "/group")) results.push_back(benchGroup(m, t, opt));
+        if (wanted(m.name + "/sustained")) results.push_back(benchSustained(m, t, opt));
+
+        // The path manager and the debug drawer know the terrain, so they cannot
+        // outlive it
+        LogicService::getActionQueue()->clearEvents();
+        LogicService::getPathManager().reset();
+        LogicService::initDebugDrawer(nullptr);
+    }
+
+    if (json)
+        printJSON(results);
+    else
+        printText(results);
+
+    return 0;
+}
@@ -0,0 +1,39 @@
+#include "bench_utils.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/// Number of memory allocations made by all threads, and by each one
+static std::atomic<size_t> allocation_count{0};
+static thread_local size_t thread_allocation_count = 0;
+
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    thread_allocation_count++;
+    return std::malloc(n ? n : 1);
+}
+
+void* operator new(std::size_t n)
+{
+    if (auto* p = operator new(n, std::nothrow)) return p;
+
+    throw std::bad_alloc{};
+}
+
+// Replace all the forms that are not aligned, so the memory is always freed by
+// the allocator that gave it. The sanitizers check that.
+void* operator new[](std::size_t n) { return operator new(n); }
+void* operator new[](std::size_t n, const std::nothrow_t& t) noexcept { return operator new(n, t); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+size_t getAllocationCount() { return allocation_count.load(std::memory_order_relaxed); }
+
+size_t getThreadAllocationCount() { return thread_allocation_count; }
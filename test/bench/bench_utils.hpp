@@ -0,0 +1,18 @@
+/**
+ * Utilities shared by the benchmarks and the tests
+ *
+ * Linking bench_utils.cpp replaces the global operator new, so we can count the
+ * memory allocations.
+ *
+ * Copyright (C) 2021 Arthur Mendes
+ */
+#pragma once
+
+#include <cstddef>
+
+/// Number of memory allocations (calls to operator new) since the program started,
+/// in all threads
+size_t getAllocationCount();
+
+/// Number of memory allocations (calls to operator new) this thread has made
+size_t getThreadAllocationCount();
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <common/logic/flow_field.hpp>
+#include <common/logic/terrain.hpp>
+
+#include "utils.hpp"
+
+using namespace familyline::logic;
+
+TEST(FlowField, CanFollowStraightLine)
+{
+    TerrainFile tf{100, 100};
+    Terrain t(tf);
+
+    FlowField ff(t, std::vector<bool>(50 * 50, false), 2, glm::vec2(60, 20), glm::vec2(1, 1));
+
+    EXPECT_TRUE(ff.isReachable(glm::vec2(20, 20)));
+    EXPECT_DOUBLE_EQ(40, ff.costAt(glm::vec2(20, 20)));
+    EXPECT_DOUBLE_EQ(0, ff.costAt(glm::vec2(60, 20)));
+
+    auto next = ff.nextPosition(glm::vec2(20, 20));
+    ASSERT_TRUE(next);
+    EXPECT_EQ(glm::vec2(22, 20), *next);
+
+    // In the destination cell, go to the destination itself
+    next = ff.nextPosition(glm::vec2(61, 21));
+    ASSERT_TRUE(next);
+    EXPECT_EQ(glm::vec2(60, 20), *next);
+}
+
+TEST(FlowField, OnlyCoversItsBounds)
+{
+    TerrainFile tf{100, 100};
+    Terrain t(tf);
+
+    FlowField ff(
+        t, std::vector<bool>(50 * 50, false), 2, glm::vec2(60, 20), glm::vec2(1, 1),
+        ObstacleGrid::Region{10, 10, 70, 30});
+
+    EXPECT_TRUE(ff.isReachable(glm::vec2(20, 20)));
+    EXPECT_DOUBLE_EQ(40, ff.costAt(glm::vec2(20, 20)));
+    EXPECT_FALSE(ff.isReachable(glm::vec2(20, 50)));
+    EXPECT_FALSE(ff.isReachable(glm::vec2(80, 20)));
+
+    EXPECT_TRUE(ff.isAffectedBy(ObstacleGrid::Region{30, 15, 32, 17}));
+    EXPECT_TRUE(ff.isAffectedBy(ObstacleGrid::Region{71, 20, 72, 21}));
+    EXPECT_FALSE(ff.isAffectedBy(ObstacleGrid::Region{80, 80, 90, 90}));
+}
+
+TEST(FlowField, CanWalkAroundWall)
+{
+    TerrainFile tf{100, 100};
+    Terrain t(tf);
+
+    // A wall in x=25, with a gap in y between 40 and 44
+    auto map = std::vector<bool>(50 * 50, false);
+    for (auto y = 0; y < 50; y++) {
+        if (y < 40 || y > 44) map[y * 50 + 25] = true;
+    }
+
+    FlowField ff(t, map, 2, glm::vec2(80, 20), glm::vec2(1, 1));
+
+    auto pos = glm::vec2(20, 20);
+    int steps = 0;
+    bool passedgap = false;
+    while (pos != glm::vec2(80, 20) && steps < 100) {
+        auto next = ff.nextPosition(pos);
+        ASSERT_TRUE(next) << "cannot move from " << pos.x << ", " << pos.y;
+
+        auto cellx = int(next->x) / 2;
+        auto celly = int(next->y) / 2;
+        ASSERT_FALSE(map[celly * 50 + cellx]) << "walked into the wall in " << next->x << ", "
+                                              << next->y;
+
+        if (cellx == 25) passedgap = true;
+
+        EXPECT_LT(ff.costAt(*next), ff.costAt(pos));
+        pos = *next;
+        steps++;
+    }
+
+    EXPECT_EQ(glm::vec2(80, 20), pos);
+    EXPECT_TRUE(passedgap);
+}
+
+TEST(FlowField, CannotReachEnclosedDestination)
+{
+    TerrainFile tf{100, 100};
+    Terrain t(tf);
+
+    // A box around the destination
+    auto map = std::vector<bool>(50 * 50, false);
+    for (auto i = 20; i <= 30; i++) {
+        map[20 * 50 + i] = true;
+        map[30 * 50 + i] = true;
+        map[i * 50 + 20] = true;
+        map[i * 50 + 30] = true;
+    }
+
+    FlowField ff(t, map, 2, glm::vec2(50, 50), glm::vec2(1, 1));
+
+    EXPECT_FALSE(ff.isReachable(glm::vec2(10, 10)));
+    EXPECT_FALSE(ff.nextPosition(glm::vec2(10, 10)));
+    EXPECT_TRUE(ff.isReachable(glm::vec2(46, 46)));
+}
+
+TEST(FlowField, AvoidsBlockedPositions)
+{
+    TerrainFile tf{100, 100};
+    Terrain t(tf);
+
+    FlowField ff(t, std::vector<bool>(50 * 50, false), 2, glm::vec2(60, 20), glm::vec2(1, 1));
+
+    // The best position is blocked, go through one of the diagonals
+    auto next = ff.nextPosition(
+        glm::vec2(20, 20), [](glm::vec2 p) { return p == glm::vec2(22, 20); });
+    ASSERT_TRUE(next);
+    EXPECT_EQ(22, next->x);
+    EXPECT_NE(20, next->y);
+
+    // Everything that gets us closer is blocked, so we wait.
+    next = ff.nextPosition(glm::vec2(20, 20), [](glm::vec2 p) { return p.x > 20; });
+    EXPECT_FALSE(next);
+}
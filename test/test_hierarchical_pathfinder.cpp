@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <common/logic/hierarchical_pathfinder.hpp>
+#include <common/logic/terrain.hpp>
+
+#include "utils.hpp"
+
+using namespace familyline::logic;
+
+/**
+ * Create a vertical wall in the pathmap, in the column `x`, with a gap between
+ * the lines `gapstart` and `gapend`
+ */
+static void addWall(std::vector<bool>& map, int width, int height, int x, int gapstart, int gapend)
+{
+    for (auto y = 0; y < height; y++) {
+        if (y >= gapstart && y <= gapend) continue;
+
+        map[y * width + x] = true;
+    }
+}
+
+TEST(HierarchicalPathfinder, CanFindWaypointsInOpenMap)
+{
+    TerrainFile tf{200, 200};
+    Terrain t(tf);
+
+    HierarchicalPathfinder hpf(t, 16);
+    hpf.update(std::vector<bool>(100 * 100, false), 2);
+
+    EXPECT_EQ(49, hpf.rebuiltClusters());
+    EXPECT_LT(0, hpf.abstractNodeCount());
+
+    auto waypoints = hpf.findWaypoints(glm::vec2(10, 10), glm::vec2(190, 190));
+    ASSERT_TRUE(waypoints);
+    ASSERT_LT(1, waypoints->size());
+    EXPECT_EQ(glm::vec2(190, 190), waypoints->back());
+
+    // Each waypoint is the entrance of a cluster, so they must always advance towards
+    // the end, and must not be too far from each other.
+    auto last = glm::vec2(10, 10);
+    for (auto& w : *waypoints) {
+        EXPECT_LE(last.x, w.x);
+        EXPECT_LE(last.y, w.y);
+        EXPECT_GE(2 * 16 * 2, glm::distance(last, w));
+        last = w;
+    }
+}
+
+TEST(HierarchicalPathfinder, ReturnsOnlyTheEndInsideSameCluster)
+{
+    TerrainFile tf{200, 200};
+    Terrain t(tf);
+
+    HierarchicalPathfinder hpf(t, 16);
+    hpf.update(std::vector<bool>(100 * 100, false), 2);
+
+    auto waypoints = hpf.findWaypoints(glm::vec2(4, 4), glm::vec2(20, 24));
+    ASSERT_TRUE(waypoints);
+    ASSERT_EQ(1, waypoints->size());
+    EXPECT_EQ(glm::vec2(20, 24), waypoints->at(0));
+}
+
+TEST(HierarchicalPathfinder, CanPassThroughWallGap)
+{
+    TerrainFile tf{200, 200};
+    Terrain t(tf);
+
+    auto map = std::vector<bool>(100 * 100, false);
+    addWall(map, 100, 100, 50, 80, 84);
+
+    HierarchicalPathfinder hpf(t, 16);
+    hpf.update(map, 2);
+
+    auto waypoints = hpf.findWaypoints(glm::vec2(20, 20), glm::vec2(180, 20));
+    ASSERT_TRUE(waypoints);
+
+    // One of the waypoints must be the entrance in the gap
+    auto gap = std::find_if(waypoints->begin(), waypoints->end(), [](auto& w) {
+        return w.y >= 80 * 2 && w.y <= 84 * 2 && w.x >= 48 * 2 && w.x <= 52 * 2;
+    });
+    EXPECT_NE(waypoints->end(), gap);
+    EXPECT_EQ(glm::vec2(180, 20), waypoints->back());
+}
+
+TEST(HierarchicalPathfinder, CannotPassThroughClosedWall)
+{
+    TerrainFile tf{200, 200};
+    Terrain t(tf);
+
+    auto map = std::vector<bool>(100 * 100, false);
+    addWall(map, 100, 100, 50, -1, -1);
+
+    HierarchicalPathfinder hpf(t, 16);
+    hpf.update(map, 2);
+
+    auto waypoints = hpf.findWaypoints(glm::vec2(20, 20), glm::vec2(180, 20));
+    EXPECT_FALSE(waypoints);
+}
+
+TEST(HierarchicalPathfinder, UpdatesOnlyChangedClusters)
+{
+    TerrainFile tf{200, 200};
+    Terrain t(tf);
+
+    auto map = std::vector<bool>(100 * 100, false);
+    addWall(map, 100, 100, 50, -1, -1);
+
+    HierarchicalPathfinder hpf(t, 16);
+    hpf.update(map, 2);
+    EXPECT_FALSE(hpf.findWaypoints(glm::vec2(20, 20), glm::vec2(180, 20)));
+
+    // Same bitmap, nothing to rebuild
+    hpf.update(map, 2);
+    EXPECT_EQ(0, hpf.rebuiltClusters());
+
+    // Open a gap in the wall. Only the cluster with the gap and its
+    // neighbors need to be rebuilt
+    for (auto y = 20; y < 25; y++) map[y * 100 + 50] = false;
+
+    hpf.update(map, 2);
+    EXPECT_GE(16, hpf.rebuiltClusters());
+    EXPECT_LT(0, hpf.rebuiltClusters());
+
+    auto waypoints = hpf.findWaypoints(glm::vec2(20, 20), glm::vec2(180, 20));
+    ASSERT_TRUE(waypoints);
+    EXPECT_EQ(glm::vec2(180, 20), waypoints->back());
+}
+
+TEST(HierarchicalPathfinder, UpdatesOnlyTheRegionsThatChanged)
+{
+    TerrainFile tf{200, 200};
+    Terrain t(tf);
+
+    auto map = std::vector<bool>(100 * 100, false);
+    addWall(map, 100, 100, 50, -1, -1);
+
+    HierarchicalPathfinder hpf(t, 16);
+    hpf.update(map, 2);
+
+    // Open a gap in the wall. The regions are in terrain cells, and the bitmap
+    // has half of its resolution
+    for (auto y = 20; y < 25; y++) map[y * 100 + 50] = false;
+
+    hpf.update(map, 2, {});
+    EXPECT_EQ(0, hpf.rebuiltClusters());
+    EXPECT_FALSE(hpf.findWaypoints(glm::vec2(20, 20), glm::vec2(180, 20)));
+
+    hpf.update(map, 2, {ObstacleGrid::Region{100, 40, 101, 50}});
+    EXPECT_GE(16, hpf.rebuiltClusters());
+    EXPECT_LT(0, hpf.rebuiltClusters());
+
+    auto waypoints = hpf.findWaypoints(glm::vec2(20, 20), glm::vec2(180, 20));
+    ASSERT_TRUE(waypoints);
+    EXPECT_EQ(glm::vec2(180, 20), waypoints->back());
+
+    // The whole bitmap was compared, so nothing else changed
+    hpf.update(map, 2);
+    EXPECT_EQ(0, hpf.rebuiltClusters());
+}
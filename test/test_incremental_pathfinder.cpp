@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <common/logic/incremental_pathfinder.hpp>
+#include <common/logic/obstacle_grid.hpp>
+#include <common/logic/pathfinder.hpp>
+#include <common/logic/terrain.hpp>
+
+using namespace familyline::logic;
+
+/**
+ * Check if the path goes from start to end, one step at a time, and never goes through
+ * a blocked cell
+ */
+static void checkPath(
+    const std::vector<glm::vec2>& path, const ObstacleGrid& g, glm::vec2 start, glm::vec2 end)
+{
+    ASSERT_LT(1, path.size());
+    EXPECT_EQ(start, path.front());
+    EXPECT_EQ(end, path.back());
+
+    for (auto i = 1u; i < path.size(); i++) {
+        auto delta = glm::abs(path[i] - path[i - 1]);
+        ASSERT_GE(1.0f, std::max(delta.x, delta.y)) << "step " << i;
+        ASSERT_EQ(0, g.countAt(int(path[i].x), int(path[i].y))) << "step " << i;
+    }
+}
+
+static double pathLength(const std::vector<glm::vec2>& path)
+{
+    double length = 0;
+    for (auto i = 1u; i < path.size(); i++) length += glm::distance(path[i], path[i - 1]);
+
+    return length;
+}
+
+TEST(IncrementalPathfinder, FindsPathAsShortAsTheNormalOne)
+{
+    TerrainFile tf{64, 64};
+    Terrain t(tf);
+
+    ObstacleGrid g(64, 64);
+    g.addLevel(2);
+    for (auto y = 8; y < 50; y += 2) g.add(glm::vec2(30, y), glm::vec2(2, 2));
+
+    IncrementalPathfinder ipf(t);
+    auto path = ipf.findPath(ObstacleView(g, 2), glm::vec2(10, 20), glm::vec2(50, 20),
+                             glm::vec2(1, 1), 10000);
+    ASSERT_TRUE(ipf.hasPossiblePath());
+    ASSERT_FALSE(ipf.maxIterReached());
+    checkPath(path, g, glm::vec2(10, 20), glm::vec2(50, 20));
+
+    Pathfinder pf(t);
+    pf.update(ObstacleView(g, 2));
+    auto expected = pf.findPath(glm::vec2(10, 20), glm::vec2(50, 20), glm::vec2(1, 1), 10000);
+
+    EXPECT_NEAR(pathLength(expected), pathLength(path), 2.0);
+}
+
+TEST(IncrementalPathfinder, ReusesSearchWhenObstaclesMoveAway)
+{
+    TerrainFile tf{64, 64};
+    Terrain t(tf);
+
+    ObstacleGrid g(64, 64);
+    g.addLevel(2);
+
+    IncrementalPathfinder ipf(t);
+    auto first = ipf.findPath(ObstacleView(g, 2), glm::vec2(10, 10), glm::vec2(30, 10),
+                              glm::vec2(1, 1), 10000);
+    ASSERT_TRUE(ipf.hasPossiblePath());
+    EXPECT_LT(0, ipf.expandedNodes());
+
+    // Something changed, but far from the path
+    g.add(glm::vec2(60, 60), glm::vec2(2, 2));
+
+    ASSERT_TRUE(ipf.plan(ObstacleView(g, 2), glm::vec2(10, 10), glm::vec2(30, 10),
+                         glm::vec2(1, 1), 10000));
+    EXPECT_EQ(0, ipf.expandedNodes());
+    EXPECT_FALSE(ipf.pathChanged());
+    EXPECT_EQ(first, ipf.path());
+}
+
+TEST(IncrementalPathfinder, RepairsPathWhenObstacleAppears)
+{
+    TerrainFile tf{64, 64};
+    Terrain t(tf);
+
+    ObstacleGrid g(64, 64);
+    g.addLevel(2);
+
+    IncrementalPathfinder ipf(t);
+    ipf.findPath(ObstacleView(g, 2), glm::vec2(10, 20), glm::vec2(40, 20), glm::vec2(1, 1),
+                 10000);
+    ASSERT_TRUE(ipf.hasPossiblePath());
+
+    // A wall in front of us, after we walked a little
+    for (auto y = 10; y < 32; y += 2) g.add(glm::vec2(25, y), glm::vec2(2, 2));
+
+    auto path = ipf.findPath(ObstacleView(g, 2), glm::vec2(12, 20), glm::vec2(40, 20),
+                             glm::vec2(1, 1), 10000);
+    ASSERT_TRUE(ipf.hasPossiblePath());
+    checkPath(path, g, glm::vec2(12, 20), glm::vec2(40, 20));
+
+    // Remove it, and the path is straight again
+    for (auto y = 10; y < 32; y += 2) g.remove(glm::vec2(25, y), glm::vec2(2, 2));
+
+    path = ipf.findPath(ObstacleView(g, 2), glm::vec2(14, 20), glm::vec2(40, 20),
+                        glm::vec2(1, 1), 10000);
+    ASSERT_TRUE(ipf.hasPossiblePath());
+    checkPath(path, g, glm::vec2(14, 20), glm::vec2(40, 20));
+    EXPECT_NEAR(26.0, pathLength(path), 0.01);
+}
+
+TEST(IncrementalPathfinder, ContinuesSearchAfterIterationLimit)
+{
+    TerrainFile tf{64, 64};
+    Terrain t(tf);
+
+    ObstacleGrid g(64, 64);
+    g.addLevel(2);
+
+    IncrementalPathfinder ipf(t);
+    std::vector<glm::vec2> path;
+    auto calls = 0;
+    do {
+        path = ipf.findPath(ObstacleView(g, 2), glm::vec2(4, 4), glm::vec2(56, 56),
+                            glm::vec2(1, 1), 5);
+        calls++;
+    } while (ipf.maxIterReached() && calls < 100);
+
+    EXPECT_LT(1, calls);
+    ASSERT_TRUE(ipf.hasPossiblePath());
+    checkPath(path, g, glm::vec2(4, 4), glm::vec2(56, 56));
+}
+
+TEST(IncrementalPathfinder, FindsNoPathToWalledOffEnd)
+{
+    TerrainFile tf{64, 64};
+    Terrain t(tf);
+
+    ObstacleGrid g(64, 64);
+    g.addLevel(2);
+
+    IncrementalPathfinder ipf(t);
+    ipf.findPath(ObstacleView(g, 2), glm::vec2(10, 10), glm::vec2(40, 40), glm::vec2(1, 1),
+                 10000);
+    ASSERT_TRUE(ipf.hasPossiblePath());
+
+    // A box around the end
+    for (auto i = 32; i <= 48; i += 2) {
+        g.add(glm::vec2(i, 32), glm::vec2(2, 2));
+        g.add(glm::vec2(i, 48), glm::vec2(2, 2));
+        g.add(glm::vec2(32, i), glm::vec2(2, 2));
+        g.add(glm::vec2(48, i), glm::vec2(2, 2));
+    }
+
+    auto path = ipf.findPath(ObstacleView(g, 2), glm::vec2(10, 10), glm::vec2(40, 40),
+                             glm::vec2(1, 1), 10000);
+    EXPECT_FALSE(ipf.maxIterReached());
+    EXPECT_FALSE(ipf.hasPossiblePath());
+    EXPECT_TRUE(path.empty());
+}
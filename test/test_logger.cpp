@@ -0,0 +1,248 @@
+#include <gtest/gtest.h>
+
+#include <common/logger.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace familyline;
+
+static std::vector<std::string> readLines(FILE* f)
+{
+    std::vector<std::string> lines;
+    char buf[512];
+
+    rewind(f);
+    while (fgets(buf, sizeof(buf), f)) lines.push_back(buf);
+    return lines;
+}
+
+TEST(Logger, MessagesAreWrittenInOrder)
+{
+    FILE* f = tmpfile();
+    ASSERT_NE(nullptr, f);
+
+    {
+        Logger log{f, LogType::Info, {"blocked"}};
+
+        std::string name = "a string";
+        log.write("test", LogType::Info, "message {} of {}", 1, name.c_str());
+        name = "changed";
+
+        log.write("test", LogType::Debug, "too low");
+        log.write("blocked", LogType::Error, "blocked tag");
+        log.write("test", LogType::Warning, std::string("message {}"), 2);
+
+        std::thread t([&]() { log.write("thread", LogType::Info, "from {}", "another thread"); });
+        t.join();
+
+        log.flush();
+    }
+
+    auto lines = readLines(f);
+    ASSERT_EQ(3, lines.size());
+    EXPECT_NE(std::string::npos, lines[0].find("message 1 of a string"));
+    EXPECT_NE(std::string::npos, lines[1].find("message 2"));
+    EXPECT_NE(std::string::npos, lines[1].find("[WARN]"));
+    EXPECT_NE(std::string::npos, lines[2].find("from another thread"));
+
+    fclose(f);
+}
+
+TEST(Logger, LostMessagesAreReported)
+{
+    FILE* f = tmpfile();
+    ASSERT_NE(nullptr, f);
+
+    uint64_t dropped = 0;
+    {
+        Logger log{f, LogType::Info, {}, 4};
+        for (auto i = 0; i < 100; i++) log.write("test", LogType::Info, "message {}", i);
+
+        dropped = log.getDroppedCount();
+    }
+
+    // The logger thread might empty the ring while we write, so we do not know
+    // how many were lost, but the messages written plus the lost ones must be
+    // every message we sent
+    auto lines      = readLines(f);
+    size_t written  = 0;
+    size_t reported = 0;
+    for (auto& l : lines) {
+        if (auto p = l.find("messages were lost"); p != std::string::npos) {
+            auto start = l.find("logger");
+            reported += std::stoul(l.substr(l.find(": ", start) + 2));
+        } else {
+            written++;
+        }
+    }
+
+    EXPECT_LT(0, dropped);
+    EXPECT_EQ(dropped, reported);
+    EXPECT_EQ(100, written + dropped);
+
+    fclose(f);
+}
+
+TEST(Logger, FatalMessagesAreNeverLost)
+{
+    FILE* f = tmpfile();
+    ASSERT_NE(nullptr, f);
+
+    uint64_t dropped = 0;
+    {
+        Logger log{f, LogType::Info, {}, 4};
+        for (auto i = 0; i < 20; i++) {
+            for (auto j = 0; j < 8; j++) log.write("test", LogType::Info, "message {}", j);
+            log.write("test", LogType::Fatal, "fatal {}", i);
+        }
+
+        dropped = log.getDroppedCount();
+    }
+
+    auto lines    = readLines(f);
+    size_t fatals = 0;
+    size_t infos  = 0;
+    for (auto& l : lines) {
+        if (l.find("[FATAL]") != std::string::npos) {
+            EXPECT_NE(std::string::npos, l.find(fmt::format("fatal {}", fatals)));
+            fatals++;
+        } else if (l.find("messages were lost") == std::string::npos) {
+            infos++;
+        }
+    }
+
+    EXPECT_EQ(20, fatals);
+    EXPECT_EQ(160, infos + dropped);
+
+    fclose(f);
+}
+
+TEST(Logger, TagsHaveTheirOwnLevel)
+{
+    FILE* f = tmpfile();
+    ASSERT_NE(nullptr, f);
+
+    LogTag quiet{"test-quiet"};
+    EXPECT_EQ(quiet.id(), LogTag{"test-quiet"}.id());
+    EXPECT_NE(quiet.id(), LogTag{"test-loud"}.id());
+    EXPECT_EQ("test-quiet", quiet.name());
+
+    {
+        Logger log{f, LogType::Info, {"test-blocked"}};
+        log.setTagLevel("test-quiet", LogType::Error);
+        log.setTagLevel("test-loud", LogType::Debug);
+
+        EXPECT_FALSE(log.isEnabled(quiet, LogType::Warning));
+        EXPECT_TRUE(log.isEnabled(quiet, LogType::Error));
+        EXPECT_FALSE(log.isEnabled("test-blocked", LogType::Fatal));
+        EXPECT_FALSE(log.isEnabled("test-other", LogType::Debug));
+        EXPECT_TRUE(log.isEnabled("test-other", LogType::Info));
+
+        // The arguments of disabled messages are not evaluated
+        int evaluated = 0;
+        LOGWRITE(&log, quiet, LogType::Info, "quiet {}", ++evaluated);
+        EXPECT_EQ(0, evaluated);
+
+        log.write(quiet, LogType::Error, "quiet error");
+        LOGDEBUG(&log, "test-loud", "loud {}", ++evaluated);
+
+#ifdef FLINE_STRIP_DEBUG_LOG
+        EXPECT_EQ(0, evaluated);
+#else
+        EXPECT_EQ(1, evaluated);
+#endif
+        log.flush();
+    }
+
+    auto lines = readLines(f);
+    ASSERT_LE(1, lines.size());
+    EXPECT_NE(std::string::npos, lines[0].find("test-quiet"));
+    EXPECT_NE(std::string::npos, lines[0].find("quiet error"));
+
+    fclose(f);
+}
+
+static std::string readFile(const std::filesystem::path& path)
+{
+    std::ifstream f{path, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+}
+
+static size_t countOf(std::string_view haystack, std::string_view needle)
+{
+    size_t count = 0;
+    for (auto p = haystack.find(needle); p != std::string_view::npos;
+         p       = haystack.find(needle, p + 1))
+        count++;
+    return count;
+}
+
+TEST(Logger, BinaryLogWritesTablesOnce)
+{
+    auto path = std::filesystem::temp_directory_path() / "familyline-test-log.flog";
+
+    {
+        Logger log{nullptr, LogType::Debug};
+
+        auto writer = std::make_unique<BinaryLogWriter>(path);
+        ASSERT_TRUE(writer->open());
+        log.setBinarySink(std::move(writer));
+
+        for (auto i = 0; i < 10; i++) {
+            log.setTick(i);
+            log.write("test-binary", LogType::Info, "iteration {} at {}", i, glm::vec2(i, i));
+        }
+
+        log.write("test-binary", LogType::Info, "not native: {}", std::optional<int>(2));
+    }
+
+    auto data = readFile(path);
+    ASSERT_LT(16, data.size());
+    EXPECT_EQ("FLOG", data.substr(0, 4));
+
+    EXPECT_EQ(1, countOf(data, "iteration {} at {}"));
+    EXPECT_EQ(1, countOf(data, "test-binary"));
+
+    // Arguments that are not numbers, strings or vectors are formatted by the logger
+    EXPECT_EQ(0, countOf(data, "not native: {}"));
+    EXPECT_EQ(1, countOf(data, "not native: Some(2)"));
+
+    std::filesystem::remove(path);
+}
+
+TEST(Logger, BinaryLogRotatesFiles)
+{
+    auto path = std::filesystem::temp_directory_path() / "familyline-test-rotate.flog";
+    auto rotated = [&](int i) { return std::filesystem::path{fmt::format("{}.{}", path.string(), i)}; };
+
+    {
+        Logger log{nullptr, LogType::Debug};
+
+        auto writer = std::make_unique<BinaryLogWriter>(path, 256, 3);
+        ASSERT_TRUE(writer->open());
+        log.setBinarySink(std::move(writer));
+
+        for (auto i = 0; i < 100; i++) {
+            log.write("test-binary", LogType::Info, "a long message, number {}", i);
+            log.flush();
+        }
+    }
+
+    EXPECT_TRUE(std::filesystem::exists(path));
+    EXPECT_TRUE(std::filesystem::exists(rotated(1)));
+    EXPECT_TRUE(std::filesystem::exists(rotated(2)));
+    EXPECT_FALSE(std::filesystem::exists(rotated(3)));
+
+    // Each file has its own tables
+    for (auto& p : {path, rotated(1), rotated(2)}) {
+        auto data = readFile(p);
+        EXPECT_EQ("FLOG", data.substr(0, 4));
+        EXPECT_EQ(1, countOf(data, "a long message, number {}"));
+        std::filesystem::remove(p);
+    }
+}
@@ -605,3 +605,301 @@ TEST(AttackManager, IsDeadEventReceivedOnDeath)
     LogicService::getActionQueue()->removeReceiver("test-receiver");
     LogicService::getActionQueue()->clearEvents();
 }
+
+TEST(AttackManager, IsEveryAttackOnTheDeadCancelledAtOnce)
+{
+    LogicService::getActionQueue()->removeReceiver("test-receiver");
+    LogicService::getActionQueue()->clearEvents();
+
+    ObjectManager om;
+    ObjectLifecycleManager olm{om};
+
+    AttackComponent aatk(
+        AttackAttributes{
+            .attackPoints  = 1.25,
+            .defensePoints = 0.5,
+            .attackSpeed   = 2048,
+            .precision     = 100,
+            .maxAngle      = M_PI},
+        {AttackRule{.minDistance = 0.5, .maxDistance = 5, .ctype = AttackTypeMelee{}}});
+
+    AttackComponent adef(
+        AttackAttributes{
+            .attackPoints  = 0.25,
+            .defensePoints = 0.75,
+            .attackSpeed   = 2048,
+            .precision     = 100,
+            .maxAngle      = M_PI},
+        {AttackRule{.minDistance = 0.5, .maxDistance = 5, .ctype = AttackTypeMelee{}}});
+
+    auto atker1 = make_object(
+        {"atker", "Attacker", glm::vec2(5, 5), 200, 200, true, []() {}, std::make_optional(aatk)});
+    auto atker2 = make_object(
+        {"atker", "Attacker", glm::vec2(5, 5), 200, 200, true, []() {}, std::make_optional(aatk)});
+    auto defer = make_object(
+        {"defder", "Defender", glm::vec2(5, 5), 1, 200, true, []() {}, std::make_optional(adef)});
+    auto victim = make_object(
+        {"victim", "Victim", glm::vec2(5, 5), 200, 200, true, []() {}, std::make_optional(adef)});
+
+    atker1->setPosition(glm::vec3(6, 0, 6));
+    atker2->setPosition(glm::vec3(6, 0, 3));
+    defer->setPosition(glm::vec3(3, 0, 3));
+    victim->setPosition(glm::vec3(1, 0, 3));
+
+    auto atkid1 = om.add(std::move(atker1));
+    auto atkid2 = om.add(std::move(atker2));
+    auto defid  = om.add(std::move(defer));
+    auto vicid  = om.add(std::move(victim));
+
+    for (auto id : {atkid1, atkid2, defid, vicid}) {
+        olm.doRegister(*om.get(id));
+        olm.notifyCreation(id);
+    }
+    olm.update();
+
+    AttackManager am;
+
+    auto& atk1 = *(*om.get(atkid1))->getAttackComponent();
+    auto& atk2 = *(*om.get(atkid2))->getAttackComponent();
+    auto& def  = *(*om.get(defid))->getAttackComponent();
+    auto& vic  = *(*om.get(vicid))->getAttackComponent();
+
+    ASSERT_TRUE(atk1.attack(def).has_value());
+    ASSERT_TRUE(atk2.attack(def).has_value());
+    ASSERT_TRUE(def.attack(vic).has_value());
+    LogicService::getActionQueue()->processEvents();
+    ASSERT_EQ(3, am.attackCount());
+
+    std::queue<EntityEvent> events_done;
+    std::queue<EntityEvent> events_dead;
+    auto test_recv = [&](const EntityEvent& e) {
+        switch (e.type.index()) {
+            case ActionQueueEvent::AttackDone: events_done.push(e); return true;
+            case ActionQueueEvent::Dying: events_dead.push(e); return true;
+            default: return false;
+        }
+    };
+
+    LogicService::getActionQueue()->addReceiver(
+        "test-receiver", test_recv, {ActionQueueEvent::AttackDone, ActionQueueEvent::Dying});
+
+    // Each attacker deals 0.5 points of damage, so the defender dies in the first
+    // tick, and its own attack is cancelled too.
+    am.update(om, olm);
+    EXPECT_EQ(0, am.attackCount());
+
+    for (auto i = 0; i < 10; i++) {
+        LogicService::getActionQueue()->processEvents();
+        am.update(om, olm);
+        olm.update();
+    }
+    LogicService::getActionQueue()->processEvents();
+
+    EXPECT_EQ(2, events_done.size());
+    EXPECT_EQ(1, events_dead.size());
+    EXPECT_EQ(200.00, (*om.get(vicid))->getHealth());
+
+    LogicService::getActionQueue()->removeReceiver("test-receiver");
+    LogicService::getActionQueue()->clearEvents();
+}
+
+TEST(AttackManager, IsDamageRecalculatedWhenAttributesChange)
+{
+    LogicService::getActionQueue()->removeReceiver("test-receiver");
+    LogicService::getActionQueue()->clearEvents();
+
+    ObjectManager om;
+    ObjectLifecycleManager olm{om};
+
+    auto attributes = AttackAttributes{
+        .attackPoints  = 1.0,
+        .defensePoints = 0.5,
+        .attackSpeed   = 2048,
+        .precision     = 100,
+        .maxAngle      = M_PI};
+
+    AttackComponent aatk(
+        attributes,
+        {AttackRule{.minDistance = 0.5, .maxDistance = 5, .ctype = AttackTypeMelee{}}});
+
+    AttackComponent adef(
+        AttackAttributes{
+            .attackPoints  = 0.25,
+            .defensePoints = 0.75,
+            .attackSpeed   = 2048,
+            .precision     = 100,
+            .maxAngle      = M_PI},
+        {AttackRule{.minDistance = 0.5, .maxDistance = 5, .ctype = AttackTypeMelee{}}});
+
+    auto atker = make_object(
+        {"atker", "Attacker", glm::vec2(5, 5), 200, 200, true, []() {}, std::make_optional(aatk)});
+    auto defer = make_object(
+        {"defder", "Defender", glm::vec2(5, 5), 200, 200, true, []() {}, std::make_optional(adef)});
+
+    atker->setPosition(glm::vec3(4, 0, 4));
+    defer->setPosition(glm::vec3(1, 0, 1));
+
+    auto atkid = om.add(std::move(atker));
+    auto defid = om.add(std::move(defer));
+
+    AttackManager am;
+
+    auto& atk = *(*om.get(atkid))->getAttackComponent();
+    auto& def = *(*om.get(defid))->getAttackComponent();
+
+    ASSERT_TRUE(atk.attack(def).has_value());
+    LogicService::getActionQueue()->processEvents();
+
+    am.update(om, olm);
+    EXPECT_DOUBLE_EQ(199.75, (*om.get(defid))->getHealth());
+
+    attributes.attackPoints = 2.0;
+    atk.setAttributes(attributes);
+
+    am.update(om, olm);
+    EXPECT_DOUBLE_EQ(198.50, (*om.get(defid))->getHealth());
+
+    LogicService::getActionQueue()->clearEvents();
+}
+
+TEST(AttackManager, ProjectileHitsOnlyWhenItArrives)
+{
+    LogicService::getActionQueue()->removeReceiver("test-receiver");
+    LogicService::getActionQueue()->clearEvents();
+
+    ObjectManager om;
+    ObjectLifecycleManager olm{om};
+
+    AttackComponent aatk(
+        AttackAttributes{
+            .attackPoints  = 1.0,
+            .defensePoints = 0.5,
+            .attackSpeed   = 256,
+            .precision     = 100,
+            .maxAngle      = M_PI},
+        {AttackRule{
+            .minDistance = 0.5,
+            .maxDistance = 20,
+            .ctype       = AttackTypeProjectile{.projectileSpeed = 2}}});
+
+    AttackComponent adef(
+        AttackAttributes{
+            .attackPoints  = 0.25,
+            .defensePoints = 0.75,
+            .attackSpeed   = 2048,
+            .precision     = 100,
+            .maxAngle      = M_PI},
+        {AttackRule{.minDistance = 0.5, .maxDistance = 5, .ctype = AttackTypeMelee{}}});
+
+    auto atker = make_object(
+        {"atker", "Attacker", glm::vec2(5, 5), 200, 200, true, []() {}, std::make_optional(aatk)});
+    auto defer = make_object(
+        {"defder", "Defender", glm::vec2(5, 5), 200, 200, true, []() {}, std::make_optional(adef)});
+
+    atker->setPosition(glm::vec3(14, 0, 1));
+    defer->setPosition(glm::vec3(4, 0, 1));
+
+    auto atkid = om.add(std::move(atker));
+    auto defid = om.add(std::move(defer));
+
+    AttackManager am;
+
+    auto& atk = *(*om.get(atkid))->getAttackComponent();
+    auto& def = *(*om.get(defid))->getAttackComponent();
+    ASSERT_TRUE(atk.attack(def).has_value());
+    LogicService::getActionQueue()->processEvents();
+
+    std::queue<EntityEvent> events;
+    auto test_recv = [&](const EntityEvent& e) {
+        events.push(e);
+        return true;
+    };
+
+    LogicService::getActionQueue()->addReceiver(
+        "test-receiver", test_recv, {ActionQueueEvent::AttackDone, ActionQueueEvent::AttackMiss});
+
+    // The projectile flies 10 units, at 2 units per tick
+    for (auto i = 0; i < 5; i++) {
+        am.update(om, olm);
+        LogicService::getActionQueue()->processEvents();
+        EXPECT_EQ(0, events.size());
+    }
+    EXPECT_EQ(1, am.getProjectiles().size());
+    EXPECT_EQ(200.00, (*om.get(defid))->getHealth());
+
+    am.update(om, olm);
+    LogicService::getActionQueue()->processEvents();
+    ASSERT_EQ(1, events.size());
+    EXPECT_EQ(0, am.getProjectiles().size());
+
+    auto* ev = std::get_if<EventAttackDone>(&events.front().type);
+    ASSERT_TRUE(ev);
+    EXPECT_EQ(atkid, ev->attackerID);
+    EXPECT_EQ(defid, ev->defenderID);
+    EXPECT_EQ(0.25, ev->damageDealt);
+    EXPECT_EQ(199.75, (*om.get(defid))->getHealth());
+
+    LogicService::getActionQueue()->removeReceiver("test-receiver");
+    LogicService::getActionQueue()->clearEvents();
+}
+
+TEST(AttackManager, ProjectileMissesIfTheDefenderMoved)
+{
+    LogicService::getActionQueue()->removeReceiver("test-receiver");
+    LogicService::getActionQueue()->clearEvents();
+
+    ObjectManager om;
+    ObjectLifecycleManager olm{om};
+
+    AttackComponent aatk(
+        AttackAttributes{
+            .attackPoints  = 1.0,
+            .defensePoints = 0.5,
+            .attackSpeed   = 256,
+            .precision     = 100,
+            .maxAngle      = M_PI},
+        {AttackRule{
+            .minDistance = 0.5,
+            .maxDistance = 20,
+            .ctype       = AttackTypeProjectile{.projectileSpeed = 2}}});
+
+    auto atker = make_object(
+        {"atker", "Attacker", glm::vec2(5, 5), 200, 200, true, []() {}, std::make_optional(aatk)});
+    auto defer = make_object(
+        {"defder", "Defender", glm::vec2(5, 5), 200, 200, true, []() {}, std::make_optional(aatk)});
+
+    atker->setPosition(glm::vec3(14, 0, 1));
+    defer->setPosition(glm::vec3(4, 0, 1));
+
+    auto atkid = om.add(std::move(atker));
+    auto defid = om.add(std::move(defer));
+
+    AttackManager am;
+
+    auto& atk = *(*om.get(atkid))->getAttackComponent();
+    auto& def = *(*om.get(defid))->getAttackComponent();
+    ASSERT_TRUE(atk.attack(def).has_value());
+    LogicService::getActionQueue()->processEvents();
+
+    std::queue<EntityEvent> events;
+    auto test_recv = [&](const EntityEvent& e) {
+        events.push(e);
+        return true;
+    };
+
+    LogicService::getActionQueue()->addReceiver(
+        "test-receiver", test_recv, {ActionQueueEvent::AttackDone, ActionQueueEvent::AttackMiss});
+
+    am.update(om, olm);
+    (*om.get(defid))->setPosition(glm::vec3(4, 0, 6));
+
+    for (auto i = 0; i < 5; i++) am.update(om, olm);
+    LogicService::getActionQueue()->processEvents();
+
+    ASSERT_EQ(1, events.size());
+    EXPECT_TRUE(std::get_if<EventAttackMiss>(&events.front().type));
+    EXPECT_EQ(200.00, (*om.get(defid))->getHealth());
+
+    LogicService::getActionQueue()->removeReceiver("test-receiver");
+    LogicService::getActionQueue()->clearEvents();
+}
@@ -1,8 +1,12 @@
 #include <gtest/gtest.h>
 
+#include <common/logic/lifecycle_manager.hpp>
 #include <common/logic/logic_service.hpp>
 #include <common/logic/object_factory.hpp>
+#include <common/logic/object_listener.hpp>
+#include <common/logic/object_path_manager.hpp>
 
+#include "bench/bench_utils.hpp"
 #include "utils.hpp"
 
 using namespace familyline::logic;
@@ -48,3 +52,169 @@ TEST(ObjectFactoryOps, ObjectNotRepeat)
     ASSERT_EQ(3, o1->getPosition().z);
     ASSERT_EQ(5, o2->getPosition().z);
 }
+
+TEST(ObjectFactoryOps, ObjectPrototypeDoesNotCreateObjects)
+{
+    auto prototype = make_object(
+        {"test-obj-one", "Test Object 1", glm::vec2(3, 4), 100, 100, false, []() {},
+         std::optional<AttackComponent>()});
+
+    ObjectFactory of;
+    of.addObject(prototype.get());
+
+    auto* p = of.getPrototype("test-obj-one");
+    ASSERT_EQ(prototype.get(), p);
+    EXPECT_EQ(glm::vec2(3, 4), p->getSize());
+    EXPECT_EQ(nullptr, of.getPrototype("test-obj-two"));
+
+    auto stats = of.getPoolStats();
+    EXPECT_EQ(0, stats.objects_created);
+    EXPECT_EQ(0, stats.objects_reused);
+}
+
+TEST(ObjectFactoryOps, ObjectReusesDeadObjects)
+{
+    AttackComponent atk(
+        AttackAttributes{
+            .attackPoints  = 1.0,
+            .defensePoints = 0.5,
+            .attackSpeed   = 2048,
+            .precision     = 90,
+            .maxAngle      = M_PI},
+        std::vector<AttackRule>{
+            AttackRule{.minDistance = 0.5, .maxDistance = 5, .ctype = AttackTypeMelee{}}});
+    auto prototype = make_object(
+        {"test-obj-one", "Test Object 1", glm::vec2(3, 3), 100, 100, false, []() {},
+         std::make_optional(atk)});
+
+    ObjectFactory of;
+    of.addObject(prototype.get());
+
+    ObjectManager om;
+    ObjectLifecycleManager olm{om};
+
+    // Create some objects and kill them, many times
+    auto spawnAndKill = [&]() {
+        std::vector<object_id_t> ids;
+        for (auto i = 0; i < 10; i++) {
+            auto id = om.add(of.getObject("test-obj-one", 10, 1, 10));
+            olm.doRegister(om.get(id).value());
+            olm.notifyCreation(id);
+
+            om.get(id).value()->addHealth(-50);
+            ids.push_back(id);
+        }
+
+        for (auto id : ids) olm.notifyDeath(id);
+        for (auto i = 0; i < 100; i++) olm.update();
+
+        for (auto id : ids) EXPECT_FALSE(om.get(id).has_value());
+        LogicService::getActionQueue()->clearEvents();
+    };
+
+    spawnAndKill();
+    auto first = of.getPoolStats();
+    EXPECT_EQ(10, first.objects_created);
+    EXPECT_EQ(10, first.free_objects);
+
+    for (auto i = 0; i < 5; i++) spawnAndKill();
+
+    // No new objects and no new control blocks
+    auto stats = of.getPoolStats();
+    EXPECT_EQ(10, stats.objects_created);
+    EXPECT_EQ(50, stats.objects_reused);
+    EXPECT_EQ(first.blocks_allocated, stats.blocks_allocated);
+    EXPECT_EQ(50, stats.blocks_reused);
+
+    // The reused objects are like new ones
+    auto o = of.getObject("test-obj-one", 5, 1, 5);
+    EXPECT_EQ(100, o->getHealth());
+    EXPECT_EQ(glm::vec3(5, 1, 5), o->getPosition());
+    ASSERT_TRUE(o->getAttackComponent());
+    EXPECT_EQ(1.0, o->getAttackComponent()->attributes().attackPoints);
+}
+
+TEST(ObjectFactoryOps, ObjectSpawnDoesNotAllocate)
+{
+    TerrainFile tf{64, 64};
+    Terrain t{tf};
+
+    LogicService::getActionQueue()->clearEvents();
+    LogicService::initDebugDrawer(new DummyDebugDrawer{t});
+    LogicService::initPathManager(t);
+    auto& pm = LogicService::getPathManager();
+    auto& ol = LogicService::getObjectListener();
+    ol->clear();
+
+    auto prototype = make_object(
+        {"test-obj-one", "Test Object 1", glm::vec2(3, 3), 100, 100, false, []() {},
+         std::optional<AttackComponent>()});
+
+    ObjectFactory of;
+    of.addObject(prototype.get());
+
+    ObjectManager om;
+    ObjectLifecycleManager olm{om};
+
+    auto tick = [&]() {
+        olm.update();
+        LogicService::getActionQueue()->processEvents();
+        pm->update(om);
+    };
+
+    // Spawn some objects, let everyone see them, and kill them, like a game would
+    std::vector<object_id_t> ids;
+    ids.reserve(10);
+    auto spawnAndKill = [&]() {
+        ids.clear();
+        for (auto i = 0; i < 10; i++) {
+            auto id = om.add(of.getObject("test-obj-one", 10 + i * 4, 1, 10));
+            olm.doRegister(om.get(id).value());
+            olm.notifyCreation(id);
+            ids.push_back(id);
+        }
+
+        for (auto i = 0; i < 10; i++) tick();
+        EXPECT_EQ(10, pm->getSpatialIndex().size());
+
+        for (auto id : ids) olm.notifyDeath(id);
+        for (auto i = 0; i < 100; i++) tick();
+
+        EXPECT_EQ(0, pm->getSpatialIndex().size());
+        EXPECT_TRUE(ol->getAliveObjects().empty());
+    };
+
+    spawnAndKill();
+
+    // After the first round, every container has the memory it needs
+    auto allocations = getThreadAllocationCount();
+    for (auto i = 0; i < 5; i++) spawnAndKill();
+    EXPECT_EQ(0, getThreadAllocationCount() - allocations);
+
+    LogicService::getActionQueue()->clearEvents();
+}
+
+TEST(ObjectFactoryOps, ObjectWeakReferencesExpireOnRelease)
+{
+    auto prototype = make_object(
+        {"test-obj-one", "Test Object 1", glm::vec2(3, 3), 100, 100, false, []() {},
+         std::optional<AttackComponent>()});
+
+    ObjectFactory of;
+    of.addObject(prototype.get());
+
+    auto o = of.getObject("test-obj-one", 3, 1, 3);
+    std::weak_ptr<GameObject> w = o;
+    o.reset();
+
+    EXPECT_TRUE(w.expired());
+
+    // The object outlives the factory if someone still has it
+    std::shared_ptr<GameObject> kept;
+    {
+        ObjectFactory other;
+        other.addObject(prototype.get());
+        kept = other.getObject("test-obj-one", 4, 1, 4);
+    }
+    EXPECT_EQ(4, kept->getPosition().x);
+}
@@ -153,3 +153,359 @@ TEST(ObjectOps, ObjectTestIfRemovalNotifies)
     events.pop();
     actionQueue->removeReceiver("test-receiver");
 }
+
+TEST(ObjectOps, ObjectOldIDDoesNotFindNewObject)
+{
+    auto atkComp                 = std::optional<AttackComponent>();
+    struct object_init objParams = {"test-obj", "Test Object", glm::vec2(3, 3), 100,
+                                    100,        false,         []() {},         atkComp};
+
+    ObjectManager om;
+    auto first  = om.add(make_object(objParams));
+    auto second = om.add(make_object(objParams));
+    om.remove(first);
+
+    // The new object will reuse the slot of the first one
+    auto third = om.add(make_object(objParams));
+    EXPECT_NE(first, third);
+    EXPECT_FALSE(om.get(first).has_value());
+    ASSERT_TRUE(om.get(third).has_value());
+    EXPECT_EQ(third, om.get(third).value()->getID());
+    EXPECT_EQ(second, om.get(second).value()->getID());
+
+    // Removing it twice does nothing
+    om.remove(first);
+    EXPECT_EQ(2, om.size());
+    EXPECT_FALSE(om.get(0).has_value());
+}
+
+TEST(ObjectOps, ObjectUpdatesAllAfterRemoval)
+{
+    int updates = 0;
+
+    auto atkComp                 = std::optional<AttackComponent>();
+    struct object_init objParams = {"test-obj", "Test Object", glm::vec2(3, 3),     100,
+                                    100,        false,         [&]() { updates++; }, atkComp};
+
+    ObjectManager om;
+    std::vector<object_id_t> ids;
+    for (auto i = 0; i < 10; i++) ids.push_back(om.add(make_object(objParams)));
+
+    om.remove(ids[0]);
+    om.remove(ids[4]);
+    om.remove(ids[9]);
+    om.update();
+    EXPECT_EQ(7, updates);
+
+    for (auto i : {1, 2, 3, 5, 6, 7, 8}) {
+        ASSERT_TRUE(om.get(ids[i]).has_value());
+        EXPECT_EQ(ids[i], om.get(ids[i]).value()->getID());
+    }
+}
+
+TEST(ObjectOps, ObjectStateIsPackedWhileInManager)
+{
+    auto atkComp                 = std::optional<AttackComponent>();
+    struct object_init objParams = {"test-obj", "Test Object", glm::vec2(3, 3), 100,
+                                    100,        false,         []() {},         atkComp};
+
+    auto first  = make_object(objParams);
+    auto second = make_object(objParams);
+    first->setPosition(glm::vec3(10, 1, 10));
+    second->setPosition(glm::vec3(20, 1, 20));
+
+    std::shared_ptr<GameObject> kept = first;
+
+    {
+        ObjectManager om;
+        auto fid = om.add(std::move(first));
+        auto sid = om.add(std::move(second));
+
+        auto& components = om.components();
+        ASSERT_EQ(2, components.size());
+        EXPECT_EQ(glm::vec3(10, 1, 10), components.positions()[0]);
+        EXPECT_EQ(glm::vec3(20, 1, 20), components.positions()[1]);
+
+        kept->setPosition(glm::vec3(12, 1, 14));
+        kept->addHealth(-30);
+        EXPECT_EQ(glm::vec3(12, 1, 14), components.positions()[0]);
+        EXPECT_DOUBLE_EQ(70, components.health()[0]);
+
+        // The second object takes the place of the first one
+        om.remove(fid);
+        ASSERT_EQ(1, components.size());
+        EXPECT_EQ(sid, components.ids()[0]);
+        EXPECT_EQ(glm::vec3(20, 1, 20), om.get(sid).value()->getPosition());
+    }
+
+    // The removed object keeps its state
+    EXPECT_EQ(glm::vec3(12, 1, 14), kept->getPosition());
+    EXPECT_DOUBLE_EQ(70, kept->getHealth());
+}
+
+TEST(ObjectOps, PackedStateTracksAttackRangeAndMoves)
+{
+    auto atkComp = std::make_optional<AttackComponent>(
+        AttackAttributes{
+            .attackPoints  = 1.0,
+            .defensePoints = 0.5,
+            .attackSpeed   = 2048,
+            .precision     = 90,
+            .maxAngle      = M_PI},
+        std::vector<AttackRule>(
+            {AttackRule{.minDistance = 0.5, .maxDistance = 5, .ctype = AttackTypeMelee{}}}));
+
+    auto attacker = make_object(
+        {"atker", "Attacker", glm::vec2(3, 3), 100, 100, false, []() {}, atkComp});
+    auto tree = make_object(
+        {"tree", "Tree", glm::vec2(3, 3), 100, 100, false, []() {}, std::nullopt});
+
+    ObjectManager om;
+    auto aid = om.add(std::move(attacker));
+    auto tid = om.add(std::move(tree));
+
+    auto& components = om.components();
+    ASSERT_EQ(0, *om.indexOf(aid));
+    ASSERT_EQ(1, *om.indexOf(tid));
+    EXPECT_DOUBLE_EQ(5, components.attackRange()[0]);
+    EXPECT_GT(0, components.attackRange()[1]);
+
+    // New objects count as moved, so their meshes are placed once
+    EXPECT_EQ(1, components.moved()[0]);
+    EXPECT_EQ(1, components.moved()[1]);
+    components.clearMoved();
+    EXPECT_EQ(0, components.moved()[0]);
+
+    om.get(tid).value()->setPosition(glm::vec3(8, 1, 8));
+    EXPECT_EQ(0, components.moved()[0]);
+    EXPECT_EQ(1, components.moved()[1]);
+
+    // The flags follow the objects when the arrays are compacted
+    om.remove(aid);
+    ASSERT_EQ(0, *om.indexOf(tid));
+    EXPECT_FALSE(om.indexOf(aid));
+    EXPECT_EQ(1, components.moved()[0]);
+    EXPECT_GT(0, components.attackRange()[0]);
+}
+
+TEST(ObjectOps, ObjectUpdateIsIndependentOfWorkerCount)
+{
+    // Each object changes other objects in a way that depends on the order of the
+    // changes, and then we hash the state of the world
+    auto runScenario = [](unsigned workers) {
+        std::vector<GameObject*> objects;
+
+        ObjectManager om;
+        om.setWorkerCount(workers);
+
+        std::vector<object_id_t> ids;
+        for (auto i = 0; i < 300; i++) {
+            auto atkComp                 = std::optional<AttackComponent>();
+            struct object_init objParams = {
+                "test-obj", "Test Object", glm::vec2(3, 3), 100, 100, false,
+                [&objects, i]() {
+                    auto* self  = objects[i];
+                    auto* other = objects[(i * 7 + 3) % objects.size()];
+                    auto pos    = self->getPosition();
+
+                    self->setPosition(pos + glm::vec3(1, 0, 0.5));
+                    self->defer([=]() {
+                        other->setPosition(other->getPosition() * 0.5f + pos);
+                        other->addHealth(-pos.x / 100.0);
+                    });
+                },
+                atkComp};
+
+            auto o = make_object(objParams);
+            o->setPosition(glm::vec3(i % 17, 1, i % 23));
+            objects.push_back(o.get());
+            ids.push_back(om.add(std::move(o)));
+        }
+
+        // Remove some objects, so that the update order is not the order of the IDs
+        std::vector<std::shared_ptr<GameObject>> removed;
+        for (auto i = 0; i < 300; i += 37) {
+            removed.push_back(om.get(ids[i]).value());
+            om.remove(ids[i]);
+        }
+
+        for (auto tick = 0; tick < 20; tick++) om.update();
+
+        size_t hash = 0;
+        for (auto* o : objects) {
+            auto pos = o->getPosition();
+            for (auto v : {double(pos.x), double(pos.y), double(pos.z), o->getHealth()}) {
+                hash = hash * 31 + std::hash<double>{}(v);
+            }
+        }
+
+        return hash;
+    };
+
+    auto serial = runScenario(0);
+    EXPECT_EQ(serial, runScenario(1));
+    EXPECT_EQ(serial, runScenario(4));
+}
+
+TEST(ObjectOps, ObjectListenerPublishesChanges)
+{
+    auto& actionQueue = LogicService::getActionQueue();
+    actionQueue->clearEvents();
+
+    auto& olist = LogicService::getObjectListener();
+    olist->clear();
+    auto start = olist->getVersion();
+
+    auto atkComp                 = std::optional<AttackComponent>();
+    struct object_init objParams = {"test-obj", "Test Object", glm::vec2(3, 3), 100,
+                                    100,        false,         [&]() {},        atkComp};
+
+    ObjectManager om;
+    auto first  = om.add(make_object(objParams));
+    auto second = om.add(make_object(objParams));
+    actionQueue->processEvents();
+
+    auto changes = olist->getChangesSince(start);
+    ASSERT_TRUE(changes);
+    ASSERT_EQ(2, changes->size());
+    EXPECT_EQ(first, (*changes)[0].id);
+    EXPECT_TRUE((*changes)[0].alive);
+    EXPECT_EQ(second, (*changes)[1].id);
+
+    // Only what changed after the version we already saw
+    auto seen = olist->getVersion();
+    om.remove(first);
+    actionQueue->processEvents();
+
+    changes = olist->getChangesSince(seen);
+    ASSERT_TRUE(changes);
+    ASSERT_EQ(1, changes->size());
+    EXPECT_EQ(first, (*changes)[0].id);
+    EXPECT_FALSE((*changes)[0].alive);
+    EXPECT_TRUE(olist->getChangesSince(olist->getVersion())->empty());
+
+    // If the old changes were discarded, we need the full list
+    olist->setMaxChanges(1);
+    om.add(make_object(objParams));
+    om.add(make_object(objParams));
+    actionQueue->processEvents();
+    EXPECT_FALSE(olist->getChangesSince(seen));
+    EXPECT_EQ(1, olist->getChangesSince(olist->getVersion() - 1)->size());
+
+    auto version = olist->getVersion();
+    olist->clear();
+    EXPECT_FALSE(olist->getChangesSince(version));
+
+    olist->setMaxChanges(4096);
+}
+
+TEST(ObjectOps, ActionQueueDeliversEventsInOrder)
+{
+    // A small queue, so it needs to grow
+    ActionQueue aq(4);
+    EventEmitter emitter("test-emitter");
+    aq.addEmitter(&emitter);
+
+    std::vector<entity_id_t> created, dead, all;
+    aq.addReceiver(
+        "test-created",
+        [&](const EntityEvent& e) {
+            created.push_back(std::get<EventCreated>(e.type).objectID);
+            return true;
+        },
+        {ActionQueueEvent::Created});
+    aq.addReceiver(
+        "test-all",
+        [&](const EntityEvent& e) {
+            if (auto* ev = std::get_if<EventCreated>(&e.type)) all.push_back(ev->objectID);
+            if (auto* ev = std::get_if<EventDead>(&e.type)) all.push_back(ev->objectID);
+            return true;
+        },
+        {ActionQueueEvent::Created, ActionQueueEvent::Dead});
+    aq.addReceiver(
+        "test-dead",
+        [&](const EntityEvent& e) {
+            dead.push_back(std::get<EventDead>(e.type).objectID);
+            return true;
+        },
+        {ActionQueueEvent::Dead});
+
+    // Process some events, so the ring buffer wraps around
+    for (auto round = 0; round < 3; round++) {
+        created.clear();
+        dead.clear();
+        all.clear();
+
+        for (entity_id_t i = 1; i <= 10; i++) {
+            EntityEvent e{0, EventCreated{.objectID = i}, nullptr};
+            emitter.pushEvent(e);
+
+            if (i % 3 == 0) {
+                EntityEvent d{0, EventDead{.objectID = i}, nullptr};
+                emitter.pushEvent(d);
+            }
+        }
+
+        EXPECT_EQ(13, aq.pendingEvents());
+        aq.processEvents();
+        EXPECT_EQ(0, aq.pendingEvents());
+
+        EXPECT_EQ(std::vector<entity_id_t>({1, 2, 3, 4, 5, 6, 7, 8, 9, 10}), created);
+        EXPECT_EQ(std::vector<entity_id_t>({3, 6, 9}), dead);
+        EXPECT_EQ(std::vector<entity_id_t>({1, 2, 3, 3, 4, 5, 6, 6, 7, 8, 9, 9, 10}), all);
+    }
+
+    // Removed receivers do not get anything
+    aq.removeReceiver("test-created");
+    created.clear();
+    dead.clear();
+
+    EntityEvent e{0, EventCreated{.objectID = 42}, nullptr};
+    emitter.pushEvent(e);
+    aq.processEvents();
+    EXPECT_EQ(0, created.size());
+    EXPECT_EQ(0, dead.size());
+}
+
+TEST(ObjectOps, ActionQueueReceiversCanChangeReceivers)
+{
+    ActionQueue aq(4);
+    EventEmitter emitter("test-emitter");
+    aq.addEmitter(&emitter);
+
+    std::vector<entity_id_t> spawner, added;
+
+    // On its first event, this receiver adds enough receivers to move the
+    // receiver list, and removes itself
+    aq.addReceiver(
+        "test-spawner",
+        [&](const EntityEvent& e) {
+            spawner.push_back(std::get<EventCreated>(e.type).objectID);
+
+            for (int i = 0; i < 16; i++) {
+                auto name = "test-added-" + std::to_string(i);
+                aq.addReceiver(
+                    name,
+                    [&, name](const EntityEvent& e) {
+                        added.push_back(std::get<EventCreated>(e.type).objectID);
+                        aq.removeReceiver(name);
+                        return true;
+                    },
+                    {ActionQueueEvent::Created});
+            }
+
+            aq.removeReceiver("test-spawner");
+            return true;
+        },
+        {ActionQueueEvent::Created});
+
+    for (entity_id_t i = 1; i <= 3; i++) {
+        EntityEvent e{0, EventCreated{.objectID = i}, nullptr};
+        emitter.pushEvent(e);
+    }
+    aq.processEvents();
+
+    // The changes only apply to the events after the one being delivered
+    EXPECT_EQ(std::vector<entity_id_t>({1}), spawner);
+    EXPECT_EQ(std::vector<entity_id_t>(16, 2), added);
+}
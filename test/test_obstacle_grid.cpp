@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <common/logic/obstacle_grid.hpp>
+#include <random>
+
+using namespace familyline::logic;
+
+TEST(ObstacleGrid, CanAddAndRemoveObjects)
+{
+    ObstacleGrid g(100, 100);
+    g.addLevel(2);
+
+    g.add(glm::vec2(10, 10), glm::vec2(4, 4));
+    g.add(glm::vec2(11, 10), glm::vec2(4, 4));
+
+    EXPECT_EQ(0, g.countAt(7, 10));
+    EXPECT_EQ(1, g.countAt(8, 10));
+    EXPECT_EQ(2, g.countAt(10, 10));
+    EXPECT_EQ(1, g.countAt(12, 10));
+    EXPECT_TRUE(g.isBlocked(5, 5, 2));
+    EXPECT_FALSE(g.isBlocked(20, 20, 2));
+
+    g.remove(glm::vec2(10, 10), glm::vec2(4, 4));
+    EXPECT_EQ(0, g.countAt(8, 10));
+    EXPECT_EQ(1, g.countAt(10, 10));
+    EXPECT_TRUE(g.isBlocked(4, 5, 2));
+    EXPECT_TRUE(g.isBlocked(5, 5, 2));
+
+    g.remove(glm::vec2(11, 10), glm::vec2(4, 4));
+    EXPECT_FALSE(g.isBlocked(4, 5, 2));
+    EXPECT_FALSE(g.isBlocked(5, 5, 2));
+}
+
+TEST(ObstacleGrid, DoesNotSeeExcludedObject)
+{
+    ObstacleGrid g(100, 100);
+    g.addLevel(2);
+
+    auto self = g.footprint(glm::vec2(10, 10), glm::vec2(4, 4));
+    g.add(glm::vec2(10, 10), glm::vec2(4, 4));
+    EXPECT_TRUE(g.isBlocked(5, 5, 2));
+    EXPECT_FALSE(g.isBlocked(5, 5, 2, self));
+
+    // Another object overlapping ours is still seen
+    g.add(glm::vec2(13, 10), glm::vec2(2, 2));
+    EXPECT_TRUE(g.isBlocked(6, 5, 2, self));
+    EXPECT_FALSE(g.isBlocked(4, 4, 2, self));
+
+    // The cells outside of the grid are always blocked
+    EXPECT_TRUE(g.isBlocked(-1, 0, 2));
+    EXPECT_TRUE(g.isBlocked(50, 0, 2));
+}
+
+TEST(ObstacleGrid, LevelsMatchRebuiltBitmap)
+{
+    ObstacleGrid g(128, 128);
+    g.addLevel(2);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> coord(0, 128);
+    std::uniform_int_distribution<int> step(-1, 1);
+
+    std::vector<glm::vec2> positions;
+    for (auto i = 0; i < 50; i++) {
+        positions.push_back(glm::vec2(coord(rng), coord(rng)));
+        g.add(positions.back(), glm::vec2(3, 3));
+    }
+
+    for (auto tick = 0; tick < 100; tick++) {
+        for (auto& p : positions) {
+            auto next = p + glm::vec2(step(rng), step(rng));
+            g.move(p, next, glm::vec2(3, 3));
+            p = next;
+        }
+    }
+
+    // A level created now is built from scratch, and must be equal to the one we
+    // kept updating
+    g.addLevel(4);
+    ObstacleGrid fresh(128, 128);
+    for (auto& p : positions) fresh.add(p, glm::vec2(3, 3));
+    fresh.addLevel(2);
+    fresh.addLevel(4);
+
+    EXPECT_EQ(fresh.toBitmap(2), g.toBitmap(2));
+    EXPECT_EQ(fresh.toBitmap(4), g.toBitmap(4));
+}
+
+TEST(ObstacleGrid, RecordsChanges)
+{
+    ObstacleGrid g(100, 100);
+    EXPECT_EQ(0, g.version());
+    EXPECT_TRUE(g.changesSince(0)->empty());
+
+    g.add(glm::vec2(10, 10), glm::vec2(4, 4));
+    ASSERT_EQ(1, g.version());
+    ASSERT_EQ(1, g.changesSince(0)->size());
+
+    // A move is a single region, covering where the object was and where it is
+    g.move(glm::vec2(10, 10), glm::vec2(11, 11), glm::vec2(4, 4));
+    auto changes = g.changesSince(1);
+    ASSERT_EQ(1, changes->size());
+
+    auto r = changes->front();
+    EXPECT_EQ(8, r.x0);
+    EXPECT_EQ(8, r.y0);
+    EXPECT_EQ(13, r.x1);
+    EXPECT_EQ(13, r.y1);
+    EXPECT_EQ(2, g.changesSince(0)->size());
+    EXPECT_TRUE(g.changesSince(2)->empty());
+
+    // Changes too old are forgotten
+    auto version = g.version();
+    for (auto i = 0; i < 5000; i++) g.move(glm::vec2(11, 11), glm::vec2(11, 11), glm::vec2(4, 4));
+
+    EXPECT_FALSE(g.changesSince(version));
+    EXPECT_EQ(100, g.changesSince(g.version() - 100)->size());
+}
+
+TEST(ObstacleGrid, ClearanceMatchesCellByCellCheck)
+{
+    ObstacleGrid g(128, 128);
+    g.addLevel(2);
+
+    // Check the areas one cell at a time, before the level has a clearance map
+    auto bruteForce = [&](int x0, int y0, int x1, int y1) {
+        for (auto y = y0; y <= y1; y++)
+            for (auto x = x0; x <= x1; x++)
+                if (g.isBlocked(x, y, 2)) return false;
+
+        return true;
+    };
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> coord(0, 128);
+    std::uniform_int_distribution<int> step(-1, 1);
+    std::uniform_int_distribution<int> cell(0, 63);
+    std::uniform_int_distribution<int> side(1, 12);
+
+    std::vector<glm::vec2> positions;
+    for (auto i = 0; i < 40; i++) {
+        positions.push_back(glm::vec2(coord(rng), coord(rng)));
+        g.add(positions.back(), glm::vec2(3, 3));
+    }
+
+    g.addClearance(2, 3);
+    g.addClearance(2, 6);
+
+    for (auto tick = 0; tick < 50; tick++) {
+        for (auto& p : positions) {
+            auto next = p + glm::vec2(step(rng), step(rng));
+            g.move(p, next, glm::vec2(3, 3));
+            p = next;
+        }
+
+        for (auto i = 0; i < 100; i++) {
+            auto x0 = cell(rng), y0 = cell(rng);
+            auto x1 = std::min(63, x0 + side(rng) - 1), y1 = std::min(63, y0 + side(rng) - 1);
+            ASSERT_EQ(bruteForce(x0, y0, x1, y1), g.isFree(2, x0, y0, x1, y1))
+                << "area (" << x0 << ", " << y0 << ") - (" << x1 << ", " << y1 << "), tick "
+                << tick;
+        }
+    }
+}
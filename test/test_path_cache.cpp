@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <common/logic/path_cache.hpp>
+
+using namespace familyline::logic;
+
+TEST(PathCache, FindsPathsBetweenTheSameRegions)
+{
+    PathCache c(16, 32);
+    std::vector<glm::vec2> corridor = {glm::vec2(40, 40), glm::vec2(100, 100)};
+
+    EXPECT_FALSE(c.find(glm::vec2(10, 10), glm::vec2(100, 100), glm::vec2(2, 2), 1));
+    c.add(glm::vec2(10, 10), glm::vec2(100, 100), glm::vec2(2, 2), 1, corridor);
+
+    // Other points in the same regions
+    auto found = c.find(glm::vec2(20, 5), glm::vec2(120, 110), glm::vec2(2, 2), 1);
+    ASSERT_TRUE(found);
+    EXPECT_EQ(corridor, *found);
+
+    // Another region, or another size
+    EXPECT_FALSE(c.find(glm::vec2(40, 10), glm::vec2(100, 100), glm::vec2(2, 2), 1));
+    EXPECT_FALSE(c.find(glm::vec2(10, 10), glm::vec2(100, 100), glm::vec2(6, 6), 1));
+
+    auto stats = c.stats();
+    EXPECT_EQ(1, stats.hits);
+    EXPECT_EQ(3, stats.misses);
+    EXPECT_EQ(1, stats.entries);
+    EXPECT_LT(corridor.size() * sizeof(glm::vec2), stats.memory);
+    EXPECT_DOUBLE_EQ(0.25, stats.hitRate());
+}
+
+TEST(PathCache, RemovesTheLeastRecentlyUsed)
+{
+    PathCache c(2, 10);
+    std::vector<glm::vec2> corridor = {glm::vec2(1, 1)};
+
+    c.add(glm::vec2(0, 0), glm::vec2(50, 0), glm::vec2(1, 1), 1, corridor);
+    c.add(glm::vec2(0, 0), glm::vec2(60, 0), glm::vec2(1, 1), 1, corridor);
+
+    // Use the first one, so the second is the least recently used
+    EXPECT_TRUE(c.find(glm::vec2(0, 0), glm::vec2(50, 0), glm::vec2(1, 1), 1));
+    c.add(glm::vec2(0, 0), glm::vec2(70, 0), glm::vec2(1, 1), 1, corridor);
+
+    EXPECT_EQ(2, c.stats().entries);
+    EXPECT_TRUE(c.find(glm::vec2(0, 0), glm::vec2(50, 0), glm::vec2(1, 1), 1));
+    EXPECT_FALSE(c.find(glm::vec2(0, 0), glm::vec2(60, 0), glm::vec2(1, 1), 1));
+    EXPECT_TRUE(c.find(glm::vec2(0, 0), glm::vec2(70, 0), glm::vec2(1, 1), 1));
+}
+
+TEST(PathCache, DiscardsPathsOfOlderObstacleVersions)
+{
+    PathCache c(16, 32);
+    c.add(glm::vec2(10, 10), glm::vec2(100, 100), glm::vec2(2, 2), 1, {glm::vec2(100, 100)});
+    EXPECT_TRUE(c.find(glm::vec2(10, 10), glm::vec2(100, 100), glm::vec2(2, 2), 1));
+
+    EXPECT_FALSE(c.find(glm::vec2(10, 10), glm::vec2(100, 100), glm::vec2(2, 2), 2));
+    EXPECT_EQ(0, c.stats().entries);
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <common/logic/obstacle_grid.hpp>
+#include <common/logic/path_smoother.hpp>
+#include <common/logic/pathfinder.hpp>
+#include <common/logic/terrain.hpp>
+
+using namespace familyline::logic;
+
+static double pathLength(const std::vector<glm::vec2>& path)
+{
+    double length = 0;
+    for (auto i = 1u; i < path.size(); i++) length += glm::distance(path[i], path[i - 1]);
+
+    return length;
+}
+
+TEST(PathSmoother, StraightPathHasOnlyTheEnds)
+{
+    TerrainFile tf{64, 64};
+    Terrain t(tf);
+
+    ObstacleGrid g(64, 64);
+    g.addLevel(2);
+
+    std::vector<glm::vec2> path;
+    for (auto x = 10; x <= 40; x++) path.push_back(glm::vec2(x, 20));
+
+    PathSmoother s(t, ObstacleView(g, 2));
+    auto smoothed = s.smooth(path, glm::vec2(1, 1));
+    ASSERT_EQ(2, smoothed.size());
+    EXPECT_EQ(glm::vec2(10, 20), smoothed.front());
+    EXPECT_EQ(glm::vec2(40, 20), smoothed.back());
+}
+
+TEST(PathSmoother, CannotWalkThroughObstacles)
+{
+    TerrainFile tf{64, 64};
+    Terrain t(tf);
+
+    ObstacleGrid g(64, 64);
+    g.addLevel(2);
+    g.add(glm::vec2(30, 20), glm::vec2(4, 4));
+
+    PathSmoother s(t, ObstacleView(g, 2));
+    EXPECT_FALSE(s.canWalkStraight(glm::vec2(10, 20), glm::vec2(50, 20), glm::vec2(1, 1)));
+    EXPECT_TRUE(s.canWalkStraight(glm::vec2(10, 10), glm::vec2(50, 10), glm::vec2(1, 1)));
+
+    // A bigger object does not fit in the same place
+    EXPECT_FALSE(s.canWalkStraight(glm::vec2(10, 16), glm::vec2(50, 16), glm::vec2(6, 6)));
+}
+
+TEST(PathSmoother, SmoothedPathAvoidsObstaclesAndIsShorter)
+{
+    TerrainFile tf{64, 64};
+    Terrain t(tf);
+
+    ObstacleGrid g(64, 64);
+    g.addLevel(2);
+    for (auto y = 8; y < 40; y += 2) g.add(glm::vec2(30, y), glm::vec2(2, 2));
+
+    Pathfinder pf(t);
+    pf.update(ObstacleView(g, 2));
+    auto path = pf.findPath(glm::vec2(10, 30), glm::vec2(50, 20), glm::vec2(1, 1), 10000);
+    ASSERT_TRUE(pf.hasPossiblePath());
+
+    PathSmoother s(t, ObstacleView(g, 2));
+    auto smoothed = s.smooth(path, glm::vec2(1, 1));
+
+    EXPECT_GT(path.size(), smoothed.size());
+    EXPECT_GE(6, smoothed.size());
+    EXPECT_EQ(path.front(), smoothed.front());
+    EXPECT_EQ(path.back(), smoothed.back());
+    EXPECT_GE(pathLength(path) + 0.01, pathLength(smoothed));
+
+    for (auto i = 1u; i < smoothed.size(); i++) {
+        auto delta = smoothed[i] - smoothed[i - 1];
+
+        // Walk through the segment, checking every unit of it
+        auto steps = int(std::ceil(glm::length(delta)));
+        for (auto j = 0; j <= steps; j++) {
+            auto p = smoothed[i - 1] + delta * float(j) / float(steps);
+            ASSERT_EQ(0, g.countAt(int(glm::round(p.x)), int(glm::round(p.y))))
+                << "segment " << i << ", step " << j;
+        }
+    }
+}
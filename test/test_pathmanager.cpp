@@ -72,6 +72,35 @@ TEST_F(ObjectPathManagerTest, CanFindPath)
     }
 }
 
+TEST_F(ObjectPathManagerTest, KeepsSpatialIndexUpdated)
+{
+    ObjectManager om;
+
+    auto atkComp                 = std::optional<AttackComponent>();
+    struct object_init objParams = {"test-obj", "Test Object", glm::vec2(3, 3), 100,
+                                    100,        false,         [&]() {},        atkComp};
+
+    auto component = make_object(objParams);
+    component->setPosition(glm::vec3(10, 1, 10));
+    auto cid = om.add(std::move(component));
+
+    auto& pm = LogicService::getPathManager();
+    LogicService::getActionQueue()->processEvents();
+    pm->update(om);
+
+    auto& index = pm->getSpatialIndex();
+    EXPECT_EQ(std::vector<object_id_t>({cid}), index.queryRadius(glm::vec2(10, 10), 1));
+
+    pm->startPathing(*om.get(cid).value().get(), glm::vec2(30, 30));
+    for (int i = 0; i <= 30; i++) {
+        LogicService::getActionQueue()->processEvents();
+        pm->update(om);
+    }
+
+    EXPECT_EQ(std::vector<object_id_t>({}), index.queryRadius(glm::vec2(10, 10), 1));
+    EXPECT_EQ(std::vector<object_id_t>({cid}), index.queryRadius(glm::vec2(30, 30), 1));
+}
+
 TEST_F(ObjectPathManagerTest, CanFindPathOnMultipleIterations)
 {
     ObjectManager om;
@@ -465,12 +494,13 @@ TEST_F(ObjectPathManagerTest, CanPathEntityTwice)
     pm->update(om);
     EXPECT_EQ(PathStatus::InProgress, pm->getPathStatus(handle));
 
+    // The path was found in the first update, and we walked in the other two
     {
         auto ncomp = om.get(cid).value();
         auto pos   = ncomp->getPosition();
-        EXPECT_EQ(prevdest.x+1, pos.x);
+        EXPECT_EQ(prevdest.x+2, pos.x);
         EXPECT_EQ(prevdest.y, pos.y);
-        EXPECT_EQ(prevdest.z-1, pos.z);
+        EXPECT_EQ(prevdest.z-2, pos.z);
     }
     
     for (int i = 0; i <= 18; i++) {
@@ -639,3 +669,390 @@ TEST(ObjectPathManager, CanPathEntityTwice)
     
 }
 */
+
+TEST_F(ObjectPathManagerTest, CanWalkLongPathThroughWallGap)
+{
+    ObjectManager om;
+
+    auto atkComp                 = std::optional<AttackComponent>();
+    struct object_init objParams = {"test-obj", "Test Object", glm::vec2(3, 3), 100,
+                                    100,        false,         [&]() {},        atkComp};
+    struct object_init wallAParams = {"test-obj", "Wall A", glm::vec2(2, 160), 100,
+                                      100,        false,    [&]() {},          atkComp};
+    struct object_init wallBParams = {"test-obj", "Wall B", glm::vec2(2, 80), 100,
+                                      100,        false,    [&]() {},         atkComp};
+
+    glm::vec3 start(20, 1, 20);
+    glm::vec3 destination(180, 0, 20);
+
+    // A wall in x=100, with a gap between z=80 and z=120.
+    auto component = make_object(objParams);
+    auto walla     = make_object(wallAParams);
+    auto wallb     = make_object(wallBParams);
+    component->setPosition(start);
+    walla->setPosition(glm::vec3(100, 1, 0));
+    wallb->setPosition(glm::vec3(100, 1, 160));
+
+    om.add(std::move(walla));
+    om.add(std::move(wallb));
+    auto cid = om.add(std::move(component));
+
+    auto& pm = LogicService::getPathManager();
+    pm->setItersPerFrame(100);
+    auto handle =
+        pm->startPathing(*om.get(cid).value().get(), glm::vec2{destination.x, destination.z});
+
+    LogicService::getActionQueue()->processEvents();
+    pm->update(om);
+    EXPECT_EQ(PathStatus::InProgress, pm->getPathStatus(handle));
+
+    for (int i = 0; i <= 400; i++) {
+        LogicService::getActionQueue()->processEvents();
+        pm->update(om);
+
+        auto pos = om.get(cid).value()->getPosition();
+        EXPECT_FALSE(pos.x > 98 && pos.x < 102 && (pos.z < 80 || pos.z > 120))
+            << "X,Y position " << pos.x << ", " << pos.z << " is inside the wall at iteration "
+            << i;
+    }
+
+    EXPECT_EQ(PathStatus::Completed, pm->getPathStatus(handle));
+
+    {
+        auto ncomp = om.get(cid).value();
+        auto pos   = ncomp->getPosition();
+        EXPECT_EQ(destination.x, pos.x);
+        EXPECT_EQ(destination.z, pos.z);
+    }
+}
+
+TEST_F(ObjectPathManagerTest, WalksAtTheSpeedOfTheMovementComponent)
+{
+    ObjectManager om;
+
+    auto atkComp                 = std::optional<AttackComponent>();
+    struct object_init objParams = {"test-obj", "Test Object", glm::vec2(3, 3), 100,
+                                    100,        false,         [&]() {},        atkComp};
+
+    glm::vec3 start(10, 1, 10);
+    glm::vec3 destination(40, 0, 50);
+
+    auto component = make_object(objParams);
+    component->setPosition(start);
+
+    // 5 units per second, so half an unit per tick
+    component->getMovementComponent() = MovementComponent{50};
+    auto cid                          = om.add(std::move(component));
+
+    auto& pm = LogicService::getPathManager();
+    pm->setTickDuration(100);
+    auto handle =
+        pm->startPathing(*om.get(cid).value().get(), glm::vec2{destination.x, destination.z});
+
+    LogicService::getActionQueue()->processEvents();
+    pm->update(om);
+    EXPECT_EQ(PathStatus::InProgress, pm->getPathStatus(handle));
+
+    // Nothing in the way, so we walk in a straight line
+    for (int i = 1; i <= 20; i++) {
+        pm->update(om);
+
+        auto pos = om.get(cid).value()->getPosition();
+        EXPECT_NEAR(i * 0.5, glm::distance(glm::vec2(start.x, start.z), glm::vec2(pos.x, pos.z)),
+                    0.01);
+    }
+
+    for (int i = 0; i < 100; i++) pm->update(om);
+
+    EXPECT_EQ(PathStatus::Completed, pm->getPathStatus(handle));
+
+    {
+        auto pos = om.get(cid).value()->getPosition();
+        EXPECT_EQ(destination.x, pos.x);
+        EXPECT_EQ(destination.z, pos.z);
+    }
+}
+
+TEST_F(ObjectPathManagerTest, ReusesLongPathsBetweenTheSameRegions)
+{
+    ObjectManager om;
+
+    auto atkComp                 = std::optional<AttackComponent>();
+    struct object_init objParams = {"test-obj", "Test Object", glm::vec2(3, 3), 100,
+                                    100,        false,         [&]() {},        atkComp};
+    struct object_init wallParams = {"test-obj", "Wall", glm::vec2(2, 160), 100,
+                                     100,        false,  [&]() {},          atkComp};
+
+    // A wall in x=100, with a gap at the bottom
+    auto wall = make_object(wallParams);
+    wall->setPosition(glm::vec3(100, 1, 80));
+    om.add(std::move(wall));
+
+    auto first  = make_object(objParams);
+    auto second = make_object(objParams);
+    first->setPosition(glm::vec3(20, 1, 20));
+    second->setPosition(glm::vec3(26, 1, 26));
+    auto fid = om.add(std::move(first));
+    auto sid = om.add(std::move(second));
+
+    auto& pm = LogicService::getPathManager();
+    pm->setItersPerFrame(100);
+    pm->startPathing(*om.get(fid).value().get(), glm::vec2(180, 20));
+    pm->startPathing(*om.get(sid).value().get(), glm::vec2(184, 26));
+
+    LogicService::getActionQueue()->processEvents();
+    pm->update(om);
+
+    auto stats = pm->getPathCacheStats();
+    EXPECT_EQ(1, stats.misses);
+    EXPECT_EQ(1, stats.hits);
+    EXPECT_EQ(1, stats.entries);
+
+    for (int i = 0; i <= 600; i++) {
+        LogicService::getActionQueue()->processEvents();
+        pm->update(om);
+
+        for (auto id : {fid, sid}) {
+            auto pos = om.get(id).value()->getPosition();
+            ASSERT_FALSE(pos.x > 98 && pos.x < 102 && pos.z < 160)
+                << "X,Y position " << pos.x << ", " << pos.z << " is inside the wall at iteration "
+                << i;
+        }
+    }
+
+    auto fpos = om.get(fid).value()->getPosition();
+    auto spos = om.get(sid).value()->getPosition();
+    EXPECT_EQ(glm::vec2(180, 20), glm::vec2(fpos.x, fpos.z));
+    EXPECT_EQ(glm::vec2(184, 26), glm::vec2(spos.x, spos.z));
+}
+
+TEST_F(ObjectPathManagerTest, CanMoveGroupWithFlowField)
+{
+    ObjectManager om;
+
+    auto atkComp                 = std::optional<AttackComponent>();
+    struct object_init objParams = {"test-obj", "Test Object", glm::vec2(3, 3), 100,
+                                    100,        false,         [&]() {},        atkComp};
+
+    glm::vec2 destination(120, 120);
+
+    // A 3x3 formation of objects
+    std::vector<object_id_t> ids;
+    std::vector<GameObject*> objects;
+    for (auto y = 0; y < 3; y++) {
+        for (auto x = 0; x < 3; x++) {
+            auto component = make_object(objParams);
+            component->setPosition(glm::vec3(20 + x * 6, 1, 20 + y * 6));
+
+            auto id = om.add(std::move(component));
+            ids.push_back(id);
+            objects.push_back(om.get(id).value().get());
+        }
+    }
+
+    auto& pm     = LogicService::getPathManager();
+    auto handles = pm->startGroupPathing(objects, destination);
+    ASSERT_EQ(9, handles.size());
+
+    LogicService::getActionQueue()->processEvents();
+    pm->update(om);
+
+    // All objects share the same field
+    EXPECT_EQ(1, pm->getFlowFieldCount());
+
+    for (int i = 0; i <= 250; i++) {
+        LogicService::getActionQueue()->processEvents();
+        pm->update(om);
+    }
+
+    EXPECT_EQ(1, pm->getFlowFieldCount());
+
+    for (auto i = 0; i < ids.size(); i++) {
+        EXPECT_EQ(PathStatus::Completed, pm->getPathStatus(handles[i]))
+            << "object " << i << " did not complete its path";
+
+        auto pos = om.get(ids[i]).value()->getPosition();
+        EXPECT_GE(3 * 3 + 2, glm::distance(glm::vec2(pos.x, pos.z), destination))
+            << "object " << i << " is too far from the destination";
+    }
+}
+
+TEST_F(ObjectPathManagerTest, KeepsFlowFieldsWhenObstaclesChangeElsewhere)
+{
+    ObjectManager om;
+
+    auto atkComp                 = std::optional<AttackComponent>();
+    struct object_init objParams = {"test-obj", "Test Object", glm::vec2(3, 3), 100,
+                                    100,        false,         [&]() {},        atkComp};
+
+    auto add = [&](glm::vec3 pos) {
+        auto component = make_object(objParams);
+        component->setPosition(pos);
+        return om.getPointer(om.add(std::move(component)));
+    };
+
+    std::vector<GameObject*> group;
+    for (auto i = 0; i < 4; i++) group.push_back(add(glm::vec3(20 + i * 6, 1, 20)));
+    auto* faraway = add(glm::vec3(150, 1, 150));
+
+    auto& pm = LogicService::getPathManager();
+    LogicService::getActionQueue()->processEvents();
+    pm->update(om);
+
+    glm::vec2 destination(60, 40);
+    pm->startGroupPathing(group, destination);
+    pm->update(om);
+    EXPECT_EQ(1, pm->getFlowFieldBuildCount());
+
+    // An object far from the group starts moving. The same order again reuses
+    // the field
+    pm->startPathing(*faraway, glm::vec2(180, 180));
+    pm->update(om);
+
+    pm->startGroupPathing(group, destination);
+    pm->update(om);
+    EXPECT_EQ(1, pm->getFlowFieldBuildCount());
+
+    // But an obstacle between the group and the destination changes it
+    add(glm::vec3(50, 1, 30));
+    LogicService::getActionQueue()->processEvents();
+    pm->update(om);
+
+    pm->startGroupPathing(group, destination);
+    pm->update(om);
+    EXPECT_EQ(2, pm->getFlowFieldBuildCount());
+}
+
+TEST_F(ObjectPathManagerTest, IsResultIndependentOfWorkerCount)
+{
+    auto atkComp                 = std::optional<AttackComponent>();
+    struct object_init objParams = {"test-obj", "Test Object", glm::vec2(3, 3), 100,
+                                    100,        false,         [&]() {},        atkComp};
+
+    // Move some objects, crossing each other's paths, and record the position of
+    // each one in each tick
+    auto runScenario = [&](unsigned workers) {
+        LogicService::getActionQueue()->clearEvents();
+        LogicService::initPathManager(*t);
+
+        auto& pm = LogicService::getPathManager();
+        pm->setWorkerCount(workers);
+
+        ObjectManager om;
+        std::vector<object_id_t> ids;
+        for (auto i = 0; i < 8; i++) {
+            auto component = make_object(objParams);
+            component->setPosition(glm::vec3(20 + i * 8, 1, 20 + (i % 2) * 60));
+            ids.push_back(om.add(std::move(component)));
+        }
+
+        for (auto i = 0; i < 8; i++) {
+            auto dest = glm::vec2(90 - i * 8, 80 - (i % 2) * 60);
+            pm->startPathing(*om.get(ids[i]).value().get(), dest);
+        }
+
+        std::vector<glm::vec3> positions;
+        for (auto tick = 0; tick < 120; tick++) {
+            LogicService::getActionQueue()->processEvents();
+            pm->update(om);
+
+            for (auto id : ids) positions.push_back(om.get(id).value()->getPosition());
+        }
+
+        return positions;
+    };
+
+    auto serial   = runScenario(0);
+    auto parallel = runScenario(4);
+    ASSERT_EQ(serial.size(), parallel.size());
+
+    for (auto i = 0; i < serial.size(); i++) {
+        ASSERT_EQ(serial[i], parallel[i]) << "object " << (i % 8) << " diverged in tick "
+                                          << (i / 8);
+    }
+}
+
+TEST_F(ObjectPathManagerTest, CanCheckIfObjectCanBePlaced)
+{
+    ObjectManager om;
+
+    auto atkComp                 = std::optional<AttackComponent>();
+    struct object_init objParams = {"test-obj", "Test Object", glm::vec2(4, 4), 100,
+                                    100,        false,         [&]() {},        atkComp};
+
+    auto component = make_object(objParams);
+    component->setPosition(glm::vec3(50, 1, 50));
+    om.add(std::move(component));
+
+    auto& pm = LogicService::getPathManager();
+    LogicService::getActionQueue()->processEvents();
+    pm->update(om);
+
+    EXPECT_FALSE(pm->canPlace(glm::vec2(50, 50), glm::vec2(4, 4)));
+    EXPECT_FALSE(pm->canPlace(glm::vec2(54, 52), glm::vec2(6, 6)));
+    EXPECT_TRUE(pm->canPlace(glm::vec2(60, 50), glm::vec2(6, 6)));
+
+    // Outside of the map
+    EXPECT_FALSE(pm->canPlace(glm::vec2(1, 1), glm::vec2(6, 6)));
+    EXPECT_FALSE(pm->canPlace(glm::vec2(199, 100), glm::vec2(6, 6)));
+}
+
+TEST_F(ObjectPathManagerTest, KnowsWhichObjectsAreMovingAfterRemovingPaths)
+{
+    ObjectManager om;
+
+    auto atkComp                 = std::optional<AttackComponent>();
+    struct object_init objParams = {"test-obj", "Test Object", glm::vec2(3, 3), 100,
+                                    100,        false,         [&]() {},        atkComp};
+
+    std::vector<object_id_t> ids;
+    std::vector<PathHandle> handles;
+    auto& pm = LogicService::getPathManager();
+    for (int i = 0; i < 3; i++) {
+        auto component = make_object(objParams);
+        component->setPosition(glm::vec3(10, 1, 10 + i * 10));
+        ids.push_back(om.add(std::move(component)));
+        handles.push_back(pm->startPathing(*om.getPointer(ids.back()), glm::vec2(60, 10 + i * 10)));
+    }
+
+    pm->update(om);
+    for (auto id : ids) EXPECT_TRUE(pm->isMoving(id));
+
+    // The paths after the removed one change their place in the list
+    pm->removePathing(handles[0]);
+    EXPECT_FALSE(pm->isMoving(ids[0]));
+    EXPECT_TRUE(pm->isMoving(ids[1]));
+    EXPECT_TRUE(pm->isMoving(ids[2]));
+    EXPECT_EQ(PathStatus::InProgress, pm->getPathStatus(*om.getPointer(ids[2])));
+
+    EXPECT_FALSE(pm->isMoving(ids[2] + 100));
+}
+
+TEST_F(ObjectPathManagerTest, SharesTheWorkerPoolWithTheObjectManager)
+{
+    auto& pool = LogicService::getWorkerPool();
+    auto& pm   = LogicService::getPathManager();
+    EXPECT_EQ(pool->threadCount(), pm->getWorkerCount());
+
+    auto users = pool.use_count();
+
+    ObjectManager om;
+    om.setWorkers(pool);
+    EXPECT_EQ(users + 1, pool.use_count());
+
+    auto atkComp                 = std::optional<AttackComponent>();
+    struct object_init objParams = {"test-obj", "Test Object", glm::vec2(3, 3), 100,
+                                    100,        false,         [&]() {},        atkComp};
+
+    auto component = make_object(objParams);
+    component->setPosition(glm::vec3(10, 1, 10));
+    auto cid = om.add(std::move(component));
+
+    auto handle = pm->startPathing(*om.getPointer(cid), glm::vec2(30, 30));
+    for (int i = 0; i < 40; i++) {
+        om.update();
+        pm->update(om);
+    }
+
+    EXPECT_EQ(PathStatus::Completed, pm->getPathStatus(handle));
+}
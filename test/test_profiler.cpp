@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <common/profiler.hpp>
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <thread>
+
+using namespace familyline;
+
+static void runZones()
+{
+    PROFILE_ZONE("outer");
+    {
+        PROFILE_ZONE("inner");
+    }
+    {
+        PROFILE_ZONE("inner");
+    }
+}
+
+TEST(Profiler, ZonesAreOnlyRecordedWhileCapturing)
+{
+    auto& p = Profiler::get();
+    p.start(64);
+    p.stop();
+
+    runZones();
+    ASSERT_TRUE(p.getEvents().empty());
+
+    p.start(64);
+    runZones();
+    p.stop();
+
+    auto events = p.getEvents();
+#ifdef FLINE_STRIP_PROFILER
+    ASSERT_TRUE(events.empty());
+#else
+    ASSERT_EQ(3, events.size());
+
+    EXPECT_STREQ("outer", events[0].second.name);
+    EXPECT_EQ(0, events[0].second.depth);
+    for (int i = 1; i < 3; i++) {
+        auto& e = events[i].second;
+        EXPECT_STREQ("inner", e.name);
+        EXPECT_EQ(1, e.depth);
+        EXPECT_GE(e.start, events[0].second.start);
+        EXPECT_LE(e.start + e.duration, events[0].second.start + events[0].second.duration);
+    }
+#endif
+}
+
+TEST(Profiler, OldZonesAreOverwritten)
+{
+    auto& p = Profiler::get();
+    p.start(4);
+
+    std::thread t([]() {
+        Profiler::get().setThreadName("worker");
+        for (int i = 0; i < 10; i++) runZones();
+    });
+    t.join();
+
+    {
+        PROFILE_ZONE("main");
+    }
+    p.stop();
+
+    auto events = p.getEvents();
+#ifndef FLINE_STRIP_PROFILER
+    ASSERT_EQ(5, events.size());
+
+    // Only the last 4 zones of the worker are kept
+    int mainzones = 0;
+    for (auto& [tid, e] : events) {
+        if (std::string_view{e.name} == "main") mainzones++;
+    }
+    EXPECT_EQ(1, mainzones);
+
+    auto path = std::filesystem::temp_directory_path() / "familyline-test-profile.json";
+    ASSERT_TRUE(p.dumpChromeTrace(path));
+
+    std::ifstream f{path};
+    auto trace = nlohmann::json::parse(f);
+    f.close();
+    std::filesystem::remove(path);
+
+    EXPECT_EQ("ms", trace["displayTimeUnit"]);
+
+    int threadnames = 0, zones = 0;
+    bool worker = false, outer = false;
+    for (auto& e : trace["traceEvents"]) {
+        if (e["ph"] == "M") {
+            threadnames++;
+            if (e["args"]["name"] == "worker") worker = true;
+        } else {
+            ASSERT_EQ("X", e["ph"]);
+            zones++;
+            if (e["name"] == "outer") outer = true;
+        }
+    }
+
+    EXPECT_EQ(5, zones);
+    EXPECT_GE(threadnames, 2);
+    EXPECT_TRUE(worker);
+    EXPECT_TRUE(outer);
+#endif
+}
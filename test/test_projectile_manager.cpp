@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <common/logic/projectile_manager.hpp>
+
+using namespace familyline::logic;
+
+static ProjectileManager::Shot makeShot(uint64_t attackID)
+{
+    return ProjectileManager::Shot{
+        .attackerID    = 1,
+        .defenderID    = 2,
+        .attackID      = attackID,
+        .atkAttributes = AttackAttributes{},
+        .damage        = 1.0,
+        .origin        = glm::vec2(0, 0),
+        .precise       = true};
+}
+
+TEST(ProjectileManager, ProjectilesArriveInWholeTicks)
+{
+    ProjectileManager pm;
+
+    // 10 units, at 3 units per tick, arrives in the 4th tick
+    pm.launch(makeShot(1), glm::vec2(0, 0), glm::vec2(6, 8), 3);
+    for (auto i = 0; i < 3; i++) {
+        EXPECT_EQ(0, pm.update().size());
+        EXPECT_EQ(1, pm.size());
+    }
+
+    auto& impacts = pm.update();
+    ASSERT_EQ(1, impacts.size());
+    EXPECT_EQ(1, impacts[0].shot.attackID);
+    EXPECT_NEAR(6, impacts[0].position.x, 0.001);
+    EXPECT_NEAR(8, impacts[0].position.y, 0.001);
+    EXPECT_EQ(0, pm.size());
+}
+
+TEST(ProjectileManager, ProjectilesKeepTheirOrderAndMemory)
+{
+    ProjectileManager pm;
+    pm.reserve(64);
+    auto capacity = pm.capacity();
+
+    for (auto v = 0; v < 4; v++) {
+        for (uint64_t i = 0; i < 64; i++) {
+            pm.launch(makeShot(i), glm::vec2(0, 0), glm::vec2(10, 0), double(1 + i % 4));
+        }
+
+        std::vector<uint64_t> arrived;
+        while (pm.size() > 0) {
+            for (auto& impact : pm.update()) arrived.push_back(impact.shot.attackID);
+        }
+
+        // The fastest ones arrive first, and the ones with the same speed arrive in
+        // the order they were shot
+        ASSERT_EQ(64, arrived.size());
+        for (auto i = 1u; i < arrived.size(); i++) {
+            if (arrived[i] % 4 == arrived[i - 1] % 4) EXPECT_LT(arrived[i - 1], arrived[i]);
+        }
+        EXPECT_EQ(3, arrived.front() % 4);
+        EXPECT_EQ(0, arrived.back() % 4);
+    }
+
+    EXPECT_EQ(capacity, pm.capacity());
+}
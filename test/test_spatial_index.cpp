@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <common/logic/spatial_index.hpp>
+
+using namespace familyline::logic;
+
+TEST(SpatialIndex, FindsObjectsInRadius)
+{
+    SpatialIndex idx(256, 256, 16);
+    idx.update(1, glm::vec2(10, 10), glm::vec2(2, 2));
+    idx.update(2, glm::vec2(20, 10), glm::vec2(2, 2));
+    idx.update(3, glm::vec2(100, 100), glm::vec2(2, 2));
+
+    EXPECT_EQ(std::vector<object_id_t>({1}), idx.queryRadius(glm::vec2(10, 10), 5));
+    EXPECT_EQ(std::vector<object_id_t>({1, 2}), idx.queryRadius(glm::vec2(15, 10), 5));
+    EXPECT_EQ(std::vector<object_id_t>({}), idx.queryRadius(glm::vec2(60, 60), 20));
+
+    // The radius is measured up to the hitbox, not to the center
+    idx.update(4, glm::vec2(60, 60), glm::vec2(20, 20));
+    EXPECT_EQ(std::vector<object_id_t>({4}), idx.queryRadius(glm::vec2(40, 60), 11));
+    EXPECT_TRUE(idx.touches(4, glm::vec2(40, 60), 11));
+    EXPECT_FALSE(idx.touches(4, glm::vec2(40, 60), 9));
+    EXPECT_FALSE(idx.touches(5, glm::vec2(40, 60), 11));
+}
+
+TEST(SpatialIndex, FindsObjectsInRectangle)
+{
+    SpatialIndex idx(256, 256, 16);
+    for (auto i = 0; i < 10; i++) idx.update(i + 1, glm::vec2(i * 20 + 5, 50), glm::vec2(2, 2));
+
+    EXPECT_EQ(
+        std::vector<object_id_t>({2, 3, 4}), idx.queryRect(glm::vec2(20, 40), glm::vec2(70, 60)));
+
+    // The corners can be in any order
+    EXPECT_EQ(
+        std::vector<object_id_t>({2, 3, 4}), idx.queryRect(glm::vec2(70, 60), glm::vec2(20, 40)));
+}
+
+TEST(SpatialIndex, FindsNearestObjects)
+{
+    SpatialIndex idx(256, 256, 16);
+    idx.update(1, glm::vec2(200, 200), glm::vec2(2, 2));
+    idx.update(2, glm::vec2(50, 50), glm::vec2(2, 2));
+    idx.update(3, glm::vec2(60, 50), glm::vec2(2, 2));
+    idx.update(4, glm::vec2(52, 52), glm::vec2(2, 2));
+
+    EXPECT_EQ(std::vector<object_id_t>({2, 4}), idx.queryNearest(glm::vec2(49, 49), 2, 500));
+    EXPECT_EQ(std::vector<object_id_t>({2, 4, 3}), idx.queryNearest(glm::vec2(49, 49), 3, 500));
+    EXPECT_EQ(std::vector<object_id_t>({1}), idx.queryNearest(glm::vec2(180, 180), 1, 500));
+    EXPECT_EQ(std::vector<object_id_t>({}), idx.queryNearest(glm::vec2(180, 180), 1, 10));
+}
+
+TEST(SpatialIndex, FollowsMovingObjects)
+{
+    SpatialIndex idx(256, 256, 16);
+    idx.update(1, glm::vec2(10, 10), glm::vec2(2, 2));
+    idx.update(2, glm::vec2(12, 10), glm::vec2(2, 2));
+
+    // Inside the same cell, and then to other cells
+    idx.update(1, glm::vec2(14, 14), glm::vec2(2, 2));
+    EXPECT_EQ(std::vector<object_id_t>({1, 2}), idx.queryRadius(glm::vec2(13, 12), 2));
+
+    idx.update(1, glm::vec2(100, 10), glm::vec2(2, 2));
+    EXPECT_EQ(std::vector<object_id_t>({2}), idx.queryRadius(glm::vec2(13, 12), 2));
+    EXPECT_EQ(std::vector<object_id_t>({1}), idx.queryRadius(glm::vec2(100, 10), 2));
+
+    idx.remove(2);
+    EXPECT_FALSE(idx.contains(2));
+    EXPECT_EQ(1, idx.size());
+    EXPECT_EQ(std::vector<object_id_t>({}), idx.queryRadius(glm::vec2(13, 12), 2));
+}
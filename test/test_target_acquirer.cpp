@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <common/logic/attack_manager.hpp>
+#include <common/logic/colony_manager.hpp>
+#include <common/logic/logic_service.hpp>
+#include <common/logic/player_manager.hpp>
+#include <common/logic/target_acquirer.hpp>
+#include <queue>
+
+#include "utils.hpp"
+
+using namespace familyline::logic;
+
+class TargetAcquirerTest : public ::testing::Test
+{
+protected:
+    ColonyManager cm;
+    PlayerManager pm;
+
+    TerrainFile tf{64, 64};
+    Terrain t{tf};
+
+    std::unique_ptr<DummyPlayer> p1, p2, p3;
+    Colony *c1, *c2, *c3;
+
+    AttackComponent atk{
+        AttackAttributes{
+            .attackPoints  = 1.0,
+            .defensePoints = 0.5,
+            .attackSpeed   = 2048,
+            .precision     = 100,
+            .maxAngle      = M_PI},
+        {AttackRule{.minDistance = 0.5, .maxDistance = 5, .ctype = AttackTypeMelee{}}}};
+
+    ObjectManager om;
+    SpatialIndex index{64, 64};
+    AttackManager am;
+
+    std::queue<EventAttackStart> starts;
+
+    void SetUp() override
+    {
+        LogicService::getActionQueue()->clearEvents();
+        LogicService::initDebugDrawer(new DummyDebugDrawer{t});
+        LogicService::initPathManager(t);
+
+        auto noinput = [&](size_t) -> std::vector<PlayerInputType> { return {}; };
+        p1           = std::make_unique<DummyPlayer>(pm, t, "Test1", 1, noinput);
+        p2           = std::make_unique<DummyPlayer>(pm, t, "Test2", 2, noinput);
+        p3           = std::make_unique<DummyPlayer>(pm, t, "Test3", 3, noinput);
+
+        Alliance& a1 = cm.createAlliance("Attackers");
+        Alliance& a2 = cm.createAlliance("Defenders");
+
+        c1 = &cm.createColony(
+            *p1.get(), 0xffff00ff, std::optional<std::reference_wrapper<Alliance>>{a1});
+        c2 = &cm.createColony(
+            *p2.get(), 0xff0000ff, std::optional<std::reference_wrapper<Alliance>>{a2});
+        c3 = &cm.createColony(
+            *p3.get(), 0xff00ffff, std::optional<std::reference_wrapper<Alliance>>{a1});
+
+        cm.setAllianceDiplomacy(a1, a2, DiplomacyStatus::Enemy);
+        cm.setAllianceDiplomacy(a2, a1, DiplomacyStatus::Enemy);
+
+        LogicService::getActionQueue()->addReceiver(
+            "test-receiver",
+            [&](const EntityEvent& e) {
+                starts.push(std::get<EventAttackStart>(e.type));
+                return true;
+            },
+            {ActionQueueEvent::AttackStart});
+    }
+
+    void TearDown() override
+    {
+        LogicService::getActionQueue()->removeReceiver("test-receiver");
+        LogicService::getActionQueue()->clearEvents();
+    }
+
+    object_id_t add(Colony& c, glm::vec3 pos)
+    {
+        auto o = make_ownable_object(
+            {"unit", "Unit", glm::vec2(1, 1), 200, 200, true, []() {}, std::make_optional(atk)});
+        o->setPosition(pos);
+        o->getColonyComponent()->owner = std::make_optional<std::reference_wrapper<Colony>>(c);
+
+        auto id = om.add(std::move(o));
+        index.update(id, glm::vec2(pos.x, pos.z), glm::vec2(1, 1));
+        return id;
+    }
+};
+
+TEST_F(TargetAcquirerTest, IdleUnitsAttackTheNearestEnemy)
+{
+    auto& pathm = *LogicService::getPathManager();
+
+    // The ally is nearer than the enemy, and the other enemy is out of range
+    auto unit     = add(*c1, glm::vec3(10, 0, 10));
+    auto enemy    = add(*c2, glm::vec3(7, 0, 10));
+    auto ally     = add(*c3, glm::vec3(9, 0, 11));
+    auto farEnemy = add(*c2, glm::vec3(40, 0, 40));
+
+    TargetAcquirer ta(cm, 1);
+
+    // Only one unit is checked per tick
+    ta.update(om, index, pathm, am);
+    LogicService::getActionQueue()->processEvents();
+    ASSERT_EQ(1, starts.size());
+    EXPECT_EQ(unit, starts.front().attackerID);
+    EXPECT_EQ(enemy, starts.front().defenderID);
+    EXPECT_TRUE(am.isAttacking(unit));
+    EXPECT_FALSE(am.isAttacking(ally));
+    starts.pop();
+
+    // The enemy cannot see the unit, because it is behind it
+    ta.update(om, index, pathm, am);
+    LogicService::getActionQueue()->processEvents();
+    EXPECT_EQ(0, starts.size());
+
+    ta.update(om, index, pathm, am);
+    LogicService::getActionQueue()->processEvents();
+    ASSERT_EQ(1, starts.size());
+    EXPECT_EQ(ally, starts.front().attackerID);
+    EXPECT_EQ(enemy, starts.front().defenderID);
+    starts.pop();
+
+    // Nobody is near the other enemy, and the ones that are attacking do not
+    // look for another target
+    for (auto i = 0; i < 8; i++) {
+        ta.update(om, index, pathm, am);
+        LogicService::getActionQueue()->processEvents();
+    }
+    EXPECT_EQ(0, starts.size());
+    EXPECT_FALSE(am.isAttacking(farEnemy));
+    EXPECT_EQ(2, am.attackCount());
+}
+
+TEST_F(TargetAcquirerTest, MovingUnitsDoNotAcquireTargets)
+{
+    auto& pathm = *LogicService::getPathManager();
+
+    // The unit walks right past the enemy
+    auto unit = add(*c1, glm::vec3(4, 0, 10));
+    add(*c2, glm::vec3(12, 0, 12));
+
+    TargetAcquirer ta(cm, 32);
+
+    auto* o = om.getPointer(unit);
+    pathm.startPathing(*o, glm::vec2(30, 10));
+    ASSERT_TRUE(pathm.isMoving(unit));
+
+    bool passed = false;
+    for (auto i = 0; i < 1000 && pathm.isMoving(unit); i++) {
+        pathm.update(om);
+        ta.update(om, index, pathm, am);
+        LogicService::getActionQueue()->processEvents();
+
+        auto pos = o->getPosition();
+        if (glm::distance(glm::vec2(pos.x, pos.z), glm::vec2(12, 12)) < 5) passed = true;
+
+        for (; !starts.empty(); starts.pop()) EXPECT_NE(unit, starts.front().attackerID);
+    }
+
+    EXPECT_TRUE(passed);
+    EXPECT_FALSE(pathm.isMoving(unit));
+    EXPECT_FALSE(am.isAttacking(unit));
+}
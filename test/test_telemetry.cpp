@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <common/telemetry.hpp>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <nlohmann/json.hpp>
+#include <string>
+
+using namespace familyline;
+
+TEST(Telemetry, HistogramBucketsHaveBoundedError)
+{
+    for (uint64_t v : std::initializer_list<uint64_t>{
+             0, 1, 63, 64, 65, 1000, 16667, 123456789, UINT64_MAX}) {
+        auto b    = Histogram::bucketOf(v);
+        auto high = Histogram::bucketHighest(b);
+
+        ASSERT_LT(b, Histogram::BucketCount);
+        EXPECT_GE(high, v);
+        EXPECT_LE(high - v, v / Histogram::SubBucketCount);
+        if (b > 0) EXPECT_LT(Histogram::bucketHighest(b - 1), v);
+    }
+}
+
+TEST(Telemetry, HistogramPercentiles)
+{
+    Histogram h;
+    EXPECT_EQ(0, h.percentile(99));
+
+    // 1000 frames of ~16ms, and 10 hitches of 100ms
+    for (int i = 0; i < 1000; i++) h.record(16000 + i);
+    for (int i = 0; i < 10; i++) h.record(100000);
+
+    EXPECT_EQ(1010, h.count());
+    EXPECT_EQ(16000, h.min());
+    EXPECT_EQ(100000, h.max());
+
+    EXPECT_NEAR(16500, h.percentile(50), 16500 / 32);
+    EXPECT_NEAR(16900, h.percentile(90), 16900 / 32);
+    EXPECT_EQ(100000, h.percentile(99.5));
+    EXPECT_EQ(100000, h.percentile(100));
+
+    Histogram other;
+    other.record(1);
+    h.merge(other);
+    EXPECT_EQ(1011, h.count());
+    EXPECT_EQ(1, h.min());
+
+    h.reset();
+    EXPECT_EQ(0, h.count());
+    EXPECT_EQ(0, h.max());
+}
+
+TEST(Telemetry, ExportsCSVAndJSON)
+{
+    Telemetry t;
+    t.setInfo("version", "test \"build\"");
+
+    for (int i = 1; i <= 100; i++) {
+        t.recordTime("frame", i / 10.0);
+        t.recordCount("objects", 42);
+    }
+
+    auto* frame = t.get("frame");
+    ASSERT_TRUE(frame);
+    EXPECT_EQ(Telemetry::Unit::Milliseconds, frame->unit);
+    EXPECT_EQ(100, frame->values.count());
+    EXPECT_EQ(10000, frame->values.max());
+    EXPECT_FALSE(t.get("draw-calls"));
+
+    // The percentiles are the highest value of their buckets: 5000us is in the
+    // bucket that goes from 4992 to 5119
+    auto csv = t.toCSV();
+    EXPECT_EQ(
+        "metric,unit,count,min,mean,p50,p90,p99,max\n"
+        "frame,ms,100,0.100,5.050,5.119,9.215,9.983,10.000\n"
+        "objects,count,100,42.000,42.000,42.000,42.000,42.000,42.000\n",
+        csv);
+
+    auto json = nlohmann::ordered_json::parse(t.toJSON());
+    EXPECT_EQ("test \"build\"", json["info"]["version"]);
+    EXPECT_EQ("ms", json["metrics"]["frame"]["unit"]);
+    EXPECT_EQ(100, json["metrics"]["frame"]["count"]);
+    EXPECT_DOUBLE_EQ(10.0, json["metrics"]["frame"]["max"].get<double>());
+    EXPECT_EQ("count", json["metrics"]["objects"]["unit"]);
+    EXPECT_DOUBLE_EQ(42.0, json["metrics"]["objects"]["p99"].get<double>());
+
+    // The metrics are kept in the order they were first recorded
+    EXPECT_EQ("frame", json["metrics"].begin().key());
+
+    auto path = std::filesystem::temp_directory_path() / "familyline-test-telemetry.json";
+    t.setExport(path, std::chrono::seconds(0));
+    ASSERT_TRUE(t.exportNow());
+
+    std::ifstream f{path};
+    std::string written{std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+    std::filesystem::remove(path);
+
+    auto parsed = nlohmann::ordered_json::parse(written);
+    parsed.erase("elapsed");
+    json.erase("elapsed");
+    EXPECT_EQ(json, parsed);
+}
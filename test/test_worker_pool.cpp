@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <common/worker_pool.hpp>
+#include <numeric>
+#include <vector>
+
+using namespace familyline;
+
+TEST(WorkerPool, RunsEveryItemOnce)
+{
+    WorkerPool pool(3);
+    ASSERT_EQ(3, pool.threadCount());
+
+    std::vector<int> runs(1000, 0);
+    for (auto batch = 0; batch < 10; batch++) {
+        pool.parallelFor(runs.size(), [&](size_t i) { runs[i]++; });
+    }
+
+    for (auto i = 0; i < runs.size(); i++) {
+        EXPECT_EQ(10, runs[i]) << "item " << i;
+    }
+}
+
+TEST(WorkerPool, RunsInCallingThreadWithoutWorkers)
+{
+    WorkerPool pool(0);
+
+    auto caller = std::this_thread::get_id();
+    std::vector<int> values(100, 0);
+    pool.parallelFor(values.size(), [&](size_t i) {
+        EXPECT_EQ(caller, std::this_thread::get_id());
+        values[i] = i;
+    });
+
+    EXPECT_EQ(99 * 100 / 2, std::accumulate(values.begin(), values.end(), 0));
+}
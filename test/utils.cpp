@@ -1,7 +1,5 @@
 #include "utils.hpp"
 
-using namespace familyline::logic;
-
 TestObject::TestObject(const struct object_init& init)
     : GameObject(init.type, init.name, init.size, init.health, init.maxHealth, init.showHealth),
       init_params_(init)
@@ -0,0 +1,273 @@
+#!/usr/bin/env python
+
+# Read a Familyline binary log file and dump it as text or JSON
+#
+# The binary log is written by the game when you set `log.binary_file` in the
+# settings file. Its format is described in src/include/common/binary_log.hpp.
+#
+# You can pass more than one file, like the rotated ones (game.flog.3, game.flog.2,
+# game.flog.1, game.flog), and they will be dumped in the order you passed them.
+
+import sys
+import struct
+import argparse
+import json
+import string
+from datetime import datetime
+
+LEVELS = ["debug", "info", "warning", "error", "fatal"]
+
+ENTRY_FORMAT = 0x01
+ENTRY_TAG = 0x02
+ENTRY_LOST = 0x03
+ENTRY_MESSAGE = 0x10
+
+ARG_INT = 1
+ARG_UINT = 2
+ARG_DOUBLE = 3
+ARG_BOOL = 4
+ARG_CHAR = 5
+ARG_STRING = 6
+ARG_VEC2 = 7
+ARG_VEC3 = 8
+ARG_FLOAT = 9
+
+SUPPORTED_VERSIONS = [1]
+
+
+class Float32(float):
+    """
+    A float that came from a 32-bit float, so we print it with less digits
+    """
+    pass
+
+
+class Vector(tuple):
+    """
+    A glm::vec2 or glm::vec3
+    """
+    pass
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def eof(self):
+        return self.pos >= len(self.data)
+
+    def byte(self):
+        v = self.data[self.pos]
+        self.pos += 1
+        return v
+
+    def varint(self):
+        v = 0
+        shift = 0
+        while True:
+            b = self.byte()
+            v |= (b & 0x7f) << shift
+            shift += 7
+            if b < 0x80:
+                return v
+
+    def signed(self):
+        v = self.varint()
+        return (v >> 1) ^ -(v & 1)
+
+    def raw(self, fmt):
+        size = struct.calcsize(fmt)
+        v = struct.unpack_from(fmt, self.data, self.pos)
+        self.pos += size
+        return v
+
+    def string(self):
+        size = self.varint()
+        v = self.data[self.pos:self.pos + size].decode("utf-8", errors="replace")
+        self.pos += size
+        return v
+
+    def arg(self):
+        atype = self.byte()
+        if atype == ARG_INT:
+            return self.signed()
+        elif atype == ARG_UINT:
+            return self.varint()
+        elif atype == ARG_DOUBLE:
+            return self.raw("<d")[0]
+        elif atype == ARG_BOOL:
+            return self.byte() != 0
+        elif atype == ARG_CHAR:
+            return chr(self.byte())
+        elif atype == ARG_STRING:
+            return self.string()
+        elif atype == ARG_VEC2:
+            return Vector(Float32(v) for v in self.raw("<ff"))
+        elif atype == ARG_VEC3:
+            return Vector(Float32(v) for v in self.raw("<fff"))
+        elif atype == ARG_FLOAT:
+            return Float32(self.raw("<f")[0])
+        else:
+            raise RuntimeError(f"unknown argument type {atype} at offset {self.pos - 1}")
+
+
+def format_value(v, spec):
+    """
+    Format a value like libfmt would
+    """
+    if isinstance(v, Vector):
+        return "(" + ", ".join(format_value(c, spec) for c in v) + ")"
+
+    if isinstance(v, bool) and spec == "":
+        return "true" if v else "false"
+
+    if isinstance(v, float) and spec == "":
+        # libfmt prints the shortest representation that reads back to the same
+        # value, without a trailing ".0"
+        if isinstance(v, Float32):
+            for precision in range(1, 10):
+                s = "{:.{}g}".format(v, precision)
+                if struct.pack("<f", float(s)) == struct.pack("<f", v):
+                    break
+        else:
+            s = repr(v)
+
+        return s[:-2] if s.endswith(".0") else s
+
+    return format(v, spec)
+
+
+def format_message(fmt, args):
+    out = []
+    index = 0
+    for literal, field, spec, _ in string.Formatter().parse(fmt):
+        out.append(literal)
+        if field is None:
+            continue
+
+        if field == "":
+            argi = index
+            index += 1
+        else:
+            argi = int(field)
+
+        try:
+            out.append(format_value(args[argi], spec or ""))
+        except (IndexError, ValueError) as e:
+            out.append(f"<{e}>")
+
+    return "".join(out)
+
+
+def parse_log(filename):
+    """
+    Parse a binary log file
+
+    Yields a dictionary for each message, and for each notice of lost messages
+    """
+    with open(filename, "rb") as lfile:
+        data = lfile.read()
+
+    if len(data) < 16:
+        raise RuntimeError("file too small")
+
+    magic, version, start = struct.unpack_from("<4sIQ", data, 0)
+    if magic != b"FLOG":
+        raise RuntimeError("invalid magic number")
+
+    if version not in SUPPORTED_VERSIONS:
+        raise RuntimeError(f"file version {version} not supported")
+
+    started = str(datetime.fromtimestamp(start / 1000000))
+
+    r = Reader(data)
+    r.pos = 16
+
+    formats = {}
+    tags = {}
+    tick = 0
+    time = 0
+
+    while not r.eof():
+        kind = r.byte()
+        if kind == ENTRY_FORMAT:
+            fid = r.varint()
+            formats[fid] = r.string()
+        elif kind == ENTRY_TAG:
+            tid = r.varint()
+            tags[tid] = r.string()
+        elif kind == ENTRY_LOST:
+            yield dict(
+                file=filename, file_start=started, time=time / 1000000, tick=tick,
+                level="warning", tag="logger", lost=r.varint())
+        elif ENTRY_MESSAGE <= kind < ENTRY_MESSAGE + len(LEVELS):
+            fid = r.varint()
+            tid = r.varint()
+            tick += r.signed()
+            time += r.signed()
+            args = [r.arg() for _ in range(r.byte())]
+
+            fmt = formats.get(fid, "<unknown format>")
+            yield dict(
+                file=filename, file_start=started, time=time / 1000000, tick=tick,
+                level=LEVELS[kind - ENTRY_MESSAGE], tag=tags.get(tid, ""),
+                format=fmt, args=args, message=format_message(fmt, args))
+        else:
+            raise RuntimeError(f"unknown entry kind {kind:#x} at offset {r.pos - 1}")
+
+
+def message_text(m):
+    if "lost" in m:
+        return f"{m['lost']} messages were lost, because the log was full"
+    return m["message"]
+
+
+def to_text(m):
+    level = "" if m["level"] == "info" else f"[{m['level']}] "
+    tag = f"{m['tag']}: " if m["tag"] else ""
+    return f"[{m['time']:13.4f}] ({m['tick']}) {level}{tag}{message_text(m)}"
+
+
+def to_json(m):
+    v = dict(m)
+    if "args" in v:
+        v["args"] = [list(a) if isinstance(a, Vector) else a for a in v["args"]]
+    return v
+
+##########################################################
+##########################################################
+
+parser = argparse.ArgumentParser(description="Decode a Familyline binary log")
+parser.add_argument("files", nargs="+", help="the log files, oldest first")
+parser.add_argument("--json", action="store_true", help="dump as JSON, one message per line")
+parser.add_argument("--level", choices=LEVELS, default="debug",
+                    help="only show messages of this level or above")
+parser.add_argument("--tag", action="append", default=[],
+                    help="only show messages with this tag. Can be repeated")
+parser.add_argument("--from-tick", type=int, default=None)
+parser.add_argument("--to-tick", type=int, default=None)
+parser.add_argument("--grep", default=None, help="only show messages containing this text")
+args = parser.parse_args()
+
+minlevel = LEVELS.index(args.level)
+
+for filename in args.files:
+    try:
+        for m in parse_log(filename):
+            if LEVELS.index(m["level"]) < minlevel:
+                continue
+            if args.tag and m["tag"] not in args.tag:
+                continue
+            if args.from_tick is not None and m["tick"] < args.from_tick:
+                continue
+            if args.to_tick is not None and m["tick"] > args.to_tick:
+                continue
+            if args.grep is not None and args.grep not in message_text(m):
+                continue
+
+            print(json.dumps(to_json(m)) if args.json else to_text(m))
+
+    except (RuntimeError, IndexError, struct.error) as e:
+        print(f"error: {filename}: {e}", file=sys.stderr)
+        exit(1)